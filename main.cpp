@@ -1,8 +1,21 @@
 #include "SysInfoProbe.hpp"
+#include "Serialization.hpp"
+#include "FleetStore.hpp"
+#include "SnapshotDiff.hpp"
+#include "SharedSnapshot.hpp"
+#include "LocalSnapshot.hpp"
+#include "SamplingScheduler.hpp"
+#include "OverheadGovernor.hpp"
+#include "TerminalScreen.hpp"
+#include "AlertEngine.hpp"
+// The CLI reports heap allocations per collector; programs that embed the library keep their own operator new.
+#define SYSINFO_ALLOCATION_HOOK
+#include "AllocationHook.hpp"
 #include <iostream>
-#include <iomanip>
 #include <vector>
 #include <string>
+#include <fstream>
+#include <filesystem>
 
 constexpr const char* RESET = "\033[0m";
 constexpr const char* BOLD = "\033[1m";
@@ -12,179 +25,343 @@ constexpr const char* YELLOW = "\033[33m";
 
 const int LabelWidth = 25;
 
+// The whole report is rendered into this buffer and written out in a few large writes.
+ReportWriter Report;
+
+// A report row starting with `label` padded to LabelWidth.
+TextWriter& Field(std::string_view label) {
+    return Report.Field(label, LabelWidth);
+}
+
+TextWriter& AppendList(TextWriter& out, const std::vector<std::string>& values) {
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (i != 0) out.Text(", ");
+        out.Text(values[i]);
+    }
+    return out;
+}
+
 void PrintSeparator() {
-    std::cout << BLUE << std::string(60, '=') << RESET << '\n';
+    Report.Row().Text(BLUE).Char('=', 60).Text(RESET).EndLine();
 }
 
-void PrintSectionTitle(const std::string& title) {
+void PrintSectionTitle(std::string_view title) {
     PrintSeparator();
-    std::cout << BOLD << CYAN << title << RESET << '\n';
+    Report.Row().Text(BOLD).Text(CYAN).Text(title).Text(RESET).EndLine();
     PrintSeparator();
 }
 
 void PrintRamInfo(const RAMINFO& ram) {
     PrintSectionTitle("RAM INFORMATION");
-    std::cout << std::left << std::setw(LabelWidth) << "Name:" << ram.Name << '\n';
-    std::cout << std::setw(LabelWidth) << "Manufacturer:" << ram.Manufacturer << '\n';
-    std::cout << std::setw(LabelWidth) << "Model:" << ram.Model << '\n';
-    std::cout << std::setw(LabelWidth) << "Memory Type:" << ram.MemoryType << '\n';
-    std::cout << std::setw(LabelWidth) << "Form Factor:" << ram.FormFactor << '\n';
-    std::cout << std::setw(LabelWidth) << "Serial Number:" << ram.SerialNumber << '\n';
-
-    std::cout << std::fixed << std::setprecision(2);
-    std::cout << std::setw(LabelWidth) << "Size (MB):" << ram.SizeInMegabytes << " MB\n";
-    std::cout << std::setw(LabelWidth) << "Size (GB):" << ram.SizeInGigabytes << " GB\n";
+    Field("Name:").Text(ram.Name).EndLine();
+    Field("Manufacturer:").Text(ram.Manufacturer).EndLine();
+    Field("Model:").Text(ram.Model).EndLine();
+    Field("Memory Type:").Text(ram.MemoryType).EndLine();
+    Field("Form Factor:").Text(ram.FormFactor).EndLine();
+    Field("Serial Number:").Text(ram.SerialNumber).EndLine();
+    Field("Size (MB):").Signed(ram.SizeInMegabytes).Text(" MB").EndLine();
+    Field("Size (GB):").Fixed(ram.SizeInGigabytes, 2).Text(" GB").EndLine();
+    Field("Latency:").Signed(ram.LatencyInNanoseconds).Text(" ns").EndLine();
+    Field("Frequency:").Signed(ram.FrequencyInMHz).Text(" MHz").EndLine();
+}
 
-    std::cout << std::setw(LabelWidth) << "Latency:" << ram.LatencyInNanoseconds << " ns\n";
-    std::cout << std::setw(LabelWidth) << "Frequency:" << ram.FrequencyInMHz << " MHz\n";
+void PrintRamModules(const std::vector<RAMINFO>& modules) {
+    PrintSectionTitle("RAM MODULES");
+    for (const auto& module : modules) {
+        Field("Slot:").Text(module.DeviceLocator).Text(" (").Text(module.BankLocator).Text(")").EndLine();
+        Field("Name:").Text(module.Name).EndLine();
+        Field("Memory Type:").Text(module.MemoryType).EndLine();
+        Field("Size (MB):").Signed(module.SizeInMegabytes).Text(" MB").EndLine();
+        Field("Frequency:").Signed(module.FrequencyInMHz).Text(" MHz").EndLine();
+        PrintSeparator();
+    }
 }
 
 void PrintMBInfo(const MAINBOARDINFO& mb) {
     PrintSectionTitle("MOTHERBOARD INFORMATION");
-    std::cout << std::left << std::setw(LabelWidth) << "Manufacturer:" << mb.Manufacturer << '\n';
-    std::cout << std::setw(LabelWidth) << "Product:" << mb.Name << '\n';
-    std::cout << std::setw(LabelWidth) << "Version:" << mb.Version << '\n';
-    std::cout << std::setw(LabelWidth) << "Serial Number:" << mb.SerialNumber << '\n';
+    Field("Manufacturer:").Text(mb.Manufacturer).EndLine();
+    Field("Product:").Text(mb.Name).EndLine();
+    Field("Version:").Text(mb.Version).EndLine();
+    Field("Serial Number:").Text(mb.SerialNumber).EndLine();
 }
 
-void PrintGpuInfo(const GPUINFO& gpu) {
+void PrintGpuInfo(const std::vector<GPUINFO>& gpus, const std::vector<GPUMEMORYCOUNTERSINFO>& counters) {
     PrintSectionTitle("GPU INFORMATION");
-    std::cout << std::left << std::setw(LabelWidth) << "Name:" << gpu.Name << '\n';
-    std::cout << std::setw(LabelWidth) << "Manufacturer:" << gpu.Manufacturer << '\n';
-    std::cout << std::setw(LabelWidth) << "Driver Version:" << gpu.DriverVersion << '\n';
-    std::cout << std::setw(LabelWidth) << "VRAM Size (MB):" << gpu.VRAMSizeInMegabytes << " MB\n";
-    std::cout << std::setw(LabelWidth) << "VRAM Size (GB):" << gpu.VRAMSizeInGigabytes << " GB\n";
+    for (size_t i = 0; i < gpus.size(); ++i) {
+        const auto& gpu = gpus[i];
+        if (i > 0) PrintSeparator();
+        Field("Name:").Text(gpu.Name).EndLine();
+        Field("Manufacturer:").Text(gpu.Manufacturer).EndLine();
+        Field("PCI ID:").Hex(gpu.VendorId, 4).Char(':').Hex(gpu.DeviceId, 4).EndLine();
+        Field("Driver Version:").Text(gpu.DriverVersion).EndLine();
+        Field("VRAM Size (MB):").Signed(gpu.VRAMSizeInMegabytes).Text(" MB").EndLine();
+        Field("VRAM Size (GB):").Fixed(gpu.VRAMSizeInGigabytes, 2).Text(" GB").EndLine();
+        if (i < counters.size())
+            Field("VRAM Used:").Unsigned(counters[i].DedicatedUsageBytes / (1024 * 1024)).Text(" MB (").Fixed(counters[i].DedicatedUsedPercent, 1)
+                .Text(" %), shared ").Unsigned(counters[i].SharedUsageBytes / (1024 * 1024)).Text(" MB").EndLine();
+        if (gpu.CurrentLinkWidth)
+            Field("PCIe Link:").Text("Gen").Unsigned(gpu.CurrentLinkGeneration).Text(" x").Unsigned(gpu.CurrentLinkWidth)
+                .Text(" (max Gen").Unsigned(gpu.MaxLinkGeneration).Text(" x").Unsigned(gpu.MaxLinkWidth).Text(")").EndLine();
+        if (gpu.RefreshRate) Field("Refresh Rate:").Signed(gpu.RefreshRate).Text(" Hz").EndLine();
+    }
 }
 
 void PrintOSInfo(const OSINFO& os) {
     PrintSectionTitle("OPERATING SYSTEM INFORMATION");
-    std::cout << std::left << std::setw(LabelWidth) << "Technical Name:" << os.TechnicalName << '\n';
-    std::cout << std::setw(LabelWidth) << "Name:" << os.Name << '\n';
-    std::cout << std::setw(LabelWidth) << "Version:" << os.Version << '\n';
-    std::cout << std::setw(LabelWidth) << "Build Number:" << os.BuildNumber << '\n';
-    std::cout << std::setw(LabelWidth) << "Architecture:" << os.Architecture << '\n';
-    std::cout << std::setw(LabelWidth) << "Install Date:" << os.InstallDate << '\n';
+    Field("Technical Name:").Text(os.TechnicalName).EndLine();
+    Field("Name:").Text(os.Name).EndLine();
+    Field("Version:").Text(os.Version).EndLine();
+    Field("Build Number:").Text(os.BuildNumber).EndLine();
+    Field("Architecture:").Text(os.Architecture).EndLine();
+    Field("Install Date:").Text(os.InstallDate).EndLine();
 }
 
 void PrintCPUInfo(const CPUINFO& cpu) {
     PrintSectionTitle("CPU INFORMATION");
-    std::cout << std::left << std::setw(LabelWidth) << "Name:" << cpu.Name << '\n';
-    std::cout << std::setw(LabelWidth) << "Manufacturer:" << cpu.Manufacturer << '\n';
-    std::cout << std::setw(LabelWidth) << "Cores:" << cpu.CoreCount << '\n';
-    std::cout << std::setw(LabelWidth) << "Logical Processors:" << cpu.ThreadCount << '\n';
-    std::cout << std::setw(LabelWidth) << "Max Clock Speed:" << cpu.MaxClockSpeed << " MHz\n";
+    Field("Name:").Text(cpu.Name).EndLine();
+    Field("Manufacturer:").Text(cpu.Manufacturer).EndLine();
+    Field("Cores:").Signed(cpu.CoreCount).EndLine();
+    Field("Logical Processors:").Signed(cpu.ThreadCount).EndLine();
+    Field("Max Clock Speed:").Signed(cpu.MaxClockSpeed).Text(" MHz").EndLine();
 
-    std::cout << std::setw(LabelWidth) << "L1 Cache:" << cpu.Cache.L1 << " KB\n";
-    std::cout << std::setw(LabelWidth) << "L2 Cache:" << cpu.Cache.L2 << " KB\n";
-    std::cout << std::setw(LabelWidth) << "L3 Cache:" << cpu.Cache.L3 << " KB\n";
+    Field("L1 Cache:").Signed(cpu.Cache.L1).Text(" KB").EndLine();
+    Field("L2 Cache:").Signed(cpu.Cache.L2).Text(" KB").EndLine();
+    Field("L3 Cache:").Signed(cpu.Cache.L3).Text(" KB").EndLine();
 
     // Print CPU instructions in a comma-separated list
-    std::cout << std::setw(LabelWidth) << "Instructions:";
-    for (size_t i = 0; i < cpu.Instructions.size(); ++i) {
-        std::cout << cpu.Instructions[i];
-        if (i != cpu.Instructions.size() - 1)
-            std::cout << ", ";
-    }
-    std::cout << '\n';
+    AppendList(Field("Instructions:"), cpu.Instructions).EndLine();
+
+    Field("Processes / Threads:").Unsigned(cpu.Pressure.ProcessCount).Text(" / ").Unsigned(cpu.Pressure.ThreadCount).EndLine();
+    Field("Running / Ready:").Unsigned(cpu.Pressure.RunningThreads).Text(" / ").Unsigned(cpu.Pressure.ReadyThreads).EndLine();
+    Field("Load Average:").Fixed(cpu.Pressure.LoadAverage1, 2).Text(", ").Fixed(cpu.Pressure.LoadAverage5, 2).Text(", ")
+        .Fixed(cpu.Pressure.LoadAverage15, 2).EndLine();
 }
 
 void PrintBIOSInfo(const BIOSINFO& bios) {
     PrintSectionTitle("BIOS INFORMATION");
-    std::cout << std::left << std::setw(LabelWidth) << "Manufacturer:" << bios.Manufacturer << '\n';
-    std::cout << std::setw(LabelWidth) << "Version:" << bios.Version << '\n';
-    std::cout << std::setw(LabelWidth) << "Build Number:" << bios.BuildNumber << '\n';
-    std::cout << std::setw(LabelWidth) << "Serial Number:" << bios.SerialNumber << '\n';
+    Field("Manufacturer:").Text(bios.Manufacturer).EndLine();
+    Field("Version:").Text(bios.Version).EndLine();
+    Field("Build Number:").Text(bios.BuildNumber).EndLine();
+    Field("Release Date:").Text(bios.ReleaseDate).EndLine();
+    Field("Serial Number:").Text(bios.SerialNumber).EndLine();
 }
 
 void PrintComputerType(const SysInfoProbe& probe) {
     PrintSectionTitle("COMPUTER TYPE");
-    std::cout << "Computer Type: " << (probe.ComputerType == LAPTOP ? "Laptop" : "Desktop") << '\n';
+    Report.Row().Text("Computer Type: ").Text(probe.ComputerType == LAPTOP ? "Laptop" : "Desktop").EndLine();
 }
 
 void PrintDisplayInfo(const std::vector<DISPLAYINFO>& displays) {
     PrintSectionTitle("DISPLAY INFORMATION");
     for (const auto& display : displays) {
-        std::cout << std::left << std::setw(LabelWidth) << "Monitor Name:" << display.MonitorName << '\n';
-        std::cout << std::setw(LabelWidth) << "Manufacturer:" << display.MonitorManufacturer << '\n';
-        std::cout << std::setw(LabelWidth) << "Screen Width:" << display.ScreenWidth << '\n';
-        std::cout << std::setw(LabelWidth) << "Screen Height:" << display.ScreenHeight << '\n';
-        std::cout << std::setw(LabelWidth) << "Max Width:" << display.MaxWidthRes << '\n';
-        std::cout << std::setw(LabelWidth) << "Max Height:" << display.MaxHeightRes << '\n';
-        std::cout << std::setw(LabelWidth) << "Screen Size (inches):" << display.ScreenSizeInch << "\"\n";
-        std::cout << std::setw(LabelWidth) << "Refresh Rate (hz):" << display.RefreshRate << '\n';
+        Field("Monitor Name:").Text(display.MonitorName).EndLine();
+        Field("Manufacturer:").Text(display.MonitorManufacturer).EndLine();
+        Field("Screen Width:").Signed(display.ScreenWidth).EndLine();
+        Field("Screen Height:").Signed(display.ScreenHeight).EndLine();
+        Field("Max Width:").Signed(display.MaxWidthRes).EndLine();
+        Field("Max Height:").Signed(display.MaxHeightRes).EndLine();
+        Field("Screen Size (inches):").Fixed(display.ScreenSizeInch, 2).Text("\"").EndLine();
+        Field("Refresh Rate (hz):").Signed(display.RefreshRate).EndLine();
+        if (!display.ManufacturerId.empty()) {
+            Field("EDID ID:").Text(display.ManufacturerId).Hex(display.ProductCode, 4, true).Text(", serial ").Text(display.SerialNumber)
+                .Text(", ").Signed(display.ManufactureYear).EndLine();
+            Field("Image Size (mm):").Signed(display.ImageWidthMm).Text(" x ").Signed(display.ImageHeightMm).EndLine();
+            Field("Native Mode:").Signed(display.NativeWidth).Text(" x ").Signed(display.NativeHeight).Text(" @ ")
+                .Fixed(display.NativeRefreshRate, 2).Text(" Hz").EndLine();
+            Field("Max Monitor Mode:").Signed(display.MaxModeWidth).Text(" x ").Signed(display.MaxModeHeight).Text(" @ ")
+                .Fixed(display.MaxModeRefreshRate, 2).Text(" Hz").EndLine();
+        }
         PrintSeparator();
     }
 }
 
 void PrintUptime(const UPTIMEINFO& uptime) {
     PrintSectionTitle("UPTIME INFORMATION");
-    std::cout << "Days: " << uptime.Days << '\n';
-    std::cout << "Hours: " << uptime.Hours << '\n';
-    std::cout << "Minutes: " << uptime.Minutes << '\n';
-    std::cout << "Seconds: " << uptime.Seconds << '\n';
+    Report.Row().Text("Days: ").Unsigned(uptime.Days).EndLine();
+    Report.Row().Text("Hours: ").Unsigned(uptime.Hours).EndLine();
+    Report.Row().Text("Minutes: ").Unsigned(uptime.Minutes).EndLine();
+    Report.Row().Text("Seconds: ").Unsigned(uptime.Seconds).EndLine();
+    Report.Row().Text("Suspended (s): ").Unsigned(uptime.SuspendedSeconds).EndLine();
+    Report.Row().Text("Booted At (unix): ").Signed(uptime.BootedAt).EndLine();
 }
 
 void PrintSoundInfo(const SOUNDINFO& sound) {
     PrintSectionTitle("SOUND INFORMATION");
-    std::cout << "Name: " << sound.Name << '\n';
+    Report.Row().Text("Name: ").Text(sound.Name).EndLine();
 }
 
 void PrintCDROMInfo(const std::vector<CDROMINFO>& cdroms) {
     PrintSectionTitle("CDROM INFORMATION");
     for (const auto& cdrom : cdroms) {
-        std::cout << "Name: " << cdrom.Name << '\n';
+        Report.Row().Text("Name: ").Text(cdrom.Name).EndLine();
     }
 }
 
 void PrintNetworkInterfaceInfo(const std::vector<NETWORKINTERFACEINFO>& network) {
     PrintSectionTitle("NETWORK INTERFACE INFORMATION");
     for (const auto& net : network) {
-        std::cout << std::left << std::setw(LabelWidth) << "Name:" << net.Name << '\n';
-        std::cout << std::setw(LabelWidth) << "Description:" << net.Description << '\n';
-        std::cout << std::setw(LabelWidth) << "Interface Index:" << net.InterfaceIndex << '\n';
-        std::cout << std::setw(LabelWidth) << "Interface Type:" << net.InterfaceType << '\n';
-        std::cout << std::setw(LabelWidth) << "MAC Address:" << net.MACAddress << '\n';
-        std::cout << std::setw(LabelWidth) << "DNS Suffix:" << net.DNSSuffix << '\n';
-
-        std::cout << std::setw(LabelWidth) << "IP Addresses:";
-        for (size_t i = 0; i < net.IPAddresses.size(); ++i) {
-            std::cout << net.IPAddresses[i];
-            if (i != net.IPAddresses.size() - 1)
-                std::cout << ", ";
-        }
-        std::cout << '\n';
-
-        std::cout << std::setw(LabelWidth) << "DNS Addresses:";
-        for (size_t i = 0; i < net.DNSAddresses.size(); ++i) {
-            std::cout << net.DNSAddresses[i];
-            if (i != net.DNSAddresses.size() - 1)
-                std::cout << ", ";
-        }
-        std::cout << '\n';
-
-        std::cout << std::setw(LabelWidth) << "Subnet Masks:";
-        for (size_t i = 0; i < net.SubnetMasks.size(); ++i) {
-            std::cout << net.SubnetMasks[i];
-            if (i != net.SubnetMasks.size() - 1)
-                std::cout << ", ";
-        }
-        std::cout << '\n';
+        Field("Name:").Text(net.Name).EndLine();
+        Field("Description:").Text(net.Description).EndLine();
+        Field("Interface Index:").Unsigned(net.InterfaceIndex).EndLine();
+        Field("Interface Type:").Unsigned(net.InterfaceType).EndLine();
+        Field("MAC Address:").Text(net.MACAddress).EndLine();
+        Field("DNS Suffix:").Text(net.DNSSuffix).EndLine();
+        AppendList(Field("IP Addresses:"), net.IPAddresses).EndLine();
+        AppendList(Field("DNS Addresses:"), net.DNSAddresses).EndLine();
+        AppendList(Field("Subnet Masks:"), net.SubnetMasks).EndLine();
         PrintSeparator();
     }
 }
 
+void PrintTCPStats(const TCPSTATSINFO& tcp) {
+    PrintSectionTitle("TCP/UDP STATISTICS");
+    Field("Connections:").Unsigned(tcp.TotalConnections).Text(" (").Unsigned(tcp.EstablishedConnections).Text(" established, ")
+        .Unsigned(tcp.ListeningSockets).Text(" listening)").EndLine();
+    Field("TIME_WAIT / CLOSE_WAIT:").Unsigned(tcp.TimeWaitConnections).Text(" / ").Unsigned(tcp.CloseWaitConnections).EndLine();
+    Field("Segments In / Out:").Unsigned(tcp.SegmentsReceived).Text(" / ").Unsigned(tcp.SegmentsSent).EndLine();
+    Field("Retransmitted:").Unsigned(tcp.SegmentsRetransmitted).EndLine();
+    Field("Failed Attempts:").Unsigned(tcp.FailedAttempts).EndLine();
+    Field("Resets In / Out:").Unsigned(tcp.EstablishedResets).Text(" / ").Unsigned(tcp.ResetsSent).EndLine();
+    Field("UDP Errors / No Port:").Unsigned(tcp.UDPReceiveErrors).Text(" / ").Unsigned(tcp.UDPNoPorts).EndLine();
+}
+
 void PrintStorageDevicesInfo(const std::vector<STORAGEDEVICEINFO>& storagedevices) {
     PrintSectionTitle("STORAGE DEVICES INFORMATION");
     for (const auto& storage : storagedevices) {
-        std::cout << "Model: " << storage.Model << '\n';
-        std::cout << "Manufacturer: " << storage.Manufacturer << '\n';
-        std::cout << "Serial Number: " << storage.SerialNumber << '\n';
-        std::cout << "Size (MiB): " << storage.SizeInMebibytes << " MB\n";
-        std::cout << "Size (GiB): " << storage.SizeInGibibytes << " GB\n";
+        Report.Row().Text("Model: ").Text(storage.Model).EndLine();
+        Report.Row().Text("Manufacturer: ").Text(storage.Manufacturer).EndLine();
+        Report.Row().Text("Serial Number: ").Text(storage.SerialNumber).EndLine();
+        Report.Row().Text("Size (MiB): ").Unsigned(storage.SizeInMebibytes).Text(" MB").EndLine();
+        Report.Row().Text("Size (GiB): ").Signed(storage.SizeInGibibytes).Text(" GB").EndLine();
         PrintSeparator();
     }
 }
 
+void PrintVolumes(const std::vector<VOLUMESPACEINFO>& volumes) {
+    PrintSectionTitle("VOLUMES");
+    for (const auto& volume : volumes)
+        Field(volume.RootPath).Unsigned(volume.FreeBytes / (1024 * 1024 * 1024)).Text(" of ").Unsigned(volume.TotalBytes / (1024 * 1024 * 1024))
+            .Text(" GiB free (").Fixed(volume.FreePercent, 1).Text(" %)").EndLine();
+}
+
+void PrintSensorInfo(const SENSORINFO& sensors) {
+    PrintSectionTitle("SENSOR INFORMATION");
+    for (const auto& zone : sensors.ThermalZones) {
+        Field("Thermal Zone:").Text(zone.Name).EndLine();
+        Field("Temperature:").Fixed(zone.TemperatureCelsius, 1).Text(" C").EndLine();
+        Field("Passive Limit:").Fixed(zone.PassiveLimitPercent, 1).Text(" %").EndLine();
+        Field("Throttle Reasons:").Unsigned(zone.ThrottleReasons).EndLine();
+    }
+    for (const auto& fan : sensors.Fans) {
+        Field("Fan:").Text(fan.Name).EndLine();
+        Field("Target Speed:").Unsigned(fan.DesiredSpeedRPM).Text(" RPM").EndLine();
+    }
+    for (const auto& domain : sensors.PowerDomains) {
+        Field("Power Domain:").Text(domain.Name).EndLine();
+        Field("Power:").Fixed(domain.PowerWatts, 1).Text(" W").EndLine();
+    }
+}
+
+void PrintNUMAInfo(const std::vector<NUMANODEINFO>& nodes, const std::vector<NUMANODECOUNTERSINFO>& counters, const LARGEPAGEINFO& largePages) {
+    PrintSectionTitle("NUMA INFORMATION");
+    for (size_t i = 0; i < nodes.size(); i++) {
+        Field("Node:").Unsigned(nodes[i].NodeNumber).Text(" (group ").Unsigned(nodes[i].ProcessorGroup).Text(", ")
+            .Unsigned(nodes[i].ProcessorCount).Text(" processors)").EndLine();
+        Field("Total:").Unsigned(nodes[i].TotalBytes / (1024 * 1024)).Text(" MiB").EndLine();
+        if (i < counters.size())
+            Field("Available:").Unsigned(counters[i].AvailableBytes / (1024 * 1024)).Text(" MiB (").Fixed(counters[i].UsedPercent, 1)
+                .Text(" % used)").EndLine();
+    }
+    Field("Large Page Size:").Unsigned(largePages.LargePageMinimumBytes / 1024).Text(" KiB").EndLine();
+    Field("1 GB Pages:").Text(largePages.bHugePagesSupported ? "Supported" : "Not supported").EndLine();
+    Field("Lock Memory Privilege:").Text(largePages.bLockMemoryPrivilege ? "Held" : "Not held").EndLine();
+}
+
+void PrintInterruptInfo(const std::vector<INTERRUPTCOUNTERSINFO>& counters, const std::vector<INTERRUPTASSIGNMENTINFO>& assignments) {
+    PrintSectionTitle("INTERRUPT INFORMATION");
+    TextWriter& header = Report.Row();
+    size_t column = header.Mark();
+    header.Text("Processor").PadFrom(column, 12);
+    column = header.Mark(); header.Text("Interrupts").AlignRight(column, 14);
+    column = header.Mark(); header.Text("DPCs").AlignRight(column, 12);
+    column = header.Mark(); header.Text("Intr %").AlignRight(column, 12);
+    column = header.Mark(); header.Text("DPC %").AlignRight(column, 10).EndLine();
+    for (const auto& cpu : counters) {
+        TextWriter& row = Report.Row();
+        column = row.Mark(); row.Unsigned(cpu.Group).Char(':').Unsigned(cpu.Number).PadFrom(column, 12);
+        column = row.Mark(); row.Unsigned(cpu.InterruptCount).AlignRight(column, 14);
+        column = row.Mark(); row.Unsigned(cpu.DpcCount).AlignRight(column, 12);
+        column = row.Mark(); row.Fixed(cpu.InterruptPercent, 2).AlignRight(column, 12);
+        column = row.Mark(); row.Fixed(cpu.DpcPercent, 2).AlignRight(column, 10).EndLine();
+    }
+    PrintSeparator();
+    for (const auto& irq : assignments) {
+        Field(irq.DeviceName).Text(irq.bMessageSignaled ? "MSI " : "IRQ ").Signed(irq.Vector).Text(", affinity 0x").Hex(irq.Affinity)
+            .Text(" (").Unsigned(irq.AffinityProcessorCount).Text(" processors)").EndLine();
+    }
+}
+
+void PrintPCIDevices(const std::vector<PCIDEVICEINFO>& devices) {
+    PrintSectionTitle("PCI DEVICES");
+    for (const auto& device : devices) {
+        TextWriter& row = Report.Row();
+        row.Hex(device.Bus, 2).Char(':').Hex(device.Device, 2).Char('.').Hex(device.Function).Text("  ")
+            .Hex(device.VendorId, 4).Char(':').Hex(device.DeviceId, 4).Text("  ");
+        if (!device.VendorName.empty()) row.Text(device.VendorName).Char(' ');
+        row.Text(device.DeviceName);
+        if (!device.ClassName.empty()) row.Text(" [").Text(device.ClassName).Char(']');
+        if (device.CurrentLinkWidth) {
+            row.Text(", Gen").Unsigned(device.CurrentLinkGeneration).Text(" x").Unsigned(device.CurrentLinkWidth)
+                .Text(" (max Gen").Unsigned(device.MaxLinkGeneration).Text(" x").Unsigned(device.MaxLinkWidth).Char(')');
+        }
+        if (device.NUMANode >= 0) row.Text(", node ").Signed(device.NUMANode);
+        row.EndLine();
+    }
+}
+
+void PrintJobLimits(const JOBLIMITSINFO& job) {
+    PrintSectionTitle("JOB LIMITS");
+    Field("In Job:").Text(job.bInJob ? "Yes" : "No").EndLine();
+    Field("Processors:").Unsigned(job.AffinityProcessorCount).Text(" of ").Unsigned(job.ProcessorCount).EndLine();
+    if (job.CPURateLimitPercent > 0)
+        Field("CPU Rate Limit:").Fixed(job.CPURateLimitPercent, 2).Text(" % (").Fixed(job.Usage.CPUCapUsagePercent, 1).Text(" % used)").EndLine();
+    if (job.CPUWeight)
+        Field("CPU Weight:").Unsigned(job.CPUWeight).EndLine();
+    if (job.JobMemoryLimitBytes)
+        Field("Job Memory Limit:").Unsigned(job.JobMemoryLimitBytes / (1024 * 1024)).Text(" MiB (peak ")
+            .Unsigned(job.Usage.PeakJobMemoryBytes / (1024 * 1024)).Text(" MiB)").EndLine();
+    if (job.ProcessMemoryLimitBytes)
+        Field("Process Memory Limit:").Unsigned(job.ProcessMemoryLimitBytes / (1024 * 1024)).Text(" MiB").EndLine();
+    Field("Effective Parallelism:").Unsigned(job.EffectiveParallelism).EndLine();
+}
+
+void PrintCollectorStats(const std::vector<COLLECTORSTATS>& collectors) {
+    PrintSectionTitle("PROBE INSTRUMENTATION");
+    static const std::pair<std::string_view, size_t> headers[] = {
+        { "Calls", 7 }, { "p50 (us)", 11 }, { "p99 (us)", 11 }, { "max (us)", 11 }, { "WMI", 6 }, { "Syscalls", 9 }, { "Allocs", 8 }
+    };
+    TextWriter& header = Report.Row();
+    size_t column = header.Mark();
+    header.Text("Collector").PadFrom(column, 40);
+    for (const auto& [title, width] : headers) {
+        column = header.Mark();
+        header.Text(title).AlignRight(column, width);
+    }
+    header.EndLine();
+    for (const auto& collector : collectors) {
+        const UINT64 values[] = { collector.Calls, collector.P50Nanoseconds / 1000, collector.P99Nanoseconds / 1000, collector.MaxNanoseconds / 1000,
+            collector.WMIQueries, collector.SystemCalls, collector.Allocations };
+        TextWriter& row = Report.Row();
+        column = row.Mark();
+        row.Text(collector.Name).PadFrom(column, 40);
+        for (size_t i = 0; i < std::size(values); i++) {
+            column = row.Mark();
+            row.Unsigned(values[i]).AlignRight(column, headers[i].second);
+        }
+        row.EndLine();
+    }
+}
+
 int Test() {
     SysInfoProbe probe;
     probe.InitializeWMIAPI();
@@ -194,10 +371,12 @@ int Test() {
         return 1;
     }
 
-    std::cout << BOLD << YELLOW << "\n*** SYSTEM INFORMATION UTILITY ***\n" << RESET;
+    Report.Row().Text(BOLD).Text(YELLOW).Text("\n*** SYSTEM INFORMATION UTILITY ***\n").Text(RESET);
 
     PrintRamInfo(probe.RAM);
-    PrintGpuInfo(probe.GPU);
+    PrintRamModules(probe.RAMModules);
+    PrintNUMAInfo(probe.NUMANodes, probe.NUMACounters, probe.LargePages);
+    PrintGpuInfo(probe.GPUs, probe.GPUMemoryCounters);
     PrintMBInfo(probe.Mainboard);
     PrintOSInfo(probe.OS);
     PrintCPUInfo(probe.CPU);
@@ -207,12 +386,471 @@ int Test() {
     PrintUptime(probe.Uptime);
     PrintSoundInfo(probe.Sound);
     PrintNetworkInterfaceInfo(probe.NetworkInterfaces);
+    PrintTCPStats(probe.TCPStats);
     PrintStorageDevicesInfo(probe.StorageDevices);
+    PrintVolumes(probe.Volumes);
     PrintCDROMInfo(probe.CDROMs);
+    PrintSensorInfo(probe.Sensors);
+    PrintInterruptInfo(probe.InterruptCounters, probe.InterruptAssignments);
+    PrintPCIDevices(probe.PCIDevices);
+    PrintJobLimits(probe.JobLimits);
+    PrintCollectorStats(Instrumentation::GetCollectorStats());
+    Report.Flush();
+
+    return 0;
+}
+
+// Collects everything and appends the serialized snapshot to a file, ready to be ingested with --fleet-ingest.
+int WriteSnapshot(const std::string& path) {
+    SysInfoProbe probe;
+    probe.InitializeWMIAPI();
+    if (auto r = probe.RetrieveAllData()) {
+        for (const auto& error : r.value())
+            std::wcerr << L"Warning: " << error.Format() << std::endl;
+    }
 
+    auto data = SerializeSnapshot(probe.TakeSnapshot());
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    if (!file) {
+        std::cerr << "Failed to write " << path << '\n';
+        return 1;
+    }
     return 0;
 }
 
-int main() {
+int IngestFile(FleetStore& store, const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<BYTE> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (auto r = store.IngestSerialized(data.data(), data.size())) {
+        std::wcerr << path.wstring() << L": " << r.value().Format() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Adds snapshot files, or every file in the given directories, to a fleet store (created if missing).
+int FleetIngest(const std::string& storePath, const std::vector<std::string>& inputs) {
+    FleetStore store;
+    if (std::filesystem::exists(storePath)) {
+        if (auto r = store.Load(storePath)) {
+            std::wcerr << r.value().Format() << std::endl;
+            return 1;
+        }
+    }
+
+    int failures = 0;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            for (const auto& entry : std::filesystem::directory_iterator(input)) {
+                if (entry.is_regular_file()) failures += IngestFile(store, entry.path());
+            }
+        }
+        else failures += IngestFile(store, input);
+    }
+
+    if (auto r = store.Save(storePath)) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+    std::cout << store.Hosts.RowCount() << " hosts, " << store.Modules.RowCount() << " memory modules in " << storePath << '\n';
+    return failures ? 1 : 0;
+}
+
+int FleetQuery(const std::string& storePath, const std::vector<std::string>& columns) {
+    FleetStore store;
+    std::vector<FLEETGROUP> groups;
+    auto r = store.Load(storePath);
+    if (!r) r = store.GroupByCount(columns, groups);
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+
+    for (const auto& column : columns)
+        std::cout << BOLD << column << RESET << '\t';
+    std::cout << BOLD << "Count" << RESET << '\n';
+    for (const auto& group : groups) {
+        for (const auto& value : group.Values)
+            std::cout << value << '\t';
+        std::cout << group.Count << '\n';
+    }
+    return 0;
+}
+
+// Reads the most recent snapshot of a file written by --snapshot.
+std::optional<Error> ReadLastSnapshot(const std::string& path, SYSINFOSNAPSHOT& snapshot) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<BYTE> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    size_t offset = 0;
+    do {
+        size_t consumed = 0;
+        if (auto r = DeserializeSnapshot(data.data() + offset, data.size() - offset, snapshot, &consumed))
+            return r;
+        offset += consumed;
+    } while (offset < data.size());
+    return std::nullopt;
+}
+
+int DiffSnapshotFiles(const std::string& oldPath, const std::string& newPath) {
+    SYSINFOSNAPSHOT oldSnapshot, newSnapshot;
+    auto r = ReadLastSnapshot(oldPath, oldSnapshot);
+    if (!r) r = ReadLastSnapshot(newPath, newSnapshot);
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+
+    std::vector<SNAPSHOTCHANGE> changes;
+    DiffSnapshots(oldSnapshot, newSnapshot, changes);
+    for (const auto& change : changes) {
+        std::cout << BOLD << change.SectionName << RESET;
+        if (!change.Key.empty()) std::cout << " [" << change.Key << ']';
+        if (change.Kind == CHANGE_ADDED) std::cout << " added\n";
+        else if (change.Kind == CHANGE_REMOVED) std::cout << " removed\n";
+        else std::cout << ' ' << change.Field << ": " << change.OldValue << " -> " << change.NewValue << '\n';
+    }
+    return changes.empty() ? 0 : 2;
+}
+
+// Packs what the scheduled samplers last refreshed into the fixed shared layout.
+LIVECOUNTERS CollectLiveCounters(const SysInfoProbe& probe, const GOVERNORINFO& governor) {
+    LIVECOUNTERS counters;
+    counters.SampledAt = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    counters.UptimeMilliseconds = Clock::SinceBoot() / (Clock::TicksPerSecond / 1000);
+    counters.CPUUtilization = probe.CPU.Utilization.CurrentUtilization;
+    counters.CPUClockSpeed = probe.CPU.Utilization.CurrentClockSpeed;
+    counters.TotalPhysicalMemory = probe.Memory.TotalPhysicalBytes;
+    counters.AvailablePhysicalMemory = probe.Memory.AvailablePhysicalBytes;
+
+    const auto& threads = probe.CPU.Utilization.ThreadsUtilization;
+    counters.ThreadCount = static_cast<DWORD>(std::min<size_t>(threads.size(), SharedLiveMaxThreads));
+    std::copy_n(threads.begin(), counters.ThreadCount, counters.ThreadsUtilization);
+
+    const auto& zones = probe.Sensors.ThermalZones;
+    counters.ThermalZoneCount = static_cast<DWORD>(std::min<size_t>(zones.size(), SharedLiveMaxSensors));
+    for (DWORD i = 0; i < counters.ThermalZoneCount; i++)
+        counters.TemperaturesCelsius[i] = zones[i].TemperatureCelsius;
+
+    const auto& domains = probe.Sensors.PowerDomains;
+    counters.PowerDomainCount = static_cast<DWORD>(std::min<size_t>(domains.size(), SharedLiveMaxSensors));
+    for (DWORD i = 0; i < counters.PowerDomainCount; i++)
+        counters.PowerWatts[i] = domains[i].PowerWatts;
+    counters.GovernorLevel = governor.Level;
+    return counters;
+}
+
+// Used by --daemon when no rules file is given.
+const char* DefaultAlertRules[] = {
+    "core > 95% for 10s",
+    "memory > 95% for 30s",
+    "volume.free < 5% clear 7 cooldown 10m",
+    "disk.busy > 95% for 30s",
+    "tcp.retransmits > 100 for 30s",
+};
+
+// One rule per line; empty lines and lines starting with '#' are skipped.
+std::optional<Error> LoadAlertRules(AlertEngine& engine, const std::string& path) {
+    const char* FuncName = "LoadAlertRules";
+    if (path.empty()) {
+        for (const char* rule : DefaultAlertRules) engine.AddRule(rule);
+        return std::nullopt;
+    }
+    std::ifstream file(path);
+    if (!file) return Error::New(FuncName, 1, L"Failed to open the alert rules file.");
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        if (auto r = engine.AddRule(line)) {
+            r.value().AddNewFunctionToStack(FuncName, 2);
+            r.value().Description += L" (line " + std::to_wstring(lineNumber) + L")";
+            return r;
+        }
+    }
+    return std::nullopt;
+}
+
+/*
+ * Collects once, then keeps the shared section current from the sampling scheduler: the probe samplers refresh
+ * live values, the counters are republished every second and the full snapshot every `snapshotSeconds`.
+ * The governor keeps the sampling thread under `budgetPercent` of one core, degrading the data if it has to.
+ * Alert rules from `alertRulesPath` (or the defaults) are checked every second and their transitions printed to stderr.
+ */
+int RunDaemon(int snapshotSeconds, double budgetPercent, const std::string& alertRulesPath) {
+    SysInfoProbe probe;
+    SharedSnapshotPublisher publisher;
+    OverheadGovernor governor(budgetPercent);
+    SamplingScheduler scheduler;
+    AlertEngine alerts;
+    auto r = LoadAlertRules(alerts, alertRulesPath);
+    if (!r) r = probe.InitializeWMIAPI();
+    if (!r) r = publisher.Create();
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+
+    // Samplers that are due together run in the order they were added: inventory first, publishing last.
+    scheduler.AddSampler("Snapshot", std::chrono::seconds(snapshotSeconds), std::chrono::seconds(snapshotSeconds), [&](UINT64& signature) {
+        probe.RetrieveAllData();
+        signature = 0;
+        SYSINFOSNAPSHOT snapshot = probe.TakeSnapshot();
+        snapshot.Governor = scheduler.GetGovernorStatus();
+        return publisher.PublishSnapshot(snapshot);
+    }, PRIORITY_LOW);
+    AddProbeSamplers(scheduler, probe);
+    DWORD lastLevel = 0;
+    scheduler.AddSampler("Publish", std::chrono::seconds(1), std::chrono::seconds(1), [&](UINT64& signature) {
+        GOVERNORINFO status = scheduler.GetGovernorStatus();
+        if (status.Level != lastLevel) {
+            std::cerr << "CPU usage " << status.UsagePercent << "% of a " << status.BudgetPercent << "% budget: degradation level "
+                << lastLevel << " -> " << status.Level << ", intervals x" << status.StretchFactor
+                << (status.bNormalPriorityShed ? ", normal and low priority samplers shed" : status.bLowPriorityShed ? ", low priority samplers shed" : "") << '\n';
+            lastLevel = status.Level;
+        }
+        publisher.PublishCounters(CollectLiveCounters(probe, status));
+        signature = 0;
+        return std::optional<Error>();
+    }, PRIORITY_CRITICAL);
+    std::vector<ALERTEVENT> events;
+    scheduler.AddSampler("Alerts", std::chrono::seconds(1), std::chrono::seconds(1), [&](UINT64& signature) {
+        events.clear();
+        alerts.Evaluate(probe, events);
+        for (const auto& event : events) std::cerr << alerts.Describe(event, probe) << '\n';
+        signature = 0;
+        return std::optional<Error>();
+    }, PRIORITY_CRITICAL);
+    scheduler.SetGovernor(&governor);
+
+    r = scheduler.Run();
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+int ReadShared() {
+    SharedSnapshotReader reader;
+    SYSINFOSNAPSHOT snapshot;
+    LIVECOUNTERS counters;
+    auto r = reader.Open();
+    if (!r) r = reader.ReadSnapshot(snapshot);
+    if (!r) r = reader.ReadCounters(counters);
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+
+    FixedText<256> title;
+    title.Text("SHARED SNAPSHOT: ").Text(snapshot.Host.HostName);
+    PrintSectionTitle(title.View());
+    Field("CPU:").Text(snapshot.CPU.Name).EndLine();
+    Field("OS:").Text(snapshot.OS.Name).Char(' ').Text(snapshot.OS.Version).EndLine();
+    Field("CPU Utilization:").Fixed(counters.CPUUtilization, 1).Text(" %").EndLine();
+    Field("Available Memory:").Unsigned(counters.AvailablePhysicalMemory / (1024 * 1024)).Text(" MB").EndLine();
+    Field("Uptime:").Unsigned(counters.UptimeMilliseconds / 1000).Text(" s").EndLine();
+    Report.Flush();
+    return 0;
+}
+
+// Signalled by Ctrl+C and Ctrl+Break while --watch runs.
+HANDLE hWatchStopEvent = NULL;
+
+BOOL WINAPI WatchCtrlHandler(DWORD ctrlType) {
+    if (ctrlType != CTRL_C_EVENT && ctrlType != CTRL_BREAK_EVENT) return FALSE;
+    SetEvent(hWatchStopEvent);
+    return TRUE;
+}
+
+std::string FormatBytes(double bytes) {
+    FixedText<32> text;
+    return text.Bytes(bytes).String();
+}
+
+BYTE UtilizationStyle(double percent) {
+    return percent >= 85 ? STYLE_RED : percent >= 50 ? STYLE_YELLOW : STYLE_GREEN;
+}
+
+// Draws `percent` of `width` cells as a bar; returns the column after it.
+int DrawBar(TerminalScreen& screen, int x, int y, int width, double percent) {
+    int filled = static_cast<int>(std::clamp(percent, 0.0, 100.0) * width / 100 + 0.5);
+    screen.Put(x, y, "[");
+    screen.Fill(x + 1, y, filled, '|', UtilizationStyle(percent));
+    screen.Put(x + 1 + width, y, "]");
+    return x + width + 2;
+}
+
+// One frame of --watch: a summary line, one cell per logical processor, then the network and disk tables as far as they fit.
+void DrawWatchFrame(TerminalScreen& screen, const SYSINFOSNAPSHOT& snapshot, int intervalSeconds) {
+    char line[256];
+    const int width = screen.Width();
+    int y = 0;
+
+    const UINT64 uptime = Clock::SinceBoot() / Clock::TicksPerSecond;
+    snprintf(line, sizeof(line), " %s | up %llud %02llu:%02llu:%02llu | every %d s | Ctrl+C to quit", snapshot.CPU.Name.c_str(),
+        uptime / 86400, uptime / 3600 % 24, uptime / 60 % 60, uptime % 60, intervalSeconds);
+    screen.Fill(0, y, width, ' ', STYLE_INVERSE);
+    screen.Put(0, y++, line, STYLE_INVERSE);
+    y++;
+
+    const CPUUTILIZATION& utilization = snapshot.CPU.Utilization;
+    const SCHEDULERPRESSUREINFO& pressure = snapshot.CPU.Pressure;
+    int x = screen.Put(0, y, "CPU ", STYLE_BOLD | STYLE_CYAN);
+    x = DrawBar(screen, x, y, 20, utilization.CurrentUtilization);
+    snprintf(line, sizeof(line), " %5.1f%%  load %.2f %.2f %.2f  running %lu  ready %lu  procs %lu", utilization.CurrentUtilization,
+        pressure.LoadAverage1, pressure.LoadAverage5, pressure.LoadAverage15, pressure.RunningThreads, pressure.ReadyThreads, pressure.ProcessCount);
+    screen.Put(x, y++, line);
+
+    const MEMORYUSAGEINFO& memory = snapshot.Memory;
+    double usedPercent = memory.TotalPhysicalBytes ? 100.0 * (memory.TotalPhysicalBytes - memory.AvailablePhysicalBytes) / memory.TotalPhysicalBytes : 0.0;
+    x = screen.Put(0, y, "Mem ", STYLE_BOLD | STYLE_CYAN);
+    x = DrawBar(screen, x, y, 20, usedPercent);
+    snprintf(line, sizeof(line), " %5.1f%%  %s / %s  commit %s / %s", usedPercent, FormatBytes(static_cast<double>(memory.TotalPhysicalBytes - memory.AvailablePhysicalBytes)).c_str(),
+        FormatBytes(static_cast<double>(memory.TotalPhysicalBytes)).c_str(), FormatBytes(static_cast<double>(memory.TotalCommitBytes - memory.AvailableCommitBytes)).c_str(),
+        FormatBytes(static_cast<double>(memory.TotalCommitBytes)).c_str());
+    screen.Put(x, y++, line);
+    y++;
+
+    // "NNNN xxx% " per processor, as many per row as fit; 256 processors take 13 rows of a 200 column terminal.
+    const int cellWidth = 10;
+    const int perRow = std::max(width / cellWidth, 1);
+    const auto& threads = utilization.ThreadsUtilization;
+    for (size_t i = 0; i < threads.size(); i++) {
+        int cellY = y + static_cast<int>(i / perRow);
+        int cellX = static_cast<int>(i % perRow) * cellWidth;
+        snprintf(line, sizeof(line), "%4zu", i);
+        screen.Put(cellX, cellY, line, STYLE_BLUE);
+        snprintf(line, sizeof(line), "%4.0f%%", threads[i]);
+        screen.Put(cellX + 4, cellY, line, UtilizationStyle(threads[i]));
+    }
+    y += static_cast<int>((threads.size() + perRow - 1) / perRow) + 1;
+
+    snprintf(line, sizeof(line), "%-32s %12s %12s", "Interface", "Receive", "Send");
+    screen.Fill(0, y, width, ' ', STYLE_BOLD);
+    screen.Put(0, y++, line, STYLE_BOLD);
+    for (const auto& counters : snapshot.NetworkCounters) {
+        std::string name = "#" + std::to_string(counters.InterfaceIndex);
+        for (const auto& network : snapshot.NetworkInterfaces)
+            if (network.InterfaceIndex == counters.InterfaceIndex) name = network.Name;
+        snprintf(line, sizeof(line), "%-32.32s %10s/s %10s/s", name.c_str(), FormatBytes(counters.ReceiveBytesPerSecond).c_str(), FormatBytes(counters.SendBytesPerSecond).c_str());
+        screen.Put(0, y++, line);
+    }
+    y++;
+
+    snprintf(line, sizeof(line), "%-32s %12s %12s %6s %6s", "Disk", "Read", "Write", "Busy", "Queue");
+    screen.Fill(0, y, width, ' ', STYLE_BOLD);
+    screen.Put(0, y++, line, STYLE_BOLD);
+    for (const auto& counters : snapshot.DiskCounters) {
+        snprintf(line, sizeof(line), "PhysicalDrive%-19lu %10s/s %10s/s ", counters.DeviceNumber, FormatBytes(counters.ReadBytesPerSecond).c_str(),
+            FormatBytes(counters.WriteBytesPerSecond).c_str());
+        x = screen.Put(0, y, line);
+        snprintf(line, sizeof(line), "%5.1f%%", counters.BusyPercent);
+        x = screen.Put(x, y, line, UtilizationStyle(counters.BusyPercent));
+        snprintf(line, sizeof(line), " %6lu", counters.QueueDepth);
+        screen.Put(x, y++, line);
+    }
+}
+
+/*
+ * Full-screen live view redrawn every `intervalSeconds`. The probe samplers refresh the values on the scheduler thread,
+ * and the probe publishes a snapshot after each wakeup; the calling thread draws from the latest snapshot,
+ * so a slow sampler never delays a frame. Only the cells that changed since the previous frame are written to the terminal.
+ */
+int RunWatch(int intervalSeconds) {
+    SysInfoProbe probe;
+    TerminalScreen screen;
+    SamplingScheduler scheduler;
+    auto r = probe.InitializeWMIAPI();
+    // Names for the panels; the counters themselves come from the samplers.
+    if (!r) r = probe.GetCpuInfo();
+    if (!r) r = probe.GetNetworkInterfacesInfo();
+    if (!r) r = probe.RefreshFreeRAM();
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+
+    hWatchStopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!hWatchStopEvent || !SetConsoleCtrlHandler(WatchCtrlHandler, TRUE)) {
+        std::cerr << "Failed to install the Ctrl+C handler: " << GetLastError() << '\n';
+        return 1;
+    }
+    r = screen.Open();
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+
+    AddProbeSamplers(scheduler, probe);
+    probe.PublishSnapshot();
+
+    LocalSnapshotReader reader;
+    r = reader.Open(probe.Publisher());
+    if (!r) r = scheduler.Start();
+    while (!r && WaitForSingleObject(hWatchStopEvent, intervalSeconds * 1000) == WAIT_TIMEOUT) {
+        const SYSINFOSNAPSHOT* snapshot = reader.BeginRead();
+        if (snapshot) {
+            screen.BeginFrame();
+            DrawWatchFrame(screen, *snapshot, intervalSeconds);
+            r = screen.Present();
+        }
+        reader.EndRead();
+    }
+    auto stopError = scheduler.Stop();
+    if (!r) r = stopError;
+    reader.Close();
+    screen.Close();
+    SetConsoleCtrlHandler(WatchCtrlHandler, FALSE);
+    CloseHandle(hWatchStopEvent);
+    if (r) {
+        std::wcerr << r.value().Format() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Converts pci.ids into the index that the PCI collector looks for next to the executable.
+int BuildPCIIndex(const std::string& sourcePath, const std::string& indexPath) {
+    auto r = PCIIdsIndex::Build(sourcePath, indexPath);
+    if (r) {
+        std::wcerr << L"Error building the PCI ID index: " << r.value().Format() << std::endl;
+        return 1;
+    }
+    PCIIdsIndex index;
+    r = index.Open(indexPath);
+    if (r) {
+        std::wcerr << L"Error reading back the PCI ID index: " << r.value().Format() << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << std::filesystem::file_size(indexPath) << " bytes to " << indexPath << '\n';
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if (args.size() == 2 && args[0] == "--snapshot")
+        return WriteSnapshot(args[1]);
+    if (args.size() >= 3 && args[0] == "--fleet-ingest")
+        return FleetIngest(args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+    if (args.size() >= 3 && args[0] == "--fleet-query")
+        return FleetQuery(args[1], std::vector<std::string>(args.begin() + 2, args.end()));
+    if (args.size() == 3 && args[0] == "--diff")
+        return DiffSnapshotFiles(args[1], args[2]);
+    if (!args.empty() && args.size() <= 4 && args[0] == "--daemon")
+        return RunDaemon(args.size() >= 2 ? std::max(std::atoi(args[1].c_str()), 1) : 60, args.size() >= 3 ? std::atof(args[2].c_str()) : 0.5,
+            args.size() == 4 ? args[3] : std::string());
+    if (args.size() == 1 && args[0] == "--read-shared")
+        return ReadShared();
+    if (!args.empty() && args.size() <= 2 && args[0] == "--watch")
+        return RunWatch(args.size() == 2 ? std::max(std::atoi(args[1].c_str()), 1) : 1);
+    if (args.size() == 3 && args[0] == "--build-pci-index")
+        return BuildPCIIndex(args[1], args[2]);
+    if (!args.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--snapshot <file> | --fleet-ingest <store> <file|dir>... | --fleet-query <store> <column>... | --diff <old> <new> | --daemon [snapshot seconds] [CPU budget %] [alert rules file] | --read-shared | --watch [interval seconds] | --build-pci-index <pci.ids> <index>]\n";
+        return 1;
+    }
+
     return Test();
 }
@@ -0,0 +1,226 @@
+#include "AlertEngine.hpp"
+#include "SysInfoProbe.hpp"
+#include <charconv>
+
+static constexpr const char* MetricNames[METRIC_COUNT] = {
+	"cpu", "core", "memory", "commit", "runqueue", "volume.free", "disk.busy", "tcp.retransmits", "temperature"
+};
+
+// Splits at spaces; an operator or a '%' attached to the previous token, as in "core>95%", is split off as well.
+static std::vector<std::string_view> Tokenize(std::string_view Text) {
+	std::vector<std::string_view> Tokens;
+	size_t Start = 0;
+	for (size_t i = 0; i <= Text.size(); i++) {
+		char c = i < Text.size() ? Text[i] : ' ';
+		bool bSeparator = c == ' ' || c == '\t' || c == '<' || c == '>' || c == '%';
+		if (!bSeparator) continue;
+		if (i > Start) Tokens.push_back(Text.substr(Start, i - Start));
+		if (c == '<' || c == '>') Tokens.push_back(Text.substr(i, 1));
+		Start = i + 1;
+	}
+	return Tokens;
+}
+
+static bool ParseNumber(std::string_view Token, double& Value) {
+	auto [End, Code] = std::from_chars(Token.data(), Token.data() + Token.size(), Value);
+	return Code == std::errc() && End == Token.data() + Token.size();
+}
+
+// "250ms", "10s", "5m" or "1h"; a bare number is in seconds.
+static bool ParseDuration(std::string_view Token, UINT64& Milliseconds) {
+	double Scale = 1000.0;
+	if (Token.ends_with("ms")) { Scale = 1.0; Token.remove_suffix(2); }
+	else if (Token.ends_with("s")) { Token.remove_suffix(1); }
+	else if (Token.ends_with("m")) { Scale = 60000.0; Token.remove_suffix(1); }
+	else if (Token.ends_with("h")) { Scale = 3600000.0; Token.remove_suffix(1); }
+	double Value = 0.0;
+	if (!ParseNumber(Token, Value) || Value < 0) return false;
+	Milliseconds = static_cast<UINT64>(Value * Scale);
+	return true;
+}
+
+std::optional<Error> AlertEngine::ParseRule(std::string_view Text, ALERTRULE& Rule) {
+	const char* FuncName = "AlertEngine::ParseRule";
+	std::vector<std::string_view> Tokens = Tokenize(Text);
+	if (Tokens.size() < 3) return Error::New(FuncName, 1, L"Expected '<metric> <operator> <threshold>'.");
+
+	Rule = ALERTRULE();
+	Rule.Name = std::string(Text);
+	auto Metric = std::find(std::begin(MetricNames), std::end(MetricNames), Tokens[0]);
+	if (Metric == std::end(MetricNames)) return Error::New(FuncName, 2, L"Unknown metric.");
+	Rule.Metric = static_cast<ALERT_METRIC>(Metric - std::begin(MetricNames));
+	if (Tokens[1] != ">" && Tokens[1] != "<") return Error::New(FuncName, 3, L"Expected '>' or '<' after the metric.");
+	Rule.bAbove = Tokens[1] == ">";
+	if (!ParseNumber(Tokens[2], Rule.Threshold)) return Error::New(FuncName, 4, L"Invalid threshold.");
+	Rule.ClearThreshold = Rule.Threshold - (Rule.bAbove ? 0.05 : -0.05) * std::abs(Rule.Threshold);
+
+	for (size_t i = 3; i < Tokens.size(); i += 2) {
+		if (i + 1 >= Tokens.size()) return Error::New(FuncName, 5, L"Missing value after a keyword.");
+		bool bValid = false;
+		if (Tokens[i] == "for") bValid = ParseDuration(Tokens[i + 1], Rule.SustainMilliseconds);
+		else if (Tokens[i] == "cooldown") bValid = ParseDuration(Tokens[i + 1], Rule.CooldownMilliseconds);
+		else if (Tokens[i] == "clear") bValid = ParseNumber(Tokens[i + 1], Rule.ClearThreshold);
+		else return Error::New(FuncName, 6, L"Unknown keyword; expected 'for', 'clear' or 'cooldown'.");
+		if (!bValid) return Error::New(FuncName, 7, L"Invalid value after a keyword.");
+	}
+	if (Rule.bAbove ? Rule.ClearThreshold > Rule.Threshold : Rule.ClearThreshold < Rule.Threshold) {
+		return Error::New(FuncName, 8, L"The clear value must be on the other side of the threshold.");
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> AlertEngine::AddRule(std::string_view Text) {
+	const char* FuncName = "AlertEngine::AddRule";
+	ALERTRULE Rule;
+	auto r = ParseRule(Text, Rule);
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 1);
+		return r;
+	}
+	AddRule(Rule);
+	return std::nullopt;
+}
+
+void AlertEngine::AddRule(const ALERTRULE& Rule) {
+	Rules.push_back(Rule);
+	bCompiled = FALSE;
+}
+
+void AlertEngine::_Compile() {
+	// Recompiling forgets the state of every element, so rules are expected to be added before the first evaluation.
+	Plan.clear();
+	for (size_t i = 0; i < Rules.size(); i++) {
+		const ALERTRULE& Rule = Rules[i];
+		_STEP Step;
+		Step.Metric = Rule.Metric;
+		Step.RuleIndex = static_cast<WORD>(i);
+		Step.Sign = Rule.bAbove ? 1.0 : -1.0;
+		Step.Threshold = Step.Sign * Rule.Threshold;
+		Step.ClearThreshold = Step.Sign * Rule.ClearThreshold;
+		Step.SustainTicks = Rule.SustainMilliseconds * (Clock::TicksPerSecond / 1000);
+		Step.CooldownTicks = Rule.CooldownMilliseconds * (Clock::TicksPerSecond / 1000);
+		Plan.push_back(std::move(Step));
+	}
+	std::stable_sort(Plan.begin(), Plan.end(), [](const _STEP& a, const _STEP& b) { return a.Metric < b.Metric; });
+	bCompiled = TRUE;
+}
+
+void AlertEngine::_Gather(ALERT_METRIC Metric, const SysInfoProbe& Probe) {
+	Values.clear();
+	const MEMORYUSAGEINFO& Memory = Probe.Memory;
+	switch (Metric) {
+	case METRIC_CPU_UTILIZATION:
+		Values.push_back(Probe.CPU.Utilization.CurrentUtilization);
+		break;
+	case METRIC_CORE_UTILIZATION:
+		Values.assign(Probe.CPU.Utilization.ThreadsUtilization.begin(), Probe.CPU.Utilization.ThreadsUtilization.end());
+		break;
+	case METRIC_MEMORY_USED:
+		// Nothing to report before the first memory sample.
+		if (Memory.TotalPhysicalBytes) Values.push_back(100.0 * (Memory.TotalPhysicalBytes - Memory.AvailablePhysicalBytes) / Memory.TotalPhysicalBytes);
+		break;
+	case METRIC_COMMIT_USED:
+		if (Memory.TotalCommitBytes) Values.push_back(100.0 * (Memory.TotalCommitBytes - Memory.AvailableCommitBytes) / Memory.TotalCommitBytes);
+		break;
+	case METRIC_RUN_QUEUE:
+		Values.push_back(Probe.CPU.Pressure.ReadyThreads);
+		break;
+	case METRIC_VOLUME_FREE:
+		for (const auto& Volume : Probe.Volumes) Values.push_back(Volume.FreePercent);
+		break;
+	case METRIC_DISK_BUSY:
+		for (const auto& Counters : Probe.DiskCounters) Values.push_back(Counters.BusyPercent);
+		break;
+	case METRIC_TCP_RETRANSMITS:
+		Values.push_back(Probe.TCPStats.RetransmitsPerSecond);
+		break;
+	case METRIC_TEMPERATURE:
+		for (const auto& Zone : Probe.Sensors.ThermalZones) Values.push_back(Zone.TemperatureCelsius);
+		break;
+	default:
+		break;
+	}
+}
+
+size_t AlertEngine::Evaluate(const SysInfoProbe& Probe, std::vector<ALERTEVENT>& Events) {
+	if (!bCompiled) _Compile();
+	const size_t FirstEvent = Events.size();
+	const UINT64 Now = Clock::Monotonic();
+	const INT64 Timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+
+	ALERT_METRIC Gathered = METRIC_COUNT;
+	for (_STEP& Step : Plan) {
+		if (Step.Metric != Gathered) {
+			_Gather(Step.Metric, Probe);
+			Gathered = Step.Metric;
+		}
+		const size_t Count = Values.size();
+		// Elements are identified by position, so a volume or disk appearing or vanishing starts every element over.
+		if (Step.States.size() != Count) Step.States.assign(Count, _ELEMENTSTATE());
+
+		Breached.resize(Count);
+		Cleared.resize(Count);
+		const double* pValues = Values.data();
+		BYTE* pBreached = Breached.data();
+		BYTE* pCleared = Cleared.data();
+		const double Sign = Step.Sign, Threshold = Step.Threshold, ClearThreshold = Step.ClearThreshold;
+		for (size_t i = 0; i < Count; i++) pBreached[i] = Sign * pValues[i] > Threshold;
+		for (size_t i = 0; i < Count; i++) pCleared[i] = Sign * pValues[i] <= ClearThreshold;
+
+		for (size_t i = 0; i < Count; i++) {
+			_ELEMENTSTATE& State = Step.States[i];
+			if (!pBreached[i] && !State.bFiring && !State.BreachedSince) continue;
+
+			ALERTEVENT Event;
+			Event.Timestamp = Timestamp;
+			Event.Value = static_cast<float>(pValues[i]);
+			Event.RuleIndex = Step.RuleIndex;
+			Event.Element = static_cast<WORD>(i);
+			if (State.bFiring) {
+				if (!pCleared[i]) continue;
+				State.bFiring = FALSE;
+				State.BreachedSince = 0;
+				Event.Kind = ALERT_CLEARED;
+				Events.push_back(Event);
+			}
+			else if (!pBreached[i]) {
+				State.BreachedSince = 0;
+			}
+			else {
+				if (!State.BreachedSince) State.BreachedSince = Now;
+				bool bSustained = Now - State.BreachedSince >= Step.SustainTicks;
+				bool bCooledDown = !State.LastFired || Now - State.LastFired >= Step.CooldownTicks;
+				if (!bSustained || !bCooledDown) continue;
+				State.bFiring = TRUE;
+				State.LastFired = Now;
+				Event.Kind = ALERT_FIRED;
+				Events.push_back(Event);
+			}
+		}
+	}
+	return Events.size() - FirstEvent;
+}
+
+std::string AlertEngine::Describe(const ALERTEVENT& Event, const SysInfoProbe& Probe) const {
+	if (Event.RuleIndex >= Rules.size()) return std::string();
+	const ALERTRULE& Rule = Rules[Event.RuleIndex];
+	std::string Element;
+	switch (Rule.Metric) {
+	case METRIC_CORE_UTILIZATION:
+		Element = std::format("processor {}", Event.Element);
+		break;
+	case METRIC_VOLUME_FREE:
+		Element = Event.Element < Probe.Volumes.size() ? Probe.Volumes[Event.Element].RootPath : std::format("volume {}", Event.Element);
+		break;
+	case METRIC_DISK_BUSY:
+		Element = Event.Element < Probe.DiskCounters.size() ? std::format("PhysicalDrive{}", Probe.DiskCounters[Event.Element].DeviceNumber) : std::format("disk {}", Event.Element);
+		break;
+	case METRIC_TEMPERATURE:
+		Element = Event.Element < Probe.Sensors.ThermalZones.size() ? Probe.Sensors.ThermalZones[Event.Element].Name : std::format("zone {}", Event.Element);
+		break;
+	default:
+		Element = "host";
+		break;
+	}
+	return std::format("{} {}: {} at {:.1f}", Event.Kind == ALERT_FIRED ? "FIRED" : "CLEARED", Rule.Name, Element, Event.Value);
+}
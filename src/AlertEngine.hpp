@@ -0,0 +1,102 @@
+/* Info: Threshold rules over the sampled values, with a sustain time, hysteresis and a cooldown, evaluated inside the probe after each sample. */
+#pragma once
+#include "Errors.hpp"		// For error handling
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SysInfoProbe;
+
+// Values a rule can watch. Per-element metrics are evaluated separately for every processor, volume, disk or zone.
+enum ALERT_METRIC : BYTE {
+	METRIC_CPU_UTILIZATION = 0,		// "cpu": percent, whole machine.
+	METRIC_CORE_UTILIZATION,		// "core": percent, per logical processor.
+	METRIC_MEMORY_USED,				// "memory": percent of physical memory in use.
+	METRIC_COMMIT_USED,				// "commit": percent of the commit limit in use.
+	METRIC_RUN_QUEUE,				// "runqueue": threads ready to run without a processor.
+	METRIC_VOLUME_FREE,				// "volume.free": percent, per fixed volume.
+	METRIC_DISK_BUSY,				// "disk.busy": percent, per physical drive.
+	METRIC_TCP_RETRANSMITS,			// "tcp.retransmits": segments per second.
+	METRIC_TEMPERATURE,				// "temperature": degrees Celsius, per thermal zone.
+	METRIC_COUNT
+};
+
+/*
+ * Written as "<metric> <'>'|'<'> <threshold>[%] [for <time>] [clear <value>] [cooldown <time>]", with times such
+ * as "500ms", "10s" or "5m", e.g. "core > 95% for 10s" or "volume.free < 5 clear 10 cooldown 1h".
+ */
+typedef struct _tag_ALERTRULE {
+	std::string Name;				// The rule text when parsed.
+	ALERT_METRIC Metric = METRIC_CPU_UTILIZATION;
+	BOOL bAbove = TRUE;				// Breached above Threshold, or below it.
+	double Threshold = 0.0;
+	// An element fires once it has been in breach this long; zero fires on the first breaching sample.
+	UINT64 SustainMilliseconds = 0;
+	// A firing element clears only once its value is back past this, so that values hovering at the threshold do not flap.
+	// Defaults to 5% of the threshold on the safe side of it.
+	double ClearThreshold = 0.0;
+	// Minimum time between two firings of the same element.
+	UINT64 CooldownMilliseconds = 0;
+} ALERTRULE, *PALERTRULE;
+
+enum ALERT_EVENT_KIND : BYTE {
+	ALERT_FIRED = 0,
+	ALERT_CLEARED
+};
+
+// Fixed-size record of one transition; AlertEngine::Describe turns it into text.
+typedef struct _tag_ALERTEVENT {
+	INT64 Timestamp = 0;			// Unix time in milliseconds.
+	float Value = 0.0f;				// The value that caused the transition.
+	WORD RuleIndex = 0;
+	WORD Element = 0;				// Index in the metric's array; zero for whole-machine metrics.
+	ALERT_EVENT_KIND Kind = ALERT_FIRED;
+} ALERTEVENT, *PALERTEVENT;
+
+/*
+ * Rules are compiled into a plan ordered by metric, so that each metric is gathered into one contiguous array per
+ * evaluation however many rules watch it. Every step then compares the whole array against its thresholds in
+ * branch-free passes and only walks the per-element state where a value is in breach or an alert is active.
+ */
+class AlertEngine {
+public:
+	static std::optional<Error> ParseRule(std::string_view Text, ALERTRULE& Rule);
+
+	std::optional<Error> AddRule(std::string_view Text);
+	void AddRule(const ALERTRULE& Rule);
+	const std::vector<ALERTRULE>& GetRules() const { return Rules; }
+
+	// Checks every rule against the latest values of the probe and appends the transitions to Events. Returns how many it appended.
+	size_t Evaluate(const SysInfoProbe& Probe, std::vector<ALERTEVENT>& Events);
+	// e.g. "FIRED core > 95% for 10s: processor 17 at 97.3".
+	std::string Describe(const ALERTEVENT& Event, const SysInfoProbe& Probe) const;
+
+private:
+	struct _ELEMENTSTATE {
+		UINT64 BreachedSince = 0;	// Clock::Monotonic of the first sample of the current breach; zero when not in breach.
+		UINT64 LastFired = 0;		// Clock::Monotonic.
+		BOOL bFiring = FALSE;
+	};
+	struct _STEP {
+		ALERT_METRIC Metric = METRIC_CPU_UTILIZATION;
+		WORD RuleIndex = 0;
+		// Negated for rules that fire below the threshold, so that every step compares with '>'.
+		double Threshold = 0.0;
+		double ClearThreshold = 0.0;
+		double Sign = 1.0;
+		UINT64 SustainTicks = 0;	// Clock::TicksPerSecond units.
+		UINT64 CooldownTicks = 0;
+		std::vector<_ELEMENTSTATE> States;
+	};
+	std::vector<ALERTRULE> Rules;
+	std::vector<_STEP> Plan;
+	BOOL bCompiled = FALSE;
+	// Kept between evaluations so that they do not allocate.
+	std::vector<double> Values;		// The metric being evaluated, one entry per element.
+	std::vector<BYTE> Breached;
+	std::vector<BYTE> Cleared;
+
+	void _Compile();
+	void _Gather(ALERT_METRIC Metric, const SysInfoProbe& Probe);
+};
@@ -0,0 +1,37 @@
+/* Info: Counting replacement of the global allocation functions, for programs that want per-collector allocation counts. */
+#pragma once
+#include "Instrumentation.hpp"	// For CountAllocation
+#include <cstdlib>
+#include <new>
+
+/*
+ * Opt-in: a program defines SYSINFO_ALLOCATION_HOOK before including this header, in exactly one of its source files.
+ * Without it the global operator new stays the program's own and allocation counts stay at zero.
+ */
+#ifdef SYSINFO_ALLOCATION_HOOK
+void* operator new(size_t Size) {
+	Instrumentation::CountAllocation(Size);
+	if (void* p = malloc(Size ? Size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void* operator new[](size_t Size) {
+	return operator new(Size);
+}
+
+void operator delete(void* p) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p) noexcept {
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+	free(p);
+}
+#endif
@@ -1,6 +1,9 @@
 #include "SysInfoProbe.hpp"
+#include <PowerBase.h>		// For GetPwrCapabilities function
+#pragma comment(lib, "PowrProf.lib")	// Required to use PowerBase.h
 
 std::optional<Error> SysInfoProbe::GetComputerType() {
+    INSTRUMENT_COLLECTOR("SysInfoProbe::GetComputerType");
     SYSTEM_POWER_CAPABILITIES SystemPowerCapabilities;
     ZeroMemory(&SystemPowerCapabilities, sizeof(SystemPowerCapabilities));
     if (GetPwrCapabilities(&SystemPowerCapabilities) == 0)
@@ -10,63 +13,43 @@ std::optional<Error> SysInfoProbe::GetComputerType() {
     return std::nullopt;
 }
 
-std::optional<Error> SysInfoProbe::GetBIOSInfo() {
-	const char* FuncName = "SysInfoProbe::GetBIOSInfo";
-	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
+std::optional<Error> SysInfoProbe::_LoadSMBIOS() {
+	const char* FuncName = "SysInfoProbe::_LoadSMBIOS";
+	if (bSMBIOSLoaded) return std::nullopt;
+
+	// 'RSMB' returns the whole structure table prefixed with a RAWSMBIOSDATA header.
+	const DWORD Provider = 'RSMB';
+	UINT uSize = GetSystemFirmwareTable(Provider, 0, NULL, 0);
+	if (uSize == 0) {
+		return Error::New(FuncName, 1, L"Failed to get SMBIOS table size.", GetLastError());
+	}
 
-	const std::vector<LPCWSTR> Attributes = {
-		L"Manufacturer",
-		L"Version",
-		L"BuildNumber",
-		L"SerialNumber"
-	};
-	bstr_t WQLQuery = WMIMgr.BuildWQLQueryString(L"Win32_BIOS", Attributes);
+	std::vector<BYTE> Buffer(uSize);
+	if (GetSystemFirmwareTable(Provider, 0, Buffer.data(), uSize) != uSize) {
+		return Error::New(FuncName, 2, L"Failed to read SMBIOS table.", GetLastError());
+	}
+	Instrumentation::CountSystemCall(2);
+	Instrumentation::CountBytesRead(uSize);
 
-	auto r = WMIMgr.ExecuteWQLQuery(WQLQuery);
+	auto r = ParseRawSMBIOSData(Buffer.data(), Buffer.size(), SMBIOS);
 	if (r) {
-		r.value().AddNewFunctionToStack(FuncName, 2);
+		r.value().AddNewFunctionToStack(FuncName, 3);
 		return r;
 	}
 
-	auto [pLocator, pServices, pEnumerator] = WMIMgr.GetData();
-	IWbemClassObject* pClassObject = NULL;
-	ULONG uReturn = 0;
-	VARIANT vtProp = { 0 };
-
-	DEFER{
-		VariantClear(&vtProp);
-		if (pClassObject) pClassObject->Release();
-	};
-
-	while (pEnumerator) {
-		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
-		if (FAILED(hr)) {
-			return Error::New(FuncName, 3, L"Failed to fetch next WMI object.", hr);
-		}
-		if (uReturn == 0) break;
-		VariantInit(&vtProp);
-
-		hr = pClassObject->Get(L"Manufacturer", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 4, L"Failed to get BIOS manufacturer.", hr);
-		}
-		BIOS.Manufacturer = w2s(vtProp.bstrVal);
-
-		hr = pClassObject->Get(L"Version", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 5, L"Failed to get BIOS version.", hr);
-		}
-		BIOS.Version = w2s(vtProp.bstrVal);
-
-		/* TODO: fill bios actual version. e.g: f2, f62 etc. */
-		/* attempted to get it directly from WMI, but it fails as always. vtProp sets itself to NULL. */
+	bSMBIOSLoaded = TRUE;
+	return std::nullopt;
+}
 
-		hr = pClassObject->Get(L"SerialNumber", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 6, L"Failed to get BIOS serial number.", hr);
-		}
-		BIOS.SerialNumber = w2s(vtProp.bstrVal);
+std::optional<Error> SysInfoProbe::GetBIOSInfo() {
+	const char* FuncName = "SysInfoProbe::GetBIOSInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
+	auto r = _LoadSMBIOS();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 1);
+		return r;
 	}
 
+	BIOS = SMBIOS.BIOS;
 	return std::nullopt;
 }
\ No newline at end of file
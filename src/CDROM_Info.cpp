@@ -2,6 +2,7 @@
 
 std::optional<Error> SysInfoProbe::GetCDROMInfo() {
 	const char* FuncName = "SysInfoProbe::GetCDROMInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
 	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
 	const std::vector<LPCWSTR> Attributes = {
 		L"Caption"
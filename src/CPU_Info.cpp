@@ -2,8 +2,10 @@
 
 std::optional<Error> SysInfoProbe::RefreshCPUUtilizations() {
 	const char* FuncName = "SysInfoProbe::RefreshCPUUtilizations";
+	INSTRUMENT_COLLECTOR(FuncName);
 	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
 	const std::vector<LPCWSTR> Attributes = {
+		L"Name",
 		L"PercentProcessorPerformance",
 		L"PercentProcessorUtility",
 	};
@@ -24,6 +26,10 @@ std::optional<Error> SysInfoProbe::RefreshCPUUtilizations() {
 		if (pClassObject) pClassObject->Release();
 	};
 
+	// Instances are "_Total", "<group>,_Total" and "<group>,<number>" per logical processor, in no particular order.
+	struct ThreadSample { int Group; int Number; double Utilization; int64_t ClockSpeed; };
+	std::vector<ThreadSample> Threads;
+
 	while (pEnumerator) {
 		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
 		if (FAILED(hr)) {
@@ -31,10 +37,125 @@ std::optional<Error> SysInfoProbe::RefreshCPUUtilizations() {
 		}
 		if (uReturn == 0) break;
 		VariantInit(&vtProp);
-		
+
+		hr = pClassObject->Get(L"Name", 0, &vtProp, 0, 0);
+		if (FAILED(hr)) {
+			return Error::New(FuncName, 4, L"Failed to get Name property.", hr);
+		}
+		std::wstring Name = (vtProp.vt == VT_BSTR && vtProp.bstrVal != NULL) ? vtProp.bstrVal : L"";
+		VariantClear(&vtProp);
+
+		// Both counters are uint64 properties, which WMI returns as strings; a row where either does not parse is skipped.
+		UINT64 Utility = 0, Performance = 0;
+		hr = pClassObject->Get(L"PercentProcessorUtility", 0, &vtProp, 0, 0);
+		if (FAILED(hr)) {
+			return Error::New(FuncName, 5, L"Failed to get PercentProcessorUtility property.", hr);
+		}
+		bool bParsed = vtProp.vt == VT_BSTR && parse_unsigned(vtProp.bstrVal, Utility);
+		VariantClear(&vtProp);
+
+		hr = pClassObject->Get(L"PercentProcessorPerformance", 0, &vtProp, 0, 0);
+		if (FAILED(hr)) {
+			return Error::New(FuncName, 6, L"Failed to get PercentProcessorPerformance property.", hr);
+		}
+		bParsed = bParsed && vtProp.vt == VT_BSTR && parse_unsigned(vtProp.bstrVal, Performance);
+		VariantClear(&vtProp);
+		pClassObject->Release();
+		pClassObject = NULL;
+		if (!bParsed) continue;
+
+		double Utilization = static_cast<double>(Utility);
+		int64_t ClockSpeed = static_cast<int64_t>(Performance);
+		size_t Comma = Name.find(L',');
+		UINT64 Group = 0, Number = 0;
+		if (Name == L"_Total") {
+			CPU.Utilization.CurrentUtilization = Utilization;
+			CPU.Utilization.CurrentClockSpeed = ClockSpeed;
+		}
+		else if (Comma != std::wstring::npos && parse_unsigned(Name.substr(0, Comma).c_str(), Group) && parse_unsigned(Name.c_str() + Comma + 1, Number)) {
+			Threads.push_back({ static_cast<int>(Group), static_cast<int>(Number), Utilization, ClockSpeed });
+		}
 	}
 
-	/* TODO: add actual code. */
+	std::sort(Threads.begin(), Threads.end(), [](const ThreadSample& a, const ThreadSample& b) {
+		return a.Group != b.Group ? a.Group < b.Group : a.Number < b.Number;
+	});
+	CPU.Utilization.ThreadsUtilization.clear();
+	CPU.Utilization.CurrentClockSpeeds.clear();
+	CPU.Utilization.ThreadUtilization = 0.0;
+	for (const auto& Thread : Threads) {
+		CPU.Utilization.ThreadsUtilization.push_back(Thread.Utilization);
+		CPU.Utilization.CurrentClockSpeeds.push_back(Thread.ClockSpeed);
+		// The busiest logical processor, which shows single-threaded saturation that the total hides.
+		CPU.Utilization.ThreadUtilization = std::max(CPU.Utilization.ThreadUtilization, Thread.Utilization);
+	}
+
+	UINT64 Now = Clock::Monotonic();
+	INT64 Timestamp = Clock::WallTime();
+	for (size_t i = 0; i < CPU.Utilization.ThreadsUtilization.size(); i++) {
+		CoreUtilizationSketches.Add(i, CPU.Utilization.ThreadsUtilization[i], Now);
+		CoreUtilizationHistory.Add(i, Timestamp, CPU.Utilization.ThreadsUtilization[i]);
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::RefreshSchedulerPressure() {
+	const char* FuncName = "SysInfoProbe::RefreshSchedulerPressure";
+	INSTRUMENT_COLLECTOR(FuncName);
+	if (LastProcessScan == 0 || Clock::Monotonic() - LastProcessScan >= ProcessScanReuseTicks) {
+		auto r = _ScanProcesses();
+		if (r) {
+			r.value().AddNewFunctionToStack(FuncName, 1);
+			return r;
+		}
+	}
+
+	UINT64 Now = Clock::Monotonic();
+	double ElapsedSeconds = LastSchedulerRefresh != 0 && Now > LastSchedulerRefresh ? static_cast<double>(Now - LastSchedulerRefresh) / Clock::TicksPerSecond : 0.0;
+	SCHEDULERPRESSUREINFO& Pressure = CPU.Pressure;
+
+	// Context switches are only counted per processor, group by group.
+	NTSTATUS Status;
+	UINT32 ContextSwitches = 0;
+	const WORD GroupCount = GetActiveProcessorGroupCount();
+	for (WORD Group = 0; Group < GroupCount; Group++) {
+		ULONG ulSize = static_cast<ULONG>(GetActiveProcessorCount(Group) * sizeof(NTINTERRUPTINFO));
+		if (SchedulerBuffer.size() < ulSize) SchedulerBuffer.resize(ulSize);
+		USHORT GroupNumber = Group;
+		Status = NtQuerySystemInformationEx(SystemInterruptInformation, &GroupNumber, sizeof(GroupNumber), SchedulerBuffer.data(), ulSize, NULL);
+		if (!NT_SUCCESS(Status)) {
+			return Error::New(FuncName, 2, L"Failed to query interrupt information.", Status);
+		}
+		Instrumentation::CountSystemCall();
+		const NTINTERRUPTINFO* pInterrupts = reinterpret_cast<const NTINTERRUPTINFO*>(SchedulerBuffer.data());
+		for (size_t i = 0; i < ulSize / sizeof(NTINTERRUPTINFO); i++) ContextSwitches += pInterrupts[i].ContextSwitches;
+	}
+
+	double Runnable = Pressure.RunningThreads + Pressure.ReadyThreads;
+	double Waiting = Pressure.ReadyThreads ? 100.0 : 0.0;
+	if (ElapsedSeconds > 0) {
+		Pressure.ContextSwitchesPerSecond = static_cast<UINT32>(ContextSwitches - LastContextSwitches) / ElapsedSeconds;
+		Pressure.ProcessesCreatedPerSecond = ProcessesCreated / ElapsedSeconds;
+		ProcessesCreated = 0;
+
+		// Each average moves towards the current value by the weight the elapsed time has over its window.
+		auto Decay = [ElapsedSeconds](double& Average, double Value, double WindowSeconds) {
+			double Keep = std::exp(-ElapsedSeconds / WindowSeconds);
+			Average = Average * Keep + Value * (1.0 - Keep);
+		};
+		Decay(Pressure.LoadAverage1, Runnable, 60);
+		Decay(Pressure.LoadAverage5, Runnable, 300);
+		Decay(Pressure.LoadAverage15, Runnable, 900);
+		Decay(Pressure.WaitingPercent10, Waiting, 10);
+		Decay(Pressure.WaitingPercent60, Waiting, 60);
+	}
+	else {
+		Pressure.LoadAverage1 = Pressure.LoadAverage5 = Pressure.LoadAverage15 = Runnable;
+		Pressure.WaitingPercent10 = Pressure.WaitingPercent60 = Waiting;
+	}
+
+	LastContextSwitches = ContextSwitches;
+	LastSchedulerRefresh = Now;
 	return std::nullopt;
 }
 
@@ -115,6 +236,7 @@ void SysInfoProbe::_GetCPUInstructions() {
 
 std::optional<Error> SysInfoProbe::GetCpuInfo() {
 	const char* FuncName = "SysInfoProbe::GetCpuInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
 	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
 	const std::vector<LPCWSTR> Attributes = {
 		L"Name",
@@ -190,6 +312,18 @@ std::optional<Error> SysInfoProbe::GetCpuInfo() {
 		r.value().AddNewFunctionToStack(FuncName, 10);
 		return r;
 	}
+	r = _LoadSMBIOS();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 11);
+		return r;
+	}
+	CPUSockets = SMBIOS.Sockets;
+	CPUCaches = SMBIOS.Caches;
 
+	r = RefreshSchedulerPressure();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 12);
+		return r;
+	}
 	return std::nullopt;
 }
@@ -0,0 +1,84 @@
+#include "Clock.hpp"
+#include <intrin.h>				// For __rdtsc and __cpuid
+#include <realtimeapiset.h>		// For the interrupt time functions
+#include <atomic>
+#include <mutex>
+#pragma comment(lib, "mincore.lib")	// Required for the interrupt time functions
+
+static std::atomic<bool> bTSCCalibrated{ false };
+// Written once by Calibrate before bTSCCalibrated is set.
+static UINT64 TSCOrigin = 0;
+static UINT64 NanosecondsOrigin = 0;
+static double NanosecondsPerTick = 0.0;
+
+static UINT64 QPCNanoseconds() {
+	static const LONGLONG Frequency = []() { LARGE_INTEGER f; QueryPerformanceFrequency(&f); return f.QuadPart; }();
+	LARGE_INTEGER Counter;
+	QueryPerformanceCounter(&Counter);
+	// Split so that the multiplication cannot overflow.
+	return static_cast<UINT64>(Counter.QuadPart / Frequency * 1000000000LL + Counter.QuadPart % Frequency * 1000000000LL / Frequency);
+}
+
+UINT64 Clock::Monotonic() {
+	ULONGLONG Time = 0;
+	QueryUnbiasedInterruptTimePrecise(&Time);
+	return Time;
+}
+
+UINT64 Clock::SinceBoot() {
+	ULONGLONG Time = 0;
+	QueryInterruptTimePrecise(&Time);
+	return Time;
+}
+
+INT64 Clock::BootWallTime() {
+	FILETIME Now = { 0 };
+	GetSystemTimePreciseAsFileTime(&Now);
+	UINT64 FileTime = (static_cast<UINT64>(Now.dwHighDateTime) << 32) | Now.dwLowDateTime;
+	// FILETIME counts 100ns units since 1601; 11644473600 seconds separate that from the Unix epoch.
+	return static_cast<INT64>(FileTime - SinceBoot()) / 10000 - 11644473600000LL;
+}
+
+INT64 Clock::WallTime() {
+	FILETIME Now = { 0 };
+	GetSystemTimePreciseAsFileTime(&Now);
+	UINT64 FileTime = (static_cast<UINT64>(Now.dwHighDateTime) << 32) | Now.dwLowDateTime;
+	return static_cast<INT64>(FileTime / 10000) - 11644473600000LL;
+}
+
+UINT64 Clock::Timestamp() {
+	if (bTSCCalibrated.load(std::memory_order_acquire)) {
+		return NanosecondsOrigin + static_cast<UINT64>((__rdtsc() - TSCOrigin) * NanosecondsPerTick);
+	}
+	return QPCNanoseconds();
+}
+
+bool Clock::Calibrate(DWORD Milliseconds) {
+	static std::once_flag Once;
+	std::call_once(Once, [Milliseconds]() {
+		// Only an invariant TSC ticks at the same rate on every core and in every power state.
+		int Registers[4] = { 0 };
+		__cpuid(Registers, 0x80000000);
+		if (static_cast<unsigned>(Registers[0]) < 0x80000007) return;
+		__cpuid(Registers, 0x80000007);
+		if (!(Registers[3] & (1 << 8))) return;
+
+		UINT64 StartNanoseconds = QPCNanoseconds();
+		UINT64 StartTSC = __rdtsc();
+		Sleep(Milliseconds);
+		UINT64 EndNanoseconds = QPCNanoseconds();
+		UINT64 EndTSC = __rdtsc();
+		if (EndTSC <= StartTSC || EndNanoseconds <= StartNanoseconds) return;
+
+		// Starting from the last QueryPerformanceCounter reading keeps timestamps continuous across the switch.
+		NanosecondsPerTick = static_cast<double>(EndNanoseconds - StartNanoseconds) / (EndTSC - StartTSC);
+		TSCOrigin = EndTSC;
+		NanosecondsOrigin = EndNanoseconds;
+		bTSCCalibrated.store(true, std::memory_order_release);
+	});
+	return IsTSCCalibrated();
+}
+
+bool Clock::IsTSCCalibrated() {
+	return bTSCCalibrated.load(std::memory_order_acquire);
+}
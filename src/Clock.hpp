@@ -0,0 +1,27 @@
+/* Info: Common time source of the collectors: monotonic and since-boot readings, a calibrated TSC fast path for timestamps and the wall-clock boot time. */
+#pragma once
+#include <Windows.h>
+
+class Clock {
+public:
+	static constexpr UINT64 TicksPerSecond = 10000000;	// Monotonic and SinceBoot are in 100ns units.
+
+	// Time since boot, excluding time spent suspended or hibernated (CLOCK_MONOTONIC). Use it for rates.
+	static UINT64 Monotonic();
+	// Time since boot, including time spent suspended or hibernated (CLOCK_BOOTTIME).
+	static UINT64 SinceBoot();
+	// Unix time of the boot in milliseconds, derived from SinceBoot so that suspends do not shift it.
+	static INT64 BootWallTime();
+	// Current Unix time in milliseconds, for timestamps that leave the process.
+	static INT64 WallTime();
+
+	/*
+	 * Nanoseconds from an arbitrary origin, for timestamping samples and timing collectors. Backed by QueryPerformanceCounter
+	 * until Calibrate succeeds, then by the TSC alone, which costs a few nanoseconds instead of a few dozen.
+	 */
+	static UINT64 Timestamp();
+	// Measures the TSC rate against QueryPerformanceCounter over the given time; only the first call does anything.
+	// Returns false when the processor has no invariant TSC, in which case Timestamp stays on QueryPerformanceCounter.
+	static bool Calibrate(DWORD Milliseconds = 20);
+	static bool IsTSCCalibrated();
+};
@@ -1,173 +1,105 @@
 #include "SysInfoProbe.hpp"
-
-std::optional<Error> SysInfoProbe::_GetRealMonitorSize() {
-	const char* FuncName = "SysInfoProbe::_GetRealMonitorSize";
-	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
-	const std::vector<LPCWSTR> Attributes = {
-		L"MaxHorizontalImageSize",
-		L"MaxVerticalImageSize",
-	};
-	WMIMgr.Cleanup();
-	auto r = WMIMgr.InitializeAPI(L"ROOT\\WMI");
-	if (r) {
-		WMIMgr.Cleanup();
-		r.value().AddNewFunctionToStack(FuncName, 2);
-		return r;
-	}
-
-	bstr_t WQLQuery = WMIMgr.BuildWQLQueryString(L"WmiMonitorBasicDisplayParams", Attributes);
-	r = WMIMgr.ExecuteWQLQuery(WQLQuery);
-	if (r) {
-		WMIMgr.Cleanup();
-		r.value().AddNewFunctionToStack(FuncName, 3);
-		return r;
-	}
-
-	auto [pLocator, pServices, pEnumerator] = WMIMgr.GetData();
-	IWbemClassObject* pClassObject = NULL;
-	ULONG uReturn = 0;
-	VARIANT vtProp = { 0 };
-	int index = 0;
+#include <initguid.h>		// Must precede ntddvdeo.h so that GUID_DEVINTERFACE_MONITOR is defined in this unit
+#include <ntddvdeo.h>		// For GUID_DEVINTERFACE_MONITOR
+#pragma comment(lib, "SetupAPI.lib")	// Required for monitor interface enumeration
+
+// The EDID the monitor driver cached in the device's hardware key, located through the interface path EnumDisplayDevices returns.
+static bool ReadMonitorEDID(HDEVINFO hDevInfo, LPCWSTR InterfacePath, std::vector<BYTE>& EDID) {
+	SP_DEVICE_INTERFACE_DATA InterfaceData = { sizeof(InterfaceData) };
+	if (!SetupDiOpenDeviceInterfaceW(hDevInfo, InterfacePath, 0, &InterfaceData)) return false;
+
+	DWORD DetailSize = 0;
+	SetupDiGetDeviceInterfaceDetailW(hDevInfo, &InterfaceData, NULL, 0, &DetailSize, NULL);
+	if (DetailSize < sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W)) return false;
+	std::vector<BYTE> DetailBuffer(DetailSize);
+	PSP_DEVICE_INTERFACE_DETAIL_DATA_W pDetail = reinterpret_cast<PSP_DEVICE_INTERFACE_DETAIL_DATA_W>(DetailBuffer.data());
+	pDetail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
+	SP_DEVINFO_DATA DeviceData = { sizeof(DeviceData) };
+	if (!SetupDiGetDeviceInterfaceDetailW(hDevInfo, &InterfaceData, pDetail, DetailSize, NULL, &DeviceData)) return false;
+
+	HKEY hKey = SetupDiOpenDevRegKey(hDevInfo, &DeviceData, DICS_FLAG_GLOBAL, 0, DIREG_DEV, KEY_READ);
+	if (hKey == INVALID_HANDLE_VALUE) return false;
 
 	DEFER{
-		VariantClear(&vtProp);
-		if (pClassObject) pClassObject->Release();
-		WMIMgr.Cleanup();
+		RegCloseKey(hKey);
 	};
 
-	while (pEnumerator) {
-		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
-		if (FAILED(hr)) {
-			return Error::New(FuncName, 4, L"Failed to fetch next WMI object.", hr);
-		}
-		if (uReturn == 0) break;
-		VariantInit(&vtProp);
-
-		hr = pClassObject->Get(L"MaxHorizontalImageSize", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || (vtProp.vt != VT_UINT && vtProp.vt != VT_I4 && vtProp.vt != VT_UI1)) {
-			return Error::New(FuncName, 5, L"Failed to get MaxHorizontalImageSize property or property is empty.", hr);
-		}
-		unsigned int HorizontalSizeCm = vtProp.uintVal;
-
-		hr = pClassObject->Get(L"MaxVerticalImageSize", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || (vtProp.vt != VT_UINT && vtProp.vt != VT_I4 && vtProp.vt != VT_UI1)) {
-			return Error::New(FuncName, 6, L"Failed to get MaxVerticalImageSize property or property is empty.", hr);
-		}
-		unsigned int VerticalSizeCm = vtProp.uintVal;
-
-		double HorizontalSizeInches = HorizontalSizeCm * 0.393701;
-		double VerticalSizeInches = VerticalSizeCm * 0.393701;
-		double DiagonalInches = std::sqrt(HorizontalSizeInches * HorizontalSizeInches + VerticalSizeInches * VerticalSizeInches);
-		
-		if (Displays.size() < index + 1) {
-			Displays.resize(index + 1);
-		}
-		
-		Displays[index].ScreenSizeInch = DiagonalInches;
-		index++;
-	}
-
-	return std::nullopt;
+	DWORD Size = 0;
+	if (RegQueryValueExW(hKey, L"EDID", NULL, NULL, NULL, &Size) != ERROR_SUCCESS || Size < EDIDBlockSize) return false;
+	EDID.resize(Size);
+	if (RegQueryValueExW(hKey, L"EDID", NULL, NULL, EDID.data(), &Size) != ERROR_SUCCESS) return false;
+	EDID.resize(Size);
+	return true;
 }
 
 std::optional<Error> SysInfoProbe::GetDisplayInfo() {
 	const char* FuncName = "SysInfoProbe::GetDisplayInfo";
-	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
-	const std::vector<LPCWSTR> Attributes = {
-		L"Name",
-		L"MonitorManufacturer"
-	};
-
-	bstr_t WQLQuery = WMIMgr.BuildWQLQueryString(L"Win32_DesktopMonitor", Attributes);
-	auto r = WMIMgr.ExecuteWQLQuery(WQLQuery);
-	if (r) {
-		r.value().AddNewFunctionToStack(FuncName, 2);
-		return r;
+	INSTRUMENT_COLLECTOR(FuncName);
+	HDEVINFO hDevInfo = SetupDiGetClassDevsW(&GUID_DEVINTERFACE_MONITOR, NULL, NULL, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+	if (hDevInfo == INVALID_HANDLE_VALUE) {
+		return Error::New(FuncName, 1, L"Failed to enumerate monitor interfaces.", GetLastError());
 	}
 
-	auto [pLocator, pServices, pEnumerator] = WMIMgr.GetData();
-	IWbemClassObject* pClassObject = NULL;
-	ULONG uReturn = 0;
-	VARIANT vtProp = { 0 };
-	DISPLAYINFO CurrentDisplay;
-
 	DEFER{
-		VariantClear(&vtProp);
-		if (pClassObject) pClassObject->Release();
+		SetupDiDestroyDeviceInfoList(hDevInfo);
 	};
 
-	while (pEnumerator) {
-		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
-		if (FAILED(hr)) {
-			return Error::New(FuncName, 3, L"Failed to fetch next WMI object.", hr);
-		}
-		if (uReturn == 0) break;
-		VariantInit(&vtProp);
+	std::vector<BYTE> EDID;
+	DISPLAY_DEVICEW Adapter = { sizeof(Adapter) };
+	for (DWORD AdapterIndex = 0; EnumDisplayDevicesW(NULL, AdapterIndex, &Adapter, 0); AdapterIndex++) {
+		if (!(Adapter.StateFlags & DISPLAY_DEVICE_ACTIVE)) continue;
 
-		hr = pClassObject->Get(L"Name", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 4, L"Failed to get Name property or property is empty.", hr);
-		}
-		CurrentDisplay.MonitorName = trim(w2s(vtProp.bstrVal));
-
-		hr = pClassObject->Get(L"MonitorManufacturer", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 5, L"Failed to get MonitorManufacturer property or property is empty.", hr);
-		}
-		CurrentDisplay.MonitorManufacturer = trim(w2s(vtProp.bstrVal));
-		Displays.push_back(CurrentDisplay);
-	}
-
-	DISPLAY_DEVICE DisplayDevice = { sizeof(DisplayDevice) };
-	int DeviceIndex = 0, index = 0;
-
-	while (EnumDisplayDevicesW(NULL, DeviceIndex, &DisplayDevice, 0))
-	{
-		if (!(DisplayDevice.StateFlags & DISPLAY_DEVICE_ACTIVE))
-		{
-			DeviceIndex++;
-			continue;
-		}
-
-		DEVMODE DeviceMode = { sizeof(DeviceMode) };
-		if (!EnumDisplaySettingsW(DisplayDevice.DeviceName, ENUM_CURRENT_SETTINGS, &DeviceMode))
-		{
-			DeviceIndex++;
-			continue;
-		}
-
-		DEVMODE MaxDeviceMode = { sizeof(MaxDeviceMode) };
+		DEVMODEW DeviceMode = { 0 };
+		DeviceMode.dmSize = sizeof(DeviceMode);
+		if (!EnumDisplaySettingsW(Adapter.DeviceName, ENUM_CURRENT_SETTINGS, &DeviceMode)) continue;
 
+		DEVMODEW MaxDeviceMode = { 0 };
+		MaxDeviceMode.dmSize = sizeof(MaxDeviceMode);
 		DWORD MaxWidth = 0, MaxHeight = 0;
-		int ModeIndex = 0;
-		while (EnumDisplaySettingsW(DisplayDevice.DeviceName, ModeIndex, &MaxDeviceMode))
-		{
-			if (MaxDeviceMode.dmPelsWidth * MaxDeviceMode.dmPelsHeight > MaxWidth * MaxHeight)
-			{
+		for (DWORD ModeIndex = 0; EnumDisplaySettingsW(Adapter.DeviceName, ModeIndex, &MaxDeviceMode); ModeIndex++) {
+			if (MaxDeviceMode.dmPelsWidth * MaxDeviceMode.dmPelsHeight > MaxWidth * MaxHeight) {
 				MaxWidth = MaxDeviceMode.dmPelsWidth;
 				MaxHeight = MaxDeviceMode.dmPelsHeight;
 			}
-			ModeIndex++;
 		}
 
-		Displays[index].RefreshRate = DeviceMode.dmDisplayFrequency;
-		Displays[index].ScreenWidth = DeviceMode.dmPelsWidth;
-		Displays[index].MaxWidthRes = MaxWidth;
-		Displays[index].MaxHeightRes = MaxHeight;
-		Displays[index].ScreenHeight = DeviceMode.dmPelsHeight;
-		DeviceIndex++;
-		index++;
-	}
-	
-	r = _GetRealMonitorSize();
-	auto r2 = WMIMgr.InitializeAPI();
-	if (r2) {
-		r2.value().AddNewFunctionToStack(FuncName, 6);
-	}
-	else if (r) {
-		r.value().AddNewFunctionToStack(FuncName, 7);
-		return r;
+		// Each monitor of the output; a cloned output drives several with the same mode.
+		DISPLAY_DEVICEW Monitor = { sizeof(Monitor) };
+		for (DWORD MonitorIndex = 0; EnumDisplayDevicesW(Adapter.DeviceName, MonitorIndex, &Monitor, EDD_GET_DEVICE_INTERFACE_NAME); MonitorIndex++) {
+			if (!(Monitor.StateFlags & DISPLAY_DEVICE_ACTIVE)) continue;
+
+			DISPLAYINFO Display;
+			Display.MonitorName = trim(w2s(Monitor.DeviceString));
+			Display.RefreshRate = DeviceMode.dmDisplayFrequency;
+			Display.ScreenWidth = DeviceMode.dmPelsWidth;
+			Display.ScreenHeight = DeviceMode.dmPelsHeight;
+			Display.MaxWidthRes = MaxWidth;
+			Display.MaxHeightRes = MaxHeight;
+
+			// A monitor without a readable EDID, such as some virtual displays, keeps the driver's description and modes.
+			EDIDINFO Info;
+			if (ReadMonitorEDID(hDevInfo, Monitor.DeviceID, EDID) && !ParseEDID(EDID.data(), EDID.size(), Info)) {
+				if (!Info.MonitorName.empty()) Display.MonitorName = Info.MonitorName;
+				Display.MonitorManufacturer = LookupPNPVendor(Info.ManufacturerId);
+				if (Display.MonitorManufacturer.empty()) Display.MonitorManufacturer = Info.ManufacturerId;
+				Display.ManufacturerId = Info.ManufacturerId;
+				Display.ProductCode = Info.ProductCode;
+				Display.SerialNumber = Info.SerialNumber;
+				Display.ManufactureYear = Info.ManufactureYear;
+				Display.ImageWidthMm = Info.ImageWidthMm;
+				Display.ImageHeightMm = Info.ImageHeightMm;
+				Display.ScreenSizeInch = std::sqrt(static_cast<double>(Info.ImageWidthMm) * Info.ImageWidthMm + static_cast<double>(Info.ImageHeightMm) * Info.ImageHeightMm) / 25.4;
+				Display.NativeWidth = Info.NativeWidth;
+				Display.NativeHeight = Info.NativeHeight;
+				Display.NativeRefreshRate = Info.NativeRefreshRate;
+				Display.MaxModeWidth = Info.MaxWidth;
+				Display.MaxModeHeight = Info.MaxHeight;
+				Display.MaxModeRefreshRate = Info.MaxRefreshRate;
+			}
+			Displays.push_back(std::move(Display));
+		}
 	}
+	Instrumentation::CountSystemCall(Displays.size() * 6 + 1);
 
 	return std::nullopt;
 }
\ No newline at end of file
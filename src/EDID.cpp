@@ -0,0 +1,277 @@
+#include "EDID.hpp"
+#include "Utils.hpp"
+#include <cstring>
+#include <algorithm>
+
+// A mode found in one of the timing lists.
+typedef struct _tag_EDIDMODE {
+	int Width;
+	int Height;
+	double RefreshRate;
+} EDIDMODE;
+
+static WORD ReadWord(const BYTE* p) { return static_cast<WORD>(p[0] | p[1] << 8); }
+
+static bool IsValidBlock(const BYTE* pBlock) {
+	BYTE Sum = 0;
+	for (size_t i = 0; i < EDIDBlockSize; i++) Sum += pBlock[i];
+	return Sum == 0;
+}
+
+// Larger by pixel count, then by refresh rate.
+static void ConsiderMode(const EDIDMODE& Mode, EDIDINFO& Out) {
+	if (Mode.Width <= 0 || Mode.Height <= 0) return;
+	INT64 Pixels = static_cast<INT64>(Mode.Width) * Mode.Height;
+	INT64 MaxPixels = static_cast<INT64>(Out.MaxWidth) * Out.MaxHeight;
+	if (Pixels > MaxPixels || (Pixels == MaxPixels && Mode.RefreshRate > Out.MaxRefreshRate)) {
+		Out.MaxWidth = Mode.Width;
+		Out.MaxHeight = Mode.Height;
+		Out.MaxRefreshRate = Mode.RefreshRate;
+	}
+}
+
+// Descriptor text is up to 13 characters, ended by a line feed and padded with spaces.
+static std::string ReadDescriptorText(const BYTE* pDescriptor) {
+	const char* pText = reinterpret_cast<const char*>(pDescriptor + 5);
+	size_t Length = 0;
+	while (Length < 13 && pText[Length] != '\n' && pText[Length] != '\0') Length++;
+	return trim(std::string(pText, Length));
+}
+
+/*
+ * An 18-byte detailed timing descriptor of the base block or a CTA-861 extension. Returns false for a display
+ * descriptor, whose pixel clock field is zero.
+ */
+static bool ReadDetailedTiming(const BYTE* pDescriptor, EDIDMODE& Mode, int& WidthMm, int& HeightMm) {
+	UINT64 PixelClock = ReadWord(pDescriptor) * 10000ULL;	// 10 kHz units.
+	if (PixelClock == 0) return false;
+	int HorizontalActive = pDescriptor[2] | (pDescriptor[4] & 0xF0) << 4;
+	int HorizontalBlanking = pDescriptor[3] | (pDescriptor[4] & 0x0F) << 8;
+	int VerticalActive = pDescriptor[5] | (pDescriptor[7] & 0xF0) << 4;
+	int VerticalBlanking = pDescriptor[6] | (pDescriptor[7] & 0x0F) << 8;
+	WidthMm = pDescriptor[12] | (pDescriptor[14] & 0xF0) << 4;
+	HeightMm = pDescriptor[13] | (pDescriptor[14] & 0x0F) << 8;
+	// An interlaced timing describes one field, so the frame has twice its lines.
+	bool bInterlaced = (pDescriptor[17] & 0x80) != 0;
+
+	UINT64 TotalPixels = static_cast<UINT64>(HorizontalActive + HorizontalBlanking) * (VerticalActive + VerticalBlanking);
+	Mode.Width = HorizontalActive;
+	Mode.Height = bInterlaced ? VerticalActive * 2 : VerticalActive;
+	Mode.RefreshRate = TotalPixels ? static_cast<double>(PixelClock) / TotalPixels : 0.0;
+	return true;
+}
+
+static void ParseDescriptors(const BYTE* pBlock, EDIDINFO& Out) {
+	for (size_t Offset = 54; Offset + 18 <= 126; Offset += 18) {
+		const BYTE* pDescriptor = pBlock + Offset;
+		EDIDMODE Mode = { 0 };
+		int WidthMm = 0, HeightMm = 0;
+		if (ReadDetailedTiming(pDescriptor, Mode, WidthMm, HeightMm)) {
+			// The first detailed timing is the preferred one, and its image size is more precise than the centimetres of byte 21.
+			if (Offset == 54) {
+				Out.NativeWidth = Mode.Width;
+				Out.NativeHeight = Mode.Height;
+				Out.NativeRefreshRate = Mode.RefreshRate;
+				if (WidthMm && HeightMm) {
+					Out.ImageWidthMm = WidthMm;
+					Out.ImageHeightMm = HeightMm;
+				}
+			}
+			ConsiderMode(Mode, Out);
+			continue;
+		}
+
+		switch (pDescriptor[3]) {
+		case 0xFC:
+			Out.MonitorName = ReadDescriptorText(pDescriptor);
+			break;
+		case 0xFF:
+			Out.SerialNumber = ReadDescriptorText(pDescriptor);
+			break;
+		}
+	}
+}
+
+// Bytes 35 to 37: one bit per VESA mode, most significant bit first.
+static void ParseEstablishedTimings(const BYTE* pBlock, EDIDINFO& Out) {
+	static const EDIDMODE EstablishedModes[17] = {
+		{ 720, 400, 70 }, { 720, 400, 88 }, { 640, 480, 60 }, { 640, 480, 67 }, { 640, 480, 72 }, { 640, 480, 75 }, { 800, 600, 56 }, { 800, 600, 60 },
+		{ 800, 600, 72 }, { 800, 600, 75 }, { 832, 624, 75 }, { 1024, 768, 87 }, { 1024, 768, 60 }, { 1024, 768, 70 }, { 1024, 768, 75 }, { 1280, 1024, 75 },
+		{ 1152, 870, 75 }
+	};
+	for (int i = 0; i < 17; i++) {
+		if (pBlock[35 + i / 8] & (0x80 >> (i % 8))) ConsiderMode(EstablishedModes[i], Out);
+	}
+}
+
+// Bytes 38 to 53: eight two-byte entries of width, aspect ratio and refresh rate; 0x0101 marks an unused one.
+static void ParseStandardTimings(const BYTE* pBlock, EDIDINFO& Out) {
+	for (size_t Offset = 38; Offset < 54; Offset += 2) {
+		BYTE WidthCode = pBlock[Offset], Flags = pBlock[Offset + 1];
+		if ((WidthCode == 0x01 && Flags == 0x01) || WidthCode == 0x00) continue;
+		EDIDMODE Mode = { (WidthCode + 31) * 8, 0, static_cast<double>((Flags & 0x3F) + 60) };
+		switch (Flags >> 6) {
+		case 0: Mode.Height = Out.Version > 1 || Out.Revision >= 3 ? Mode.Width * 10 / 16 : Mode.Width; break;	// 1:1 before EDID 1.3.
+		case 1: Mode.Height = Mode.Width * 3 / 4; break;
+		case 2: Mode.Height = Mode.Width * 4 / 5; break;
+		case 3: Mode.Height = Mode.Width * 9 / 16; break;
+		}
+		ConsiderMode(Mode, Out);
+	}
+}
+
+// The video formats of CTA-861 that matter for the largest mode; smaller ones never win against the detailed timings.
+static bool LookupVideoFormat(BYTE Vic, EDIDMODE& Mode) {
+	static const struct { BYTE Vic; EDIDMODE Mode; } VideoFormats[] = {
+		{ 16, { 1920, 1080, 60 } }, { 31, { 1920, 1080, 50 } }, { 63, { 1920, 1080, 120 } }, { 64, { 1920, 1080, 100 } },
+		{ 93, { 3840, 2160, 24 } }, { 94, { 3840, 2160, 25 } }, { 95, { 3840, 2160, 30 } }, { 96, { 3840, 2160, 50 } }, { 97, { 3840, 2160, 60 } },
+		{ 98, { 4096, 2160, 24 } }, { 99, { 4096, 2160, 25 } }, { 100, { 4096, 2160, 30 } }, { 101, { 4096, 2160, 50 } }, { 102, { 4096, 2160, 60 } },
+		{ 117, { 3840, 2160, 100 } }, { 118, { 3840, 2160, 120 } }, { 218, { 4096, 2160, 100 } }, { 219, { 4096, 2160, 120 } },
+		{ 194, { 7680, 4320, 24 } }, { 195, { 7680, 4320, 25 } }, { 196, { 7680, 4320, 30 } }, { 197, { 7680, 4320, 48 } },
+		{ 198, { 7680, 4320, 50 } }, { 199, { 7680, 4320, 60 } }, { 200, { 7680, 4320, 100 } }, { 201, { 7680, 4320, 120 } },
+	};
+	for (const auto& Format : VideoFormats) {
+		if (Format.Vic != Vic) continue;
+		Mode = Format.Mode;
+		return true;
+	}
+	return false;
+}
+
+static void ParseCTAExtension(const BYTE* pBlock, EDIDINFO& Out) {
+	// Byte 2 is where the detailed timings start; the data block collection lies between byte 4 and it.
+	size_t DetailedTimingsOffset = pBlock[2];
+	if (DetailedTimingsOffset < 4 || DetailedTimingsOffset > 127) return;
+
+	for (size_t Offset = 4; Offset < DetailedTimingsOffset;) {
+		BYTE Tag = pBlock[Offset] >> 5, Length = pBlock[Offset] & 0x1F;
+		if (Offset + 1 + Length > DetailedTimingsOffset) break;
+		// Video data block: one short video descriptor per byte. VICs 1 to 64 carry a native flag in bit 7.
+		if (Tag == 2) {
+			for (size_t i = 1; i <= Length; i++) {
+				BYTE Svd = pBlock[Offset + i];
+				BYTE Vic = Svd >= 129 && Svd <= 192 ? Svd & 0x7F : Svd;
+				EDIDMODE Mode = { 0 };
+				if (LookupVideoFormat(Vic, Mode)) ConsiderMode(Mode, Out);
+			}
+		}
+		Offset += 1 + Length;
+	}
+
+	for (size_t Offset = DetailedTimingsOffset; Offset + 18 <= 127; Offset += 18) {
+		EDIDMODE Mode = { 0 };
+		int WidthMm = 0, HeightMm = 0;
+		if (!ReadDetailedTiming(pBlock + Offset, Mode, WidthMm, HeightMm)) break;
+		ConsiderMode(Mode, Out);
+	}
+}
+
+/*
+ * A DisplayID section carried in an extension block: after the extension tag, a four-byte header whose second byte is
+ * the payload size, then data blocks of a tag, a revision and a payload length. Only the display parameters and the
+ * 20-byte detailed timings of types I (DisplayID 1.x) and VII (DisplayID 2.x) are read; they differ only in the unit
+ * of the pixel clock.
+ */
+static void ParseDisplayIDExtension(const BYTE* pBlock, EDIDINFO& Out) {
+	size_t SectionEnd = 5 + static_cast<size_t>(pBlock[2]);
+	if (SectionEnd > 127) SectionEnd = 127;
+
+	for (size_t Offset = 5; Offset + 3 <= SectionEnd;) {
+		BYTE Tag = pBlock[Offset];
+		size_t Length = pBlock[Offset + 2];
+		const BYTE* pPayload = pBlock + Offset + 3;
+		if (Tag == 0 && Length == 0) break;		// Padding.
+		if (Offset + 3 + Length > SectionEnd) break;
+
+		if (Tag == 0x01 && Length >= 8) {
+			// Display parameters: image size in tenths of a millimetre, then the native pixel format.
+			int WidthMm = ReadWord(pPayload) / 10, HeightMm = ReadWord(pPayload + 2) / 10;
+			if (!Out.ImageWidthMm && WidthMm && HeightMm) {
+				Out.ImageWidthMm = WidthMm;
+				Out.ImageHeightMm = HeightMm;
+			}
+			if (!Out.NativeWidth) {
+				Out.NativeWidth = ReadWord(pPayload + 4);
+				Out.NativeHeight = ReadWord(pPayload + 6);
+			}
+		}
+		else if (Tag == 0x03 || Tag == 0x22) {
+			UINT64 ClockUnit = Tag == 0x03 ? 10000 : 1000;
+			for (size_t i = 0; i + 20 <= Length; i += 20) {
+				const BYTE* pTiming = pPayload + i;
+				UINT64 PixelClock = ((pTiming[0] | pTiming[1] << 8 | pTiming[2] << 16) + 1ULL) * ClockUnit;
+				int HorizontalActive = ReadWord(pTiming + 4) + 1, HorizontalBlanking = ReadWord(pTiming + 6) + 1;
+				int VerticalActive = ReadWord(pTiming + 12) + 1, VerticalBlanking = ReadWord(pTiming + 14) + 1;
+				UINT64 TotalPixels = static_cast<UINT64>(HorizontalActive + HorizontalBlanking) * (VerticalActive + VerticalBlanking);
+				EDIDMODE Mode = { HorizontalActive, VerticalActive, static_cast<double>(PixelClock) / TotalPixels };
+				// Bit 7 of the options byte marks the preferred timing; it only stands in when the base block has none.
+				if ((pTiming[3] & 0x80) && !Out.NativeRefreshRate) {
+					Out.NativeWidth = Mode.Width;
+					Out.NativeHeight = Mode.Height;
+					Out.NativeRefreshRate = Mode.RefreshRate;
+				}
+				ConsiderMode(Mode, Out);
+			}
+		}
+		Offset += 3 + Length;
+	}
+}
+
+std::optional<Error> ParseEDID(const BYTE* pData, size_t DataSize, EDIDINFO& Out) {
+	const char* FuncName = "ParseEDID";
+	static const BYTE Header[8] = { 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x00 };
+	if (!pData || DataSize < EDIDBlockSize) return Error::New(FuncName, 1, L"EDID is smaller than its base block.");
+	if (memcmp(pData, Header, sizeof(Header)) != 0) return Error::New(FuncName, 2, L"EDID header is missing.");
+	if (!IsValidBlock(pData)) return Error::New(FuncName, 3, L"EDID base block checksum mismatch.");
+
+	Out = EDIDINFO();
+	Out.Version = pData[18];
+	Out.Revision = pData[19];
+	Out.ExtensionCount = pData[126];
+
+	// Three letters of five bits each, 1 for 'A', big-endian.
+	WORD Manufacturer = static_cast<WORD>(pData[8] << 8 | pData[9]);
+	for (int Shift = 10; Shift >= 0; Shift -= 5) {
+		BYTE Letter = (Manufacturer >> Shift) & 0x1F;
+		if (Letter >= 1 && Letter <= 26) Out.ManufacturerId.push_back(static_cast<char>('A' + Letter - 1));
+	}
+	Out.ProductCode = ReadWord(pData + 10);
+	DWORD SerialNumber = 0;
+	memcpy(&SerialNumber, pData + 12, sizeof(SerialNumber));
+	// Week 0xFF means byte 17 is the model year rather than the year of manufacture.
+	Out.ManufactureWeek = pData[16] <= 54 ? pData[16] : 0;
+	Out.ManufactureYear = pData[17] ? 1990 + pData[17] : 0;
+	Out.ImageWidthMm = pData[21] * 10;
+	Out.ImageHeightMm = pData[22] * 10;
+	if (!Out.ImageWidthMm || !Out.ImageHeightMm) Out.ImageWidthMm = Out.ImageHeightMm = 0;	// One zero encodes an aspect ratio, not a size.
+
+	ParseEstablishedTimings(pData, Out);
+	ParseStandardTimings(pData, Out);
+	ParseDescriptors(pData, Out);
+	if (Out.SerialNumber.empty() && SerialNumber) Out.SerialNumber = std::to_string(SerialNumber);
+
+	size_t BlockCount = (std::min)(static_cast<size_t>(Out.ExtensionCount) + 1, DataSize / EDIDBlockSize);
+	for (size_t i = 1; i < BlockCount; i++) {
+		const BYTE* pBlock = pData + i * EDIDBlockSize;
+		if (!IsValidBlock(pBlock)) continue;
+		switch (pBlock[0]) {
+		case 0x02: ParseCTAExtension(pBlock, Out); break;
+		case 0x70: ParseDisplayIDExtension(pBlock, Out); break;
+		}
+	}
+
+	return std::nullopt;
+}
+
+std::string LookupPNPVendor(const std::string& ManufacturerId) {
+	static const struct { const char* Id; const char* Name; } Vendors[] = {
+		{ "ACR", "Acer" }, { "AOC", "AOC" }, { "APP", "Apple" }, { "AUO", "AU Optronics" }, { "AUS", "ASUS" }, { "BNQ", "BenQ" },
+		{ "BOE", "BOE" }, { "CMN", "Innolux" }, { "DEL", "Dell" }, { "ENC", "EIZO" }, { "GSM", "LG Electronics" }, { "HPN", "HP" },
+		{ "HWP", "HP" }, { "IVM", "iiyama" }, { "LEN", "Lenovo" }, { "LGD", "LG Display" }, { "MSI", "MSI" }, { "NEC", "NEC" },
+		{ "PHL", "Philips" }, { "SAM", "Samsung" }, { "SDC", "Samsung Display" }, { "SHP", "Sharp" }, { "SNY", "Sony" }, { "VSC", "ViewSonic" },
+	};
+	for (const auto& Vendor : Vendors) {
+		if (ManufacturerId == Vendor.Id) return Vendor.Name;
+	}
+	return std::string();
+}
@@ -0,0 +1,17 @@
+/* Info: Parser for EDID blobs and their CTA-861 and DisplayID extensions. It only works on bytes, so captured EDIDs can be fed to it directly. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For EDIDINFO
+#include <optional>
+
+constexpr size_t EDIDBlockSize = 128;
+
+/*
+ * Decodes a base block followed by any number of extension blocks (the format of the registry's EDID value and of
+ * /sys/class/drm/<connector>/edid). The base block must be valid; an extension with a bad checksum or of an unknown
+ * type is skipped, as is the part of a blob that ends mid-block.
+ */
+std::optional<Error> ParseEDID(const BYTE* pData, size_t DataSize, EDIDINFO& Out);
+
+// Vendor name of a PNP ID for the common monitor makers; empty for others.
+std::string LookupPNPVendor(const std::string& ManufacturerId);
@@ -0,0 +1,416 @@
+#include "FleetStore.hpp"
+#include "Serialization.hpp"
+#include <algorithm>
+#include <fstream>
+
+// "SIPF" in little-endian; followed by the format version, which goes up whenever a column is added.
+constexpr DWORD FleetMagic = 0x46504953;
+constexpr BYTE FleetFormatVersion = 2;
+
+// Load rejects tables with more rows than this before allocating anything for them.
+constexpr UINT64 FleetMaxRows = 1ULL << 26;
+// A column whose values are all equal packs to zero bits, but every table of a real fleet has one that differs between
+// rows (collection times, host rows), so rows cost at least a bit each; only tables this small may have none.
+constexpr UINT64 FleetRowsWithoutData = 4096;
+
+// Group-by keys fit a flat counter array up to this many combinations; above it they are sorted instead.
+constexpr UINT64 FlatGroupLimit = 1ULL << 24;
+
+// Host table columns and how each is read from a snapshot. Exactly one of the two readers is set.
+typedef struct _tag_HOSTCOLUMNDEF {
+	const char* Name;
+	const std::string& (*ReadString)(const SYSINFOSNAPSHOT&);
+	INT64 (*ReadInteger)(const SYSINFOSNAPSHOT&);
+	BYTE SinceVersion = 1;		// First format version with the column; new columns go at the end.
+} HOSTCOLUMNDEF;
+
+static const HOSTCOLUMNDEF HostColumns[] = {
+	{ "Host.HostName", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.Host.HostName; }, nullptr },
+	{ "Host.CollectedAt", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return s.Host.CollectedAt; } },
+	{ "CPU.Name", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.CPU.Name; }, nullptr },
+	{ "CPU.Manufacturer", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.CPU.Manufacturer; }, nullptr },
+	{ "CPU.CoreCount", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return s.CPU.CoreCount; } },
+	{ "CPU.ThreadCount", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return s.CPU.ThreadCount; } },
+	{ "CPU.MaxClockSpeed", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return s.CPU.MaxClockSpeed; } },
+	{ "CPUSockets.Count", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return static_cast<INT64>(s.CPUSockets.size()); } },
+	{ "RAM.SizeInMegabytes", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return s.RAM.SizeInMegabytes; } },
+	{ "RAM.MemoryType", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.RAM.MemoryType; }, nullptr },
+	{ "RAMModules.Count", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return static_cast<INT64>(s.RAMModules.size()); } },
+	{ "Mainboard.Manufacturer", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.Mainboard.Manufacturer; }, nullptr },
+	{ "Mainboard.Name", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.Mainboard.Name; }, nullptr },
+	{ "BIOS.Manufacturer", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.BIOS.Manufacturer; }, nullptr },
+	{ "BIOS.Version", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.BIOS.Version; }, nullptr },
+	{ "OS.Name", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.OS.Name; }, nullptr },
+	{ "OS.Version", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.OS.Version; }, nullptr },
+	{ "OS.BuildNumber", [](const SYSINFOSNAPSHOT& s) -> const std::string& { return s.OS.BuildNumber; }, nullptr },
+	{ "GPU.Name", [](const SYSINFOSNAPSHOT& s) -> const std::string& { static const std::string None; return s.GPUs.empty() ? None : s.GPUs.front().Name; }, nullptr },
+	{ "StorageDevices.Count", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return static_cast<INT64>(s.StorageDevices.size()); } },
+	{ "NetworkInterfaces.Count", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return static_cast<INT64>(s.NetworkInterfaces.size()); } },
+	{ "GPUs.Count", nullptr, [](const SYSINFOSNAPSHOT& s) -> INT64 { return static_cast<INT64>(s.GPUs.size()); }, 2 },
+};
+
+void FleetColumn::AppendString(const std::string& Value) {
+	if (DictionaryIndex.size() != Dictionary.size()) {
+		DictionaryIndex.clear();
+		for (DWORD i = 0; i < Dictionary.size(); i++) DictionaryIndex.emplace(Dictionary[i], i);
+	}
+
+	auto [Entry, bInserted] = DictionaryIndex.emplace(Value, static_cast<DWORD>(Dictionary.size()));
+	if (bInserted) Dictionary.push_back(Value);
+	Codes.push_back(Entry->second);
+}
+
+std::string FleetColumn::ValueAt(size_t Row) const {
+	return Kind == FLEET_STRING ? Dictionary[Codes[Row]] : std::to_string(Values[Row]);
+}
+
+const FleetColumn* FleetTable::FindColumn(const std::string& ColumnName) const {
+	for (const auto& Column : Columns) {
+		if (Column.Name == ColumnName) return &Column;
+	}
+	return nullptr;
+}
+
+FleetStore::FleetStore() {
+	Hosts.Name = "Hosts";
+	for (const auto& Definition : HostColumns) {
+		Hosts.Columns.emplace_back(Definition.Name, Definition.ReadString ? FLEET_STRING : FLEET_INTEGER);
+	}
+
+	Modules.Name = "Modules";
+	Modules.Columns.emplace_back("HostRow", FLEET_INTEGER);
+	Modules.Columns.emplace_back("RAMModules.Manufacturer", FLEET_STRING);
+	Modules.Columns.emplace_back("RAMModules.Model", FLEET_STRING);
+	Modules.Columns.emplace_back("RAMModules.MemoryType", FLEET_STRING);
+	Modules.Columns.emplace_back("RAMModules.SizeInMegabytes", FLEET_INTEGER);
+	Modules.Columns.emplace_back("RAMModules.FrequencyInMHz", FLEET_INTEGER);
+}
+
+void FleetStore::Ingest(const SYSINFOSNAPSHOT& Snapshot) {
+	INT64 HostRow = static_cast<INT64>(Hosts.RowCount());
+	for (size_t i = 0; i < std::size(HostColumns); i++) {
+		if (HostColumns[i].ReadString) Hosts.Columns[i].AppendString(HostColumns[i].ReadString(Snapshot));
+		else Hosts.Columns[i].AppendInteger(HostColumns[i].ReadInteger(Snapshot));
+	}
+
+	for (const auto& Module : Snapshot.RAMModules) {
+		Modules.Columns[0].AppendInteger(HostRow);
+		Modules.Columns[1].AppendString(Module.Manufacturer);
+		Modules.Columns[2].AppendString(Module.Model);
+		Modules.Columns[3].AppendString(Module.MemoryType);
+		Modules.Columns[4].AppendInteger(Module.SizeInMegabytes);
+		Modules.Columns[5].AppendInteger(Module.FrequencyInMHz);
+	}
+}
+
+std::optional<Error> FleetStore::IngestSerialized(const BYTE* pData, size_t DataSize) {
+	const char* FuncName = "FleetStore::IngestSerialized";
+	SYSINFOSNAPSHOT Snapshot;
+	size_t Offset = 0;
+	while (Offset < DataSize) {
+		size_t Consumed = 0;
+		auto r = DeserializeSnapshot(pData + Offset, DataSize - Offset, Snapshot, &Consumed);
+		if (r) {
+			r.value().AddNewFunctionToStack(FuncName, 1);
+			return r;
+		}
+		Ingest(Snapshot);
+		Offset += Consumed;
+	}
+	return std::nullopt;
+}
+
+// Number of bits needed to store every value up to and including MaxValue.
+static BYTE BitWidth(UINT64 MaxValue) {
+	BYTE Width = 0;
+	while (Width < 64 && (MaxValue >> Width) != 0) Width++;
+	return Width;
+}
+
+static void WritePacked(ByteWriter& Writer, const std::vector<UINT64>& Values, BYTE Width) {
+	Writer.WriteByte(Width);
+	UINT64 Word = 0;
+	int Used = 0;
+	for (UINT64 Value : Values) {
+		for (int Written = 0; Written < Width;) {
+			int Take = std::min<int>(Width - Written, 64 - Used);
+			UINT64 Bits = (Take == 64) ? Value : ((Value >> Written) & ((1ULL << Take) - 1));
+			Word |= Bits << Used;
+			Used += Take;
+			Written += Take;
+			if (Used == 64) {
+				for (int i = 0; i < 8; i++) Writer.WriteByte(static_cast<BYTE>(Word >> (i * 8)));
+				Word = 0;
+				Used = 0;
+			}
+		}
+	}
+	for (int i = 0; i < (Used + 7) / 8; i++) Writer.WriteByte(static_cast<BYTE>(Word >> (i * 8)));
+}
+
+static BOOL ReadPacked(ByteReader& Reader, std::vector<UINT64>& Values, size_t Count) {
+	BYTE Width = Reader.ReadByte();
+	if (Width > 64 || Count > FleetMaxRows) return FALSE;
+	const BYTE* pBytes = Reader.Skip((Count * Width + 7) / 8);
+	if (!pBytes) return FALSE;
+
+	Values.resize(Count);
+	size_t BitOffset = 0;
+	for (size_t i = 0; i < Count; i++) {
+		UINT64 Value = 0;
+		for (int Bit = 0; Bit < Width; Bit++, BitOffset++) {
+			Value |= static_cast<UINT64>((pBytes[BitOffset / 8] >> (BitOffset % 8)) & 1) << Bit;
+		}
+		Values[i] = Value;
+	}
+	return TRUE;
+}
+
+static void WriteColumn(ByteWriter& Writer, const FleetColumn& Column) {
+	Writer.WriteString(Column.Name);
+	Writer.WriteByte(Column.Kind);
+
+	std::vector<UINT64> Packed(Column.RowCount());
+	if (Column.Kind == FLEET_STRING) {
+		Writer.WriteVarint(Column.Dictionary.size());
+		for (const auto& Value : Column.Dictionary) Writer.WriteString(Value);
+		std::copy(Column.Codes.begin(), Column.Codes.end(), Packed.begin());
+		WritePacked(Writer, Packed, BitWidth(Column.Dictionary.empty() ? 0 : Column.Dictionary.size() - 1));
+	}
+	else {
+		// Frame of reference: values are stored as offsets from the column minimum.
+		INT64 Minimum = Column.Values.empty() ? 0 : *std::min_element(Column.Values.begin(), Column.Values.end());
+		UINT64 MaxOffset = 0;
+		for (size_t i = 0; i < Column.Values.size(); i++) {
+			Packed[i] = static_cast<UINT64>(Column.Values[i]) - static_cast<UINT64>(Minimum);
+			MaxOffset = std::max(MaxOffset, Packed[i]);
+		}
+		Writer.WriteSignedVarint(Minimum);
+		WritePacked(Writer, Packed, BitWidth(MaxOffset));
+	}
+}
+
+static BOOL ReadColumn(ByteReader& Reader, FleetColumn& Column, size_t RowCount) {
+	std::string Name = Reader.ReadString();
+	Column = FleetColumn(Name, static_cast<FLEET_COLUMN_KIND>(Reader.ReadByte()));
+
+	std::vector<UINT64> Packed;
+	if (Column.Kind == FLEET_STRING) {
+		UINT64 DictionarySize = Reader.ReadVarint();
+		if (DictionarySize > Reader.Remaining()) return FALSE;
+		Column.Dictionary.resize(static_cast<size_t>(DictionarySize));
+		for (auto& Value : Column.Dictionary) Value = Reader.ReadString();
+		if (!ReadPacked(Reader, Packed, RowCount)) return FALSE;
+		Column.Codes.resize(RowCount);
+		for (size_t i = 0; i < RowCount; i++) {
+			if (Packed[i] >= DictionarySize) return FALSE;
+			Column.Codes[i] = static_cast<DWORD>(Packed[i]);
+		}
+	}
+	else if (Column.Kind == FLEET_INTEGER) {
+		INT64 Minimum = Reader.ReadSignedVarint();
+		if (!ReadPacked(Reader, Packed, RowCount)) return FALSE;
+		Column.Values.resize(RowCount);
+		for (size_t i = 0; i < RowCount; i++) Column.Values[i] = static_cast<INT64>(Packed[i] + static_cast<UINT64>(Minimum));
+	}
+	else return FALSE;
+
+	return !Reader.bFailed;
+}
+
+// Format version that introduced a column; module columns all date from the first one.
+static BYTE ColumnSinceVersion(const std::string& Name) {
+	for (const auto& Definition : HostColumns) {
+		if (Name == Definition.Name) return Definition.SinceVersion;
+	}
+	return 1;
+}
+
+/*
+ * Moves the columns read from a file of version FileVersion into Table, in Table's order. Columns added after that
+ * version are filled with empty values; FALSE when any other column is missing, mistyped or unknown.
+ */
+static BOOL AdoptColumns(FleetTable& Table, std::vector<FleetColumn>& Columns, size_t RowCount, BYTE FileVersion) {
+	size_t Adopted = 0;
+	for (auto& Expected : Table.Columns) {
+		auto Found = std::find_if(Columns.begin(), Columns.end(), [&](const FleetColumn& Column) { return Column.Name == Expected.Name; });
+		if (Found == Columns.end()) {
+			if (ColumnSinceVersion(Expected.Name) <= FileVersion) return FALSE;
+			if (Expected.Kind == FLEET_STRING) {
+				Expected.Dictionary.assign(1, std::string());
+				Expected.Codes.assign(RowCount, 0);
+			}
+			else Expected.Values.assign(RowCount, 0);
+			continue;
+		}
+		if (Found->Kind != Expected.Kind) return FALSE;
+		Expected = std::move(*Found);
+		Found->Name.clear();
+		Adopted++;
+	}
+	return Adopted == Columns.size();
+}
+
+std::optional<Error> FleetStore::Save(const std::filesystem::path& Path) const {
+	const char* FuncName = "FleetStore::Save";
+	ByteWriter Writer;
+	Writer.WriteFixed32(FleetMagic);
+	Writer.WriteByte(FleetFormatVersion);
+	for (const FleetTable* pTable : { &Hosts, &Modules }) {
+		Writer.WriteString(pTable->Name);
+		Writer.WriteVarint(pTable->RowCount());
+		Writer.WriteVarint(pTable->Columns.size());
+		for (const auto& Column : pTable->Columns) WriteColumn(Writer, Column);
+	}
+
+	std::ofstream File(Path, std::ios::binary | std::ios::trunc);
+	if (!File) {
+		return Error::New(FuncName, 1, L"Failed to create fleet store file.");
+	}
+	File.write(reinterpret_cast<const char*>(Writer.Buffer.data()), Writer.Buffer.size());
+	if (!File) {
+		return Error::New(FuncName, 2, L"Failed to write fleet store file.");
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> FleetStore::Load(const std::filesystem::path& Path) {
+	const char* FuncName = "FleetStore::Load";
+	std::ifstream File(Path, std::ios::binary);
+	if (!File) {
+		return Error::New(FuncName, 1, L"Failed to open fleet store file.");
+	}
+	std::vector<BYTE> Buffer((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+
+	ByteReader Reader(Buffer.data(), Buffer.size());
+	DWORD Magic = Reader.ReadFixed32();
+	BYTE FileVersion = Reader.ReadByte();
+	if (Magic != FleetMagic || FileVersion == 0 || FileVersion > FleetFormatVersion) {
+		return Error::New(FuncName, 2, L"File is not a fleet store or has an unsupported version.");
+	}
+
+	// Starts with the columns this build writes; an older file may only lack the ones added since.
+	FleetStore Loaded;
+	for (FleetTable* pTable : { &Loaded.Hosts, &Loaded.Modules }) {
+		std::string Name = Reader.ReadString();
+		UINT64 RowCount = Reader.ReadVarint();
+		UINT64 ColumnCount = Reader.ReadVarint();
+		UINT64 RowLimit = (std::min)(FleetMaxRows, FleetRowsWithoutData + static_cast<UINT64>(Reader.Remaining()) * 8);
+		if (Reader.bFailed || Name != pTable->Name || RowCount > RowLimit || ColumnCount > Reader.Remaining()) {
+			return Error::New(FuncName, 3, L"Fleet store table header is corrupted.");
+		}
+		std::vector<FleetColumn> Columns(static_cast<size_t>(ColumnCount));
+		for (auto& Column : Columns) {
+			if (!ReadColumn(Reader, Column, static_cast<size_t>(RowCount))) {
+				return Error::New(FuncName, 4, L"Fleet store column is corrupted.");
+			}
+		}
+		if (!AdoptColumns(*pTable, Columns, static_cast<size_t>(RowCount), FileVersion)) {
+			return Error::New(FuncName, 5, L"Fleet store columns do not match the columns of this version.");
+		}
+	}
+
+	// Every module row must point at an existing host row.
+	for (INT64 HostRow : Loaded.Modules.Columns[0].Values) {
+		if (HostRow < 0 || static_cast<UINT64>(HostRow) >= Loaded.Hosts.RowCount()) {
+			return Error::New(FuncName, 6, L"Fleet store module row points at a missing host.");
+		}
+	}
+
+	*this = std::move(Loaded);
+	return std::nullopt;
+}
+
+std::optional<Error> FleetStore::GroupByCount(const std::vector<std::string>& ColumnNames, std::vector<FLEETGROUP>& Out) const {
+	const char* FuncName = "FleetStore::GroupByCount";
+	Out.clear();
+	if (ColumnNames.empty()) return Error::New(FuncName, 1, L"No group-by column given.");
+
+	const FleetTable* pTable = Hosts.FindColumn(ColumnNames.front()) ? &Hosts : &Modules;
+	size_t RowCount = pTable->RowCount();
+
+	// Every key column becomes a dense code array with a known cardinality; integer columns get a temporary dictionary.
+	std::vector<const FleetColumn*> KeyColumns;
+	std::vector<std::vector<INT64>> IntegerDictionaries(ColumnNames.size());
+	std::vector<std::vector<DWORD>> IntegerCodes(ColumnNames.size());
+	std::vector<const DWORD*> Codes;
+	std::vector<UINT64> Cardinalities;
+	UINT64 KeySpace = 1;
+
+	for (size_t c = 0; c < ColumnNames.size(); c++) {
+		const FleetColumn* pColumn = pTable->FindColumn(ColumnNames[c]);
+		if (!pColumn) {
+			std::wstring wName(ColumnNames[c].begin(), ColumnNames[c].end());
+			return Error::New(FuncName, 2, L"Unknown column or columns from different tables: " + wName);
+		}
+		KeyColumns.push_back(pColumn);
+
+		if (pColumn->Kind == FLEET_STRING) {
+			Codes.push_back(pColumn->Codes.data());
+			Cardinalities.push_back(std::max<UINT64>(pColumn->Dictionary.size(), 1));
+		}
+		else {
+			auto& Dictionary = IntegerDictionaries[c];
+			Dictionary = pColumn->Values;
+			std::sort(Dictionary.begin(), Dictionary.end());
+			Dictionary.erase(std::unique(Dictionary.begin(), Dictionary.end()), Dictionary.end());
+			IntegerCodes[c].resize(RowCount);
+			for (size_t i = 0; i < RowCount; i++) {
+				IntegerCodes[c][i] = static_cast<DWORD>(std::lower_bound(Dictionary.begin(), Dictionary.end(), pColumn->Values[i]) - Dictionary.begin());
+			}
+			Codes.push_back(IntegerCodes[c].data());
+			Cardinalities.push_back(std::max<UINT64>(Dictionary.size(), 1));
+		}
+
+		if (KeySpace > UINT64_MAX / Cardinalities.back()) {
+			return Error::New(FuncName, 3, L"Too many distinct value combinations to group by.");
+		}
+		KeySpace *= Cardinalities.back();
+	}
+
+	// Column-at-a-time key building: one tight multiply-add loop per column, which the compiler vectorizes.
+	std::vector<UINT64> Keys(RowCount, 0);
+	for (size_t c = 0; c < Codes.size(); c++) {
+		const DWORD* pCodes = Codes[c];
+		UINT64 Cardinality = Cardinalities[c];
+		UINT64* pKeys = Keys.data();
+		for (size_t i = 0; i < RowCount; i++) pKeys[i] = pKeys[i] * Cardinality + pCodes[i];
+	}
+
+	std::vector<std::pair<UINT64, UINT64>> Groups;
+	if (KeySpace <= FlatGroupLimit) {
+		std::vector<DWORD> Counts(static_cast<size_t>(KeySpace), 0);
+		for (size_t i = 0; i < RowCount; i++) Counts[static_cast<size_t>(Keys[i])]++;
+		for (size_t Key = 0; Key < Counts.size(); Key++) {
+			if (Counts[Key]) Groups.emplace_back(Key, Counts[Key]);
+		}
+	}
+	else {
+		std::sort(Keys.begin(), Keys.end());
+		for (size_t i = 0; i < RowCount;) {
+			size_t j = i;
+			while (j < RowCount && Keys[j] == Keys[i]) j++;
+			Groups.emplace_back(Keys[i], j - i);
+			i = j;
+		}
+	}
+
+	std::sort(Groups.begin(), Groups.end(), [](const auto& a, const auto& b) { return a.second > b.second || (a.second == b.second && a.first < b.first); });
+
+	// Keys are decoded back into per-column codes, last column first.
+	for (const auto& [Key, Count] : Groups) {
+		FLEETGROUP Group;
+		Group.Count = Count;
+		Group.Values.resize(KeyColumns.size());
+		UINT64 Remainder = Key;
+		for (size_t c = KeyColumns.size(); c-- > 0;) {
+			size_t Code = static_cast<size_t>(Remainder % Cardinalities[c]);
+			Remainder /= Cardinalities[c];
+			if (KeyColumns[c]->Kind == FLEET_STRING) Group.Values[c] = KeyColumns[c]->Dictionary.empty() ? std::string() : KeyColumns[c]->Dictionary[Code];
+			else Group.Values[c] = IntegerDictionaries[c].empty() ? std::string() : std::to_string(IntegerDictionaries[c][Code]);
+		}
+		Out.push_back(std::move(Group));
+	}
+
+	return std::nullopt;
+}
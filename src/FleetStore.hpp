@@ -0,0 +1,77 @@
+/* Info: Columnar store for the snapshots of many hosts. String columns are dictionary-encoded and every column is bit-packed on disk. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SYSINFOSNAPSHOT
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+
+enum FLEET_COLUMN_KIND : BYTE {
+	FLEET_STRING = 1,
+	FLEET_INTEGER = 2
+};
+
+class FleetColumn {
+public:
+	std::string Name;
+	FLEET_COLUMN_KIND Kind = FLEET_STRING;
+
+	// String columns: each distinct value is stored once and rows hold its index.
+	std::vector<std::string> Dictionary;
+	std::vector<DWORD> Codes;
+
+	// Integer columns.
+	std::vector<INT64> Values;
+
+	FleetColumn() = default;
+	FleetColumn(const std::string& Name, FLEET_COLUMN_KIND Kind) : Name(Name), Kind(Kind) {}
+
+	void AppendString(const std::string& Value);
+	void AppendInteger(INT64 Value) { Values.push_back(Value); }
+	size_t RowCount() const { return Kind == FLEET_STRING ? Codes.size() : Values.size(); }
+	std::string ValueAt(size_t Row) const;
+
+private:
+	// Value -> code; rebuilt from Dictionary after a load, on the first append.
+	std::unordered_map<std::string, DWORD> DictionaryIndex;
+};
+
+class FleetTable {
+public:
+	std::string Name;
+	std::vector<FleetColumn> Columns;
+
+	const FleetColumn* FindColumn(const std::string& ColumnName) const;
+	size_t RowCount() const { return Columns.empty() ? 0 : Columns.front().RowCount(); }
+};
+
+// One result row of FleetStore::GroupByCount.
+typedef struct _tag_FLEETGROUP {
+	std::vector<std::string> Values;
+	UINT64 Count = 0;
+} FLEETGROUP, *PFLEETGROUP;
+
+/*
+ * Hosts holds one row per ingested snapshot ("CPU.Name", "BIOS.Version", ...), and Modules one row per
+ * memory module ("RAMModules.Model", ...) with "HostRow" pointing back at its host.
+ */
+class FleetStore {
+public:
+	FleetTable Hosts;
+	FleetTable Modules;
+
+	FleetStore();
+
+	void Ingest(const SYSINFOSNAPSHOT& Snapshot);
+	// Ingests every snapshot in a buffer of back-to-back serialized snapshots.
+	std::optional<Error> IngestSerialized(const BYTE* pData, size_t DataSize);
+
+	std::optional<Error> Save(const std::filesystem::path& Path) const;
+	std::optional<Error> Load(const std::filesystem::path& Path);
+
+	/*
+	 * Counts rows per distinct combination of the given columns, largest groups first.
+	 * All columns must belong to the same table, e.g. {"CPU.Name", "BIOS.Version"}.
+	 */
+	std::optional<Error> GroupByCount(const std::vector<std::string>& ColumnNames, std::vector<FLEETGROUP>& Out) const;
+};
@@ -1,80 +1,222 @@
 #include "SysInfoProbe.hpp"
+#include <dxgi.h>			// For adapter enumeration
+#include <initguid.h>		// Must precede devguid.h so that GUID_DEVCLASS_DISPLAY is defined in this unit
+#include <devguid.h>		// For the setup class of display adapters
+#pragma comment(lib, "dxgi.lib")		// Required for adapter enumeration
+#pragma comment(lib, "Pdh.lib")			// Required for the adapter memory counters
+
+// Used when the PCI ID index is not installed; these vendors make nearly every adapter DXGI reports.
+static std::string KnownGPUVendor(WORD VendorId) {
+	switch (VendorId) {
+	case 0x10DE: return "NVIDIA";
+	case 0x1002: return "Advanced Micro Devices, Inc.";
+	case 0x8086: return "Intel Corporation";
+	case 0x5143: return "Qualcomm";
+	case 0x1414: return "Microsoft";
+	default: return std::string();
+	}
+}
 
 std::optional<Error> SysInfoProbe::GetGpuInfo() {
 	const char* FuncName = "SysInfoProbe::GetGpuInfo";
-	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
-	
-	const std::vector<LPCWSTR> Attributes = {
-		L"Name",
-		L"AdapterCompatibility",
-		L"DriverVersion",
-		L"CurrentRefreshRate",
-		L"AdapterRAM"
-	};
-	bstr_t WQLQuery = WMIMgr.BuildWQLQueryString(L"Win32_VideoController", Attributes);
+	INSTRUMENT_COLLECTOR(FuncName);
+	auto NamesError = _OpenPCINames();
 
-	auto r = WMIMgr.ExecuteWQLQuery(WQLQuery);
+	// Link state and NUMA node come from the adapters' own PCI functions, so they do not depend on GetPCIDevices.
+	std::vector<PCIDEVICEINFO> DisplayFunctions;
+	auto r = _EnumeratePCIDevices(&GUID_DEVCLASS_DISPLAY, DisplayFunctions);
 	if (r) {
-		r.value().AddNewFunctionToStack(FuncName, 2);
+		r.value().AddNewFunctionToStack(FuncName, 5);
 		return r;
 	}
 
-	auto [pLocator, pServices, pEnumerator] = WMIMgr.GetData();
-	IWbemClassObject* pClassObject = NULL;
-	ULONG uReturn = 0;
-	VARIANT vtProp = { 0 };
+	IDXGIFactory1* pFactory = NULL;
+	HRESULT hr = CreateDXGIFactory1(__uuidof(IDXGIFactory1), reinterpret_cast<void**>(&pFactory));
+	if (FAILED(hr)) {
+		return Error::New(FuncName, 1, L"Failed to create DXGI factory.", hr);
+	}
 
-	DEFER {
-		VariantClear(&vtProp);
-		if (pClassObject) pClassObject->Release();
+	DEFER{
+		pFactory->Release();
 	};
 
-	while (pEnumerator) {
-		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
+	GPUs.clear();
+	GPUMemoryCounters.clear();
+	std::vector<BOOL> PCIDeviceTaken(DisplayFunctions.size(), FALSE);
+	IDXGIAdapter1* pAdapter = NULL;
+	for (UINT AdapterIndex = 0;; AdapterIndex++) {
+		hr = pFactory->EnumAdapters1(AdapterIndex, &pAdapter);
+		if (hr == DXGI_ERROR_NOT_FOUND) break;
 		if (FAILED(hr)) {
-			return Error::New(FuncName, 3, L"Failed to fetch next WMI object.", hr);
+			return Error::New(FuncName, 3, L"Failed to enumerate DXGI adapters.", hr);
 		}
-		if (uReturn == 0) break;
-		VariantInit(&vtProp);
+		DEFER{ pAdapter->Release(); };
+		DXGI_ADAPTER_DESC1 Desc = { 0 };
+		if (FAILED(pAdapter->GetDesc1(&Desc))) continue;
+		// The Basic Render Driver and other software rasterizers.
+		if (Desc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) continue;
 
-		hr = pClassObject->Get(L"Name", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 4, L"Failed to get GPU name.", hr);
-		}
-		GPU.Name = w2s(vtProp.bstrVal);
+		GPUINFO GPU;
+		GPU.Name = w2s(Desc.Description);
+		GPU.AdapterLuid = static_cast<UINT64>(static_cast<DWORD>(Desc.AdapterLuid.HighPart)) << 32 | Desc.AdapterLuid.LowPart;
+		GPU.VendorId = static_cast<WORD>(Desc.VendorId);
+		GPU.DeviceId = static_cast<WORD>(Desc.DeviceId);
+		GPU.SubsystemId = static_cast<WORD>(Desc.SubSysId >> 16);
+		GPU.SubsystemVendorId = static_cast<WORD>(Desc.SubSysId);
+		GPU.Revision = static_cast<BYTE>(Desc.Revision);
+		GPU.DedicatedVideoMemoryBytes = Desc.DedicatedVideoMemory;
+		GPU.DedicatedSystemMemoryBytes = Desc.DedicatedSystemMemory;
+		GPU.SharedSystemMemoryBytes = Desc.SharedSystemMemory;
+		// SIZE_T, so no longer capped at 4 GB like Win32_VideoController.AdapterRAM.
+		GPU.VRAMSizeInMegabytes = static_cast<int>(Desc.DedicatedVideoMemory / (1024 * 1024));
+		GPU.VRAMSizeInGigabytes = Desc.DedicatedVideoMemory / (1024.0 * 1024.0 * 1024.0);
+		GPU.Manufacturer = PCINames.VendorName(GPU.VendorId);
+		if (GPU.Manufacturer.empty()) GPU.Manufacturer = KnownGPUVendor(GPU.VendorId);
 
-		hr = pClassObject->Get(L"AdapterCompatibility", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 5, L"Failed to get manufacturer name.", hr);
+		// The user-mode driver version, as Device Manager shows it.
+		LARGE_INTEGER UMDVersion = { 0 };
+		if (SUCCEEDED(pAdapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &UMDVersion))) {
+			GPU.DriverVersion = std::format("{}.{}.{}.{}", HIWORD(UMDVersion.HighPart), LOWORD(UMDVersion.HighPart), HIWORD(UMDVersion.LowPart), LOWORD(UMDVersion.LowPart));
 		}
-		GPU.Manufacturer = w2s(vtProp.bstrVal);
 
-		hr = pClassObject->Get(L"DriverVersion", 0, &vtProp, 0, 0); 
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 6, L"Failed to get driver version.", hr);
+		// Session 0, where services run, has no outputs to enumerate.
+		IDXGIOutput* pOutput = NULL;
+		for (UINT OutputIndex = 0;; OutputIndex++) {
+			hr = pAdapter->EnumOutputs(OutputIndex, &pOutput);
+			if (hr == DXGI_ERROR_NOT_FOUND || hr == DXGI_ERROR_NOT_CURRENTLY_AVAILABLE) break;
+			if (FAILED(hr)) {
+				return Error::New(FuncName, 4, L"Failed to enumerate the outputs of a DXGI adapter.", hr);
+			}
+			DXGI_OUTPUT_DESC OutputDesc = { 0 };
+			DEVMODEW Mode = { 0 };
+			Mode.dmSize = sizeof(Mode);
+			if (SUCCEEDED(pOutput->GetDesc(&OutputDesc)) && EnumDisplaySettingsW(OutputDesc.DeviceName, ENUM_CURRENT_SETTINGS, &Mode)) {
+				GPU.RefreshRate = (std::max)(GPU.RefreshRate, static_cast<int>(Mode.dmDisplayFrequency));
+			}
+			pOutput->Release();
 		}
-		GPU.DriverVersion = w2s(vtProp.bstrVal);
 
-		hr = pClassObject->Get(L"CurrentRefreshRate", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_I4) {
-			return Error::New(FuncName, 7, L"Failed to get refresh rate.", hr);
+		// Identical cards share every ID, so each takes the first PCI function with those IDs that no earlier adapter took.
+		for (size_t i = 0; i < DisplayFunctions.size(); i++) {
+			const PCIDEVICEINFO& Device = DisplayFunctions[i];
+			if (PCIDeviceTaken[i] || Device.VendorId != GPU.VendorId || Device.DeviceId != GPU.DeviceId ||
+				Device.SubsystemVendorId != GPU.SubsystemVendorId || Device.SubsystemId != GPU.SubsystemId) continue;
+			PCIDeviceTaken[i] = TRUE;
+			GPU.PCIInstanceId = Device.InstanceId;
+			GPU.CurrentLinkGeneration = Device.CurrentLinkGeneration;
+			GPU.CurrentLinkWidth = Device.CurrentLinkWidth;
+			GPU.MaxLinkGeneration = Device.MaxLinkGeneration;
+			GPU.MaxLinkWidth = Device.MaxLinkWidth;
+			GPU.NUMANode = Device.NUMANode;
+			break;
 		}
-		GPU.RefreshRate = vtProp.intVal;
 
-		hr = pClassObject->Get(L"AdapterRam", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || (vtProp.vt != VT_I4)) {
-			return Error::New(FuncName, 8, L"Failed to get VRAM size.", hr);
+		GPUMEMORYCOUNTERSINFO Counters;
+		Counters.AdapterLuid = GPU.AdapterLuid;
+		GPUMemoryCounters.push_back(Counters);
+		GPUs.push_back(std::move(GPU));
+	}
+	Instrumentation::CountSystemCall(GPUs.size() * 3 + 1);
+
+	std::optional<Error> CountersError;
+	if (!hGPUMemoryQuery) CountersError = _OpenGPUMemoryCounters();
+	r = RefreshGPUMemory();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		return r;
+	}
+
+	// The adapters are complete without usage counters or vendor names, so those errors are only reported once they are collected.
+	if (CountersError) {
+		CountersError.value().AddNewFunctionToStack(FuncName, 6);
+		return CountersError;
+	}
+	if (NamesError) {
+		NamesError.value().AddNewFunctionToStack(FuncName, 7);
+		return NamesError;
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_OpenGPUMemoryCounters() {
+	const char* FuncName = "SysInfoProbe::_OpenGPUMemoryCounters";
+	PDH_STATUS Status = PdhOpenQueryW(NULL, 0, &hGPUMemoryQuery);
+	if (Status != ERROR_SUCCESS) {
+		hGPUMemoryQuery = NULL;
+		return Error::New(FuncName, 1, L"Failed to open PDH query.", Status);
+	}
+
+	// Both are gauges, so unlike rate counters a single collection gives valid values.
+	if (PdhAddEnglishCounterW(hGPUMemoryQuery, L"\\GPU Adapter Memory(*)\\Dedicated Usage", 0, &hDedicatedUsageCounter) != ERROR_SUCCESS ||
+		PdhAddEnglishCounterW(hGPUMemoryQuery, L"\\GPU Adapter Memory(*)\\Shared Usage", 0, &hSharedUsageCounter) != ERROR_SUCCESS) {
+		// Before Windows 10 1709 the counter set does not exist; usage then stays at zero.
+		_CloseGPUMemoryCounters();
+		return Error::New(FuncName, 2, L"GPU adapter memory counters are not available.");
+	}
+	return std::nullopt;
+}
+
+void SysInfoProbe::_CloseGPUMemoryCounters() {
+	if (hGPUMemoryQuery) {
+		PdhCloseQuery(hGPUMemoryQuery);
+		hGPUMemoryQuery = NULL;
+	}
+	hDedicatedUsageCounter = NULL;
+	hSharedUsageCounter = NULL;
+}
+
+std::optional<Error> SysInfoProbe::_SampleGPUMemoryCounter(PDH_HCOUNTER hCounter, BOOL bDedicated) {
+	const char* FuncName = "SysInfoProbe::_SampleGPUMemoryCounter";
+	DWORD dwBufferSize = static_cast<DWORD>(GPUCounterBuffer.size());
+	DWORD dwItemCount = 0;
+	PDH_STATUS Status = PdhGetFormattedCounterArrayW(hCounter, PDH_FMT_LARGE, &dwBufferSize, &dwItemCount,
+		reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(GPUCounterBuffer.data()));
+	if (Status == PDH_MORE_DATA) {
+		GPUCounterBuffer.resize(dwBufferSize);
+		Status = PdhGetFormattedCounterArrayW(hCounter, PDH_FMT_LARGE, &dwBufferSize, &dwItemCount,
+			reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(GPUCounterBuffer.data()));
+	}
+	if (Status != ERROR_SUCCESS) {
+		return Error::New(FuncName, 1, L"Failed to read GPU adapter memory counter array.", Status);
+	}
+
+	PPDH_FMT_COUNTERVALUE_ITEM_W pItems = reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(GPUCounterBuffer.data());
+	for (DWORD i = 0; i < dwItemCount; i++) {
+		if (pItems[i].FmtValue.CStatus != PDH_CSTATUS_VALID_DATA && pItems[i].FmtValue.CStatus != PDH_CSTATUS_NEW_DATA) continue;
+		// Instances are named "luid_0x<high>_0x<low>_phys_<n>"; linked adapters have one per physical GPU.
+		UINT LuidHigh = 0, LuidLow = 0, Physical = 0;
+		if (swscanf_s(pItems[i].szName, L"luid_0x%x_0x%x_phys_%u", &LuidHigh, &LuidLow, &Physical) != 3) continue;
+		UINT64 Luid = static_cast<UINT64>(LuidHigh) << 32 | LuidLow;
+		for (auto& Counters : GPUMemoryCounters) {
+			if (Counters.AdapterLuid != Luid) continue;
+			(bDedicated ? Counters.DedicatedUsageBytes : Counters.SharedUsageBytes) += static_cast<UINT64>(pItems[i].FmtValue.largeValue);
 		}
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::RefreshGPUMemory() {
+	const char* FuncName = "SysInfoProbe::RefreshGPUMemory";
+	INSTRUMENT_COLLECTOR(FuncName);
+	if (!hGPUMemoryQuery) return std::nullopt;
+
+	PDH_STATUS Status = PdhCollectQueryData(hGPUMemoryQuery);
+	if (Status != ERROR_SUCCESS) {
+		return Error::New(FuncName, 1, L"Failed to collect GPU adapter memory counters.", Status);
+	}
+	Instrumentation::CountSystemCall();
 
-		// CAUTION - 4GB is the limit.
-		// std::cout << vtProp.uintVal << std::endl;
-		GPU.VRAMSizeInMegabytes = static_cast<int>(vtProp.uintVal / pow(1024, 2));  // BYTES -> KB -> MB = BYTES / 1024 * 1024 
-		GPU.VRAMSizeInGigabytes = GPU.VRAMSizeInMegabytes / 1024;
+	for (auto& Counters : GPUMemoryCounters) Counters.DedicatedUsageBytes = Counters.SharedUsageBytes = 0;
+	auto r = _SampleGPUMemoryCounter(hDedicatedUsageCounter, TRUE);
+	if (!r) r = _SampleGPUMemoryCounter(hSharedUsageCounter, FALSE);
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		return r;
+	}
 
-		// TODO: Implement a much safer method to fetch VRAM - 
-		// https://stackoverflow.com/questions/68274009/wmi-win32-videocontroller-ram-4gb-limit
-		// https://stackoverflow.com/a/74552200 - Direct Link to Answer
+	// GPUMemoryCounters is parallel to GPUs.
+	for (size_t i = 0; i < GPUMemoryCounters.size() && i < GPUs.size(); i++) {
+		if (GPUs[i].DedicatedVideoMemoryBytes) GPUMemoryCounters[i].DedicatedUsedPercent = 100.0 * GPUMemoryCounters[i].DedicatedUsageBytes / GPUs[i].DedicatedVideoMemoryBytes;
 	}
-	
 	return std::nullopt;
 }
\ No newline at end of file
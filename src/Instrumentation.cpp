@@ -0,0 +1,210 @@
+#include "Instrumentation.hpp"
+#include <bit>
+#include <mutex>
+
+int LatencyHistogram::BucketIndex(UINT64 Nanoseconds) {
+	if (Nanoseconds < SubBuckets) return static_cast<int>(Nanoseconds);
+	int Magnitude = std::bit_width(Nanoseconds) - 1;
+	if (Magnitude > MaxMagnitude) return BucketCount - 1;
+	int SubBucket = static_cast<int>((Nanoseconds >> (Magnitude - SubBucketBits)) & (SubBuckets - 1));
+	return (Magnitude - SubBucketBits + 1) * SubBuckets + SubBucket;
+}
+
+UINT64 LatencyHistogram::BucketLowerBound(int Index) {
+	if (Index < SubBuckets) return Index;
+	int Magnitude = Index / SubBuckets + SubBucketBits - 1;
+	UINT64 SubBucket = Index % SubBuckets;
+	return (SubBuckets + SubBucket) << (Magnitude - SubBucketBits);
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& Other) {
+	for (int i = 0; i < BucketCount; i++) Buckets[i] += Other.Buckets[i];
+}
+
+UINT64 LatencyHistogram::Count() const {
+	UINT64 Total = 0;
+	for (UINT64 Bucket : Buckets) Total += Bucket;
+	return Total;
+}
+
+UINT64 LatencyHistogram::Percentile(double Percent) const {
+	UINT64 Total = Count();
+	if (Total == 0) return 0;
+	UINT64 Rank = static_cast<UINT64>(Percent / 100.0 * Total + 0.5);
+	if (Rank == 0) Rank = 1;
+	UINT64 Seen = 0;
+	for (int i = 0; i < BucketCount; i++) {
+		Seen += Buckets[i];
+		if (Seen >= Rank) return i + 1 < BucketCount ? BucketLowerBound(i + 1) - 1 : BucketLowerBound(i);
+	}
+	return BucketLowerBound(BucketCount - 1);
+}
+
+/*
+ * Counters of one collector on one thread. Only the owning thread writes them, with plain load+store on relaxed
+ * atomics, so readers on other threads see torn-free values without any locked instruction on the hot path.
+ */
+struct _COLLECTORSLOT {
+	std::atomic<UINT64> Calls;
+	std::atomic<UINT64> TotalNanoseconds;
+	std::atomic<UINT64> MaxNanoseconds;
+	std::atomic<UINT64> WMIQueries;
+	std::atomic<UINT64> SystemCalls;
+	std::atomic<UINT64> BytesRead;
+	std::atomic<UINT64> Allocations;
+	std::atomic<UINT64> AllocatedBytes;
+	std::atomic<UINT64> Buckets[LatencyHistogram::BucketCount];
+};
+
+struct _THREADCOUNTERS {
+	std::atomic<_COLLECTORSLOT*> Slots[Instrumentation::MaxCollectors];
+};
+
+static void Add(std::atomic<UINT64>& Counter, UINT64 Value) {
+	Counter.store(Counter.load(std::memory_order_relaxed) + Value, std::memory_order_relaxed);
+}
+
+// Blocks of threads that have exited stay registered so that their counts are not lost; a probe has few threads.
+static std::mutex RegistryLock;
+static std::string CollectorNames[Instrumentation::MaxCollectors];
+static std::atomic<int> CollectorCount{ 0 };
+static _THREADCOUNTERS* ThreadBlocks[256];
+static std::atomic<int> ThreadBlockCount{ 0 };
+static _THREADCOUNTERS OverflowBlock;	// Shared by threads beyond the 256th; their counts may then race.
+
+// Plain pointers and ints so that these need no dynamic initialization, which the allocation hook relies on.
+static thread_local _THREADCOUNTERS* pCurrentThread = nullptr;
+static thread_local int CurrentCollectorId = -1;
+
+/*
+ * Blocks and slots come from calloc rather than operator new: they are created while a collector is current,
+ * and an allocation through the counted operator new would try to count itself.
+ */
+static _THREADCOUNTERS* GetThreadBlock() {
+	if (pCurrentThread) return pCurrentThread;
+
+	std::lock_guard Lock(RegistryLock);
+	int Count = ThreadBlockCount.load(std::memory_order_relaxed);
+	_THREADCOUNTERS* pBlock = Count < 256 ? static_cast<_THREADCOUNTERS*>(calloc(1, sizeof(_THREADCOUNTERS))) : nullptr;
+	if (pBlock) {
+		ThreadBlocks[Count] = pBlock;
+		ThreadBlockCount.store(Count + 1, std::memory_order_release);
+	}
+	else pBlock = &OverflowBlock;
+	pCurrentThread = pBlock;
+	return pBlock;
+}
+
+static _COLLECTORSLOT* GetSlot(int CollectorId) {
+	_THREADCOUNTERS* pBlock = GetThreadBlock();
+	_COLLECTORSLOT* pSlot = pBlock->Slots[CollectorId].load(std::memory_order_relaxed);
+	if (!pSlot) {
+		pSlot = static_cast<_COLLECTORSLOT*>(calloc(1, sizeof(_COLLECTORSLOT)));
+		if (!pSlot) return nullptr;
+		pBlock->Slots[CollectorId].store(pSlot, std::memory_order_release);
+	}
+	return pSlot;
+}
+
+// The slot of the current collector, or nullptr when counts have nowhere to go. Never creates a thread block.
+static _COLLECTORSLOT* CurrentSlot() {
+	if (CurrentCollectorId < 0 || !pCurrentThread) return nullptr;
+	return pCurrentThread->Slots[CurrentCollectorId].load(std::memory_order_relaxed);
+}
+
+int Instrumentation::RegisterCollector(const std::string& Name) {
+	std::lock_guard Lock(RegistryLock);
+	int Count = CollectorCount.load(std::memory_order_relaxed);
+	for (int i = 0; i < Count; i++) {
+		if (CollectorNames[i] == Name) return i;
+	}
+	// Past the limit, collectors share the last identifier rather than failing.
+	if (Count == MaxCollectors) return MaxCollectors - 1;
+	CollectorNames[Count] = Name;
+	CollectorCount.store(Count + 1, std::memory_order_release);
+	return Count;
+}
+
+void Instrumentation::CountWMIQuery() {
+	if (auto pSlot = CurrentSlot()) Add(pSlot->WMIQueries, 1);
+}
+
+void Instrumentation::CountSystemCall(UINT64 Count) {
+	if (auto pSlot = CurrentSlot()) Add(pSlot->SystemCalls, Count);
+}
+
+void Instrumentation::CountBytesRead(UINT64 Bytes) {
+	if (auto pSlot = CurrentSlot()) Add(pSlot->BytesRead, Bytes);
+}
+
+void Instrumentation::CountAllocation(UINT64 Bytes) {
+	if (auto pSlot = CurrentSlot()) {
+		Add(pSlot->Allocations, 1);
+		Add(pSlot->AllocatedBytes, Bytes);
+	}
+}
+
+void Instrumentation::_RecordCall(int CollectorId, UINT64 Nanoseconds) {
+	_COLLECTORSLOT* pSlot = GetSlot(CollectorId);
+	if (!pSlot) return;
+	Add(pSlot->Calls, 1);
+	Add(pSlot->TotalNanoseconds, Nanoseconds);
+	if (Nanoseconds > pSlot->MaxNanoseconds.load(std::memory_order_relaxed)) pSlot->MaxNanoseconds.store(Nanoseconds, std::memory_order_relaxed);
+	Add(pSlot->Buckets[LatencyHistogram::BucketIndex(Nanoseconds)], 1);
+}
+
+LatencyHistogram Instrumentation::GetCollectorHistogram(int CollectorId) {
+	LatencyHistogram Histogram;
+	int ThreadCount = ThreadBlockCount.load(std::memory_order_acquire);
+	for (int t = 0; t <= ThreadCount; t++) {
+		_THREADCOUNTERS* pBlock = t < ThreadCount ? ThreadBlocks[t] : &OverflowBlock;
+		_COLLECTORSLOT* pSlot = pBlock->Slots[CollectorId].load(std::memory_order_acquire);
+		if (!pSlot) continue;
+		for (int i = 0; i < LatencyHistogram::BucketCount; i++) Histogram.Buckets[i] += pSlot->Buckets[i].load(std::memory_order_relaxed);
+	}
+	return Histogram;
+}
+
+std::vector<COLLECTORSTATS> Instrumentation::GetCollectorStats() {
+	std::vector<COLLECTORSTATS> Stats;
+	int Count = CollectorCount.load(std::memory_order_acquire);
+	int ThreadCount = ThreadBlockCount.load(std::memory_order_acquire);
+
+	for (int c = 0; c < Count; c++) {
+		COLLECTORSTATS Collector;
+		Collector.Name = CollectorNames[c];
+		for (int t = 0; t <= ThreadCount; t++) {
+			_THREADCOUNTERS* pBlock = t < ThreadCount ? ThreadBlocks[t] : &OverflowBlock;
+			_COLLECTORSLOT* pSlot = pBlock->Slots[c].load(std::memory_order_acquire);
+			if (!pSlot) continue;
+			Collector.Calls += pSlot->Calls.load(std::memory_order_relaxed);
+			Collector.TotalNanoseconds += pSlot->TotalNanoseconds.load(std::memory_order_relaxed);
+			Collector.MaxNanoseconds = std::max(Collector.MaxNanoseconds, pSlot->MaxNanoseconds.load(std::memory_order_relaxed));
+			Collector.WMIQueries += pSlot->WMIQueries.load(std::memory_order_relaxed);
+			Collector.SystemCalls += pSlot->SystemCalls.load(std::memory_order_relaxed);
+			Collector.BytesRead += pSlot->BytesRead.load(std::memory_order_relaxed);
+			Collector.Allocations += pSlot->Allocations.load(std::memory_order_relaxed);
+			Collector.AllocatedBytes += pSlot->AllocatedBytes.load(std::memory_order_relaxed);
+		}
+
+		LatencyHistogram Histogram = GetCollectorHistogram(c);
+		Collector.P50Nanoseconds = Histogram.Percentile(50);
+		Collector.P90Nanoseconds = Histogram.Percentile(90);
+		Collector.P99Nanoseconds = Histogram.Percentile(99);
+		Stats.push_back(std::move(Collector));
+	}
+	return Stats;
+}
+
+CollectorScope::CollectorScope(int CollectorId) : CollectorId(CollectorId), PreviousCollectorId(CurrentCollectorId) {
+	// The slot is created up front so that counts made inside the scope find it.
+	GetSlot(CollectorId);
+	CurrentCollectorId = CollectorId;
+	Start = Clock::Timestamp();
+}
+
+CollectorScope::~CollectorScope() {
+	UINT64 Nanoseconds = Clock::Timestamp() - Start;
+	CurrentCollectorId = PreviousCollectorId;
+	Instrumentation::_RecordCall(CollectorId, Nanoseconds);
+}
@@ -0,0 +1,74 @@
+/* Info: Self-instrumentation of the probe: per-collector latency histograms and counts of WMI queries, system calls, bytes read and heap allocations. */
+#pragma once
+#include "SysInfoTypes.hpp"		// For COLLECTORSTATS
+#include "Clock.hpp"			// For collector timings
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*
+ * Log-linear latency histogram in nanoseconds. Values below 8 get their own bucket; above that, every power of two
+ * is split into 8 linear sub-buckets, which bounds the relative error of any percentile to 12.5%.
+ */
+class LatencyHistogram {
+public:
+	static constexpr int SubBucketBits = 3;
+	static constexpr int SubBuckets = 1 << SubBucketBits;
+	static constexpr int MaxMagnitude = 44;		// 2^44 ns, about 4.9 hours; longer values land in the last bucket.
+	static constexpr int BucketCount = (MaxMagnitude - SubBucketBits + 2) * SubBuckets;
+
+	UINT64 Buckets[BucketCount] = { 0 };
+
+	static int BucketIndex(UINT64 Nanoseconds);
+	static UINT64 BucketLowerBound(int Index);
+
+	void Record(UINT64 Nanoseconds) { Buckets[BucketIndex(Nanoseconds)]++; }
+	void Merge(const LatencyHistogram& Other);
+	UINT64 Count() const;
+	// Upper bound of the bucket holding the given percentile (0-100); 0 when empty.
+	UINT64 Percentile(double Percent) const;
+};
+
+/*
+ * Every thread records into counters only it writes, so recording never contends; readers sum all threads.
+ * Counts are attributed to the innermost collector running on the calling thread and dropped outside any.
+ */
+class Instrumentation {
+public:
+	static constexpr int MaxCollectors = 64;
+
+	// Returns the identifier of a collector, registering the name on first use.
+	static int RegisterCollector(const std::string& Name);
+
+	static void CountWMIQuery();
+	static void CountSystemCall(UINT64 Count = 1);
+	static void CountBytesRead(UINT64 Bytes);
+	// Only called by the operator new of AllocationHook.hpp; allocation counts stay at zero in programs without it.
+	static void CountAllocation(UINT64 Bytes);
+
+	static std::vector<COLLECTORSTATS> GetCollectorStats();
+	static LatencyHistogram GetCollectorHistogram(int CollectorId);
+
+private:
+	friend class CollectorScope;
+	static void _RecordCall(int CollectorId, UINT64 Nanoseconds);
+};
+
+// Times the enclosing scope and makes it the collector that counts are attributed to.
+class CollectorScope {
+public:
+	explicit CollectorScope(int CollectorId);
+	~CollectorScope();
+
+	CollectorScope(const CollectorScope&) = delete;
+	CollectorScope& operator=(const CollectorScope&) = delete;
+
+private:
+	int CollectorId;
+	int PreviousCollectorId;
+	UINT64 Start;					// Clock::Timestamp at construction.
+};
+
+#define INSTRUMENT_COLLECTOR(Name) \
+	static const int _InstrumentedCollectorId = Instrumentation::RegisterCollector(Name); \
+	CollectorScope _InstrumentedCollectorScope(_InstrumentedCollectorId)
@@ -0,0 +1,145 @@
+#include "SysInfoProbe.hpp"
+#pragma comment(lib, "SetupAPI.lib")	// Required for device enumeration
+#pragma comment(lib, "cfgmgr32.lib")	// Required for the IRQ resources of devices
+
+std::optional<Error> SysInfoProbe::GetInterruptInfo() {
+	const char* FuncName = "SysInfoProbe::GetInterruptInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
+	HDEVINFO hDevInfo = SetupDiGetClassDevsW(NULL, NULL, NULL, DIGCF_ALLCLASSES | DIGCF_PRESENT);
+	if (hDevInfo == INVALID_HANDLE_VALUE) {
+		return Error::New(FuncName, 1, L"Failed to enumerate devices.", GetLastError());
+	}
+
+	DEFER{
+		SetupDiDestroyDeviceInfoList(hDevInfo);
+	};
+
+	InterruptAssignments.clear();
+	std::vector<BYTE> ResourceBuffer;
+	SP_DEVINFO_DATA DeviceData = { sizeof(DeviceData) };
+	for (DWORD DeviceIndex = 0; SetupDiEnumDeviceInfo(hDevInfo, DeviceIndex, &DeviceData); DeviceIndex++) {
+		// Only the configuration the device actually runs with; devices without one use no interrupts.
+		LOG_CONF LogConf = 0;
+		if (CM_Get_First_Log_Conf(&LogConf, DeviceData.DevInst, ALLOC_LOG_CONF) != CR_SUCCESS) continue;
+		DEFER{ CM_Free_Log_Conf_Handle(LogConf); };
+
+		// Each descriptor is the starting point for the next one, so it is freed one step later.
+		std::string DeviceName, InstanceId;
+		RES_DES Current = LogConf, Next = 0;
+		DEFER{ if (Current != LogConf) CM_Free_Res_Des_Handle(Current); };
+		while (CM_Get_Next_Res_Des(&Next, Current, ResType_IRQ, NULL, 0) == CR_SUCCESS) {
+			if (Current != LogConf) CM_Free_Res_Des_Handle(Current);
+			Current = Next;
+
+			ULONG ulSize = 0;
+			if (CM_Get_Res_Des_Data_Size(&ulSize, Current, 0) != CR_SUCCESS || ulSize < sizeof(IRQ_DES)) continue;
+			ResourceBuffer.resize(ulSize);
+			if (CM_Get_Res_Des_Data(Current, ResourceBuffer.data(), ulSize, 0) != CR_SUCCESS) continue;
+			const IRQ_DES& Irq = *reinterpret_cast<const IRQ_DES*>(ResourceBuffer.data());
+
+			// Names are only looked up for devices that turn out to have interrupts.
+			if (InstanceId.empty()) {
+				WCHAR Buffer[MAX_DEVICE_ID_LEN] = { 0 };
+				if (CM_Get_Device_IDW(DeviceData.DevInst, Buffer, MAX_DEVICE_ID_LEN, 0) == CR_SUCCESS) InstanceId = w2s(Buffer);
+				if (SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_FRIENDLYNAME, NULL, reinterpret_cast<PBYTE>(Buffer), sizeof(Buffer), NULL) ||
+					SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_DEVICEDESC, NULL, reinterpret_cast<PBYTE>(Buffer), sizeof(Buffer), NULL))
+					DeviceName = w2s(Buffer);
+			}
+
+			INTERRUPTASSIGNMENTINFO Assignment;
+			Assignment.DeviceName = DeviceName;
+			Assignment.InstanceId = InstanceId;
+			Assignment.Vector = static_cast<LONG>(Irq.IRQD_Alloc_Num);
+			Assignment.bMessageSignaled = Assignment.Vector < 0;
+			Assignment.Affinity = Irq.IRQD_Affinity;
+			for (UINT64 Mask = Assignment.Affinity; Mask; Mask &= Mask - 1) Assignment.AffinityProcessorCount++;
+			InterruptAssignments.push_back(Assignment);
+		}
+	}
+	Instrumentation::CountSystemCall(InterruptAssignments.size() + 1);
+
+	auto r = RefreshInterruptCounters();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		return r;
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::RefreshInterruptCounters() {
+	const char* FuncName = "SysInfoProbe::RefreshInterruptCounters";
+	INSTRUMENT_COLLECTOR(FuncName);
+	const size_t ProcessorCount = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+	const WORD GroupCount = GetActiveProcessorGroupCount();
+
+	// Last refresh becomes the previous one; a changed processor count (hot add) starts over.
+	bool bHasPrevious = LastInterruptRefresh != 0 && InterruptCounts.size() == 3 * ProcessorCount;
+	std::swap(InterruptCounts, PreviousInterruptCounts);
+	std::swap(InterruptTimes, PreviousInterruptTimes);
+	InterruptCounts.resize(3 * ProcessorCount);
+	InterruptTimes.resize(3 * ProcessorCount);
+	if (!bHasPrevious) InterruptCounters.assign(ProcessorCount, INTERRUPTCOUNTERSINFO());
+
+	size_t First = 0;
+	for (WORD Group = 0; Group < GroupCount && First < ProcessorCount; Group++) {
+		size_t GroupProcessors = (std::min<size_t>)(GetActiveProcessorCount(Group), ProcessorCount - First);
+		InterruptBuffer.resize(GroupProcessors * sizeof(NTPROCESSORPERFORMANCEINFO));
+		ULONG ulSize = static_cast<ULONG>(GroupProcessors * sizeof(NTPROCESSORPERFORMANCEINFO));
+		USHORT GroupNumber = Group;
+		NTSTATUS Status = NtQuerySystemInformationEx(SystemProcessorPerformanceInformation, &GroupNumber, sizeof(GroupNumber), InterruptBuffer.data(), ulSize, NULL);
+		if (!NT_SUCCESS(Status)) {
+			return Error::New(FuncName, 1, L"Failed to query processor performance information.", Status);
+		}
+		PNTPROCESSORPERFORMANCEINFO pPerformance = reinterpret_cast<PNTPROCESSORPERFORMANCEINFO>(InterruptBuffer.data());
+		for (size_t i = 0; i < GroupProcessors; i++) {
+			InterruptCounts[First + i] = pPerformance[i].InterruptCount;
+			InterruptTimes[First + i] = pPerformance[i].InterruptTime.QuadPart;
+			InterruptTimes[ProcessorCount + First + i] = pPerformance[i].DpcTime.QuadPart;
+			InterruptTimes[2 * ProcessorCount + First + i] = pPerformance[i].KernelTime.QuadPart + pPerformance[i].UserTime.QuadPart;
+
+			INTERRUPTCOUNTERSINFO& Counters = InterruptCounters[First + i];
+			Counters.Processor = static_cast<DWORD>(First + i);
+			Counters.Group = Group;
+			Counters.Number = static_cast<BYTE>(i);
+			Counters.InterruptCount = pPerformance[i].InterruptCount;
+		}
+
+		// The interrupt entries are smaller, so the buffer already fits them.
+		ulSize = static_cast<ULONG>(GroupProcessors * sizeof(NTINTERRUPTINFO));
+		Status = NtQuerySystemInformationEx(SystemInterruptInformation, &GroupNumber, sizeof(GroupNumber), InterruptBuffer.data(), ulSize, NULL);
+		if (!NT_SUCCESS(Status)) {
+			return Error::New(FuncName, 2, L"Failed to query interrupt information.", Status);
+		}
+		PNTINTERRUPTINFO pInterrupts = reinterpret_cast<PNTINTERRUPTINFO>(InterruptBuffer.data());
+		for (size_t i = 0; i < GroupProcessors; i++) {
+			InterruptCounts[ProcessorCount + First + i] = pInterrupts[i].DpcCount;
+			InterruptCounts[2 * ProcessorCount + First + i] = pInterrupts[i].ContextSwitches;
+			InterruptCounters[First + i].DpcCount = pInterrupts[i].DpcCount;
+			InterruptCounters[First + i].ContextSwitches = pInterrupts[i].ContextSwitches;
+		}
+		Instrumentation::CountSystemCall(2);
+		Instrumentation::CountBytesRead(GroupProcessors * (sizeof(NTPROCESSORPERFORMANCEINFO) + sizeof(NTINTERRUPTINFO)));
+		First += GroupProcessors;
+	}
+
+	UINT64 Now = Clock::Monotonic();
+	double ElapsedSeconds = static_cast<double>(Now - LastInterruptRefresh) / Clock::TicksPerSecond;
+	LastInterruptRefresh = Now;
+	if (!bHasPrevious || ElapsedSeconds <= 0) return std::nullopt;
+
+	// The previous arrays are not needed afterwards, so they receive the deltas; unsigned subtraction also handles the 32-bit wrap.
+	for (size_t i = 0; i < PreviousInterruptCounts.size(); i++) PreviousInterruptCounts[i] = InterruptCounts[i] - PreviousInterruptCounts[i];
+	for (size_t i = 0; i < PreviousInterruptTimes.size(); i++) PreviousInterruptTimes[i] = InterruptTimes[i] - PreviousInterruptTimes[i];
+
+	for (size_t p = 0; p < ProcessorCount; p++) {
+		INTERRUPTCOUNTERSINFO& Counters = InterruptCounters[p];
+		Counters.InterruptsPerSecond = PreviousInterruptCounts[p] / ElapsedSeconds;
+		Counters.DpcsPerSecond = PreviousInterruptCounts[ProcessorCount + p] / ElapsedSeconds;
+		Counters.ContextSwitchesPerSecond = PreviousInterruptCounts[2 * ProcessorCount + p] / ElapsedSeconds;
+
+		UINT64 TotalTime = PreviousInterruptTimes[2 * ProcessorCount + p];
+		Counters.InterruptPercent = TotalTime ? 100.0 * PreviousInterruptTimes[p] / TotalTime : 0.0;
+		Counters.DpcPercent = TotalTime ? 100.0 * PreviousInterruptTimes[ProcessorCount + p] / TotalTime : 0.0;
+	}
+	return std::nullopt;
+}
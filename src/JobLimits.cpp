@@ -0,0 +1,94 @@
+#include "SysInfoProbe.hpp"
+
+static DWORD CountBits(KAFFINITY Mask) {
+	DWORD Count = 0;
+	for (; Mask; Mask &= Mask - 1) Count++;
+	return Count;
+}
+
+std::optional<Error> SysInfoProbe::GetJobLimits() {
+	const char* FuncName = "SysInfoProbe::GetJobLimits";
+	INSTRUMENT_COLLECTOR(FuncName);
+	JOBLIMITSINFO Limits;
+	Limits.ProcessorCount = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+
+	// The affinity mask only covers the current processor group; a process spanning several groups has no restriction to report.
+	DWORD_PTR ProcessAffinity = 0, SystemAffinity = 0;
+	USHORT GroupCount = 0;
+	GetProcessGroupAffinity(GetCurrentProcess(), &GroupCount, NULL);
+	if (GroupCount <= 1 && GetProcessAffinityMask(GetCurrentProcess(), &ProcessAffinity, &SystemAffinity)) {
+		Limits.AffinityProcessorCount = CountBits(ProcessAffinity);
+	}
+	else {
+		Limits.AffinityProcessorCount = Limits.ProcessorCount;
+	}
+	Instrumentation::CountSystemCall(3);
+
+	if (!IsProcessInJob(GetCurrentProcess(), NULL, &Limits.bInJob)) {
+		return Error::New(FuncName, 1, L"Failed to check job membership.", GetLastError());
+	}
+	Instrumentation::CountSystemCall();
+
+	if (Limits.bInJob) {
+		// A NULL handle queries the job of the calling process.
+		JOBOBJECT_EXTENDED_LIMIT_INFORMATION Extended = { 0 };
+		if (!QueryInformationJobObject(NULL, JobObjectExtendedLimitInformation, &Extended, sizeof(Extended), NULL)) {
+			return Error::New(FuncName, 2, L"Failed to query job limits.", GetLastError());
+		}
+		DWORD LimitFlags = Extended.BasicLimitInformation.LimitFlags;
+		if (LimitFlags & JOB_OBJECT_LIMIT_JOB_MEMORY) Limits.JobMemoryLimitBytes = Extended.JobMemoryLimit;
+		if (LimitFlags & JOB_OBJECT_LIMIT_PROCESS_MEMORY) Limits.ProcessMemoryLimitBytes = Extended.ProcessMemoryLimit;
+		if (LimitFlags & JOB_OBJECT_LIMIT_AFFINITY) {
+			Limits.AffinityProcessorCount = (std::min)(Limits.AffinityProcessorCount, CountBits(Extended.BasicLimitInformation.Affinity));
+		}
+		Limits.Usage.PeakJobMemoryBytes = Extended.PeakJobMemoryUsed;
+		Limits.Usage.PeakProcessMemoryBytes = Extended.PeakProcessMemoryUsed;
+
+		// Rates are in hundredths of a percent of the whole machine.
+		JOBOBJECT_CPU_RATE_CONTROL_INFORMATION RateControl = { 0 };
+		if (!QueryInformationJobObject(NULL, JobObjectCpuRateControlInformation, &RateControl, sizeof(RateControl), NULL)) {
+			return Error::New(FuncName, 3, L"Failed to query CPU rate control.", GetLastError());
+		}
+		if (RateControl.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_ENABLE) {
+			if (RateControl.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_WEIGHT_BASED) {
+				Limits.CPUWeight = RateControl.Weight;
+			}
+			else if (RateControl.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_MIN_MAX_RATE) {
+				Limits.CPURateLimitPercent = RateControl.MaxRate / 100.0;
+			}
+			else if (RateControl.ControlFlags & JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP) {
+				Limits.CPURateLimitPercent = RateControl.CpuRate / 100.0;
+			}
+		}
+
+		JOBOBJECT_BASIC_ACCOUNTING_INFORMATION Accounting = { 0 };
+		if (!QueryInformationJobObject(NULL, JobObjectBasicAccountingInformation, &Accounting, sizeof(Accounting), NULL)) {
+			return Error::New(FuncName, 4, L"Failed to query job accounting.", GetLastError());
+		}
+		Instrumentation::CountSystemCall(3);
+		Instrumentation::CountBytesRead(sizeof(Extended) + sizeof(RateControl) + sizeof(Accounting));
+		Limits.Usage.TotalCPUTime = Accounting.TotalUserTime.QuadPart + Accounting.TotalKernelTime.QuadPart;
+		Limits.Usage.ActiveProcesses = Accounting.ActiveProcesses;
+	}
+
+	// The cap is a share of every processor of the machine, so 25% of 16 processors lets 4 threads run at once.
+	Limits.EffectiveParallelism = Limits.AffinityProcessorCount;
+	if (Limits.CPURateLimitPercent > 0) {
+		// Rounded up: a cap of 2.5 processors still runs a third thread part of the time.
+		DWORD CappedProcessors = static_cast<DWORD>(Limits.ProcessorCount * Limits.CPURateLimitPercent / 100.0 + 0.999);
+		Limits.EffectiveParallelism = (std::min)(Limits.EffectiveParallelism, CappedProcessors);
+	}
+	Limits.EffectiveParallelism = (std::max<DWORD>)(Limits.EffectiveParallelism, 1);
+
+	UINT64 Now = Clock::Monotonic();
+	if (Limits.CPURateLimitPercent > 0 && LastJobRefresh != 0 && Now > LastJobRefresh && Limits.Usage.TotalCPUTime >= LastJobCPUTime) {
+		// Both figures in 100ns units: CPU time the cap allowed over the interval against CPU time the job used.
+		double Allowed = static_cast<double>(Now - LastJobRefresh) * Limits.ProcessorCount * Limits.CPURateLimitPercent / 100.0;
+		Limits.Usage.CPUCapUsagePercent = 100.0 * (Limits.Usage.TotalCPUTime - LastJobCPUTime) / Allowed;
+	}
+	LastJobCPUTime = Limits.Usage.TotalCPUTime;
+	LastJobRefresh = Now;
+
+	JobLimits = Limits;
+	return std::nullopt;
+}
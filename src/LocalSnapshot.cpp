@@ -0,0 +1,62 @@
+#include "LocalSnapshot.hpp"
+
+LocalSnapshotPublisher::~LocalSnapshotPublisher() {
+	for (const auto& Entry : Retired) delete Entry.pSnapshot;
+	delete pCurrent.load();
+}
+
+void LocalSnapshotPublisher::Publish(SYSINFOSNAPSHOT&& Snapshot) {
+	const SYSINFOSNAPSHOT* pPrevious = pCurrent.exchange(new SYSINFOSNAPSHOT(std::move(Snapshot)));
+	// A reader that sees the new epoch loaded the pointer after the exchange, so it cannot hold pPrevious.
+	UINT64 ReplacedAt = Epoch.fetch_add(1) + 1;
+	if (pPrevious) Retired.push_back({ pPrevious, ReplacedAt });
+	Reclaim();
+}
+
+void LocalSnapshotPublisher::Reclaim() {
+	if (Retired.empty()) return;
+
+	UINT64 OldestReader = IdleEpoch;
+	for (const auto& Slot : Readers) {
+		UINT64 ReaderEpoch = Slot.Epoch.load();
+		if (ReaderEpoch < OldestReader) OldestReader = ReaderEpoch;
+	}
+
+	// Retired in epoch order, so the ones that can go are a prefix.
+	size_t Count = 0;
+	while (Count < Retired.size() && Retired[Count].Epoch <= OldestReader) delete Retired[Count++].pSnapshot;
+	Retired.erase(Retired.begin(), Retired.begin() + Count);
+}
+
+std::optional<Error> LocalSnapshotReader::Open(LocalSnapshotPublisher& Publisher) {
+	const char* FuncName = "LocalSnapshotReader::Open";
+	Close();
+	for (auto& Slot : Publisher.Readers) {
+		BOOL bExpected = FALSE;
+		if (Slot.bInUse.compare_exchange_strong(bExpected, TRUE)) {
+			pPublisher = &Publisher;
+			pSlot = &Slot;
+			return std::nullopt;
+		}
+	}
+	return Error::New(FuncName, 1, L"Every reader slot of the publisher is in use.");
+}
+
+void LocalSnapshotReader::Close() {
+	if (!pSlot) return;
+	pSlot->Epoch.store(LocalSnapshotPublisher::IdleEpoch);
+	pSlot->bInUse.store(FALSE);
+	pSlot = nullptr;
+	pPublisher = nullptr;
+}
+
+const SYSINFOSNAPSHOT* LocalSnapshotReader::BeginRead() {
+	if (!pSlot) return nullptr;
+	// Announcing the epoch before loading the pointer is what keeps the publisher from freeing what gets loaded.
+	pSlot->Epoch.store(pPublisher->Epoch.load());
+	return pPublisher->pCurrent.load();
+}
+
+void LocalSnapshotReader::EndRead() {
+	if (pSlot) pSlot->Epoch.store(LocalSnapshotPublisher::IdleEpoch);
+}
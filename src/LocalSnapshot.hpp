@@ -0,0 +1,66 @@
+/* Info: Publishes immutable snapshots to threads of the same process: readers never wait, and old snapshots are freed once no reader can still see them. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SYSINFOSNAPSHOT
+#include <atomic>
+#include <optional>
+#include <vector>
+
+constexpr DWORD LocalSnapshotMaxReaders = 64;
+
+/*
+ * The current snapshot is a pointer that Publish swaps. The replaced snapshot is retired, not freed: every reader
+ * announces the epoch it started reading in, and a retired snapshot is freed by a later Publish or Reclaim once
+ * every reader still reading started after it was replaced.
+ * Publish and Reclaim must be called from one thread at a time, usually the collecting thread. Readers must be
+ * closed before the publisher is destroyed.
+ */
+class LocalSnapshotPublisher {
+public:
+	~LocalSnapshotPublisher();
+
+	void Publish(SYSINFOSNAPSHOT&& Snapshot);
+	// Frees the retired snapshots no reader can still hold; Publish does this after every swap.
+	void Reclaim();
+	size_t RetiredCount() const { return Retired.size(); }
+
+private:
+	friend class LocalSnapshotReader;
+
+	static constexpr UINT64 IdleEpoch = ~0ULL;
+
+	// One cache line each, so that readers on different cores do not invalidate each other's slot.
+	struct alignas(64) _READERSLOT {
+		std::atomic<UINT64> Epoch{ IdleEpoch };		// Global epoch at BeginRead, or IdleEpoch outside a read.
+		std::atomic<BOOL> bInUse{ FALSE };			// Claimed by an open LocalSnapshotReader.
+	};
+	struct _RETIRED {
+		const SYSINFOSNAPSHOT* pSnapshot;
+		UINT64 Epoch;			// Global epoch right after the snapshot was replaced.
+	};
+
+	std::atomic<const SYSINFOSNAPSHOT*> pCurrent{ nullptr };
+	std::atomic<UINT64> Epoch{ 0 };
+	_READERSLOT Readers[LocalSnapshotMaxReaders];
+	std::vector<_RETIRED> Retired;		// Only touched by the publishing thread.
+};
+
+/*
+ * A reader thread's claim on one slot of a publisher. BeginRead and EndRead are wait-free: a few atomic loads and
+ * stores, no locks and no allocation. A reader is used by one thread and its reads do not nest.
+ */
+class LocalSnapshotReader {
+public:
+	~LocalSnapshotReader() { Close(); }
+
+	std::optional<Error> Open(LocalSnapshotPublisher& Publisher);
+	void Close();
+
+	// The current snapshot, which stays valid and unchanged until EndRead; nullptr before the first Publish.
+	const SYSINFOSNAPSHOT* BeginRead();
+	void EndRead();
+
+private:
+	LocalSnapshotPublisher* pPublisher = nullptr;
+	LocalSnapshotPublisher::_READERSLOT* pSlot = nullptr;
+};
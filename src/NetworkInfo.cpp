@@ -1,7 +1,10 @@
 #include "SysInfoProbe.hpp"
+#pragma comment(lib, "ws2_32.lib")		// Required for inet_ntop
+#pragma comment(lib, "IPHlpApi.lib")	// Required for adapters, interface counters and TCP/UDP statistics
 
 std::optional<Error> SysInfoProbe::GetNetworkInterfacesInfo() {
 	const char* FuncName = "SysInfoProbe::GetNetworkInterfacesInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
 	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
 
     ULONG ulRequiredBufferSize = 0;
@@ -17,6 +20,8 @@ std::optional<Error> SysInfoProbe::GetNetworkInterfacesInfo() {
     if (dwRetVal != NO_ERROR) {
 		return Error::New(FuncName, 3, L"Failed to get adapter addresses.");
     }
+    Instrumentation::CountSystemCall(2);
+    Instrumentation::CountBytesRead(ulRequiredBufferSize);
 
     for (PIP_ADAPTER_ADDRESSES pAdapter = pAdapterAddresses; pAdapter != nullptr; pAdapter = pAdapter->Next) {
         NETWORKINTERFACEINFO CurrentInterfaceInfo;
@@ -32,12 +37,9 @@ std::optional<Error> SysInfoProbe::GetNetworkInterfacesInfo() {
         CurrentInterfaceInfo.InterfaceType = pAdapter->IfType;
 
         if (pAdapter->PhysicalAddressLength > 0) {
-            std::ostringstream oss;
-            for (ULONG i = 0; i < pAdapter->PhysicalAddressLength; i++) {
-                if (i != 0) oss << "-";
-                oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(pAdapter->PhysicalAddress[i]);
-            }
-            CurrentInterfaceInfo.MACAddress = oss.str();
+            FixedText<3 * MAX_ADAPTER_ADDRESS_LENGTH> MACAddress;
+            MACAddress.MACAddress(pAdapter->PhysicalAddress, pAdapter->PhysicalAddressLength);
+            CurrentInterfaceInfo.MACAddress = MACAddress.View();
         }
 
         if (pAdapter->DnsSuffix)
@@ -54,15 +56,10 @@ std::optional<Error> SysInfoProbe::GetNetworkInterfacesInfo() {
                 inet_ntop(AF_INET, &(sa_in->sin_addr), addressBuffer, sizeof(addressBuffer));
                 CurrentInterfaceInfo.IPAddresses.push_back(addressBuffer);
 
-                // Compute subnet mask using OnLinkPrefixLength.
-                unsigned int Prefix = pUnicast->OnLinkPrefixLength; // e.g., 24 for 255.255.255.0
-                unsigned int Mask = (Prefix == 0) ? 0 : (0xFFFFFFFF << (32 - Prefix));
-                std::ostringstream MaskStream;
-                MaskStream << ((Mask >> 24) & 0xFF) << "."
-                            << ((Mask >> 16) & 0xFF) << "."
-                            << ((Mask >> 8) & 0xFF) << "."
-                            << (Mask & 0xFF);
-                CurrentInterfaceInfo.SubnetMasks.push_back(MaskStream.str());
+                // Compute subnet mask using OnLinkPrefixLength, e.g., 24 for 255.255.255.0.
+                FixedText<16> Mask;
+                Mask.IPv4Mask(pUnicast->OnLinkPrefixLength);
+                CurrentInterfaceInfo.SubnetMasks.emplace_back(Mask.View());
             }
             else if (sa->sa_family == AF_INET6) {
                 // IPv6 address
@@ -71,9 +68,9 @@ std::optional<Error> SysInfoProbe::GetNetworkInterfacesInfo() {
                 CurrentInterfaceInfo.IPAddresses.push_back(addressBuffer);
 
                 // the subnet is typically represented as the prefix length.
-                std::ostringstream oss;
-                oss << static_cast<int>(pUnicast->OnLinkPrefixLength);
-                CurrentInterfaceInfo.SubnetMasks.push_back(oss.str()); // e.g., "64"
+                FixedText<4> Prefix;
+                Prefix.Unsigned(pUnicast->OnLinkPrefixLength);
+                CurrentInterfaceInfo.SubnetMasks.emplace_back(Prefix.View()); // e.g., "64"
             }
         }
 
@@ -93,5 +90,150 @@ std::optional<Error> SysInfoProbe::GetNetworkInterfacesInfo() {
         NetworkInterfaces.push_back(CurrentInterfaceInfo);
     }
 
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::RefreshNetworkCounters() {
+	const char* FuncName = "SysInfoProbe::RefreshNetworkCounters";
+	INSTRUMENT_COLLECTOR(FuncName);
+	PMIB_IF_TABLE2 pTable = NULL;
+	DWORD dwRetVal = GetIfTable2(&pTable);
+	if (dwRetVal != NO_ERROR) {
+		return Error::New(FuncName, 1, L"Failed to get interface table.", dwRetVal);
+	}
+	DEFER{ FreeMibTable(pTable); };
+	Instrumentation::CountSystemCall();
+	Instrumentation::CountBytesRead(static_cast<UINT64>(pTable->NumEntries) * sizeof(MIB_IF_ROW2));
+
+	UINT64 Now = Clock::Monotonic();
+	double ElapsedSeconds = static_cast<double>(Now - LastNetworkRefresh) / Clock::TicksPerSecond;
+	INT64 Timestamp = Clock::WallTime();
+	std::vector<NETWORKCOUNTERSINFO> Previous = std::move(NetworkCounters);
+	NetworkCounters.clear();
+
+	for (ULONG i = 0; i < pTable->NumEntries; i++) {
+		const MIB_IF_ROW2& Row = pTable->Table[i];
+		// Only the interfaces reported by GetNetworkInterfacesInfo, or every physical one if it was not called.
+		bool bWanted = NetworkInterfaces.empty() ? Row.InterfaceAndOperStatusFlags.HardwareInterface :
+			std::any_of(NetworkInterfaces.begin(), NetworkInterfaces.end(), [&](const NETWORKINTERFACEINFO& Interface) { return Interface.InterfaceIndex == Row.InterfaceIndex; });
+		if (!bWanted) continue;
+
+		NETWORKCOUNTERSINFO Counters;
+		Counters.InterfaceIndex = Row.InterfaceIndex;
+		Counters.ReceivedBytes = Row.InOctets;
+		Counters.SentBytes = Row.OutOctets;
+		Counters.ReceivedPackets = Row.InUcastPkts + Row.InNUcastPkts;
+		Counters.SentPackets = Row.OutUcastPkts + Row.OutNUcastPkts;
+		Counters.ReceiveErrors = Row.InErrors;
+		Counters.SendErrors = Row.OutErrors;
+		Counters.ReceiveDiscards = Row.InDiscards;
+		Counters.SendDiscards = Row.OutDiscards;
+
+		for (const auto& Last : Previous) {
+			if (Last.InterfaceIndex != Counters.InterfaceIndex || LastNetworkRefresh == 0 || ElapsedSeconds <= 0) continue;
+			// Counters restart when an adapter is reset; a smaller value means no rate this time.
+			if (Counters.ReceivedBytes >= Last.ReceivedBytes) Counters.ReceiveBytesPerSecond = (Counters.ReceivedBytes - Last.ReceivedBytes) / ElapsedSeconds;
+			if (Counters.SentBytes >= Last.SentBytes) Counters.SendBytesPerSecond = (Counters.SentBytes - Last.SentBytes) / ElapsedSeconds;
+			ReceiveRateSketches.Add(Counters.InterfaceIndex, Counters.ReceiveBytesPerSecond, Now);
+			SendRateSketches.Add(Counters.InterfaceIndex, Counters.SendBytesPerSecond, Now);
+		}
+		ReceivedBytesHistory.Add(Counters.InterfaceIndex, Timestamp, static_cast<INT64>(Counters.ReceivedBytes));
+		SentBytesHistory.Add(Counters.InterfaceIndex, Timestamp, static_cast<INT64>(Counters.SentBytes));
+		NetworkCounters.push_back(Counters);
+	}
+
+	LastNetworkRefresh = Now;
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::RefreshTCPStatistics() {
+	const char* FuncName = "SysInfoProbe::RefreshTCPStatistics";
+	INSTRUMENT_COLLECTOR(FuncName);
+	TCPSTATSINFO Stats;
+	for (ULONG Family : { AF_INET, AF_INET6 }) {
+		MIB_TCPSTATS2 Tcp = { };
+		DWORD dwRetVal = GetTcpStatisticsEx2(&Tcp, Family);
+		// A protocol that is not installed only leaves its share out.
+		if (dwRetVal == ERROR_NOT_SUPPORTED) continue;
+		if (dwRetVal != NO_ERROR) {
+			return Error::New(FuncName, 1, L"Failed to get TCP statistics.", dwRetVal);
+		}
+		Stats.SegmentsReceived += Tcp.dw64InSegs;
+		Stats.SegmentsSent += Tcp.dw64OutSegs;
+		Stats.SegmentsRetransmitted += Tcp.dwRetransSegs;
+		Stats.ActiveOpens += Tcp.dwActiveOpens;
+		Stats.PassiveOpens += Tcp.dwPassiveOpens;
+		Stats.FailedAttempts += Tcp.dwAttemptFails;
+		Stats.EstablishedResets += Tcp.dwEstabResets;
+		Stats.ResetsSent += Tcp.dwOutRsts;
+		Stats.ReceiveErrors += Tcp.dwInErrs;
+
+		MIB_UDPSTATS2 Udp = { };
+		dwRetVal = GetUdpStatisticsEx2(&Udp, Family);
+		if (dwRetVal != NO_ERROR) {
+			return Error::New(FuncName, 2, L"Failed to get UDP statistics.", dwRetVal);
+		}
+		Stats.UDPDatagramsReceived += Udp.dw64InDatagrams;
+		Stats.UDPDatagramsSent += Udp.dw64OutDatagrams;
+		Stats.UDPNoPorts += Udp.dwNoPorts;
+		Stats.UDPReceiveErrors += Udp.dwInErrors;
+		Stats.UDPEndpoints += Udp.dwNumAddrs;
+		Instrumentation::CountSystemCall(2);
+	}
+
+	// The statistics do not count connections by state, so both connection tables are scanned once.
+	auto CountState = [&Stats](DWORD State) {
+		Stats.TotalConnections++;
+		switch (State) {
+		case MIB_TCP_STATE_LISTEN: Stats.ListeningSockets++; break;
+		case MIB_TCP_STATE_ESTAB: Stats.EstablishedConnections++; break;
+		case MIB_TCP_STATE_TIME_WAIT: Stats.TimeWaitConnections++; break;
+		case MIB_TCP_STATE_CLOSE_WAIT: Stats.CloseWaitConnections++; break;
+		}
+	};
+	for (ULONG Family : { AF_INET, AF_INET6 }) {
+		ULONG ulSize = static_cast<ULONG>(TCPTableBuffer.size());
+		DWORD dwRetVal;
+		while ((dwRetVal = Family == AF_INET ? GetTcpTable(reinterpret_cast<PMIB_TCPTABLE>(TCPTableBuffer.data()), &ulSize, FALSE) :
+			GetTcp6Table(reinterpret_cast<PMIB_TCP6TABLE>(TCPTableBuffer.data()), &ulSize, FALSE)) == ERROR_INSUFFICIENT_BUFFER) {
+			// Connections come and go between the two calls, hence the headroom.
+			TCPTableBuffer.resize(ulSize + ulSize / 4);
+			ulSize = static_cast<ULONG>(TCPTableBuffer.size());
+			Instrumentation::CountSystemCall();
+		}
+		if (dwRetVal == ERROR_NOT_SUPPORTED) continue;
+		if (dwRetVal != NO_ERROR) {
+			return Error::New(FuncName, 3, L"Failed to get TCP connection table.", dwRetVal);
+		}
+		Instrumentation::CountSystemCall();
+		Instrumentation::CountBytesRead(ulSize);
+
+		if (Family == AF_INET) {
+			PMIB_TCPTABLE pTable = reinterpret_cast<PMIB_TCPTABLE>(TCPTableBuffer.data());
+			for (DWORD i = 0; i < pTable->dwNumEntries; i++) CountState(pTable->table[i].dwState);
+		}
+		else {
+			PMIB_TCP6TABLE pTable = reinterpret_cast<PMIB_TCP6TABLE>(TCPTableBuffer.data());
+			for (DWORD i = 0; i < pTable->dwNumEntries; i++) CountState(pTable->table[i].State);
+		}
+	}
+
+	UINT64 Now = Clock::Monotonic();
+	double ElapsedSeconds = static_cast<double>(Now - LastTCPRefresh) / Clock::TicksPerSecond;
+	if (LastTCPRefresh != 0 && ElapsedSeconds > 0) {
+		// Some counters are 32 bits wide; a counter that went backwards wrapped and gives no rate this time.
+		const TCPSTATSINFO& Last = TCPStats;
+		auto Rate = [ElapsedSeconds](UINT64 Current, UINT64 Previous) { return Current >= Previous ? (Current - Previous) / ElapsedSeconds : 0.0; };
+		Stats.RetransmitsPerSecond = Rate(Stats.SegmentsRetransmitted, Last.SegmentsRetransmitted);
+		Stats.FailedAttemptsPerSecond = Rate(Stats.FailedAttempts, Last.FailedAttempts);
+		Stats.ResetsPerSecond = Rate(Stats.EstablishedResets + Stats.ResetsSent, Last.EstablishedResets + Last.ResetsSent);
+		Stats.UDPReceiveErrorsPerSecond = Rate(Stats.UDPReceiveErrors, Last.UDPReceiveErrors);
+
+		double SentPerSecond = Rate(Stats.SegmentsSent, Last.SegmentsSent);
+		if (SentPerSecond > 0) Stats.RetransmitPercent = 100.0 * Stats.RetransmitsPerSecond / SentPerSecond;
+	}
+
+	TCPStats = Stats;
+	LastTCPRefresh = Now;
 	return std::nullopt;
 }
\ No newline at end of file
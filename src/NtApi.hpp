@@ -0,0 +1,110 @@
+/* Info: Native API layouts that the Windows SDK headers only declare partially. */
+#pragma once
+#include <Windows.h>
+#include <winternl.h>		// For NtQuerySystemInformation and UNICODE_STRING
+#pragma comment(lib, "ntdll.lib")	// Required for NtQuerySystemInformation
+
+#ifndef NT_SUCCESS
+#define NT_SUCCESS(Status) (((NTSTATUS)(Status)) >= 0)
+#endif
+#ifndef STATUS_INFO_LENGTH_MISMATCH
+#define STATUS_INFO_LENGTH_MISMATCH ((NTSTATUS)0xC0000004L)
+#endif
+
+/*
+ * One entry of NtQuerySystemInformation(SystemProcessInformation); winternl.h hides most of it behind Reserved fields.
+ * Entries are chained by NextEntryOffset and each is followed by NumberOfThreads NTTHREADINFO entries.
+ */
+typedef struct _tag_NTPROCESSINFO {
+	ULONG NextEntryOffset;
+	ULONG NumberOfThreads;
+	LARGE_INTEGER WorkingSetPrivateSize;
+	ULONG HardFaultCount;
+	ULONG NumberOfThreadsHighWatermark;
+	ULONGLONG CycleTime;
+	LARGE_INTEGER CreateTime;
+	LARGE_INTEGER UserTime;
+	LARGE_INTEGER KernelTime;
+	UNICODE_STRING ImageName;
+	LONG BasePriority;
+	HANDLE UniqueProcessId;
+	HANDLE InheritedFromUniqueProcessId;
+	ULONG HandleCount;
+	ULONG SessionId;
+	ULONG_PTR UniqueProcessKey;
+	SIZE_T PeakVirtualSize;
+	SIZE_T VirtualSize;
+	ULONG PageFaultCount;
+	SIZE_T PeakWorkingSetSize;
+	SIZE_T WorkingSetSize;
+	SIZE_T QuotaPeakPagedPoolUsage;
+	SIZE_T QuotaPagedPoolUsage;
+	SIZE_T QuotaPeakNonPagedPoolUsage;
+	SIZE_T QuotaNonPagedPoolUsage;
+	SIZE_T PagefileUsage;
+	SIZE_T PeakPagefileUsage;
+	SIZE_T PrivatePageCount;
+	LARGE_INTEGER ReadOperationCount;
+	LARGE_INTEGER WriteOperationCount;
+	LARGE_INTEGER OtherOperationCount;
+	LARGE_INTEGER ReadTransferCount;
+	LARGE_INTEGER WriteTransferCount;
+	LARGE_INTEGER OtherTransferCount;
+} NTPROCESSINFO, *PNTPROCESSINFO;
+
+// Thread entry following an NTPROCESSINFO.
+typedef struct _tag_NTTHREADINFO {
+	LARGE_INTEGER KernelTime;
+	LARGE_INTEGER UserTime;
+	LARGE_INTEGER CreateTime;
+	ULONG WaitTime;
+	PVOID StartAddress;
+	HANDLE UniqueProcessId;
+	HANDLE UniqueThreadId;
+	LONG Priority;
+	LONG BasePriority;
+	ULONG ContextSwitches;
+	ULONG ThreadState;				// One of the NtThread* values below.
+	ULONG WaitReason;				// One of the NtWait* values below, when waiting.
+} NTTHREADINFO, *PNTTHREADINFO;
+
+// KTHREAD_STATE values.
+enum : ULONG {
+	NtThreadReady = 1,
+	NtThreadRunning = 2,
+	NtThreadStandby = 3,			// Selected to run next on a processor.
+	NtThreadWaiting = 5,
+	NtThreadDeferredReady = 7
+};
+
+// KWAIT_REASON values for paging I/O.
+enum : ULONG {
+	NtWaitPageIn = 2,
+	NtWaitWrPageIn = 9
+};
+
+// SystemProcessorPerformanceInformation, one entry per processor of the queried group; winternl.h hides the DPC and interrupt fields.
+typedef struct _tag_NTPROCESSORPERFORMANCEINFO {
+	LARGE_INTEGER IdleTime;
+	LARGE_INTEGER KernelTime;		// Includes IdleTime.
+	LARGE_INTEGER UserTime;
+	LARGE_INTEGER DpcTime;
+	LARGE_INTEGER InterruptTime;
+	ULONG InterruptCount;
+} NTPROCESSORPERFORMANCEINFO, *PNTPROCESSORPERFORMANCEINFO;
+
+// SystemInterruptInformation, one entry per processor of the queried group.
+typedef struct _tag_NTINTERRUPTINFO {
+	ULONG ContextSwitches;
+	ULONG DpcCount;
+	ULONG DpcRate;
+	ULONG TimeIncrement;
+	ULONG DpcBypassCount;
+	ULONG ApcBypassCount;
+} NTINTERRUPTINFO, *PNTINTERRUPTINFO;
+
+#define SystemInterruptInformation ((SYSTEM_INFORMATION_CLASS)23)
+
+// Per-processor classes only cover one processor group; the Ex variant takes the group number as input.
+extern "C" NTSTATUS NTAPI NtQuerySystemInformationEx(SYSTEM_INFORMATION_CLASS SystemInformationClass, PVOID InputBuffer, ULONG InputBufferLength,
+	PVOID SystemInformation, ULONG SystemInformationLength, PULONG ReturnLength);
@@ -1,49 +1,16 @@
 #include "SysInfoProbe.hpp"
 #include <chrono>
 
+// Kept as it came from WMI when it is not a CIM_DATETIME.
 std::string SysInfoProbe::_FormatWMIDateTime(const std::string& WMIDateTime) {
-	int Year = std::stoi(WMIDateTime.substr(0, 4));
-	int Month = std::stoi(WMIDateTime.substr(4, 2));
-	int Day = std::stoi(WMIDateTime.substr(6, 2));
-	int Hour = std::stoi(WMIDateTime.substr(8, 2));
-	int Minutes = std::stoi(WMIDateTime.substr(10, 2));
-	int Seconds = std::stoi(WMIDateTime.substr(12, 2));
-
-	int tzMinutes = 0;
-	bool tzPlus = false;
-	std::size_t tzSignPlus = WMIDateTime.find('+');
-	std::size_t tzSignMinus = WMIDateTime.find('-');
-
-	if (tzSignPlus != std::string::npos) {
-		tzMinutes = std::stoi(WMIDateTime.substr(tzSignPlus + 1));
-		tzPlus = true;
-	}
-	else if (tzSignMinus != std::string::npos) {
-		tzMinutes = std::stoi(WMIDateTime.substr(tzSignMinus + 1));
-		tzPlus = false;
-	}
-
-	int tzHours = tzMinutes / 60;
-	int tzRemainderMinutes = tzMinutes % 60;
-
-	std::ostringstream TimezoneStream;
-	TimezoneStream << "UTC " << (tzPlus ? "+" : "-")
-		<< std::setw(2) << std::setfill('0') << tzHours << ":"
-		<< std::setw(2) << std::setfill('0') << tzRemainderMinutes;
-	std::string Timezone = TimezoneStream.str();
-
-	std::string AmPm = "AM";
-	if (Hour >= 12) {
-		AmPm = "PM";
-		if (Hour > 12) Hour -= 12; 
-	}
-	else if (Hour == 0) Hour = 12;
-
-	return std::format("{:04}-{:02}-{:02} {:02}:{:02}:{:02} {} {}", Year, Month, Day, Hour, Minutes, Seconds, AmPm, Timezone);
+	FixedText<64> Text;
+	if (!Text.WMIDateTime(WMIDateTime)) return WMIDateTime;
+	return Text.String();
 }
 
 std::optional<Error> SysInfoProbe::GetOperatingSystemInfo() {
 	const char* FuncName = "SysInfoProbe::GetOperatingSystemInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
 	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
 	const std::vector<LPCWSTR> Attributes = {
 		L"Name",
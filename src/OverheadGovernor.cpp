@@ -0,0 +1,36 @@
+#include "OverheadGovernor.hpp"
+#include <chrono>
+
+BOOL OverheadGovernor::Update(UINT64 CPUTime, UINT64 WallTime) {
+	if (WallTime == 0) return FALSE;
+	Status.UsagePercent = 100.0 * CPUTime / WallTime;
+
+	if (Status.UsagePercent > Status.BudgetPercent) {
+		HeadroomWindows = 0;
+		if (Status.Level == MaxLevel) return FALSE;
+		_ApplyLevel(Status.Level + 1);
+		return TRUE;
+	}
+
+	if (Status.UsagePercent >= Status.BudgetPercent * HeadroomRatio) {
+		HeadroomWindows = 0;
+		return FALSE;
+	}
+	if (Status.Level == 0 || ++HeadroomWindows < HeadroomWindowsToRestore) return FALSE;
+	HeadroomWindows = 0;
+	_ApplyLevel(Status.Level - 1);
+	return TRUE;
+}
+
+void OverheadGovernor::_ApplyLevel(DWORD Level) {
+	static const DWORD StretchFactors[MaxLevel + 1] = { 1, 2, 4, 4, 8, 8 };
+	if (Status.Level == 0 && Level > 0) {
+		Status.DegradedSince = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+	if (Level == 0) Status.DegradedSince = 0;
+
+	Status.Level = Level;
+	Status.StretchFactor = StretchFactors[Level];
+	Status.bLowPriorityShed = Level >= 3;
+	Status.bNormalPriorityShed = Level >= 5;
+}
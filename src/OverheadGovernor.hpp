@@ -0,0 +1,36 @@
+/* Info: Keeps the probe's own CPU usage under a budget by stretching sampling intervals and shedding low-priority samplers. */
+#pragma once
+#include "SysInfoTypes.hpp"		// For GOVERNORINFO and SAMPLER_PRIORITY
+
+/*
+ * Fed once per evaluation window with the CPU time the probe used, the governor moves between degradation levels:
+ *   0: everything at its own interval      3: intervals x4, low priority shed
+ *   1: intervals x2                         4: intervals x8, low priority shed
+ *   2: intervals x4                         5: intervals x8, low and normal priority shed
+ * A window over budget raises the level by one. The level only drops after several consecutive windows well
+ * under budget, so that restoring samplers does not immediately push usage back over it.
+ */
+class OverheadGovernor {
+public:
+	static constexpr DWORD MaxLevel = 5;
+	// Fraction of the budget under which a window counts as headroom.
+	static constexpr double HeadroomRatio = 0.5;
+	static constexpr DWORD HeadroomWindowsToRestore = 3;
+
+	explicit OverheadGovernor(double BudgetPercent = 0.5) { Status.BudgetPercent = BudgetPercent; }
+
+	// Returns TRUE when the level changed. Times are in 100ns units, as returned by GetThreadTimes.
+	BOOL Update(UINT64 CPUTime, UINT64 WallTime);
+
+	DWORD StretchFactor() const { return Status.StretchFactor; }
+	BOOL IsShed(SAMPLER_PRIORITY Priority) const {
+		return (Priority == PRIORITY_LOW && Status.bLowPriorityShed) || (Priority == PRIORITY_NORMAL && Status.bNormalPriorityShed);
+	}
+	const GOVERNORINFO& GetStatus() const { return Status; }
+
+private:
+	GOVERNORINFO Status;
+	DWORD HeadroomWindows = 0;
+
+	void _ApplyLevel(DWORD Level);
+};
@@ -0,0 +1,285 @@
+#include "PCIIds.hpp"
+#include "Serialization.hpp"	// For the ByteWriter that assembles the index
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// "PCII" in little-endian.
+constexpr DWORD PCIIdsMagic = 0x49494350;
+constexpr DWORD PCIIdsVersion = 1;
+
+// Exactly `Digits` hexadecimal digits at the start of `Text`.
+static bool ParseHex(std::string_view Text, size_t Digits, DWORD& Value) {
+	if (Text.size() < Digits) return false;
+	Value = 0;
+	for (size_t i = 0; i < Digits; i++) {
+		char c = Text[i];
+		DWORD Digit = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : 16;
+		if (Digit == 16) return false;
+		Value = Value << 4 | Digit;
+	}
+	return true;
+}
+
+// The name that follows an identifier and its separating spaces.
+static std::string_view NameAfter(std::string_view Line, size_t IdLength) {
+	Line.remove_prefix((std::min)(IdLength, Line.size()));
+	while (!Line.empty() && (Line.front() == ' ' || Line.front() == '\t')) Line.remove_prefix(1);
+	return Line;
+}
+
+std::optional<Error> PCIIdsIndex::Build(const std::filesystem::path& SourcePath, const std::filesystem::path& IndexPath) {
+	const char* FuncName = "PCIIdsIndex::Build";
+	std::ifstream Source(SourcePath);
+	if (!Source) {
+		return Error::New(FuncName, 1, L"Failed to open the pci.ids file.");
+	}
+
+	struct _DEVICE {
+		PCIIDSDEVICE Record = {};
+		std::string Name;
+		std::vector<std::pair<PCIIDSSUBSYSTEM, std::string>> Subsystems;
+	};
+	struct _VENDOR {
+		PCIIDSVENDOR Record = {};
+		std::string Name;
+		std::vector<_DEVICE> Devices;
+	};
+	std::vector<_VENDOR> Vendors;
+	std::vector<std::pair<PCIIDSCLASS, std::string>> Classes;
+
+	// Vendors come first; a "C" line starts the class section, whose indented lines are subclasses and programming interfaces.
+	bool bInClasses = false;
+	DWORD Class = 0, Subclass = 0;
+	std::string Line;
+	while (std::getline(Source, Line)) {
+		if (!Line.empty() && Line.back() == '\r') Line.pop_back();
+		if (Line.empty() || Line[0] == '#') continue;
+		std::string_view Text = Line;
+		size_t Depth = 0;
+		while (Depth < Text.size() && Text[Depth] == '\t') Depth++;
+		Text.remove_prefix(Depth);
+
+		DWORD Id = 0, SubId = 0;
+		if (Depth == 0 && Text.starts_with("C ")) {
+			if (!ParseHex(Text.substr(2), 2, Class)) continue;
+			bInClasses = true;
+			Classes.push_back({ { Class << 16, 0 }, std::string(NameAfter(Text, 4)) });
+		}
+		else if (Depth == 0) {
+			if (!ParseHex(Text, 4, Id)) continue;
+			bInClasses = false;
+			_VENDOR Vendor;
+			Vendor.Record.VendorId = static_cast<WORD>(Id);
+			Vendor.Name = NameAfter(Text, 4);
+			Vendors.push_back(std::move(Vendor));
+		}
+		else if (bInClasses && Depth == 1) {
+			if (!ParseHex(Text, 2, Subclass)) continue;
+			Classes.push_back({ { 1u << 24 | Class << 16 | Subclass << 8, 0 }, std::string(NameAfter(Text, 2)) });
+		}
+		else if (bInClasses && Depth == 2) {
+			if (!ParseHex(Text, 2, Id)) continue;
+			Classes.push_back({ { 2u << 24 | Class << 16 | Subclass << 8 | Id, 0 }, std::string(NameAfter(Text, 2)) });
+		}
+		else if (Depth == 1 && !Vendors.empty()) {
+			if (!ParseHex(Text, 4, Id)) continue;
+			_DEVICE Device;
+			Device.Record.DeviceId = static_cast<WORD>(Id);
+			Device.Name = NameAfter(Text, 4);
+			Vendors.back().Devices.push_back(std::move(Device));
+		}
+		else if (Depth == 2 && !Vendors.empty() && !Vendors.back().Devices.empty()) {
+			if (!ParseHex(Text, 4, Id) || Text.size() < 9 || !ParseHex(Text.substr(5), 4, SubId)) continue;
+			PCIIDSSUBSYSTEM Subsystem = { static_cast<WORD>(Id), static_cast<WORD>(SubId), 0 };
+			Vendors.back().Devices.back().Subsystems.push_back({ Subsystem, std::string(NameAfter(Text, 9)) });
+		}
+	}
+	if (Vendors.empty()) {
+		return Error::New(FuncName, 2, L"The file has no vendor entries.");
+	}
+
+	// Names are stored once; subsystem names in particular repeat a lot. Offset 0 is the empty name.
+	std::string Strings(1, '\0');
+	std::unordered_map<std::string, DWORD> StringOffsets;
+	auto AddString = [&](const std::string& Name) -> DWORD {
+		if (Name.empty()) return 0;
+		auto [Entry, bInserted] = StringOffsets.emplace(Name, static_cast<DWORD>(Strings.size()));
+		if (bInserted) Strings.append(Name).push_back('\0');
+		return Entry->second;
+	};
+
+	// The repository is sorted, but lookups depend on it, so it is sorted again rather than trusted.
+	std::vector<PCIIDSVENDOR> VendorTable;
+	std::vector<PCIIDSDEVICE> DeviceTable;
+	std::vector<PCIIDSSUBSYSTEM> SubsystemTable;
+	std::vector<PCIIDSCLASS> ClassTable;
+	std::stable_sort(Vendors.begin(), Vendors.end(), [](const _VENDOR& a, const _VENDOR& b) { return a.Record.VendorId < b.Record.VendorId; });
+	for (auto& Vendor : Vendors) {
+		std::stable_sort(Vendor.Devices.begin(), Vendor.Devices.end(), [](const _DEVICE& a, const _DEVICE& b) { return a.Record.DeviceId < b.Record.DeviceId; });
+		Vendor.Record.Name = AddString(Vendor.Name);
+		Vendor.Record.FirstDevice = static_cast<DWORD>(DeviceTable.size());
+		Vendor.Record.DeviceCount = static_cast<DWORD>(Vendor.Devices.size());
+		VendorTable.push_back(Vendor.Record);
+		for (auto& Device : Vendor.Devices) {
+			std::stable_sort(Device.Subsystems.begin(), Device.Subsystems.end(), [](const auto& a, const auto& b) {
+				return std::tie(a.first.SubsystemVendorId, a.first.SubsystemId) < std::tie(b.first.SubsystemVendorId, b.first.SubsystemId);
+			});
+			Device.Record.Name = AddString(Device.Name);
+			Device.Record.FirstSubsystem = static_cast<DWORD>(SubsystemTable.size());
+			Device.Record.SubsystemCount = static_cast<DWORD>(Device.Subsystems.size());
+			DeviceTable.push_back(Device.Record);
+			for (auto& [Subsystem, Name] : Device.Subsystems) {
+				Subsystem.Name = AddString(Name);
+				SubsystemTable.push_back(Subsystem);
+			}
+		}
+	}
+	std::stable_sort(Classes.begin(), Classes.end(), [](const auto& a, const auto& b) { return a.first.Key < b.first.Key; });
+	for (auto& [Record, Name] : Classes) {
+		Record.Name = AddString(Name);
+		ClassTable.push_back(Record);
+	}
+	// Keeps the file a multiple of 4 bytes, like every record.
+	Strings.resize((Strings.size() + 3) & ~static_cast<size_t>(3), '\0');
+
+	PCIIDSHEADER Header = { 0 };
+	Header.Magic = PCIIdsMagic;
+	Header.Version = PCIIdsVersion;
+	Header.VendorCount = static_cast<DWORD>(VendorTable.size());
+	Header.DeviceCount = static_cast<DWORD>(DeviceTable.size());
+	Header.SubsystemCount = static_cast<DWORD>(SubsystemTable.size());
+	Header.ClassCount = static_cast<DWORD>(ClassTable.size());
+	Header.StringsSize = static_cast<DWORD>(Strings.size());
+
+	// The records are written as they sit in memory; every supported Windows target is little-endian.
+	ByteWriter Writer;
+	Writer.WriteBytes(&Header, sizeof(Header));
+	Writer.WriteBytes(VendorTable.data(), VendorTable.size() * sizeof(PCIIDSVENDOR));
+	Writer.WriteBytes(DeviceTable.data(), DeviceTable.size() * sizeof(PCIIDSDEVICE));
+	Writer.WriteBytes(SubsystemTable.data(), SubsystemTable.size() * sizeof(PCIIDSSUBSYSTEM));
+	Writer.WriteBytes(ClassTable.data(), ClassTable.size() * sizeof(PCIIDSCLASS));
+	Writer.WriteBytes(Strings.data(), Strings.size());
+
+	std::ofstream Index(IndexPath, std::ios::binary | std::ios::trunc);
+	if (!Index) {
+		return Error::New(FuncName, 3, L"Failed to create the index file.");
+	}
+	Index.write(reinterpret_cast<const char*>(Writer.Buffer.data()), Writer.Buffer.size());
+	if (!Index) {
+		return Error::New(FuncName, 4, L"Failed to write the index file.");
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> PCIIdsIndex::Open(const std::filesystem::path& IndexPath) {
+	const char* FuncName = "PCIIdsIndex::Open";
+	Close();
+
+	hFile = CreateFileW(IndexPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) {
+		return Error::New(FuncName, 1, L"Failed to open the PCI ID index.", GetLastError());
+	}
+	LARGE_INTEGER FileSize = { 0 };
+	if (!GetFileSizeEx(hFile, &FileSize) || FileSize.QuadPart < static_cast<LONGLONG>(sizeof(PCIIDSHEADER))) {
+		Close();
+		return Error::New(FuncName, 2, L"The PCI ID index is too small.");
+	}
+
+	hMapping = CreateFileMappingW(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (hMapping) pView = static_cast<const BYTE*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!pView) {
+		DWORD LastError = GetLastError();
+		Close();
+		return Error::New(FuncName, 3, L"Failed to map the PCI ID index.", LastError);
+	}
+
+	// Only the header and the table bounds are checked here; lookups check the ranges they follow, so opening touches one page.
+	pHeader = reinterpret_cast<const PCIIDSHEADER*>(pView);
+	UINT64 ExpectedSize = sizeof(PCIIDSHEADER) + static_cast<UINT64>(pHeader->VendorCount) * sizeof(PCIIDSVENDOR) +
+		static_cast<UINT64>(pHeader->DeviceCount) * sizeof(PCIIDSDEVICE) + static_cast<UINT64>(pHeader->SubsystemCount) * sizeof(PCIIDSSUBSYSTEM) +
+		static_cast<UINT64>(pHeader->ClassCount) * sizeof(PCIIDSCLASS) + pHeader->StringsSize;
+	if (pHeader->Magic != PCIIdsMagic || pHeader->Version != PCIIdsVersion || ExpectedSize != static_cast<UINT64>(FileSize.QuadPart) ||
+		pHeader->StringsSize == 0 || pView[FileSize.QuadPart - 1] != '\0') {
+		Close();
+		return Error::New(FuncName, 4, L"The PCI ID index is corrupted or from another version.");
+	}
+	pVendors = reinterpret_cast<const PCIIDSVENDOR*>(pHeader + 1);
+	pDevices = reinterpret_cast<const PCIIDSDEVICE*>(pVendors + pHeader->VendorCount);
+	pSubsystems = reinterpret_cast<const PCIIDSSUBSYSTEM*>(pDevices + pHeader->DeviceCount);
+	pClasses = reinterpret_cast<const PCIIDSCLASS*>(pSubsystems + pHeader->SubsystemCount);
+	pStrings = reinterpret_cast<const char*>(pClasses + pHeader->ClassCount);
+	return std::nullopt;
+}
+
+void PCIIdsIndex::Close() {
+	if (pView) UnmapViewOfFile(pView);
+	if (hMapping) CloseHandle(hMapping);
+	if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+	pView = nullptr;
+	hMapping = NULL;
+	hFile = INVALID_HANDLE_VALUE;
+	pHeader = nullptr;
+}
+
+std::string_view PCIIdsIndex::_Name(DWORD Offset) const {
+	// The string table ends with a NUL, so any offset inside it is a terminated string.
+	return Offset < pHeader->StringsSize ? std::string_view(pStrings + Offset) : std::string_view();
+}
+
+std::string_view PCIIdsIndex::VendorName(WORD VendorId) const {
+	if (!pView) return std::string_view();
+	const PCIIDSVENDOR* pEnd = pVendors + pHeader->VendorCount;
+	const PCIIDSVENDOR* pVendor = std::lower_bound(pVendors, pEnd, VendorId, [](const PCIIDSVENDOR& Entry, WORD Id) { return Entry.VendorId < Id; });
+	return pVendor != pEnd && pVendor->VendorId == VendorId ? _Name(pVendor->Name) : std::string_view();
+}
+
+const PCIIDSDEVICE* PCIIdsIndex::_FindDevice(WORD VendorId, WORD DeviceId) const {
+	if (!pView) return nullptr;
+	const PCIIDSVENDOR* pEnd = pVendors + pHeader->VendorCount;
+	const PCIIDSVENDOR* pVendor = std::lower_bound(pVendors, pEnd, VendorId, [](const PCIIDSVENDOR& Entry, WORD Id) { return Entry.VendorId < Id; });
+	if (pVendor == pEnd || pVendor->VendorId != VendorId) return nullptr;
+	if (static_cast<UINT64>(pVendor->FirstDevice) + pVendor->DeviceCount > pHeader->DeviceCount) return nullptr;
+
+	const PCIIDSDEVICE* pFirst = pDevices + pVendor->FirstDevice;
+	const PCIIDSDEVICE* pLast = pFirst + pVendor->DeviceCount;
+	const PCIIDSDEVICE* pDevice = std::lower_bound(pFirst, pLast, DeviceId, [](const PCIIDSDEVICE& Entry, WORD Id) { return Entry.DeviceId < Id; });
+	return pDevice != pLast && pDevice->DeviceId == DeviceId ? pDevice : nullptr;
+}
+
+std::string_view PCIIdsIndex::DeviceName(WORD VendorId, WORD DeviceId) const {
+	const PCIIDSDEVICE* pDevice = _FindDevice(VendorId, DeviceId);
+	return pDevice ? _Name(pDevice->Name) : std::string_view();
+}
+
+std::string_view PCIIdsIndex::SubsystemName(WORD VendorId, WORD DeviceId, WORD SubsystemVendorId, WORD SubsystemId) const {
+	const PCIIDSDEVICE* pDevice = _FindDevice(VendorId, DeviceId);
+	if (!pDevice || static_cast<UINT64>(pDevice->FirstSubsystem) + pDevice->SubsystemCount > pHeader->SubsystemCount) return std::string_view();
+
+	const DWORD Key = static_cast<DWORD>(SubsystemVendorId) << 16 | SubsystemId;
+	const PCIIDSSUBSYSTEM* pFirst = pSubsystems + pDevice->FirstSubsystem;
+	const PCIIDSSUBSYSTEM* pLast = pFirst + pDevice->SubsystemCount;
+	const PCIIDSSUBSYSTEM* pSubsystem = std::lower_bound(pFirst, pLast, Key, [](const PCIIDSSUBSYSTEM& Entry, DWORD Key) {
+		return (static_cast<DWORD>(Entry.SubsystemVendorId) << 16 | Entry.SubsystemId) < Key;
+	});
+	if (pSubsystem == pLast || pSubsystem->SubsystemVendorId != SubsystemVendorId || pSubsystem->SubsystemId != SubsystemId) return std::string_view();
+	return _Name(pSubsystem->Name);
+}
+
+std::string_view PCIIdsIndex::ClassName(BYTE Class, BYTE Subclass, BYTE ProgIf) const {
+	if (!pView) return std::string_view();
+	const PCIIDSCLASS* pEnd = pClasses + pHeader->ClassCount;
+	const DWORD Keys[3] = {
+		2u << 24 | static_cast<DWORD>(Class) << 16 | static_cast<DWORD>(Subclass) << 8 | ProgIf,
+		1u << 24 | static_cast<DWORD>(Class) << 16 | static_cast<DWORD>(Subclass) << 8,
+		static_cast<DWORD>(Class) << 16
+	};
+	for (DWORD Key : Keys) {
+		const PCIIDSCLASS* pEntry = std::lower_bound(pClasses, pEnd, Key, [](const PCIIDSCLASS& Entry, DWORD Key) { return Entry.Key < Key; });
+		if (pEntry != pEnd && pEntry->Key == Key) return _Name(pEntry->Name);
+	}
+	return std::string_view();
+}
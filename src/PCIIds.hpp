@@ -0,0 +1,91 @@
+/* Info: Compact binary index of the PCI ID repository (pci.ids) for vendor, device, subsystem and class names, memory-mapped and binary-searched. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include <filesystem>
+#include <optional>
+#include <string_view>
+
+// Default index location, next to the executable; built with --build-pci-index.
+constexpr LPCWSTR PCIIdsIndexFileName = L"pci.ids.bin";
+
+// On-disk records; all little-endian, and every name is an offset into the string table.
+typedef struct _tag_PCIIDSHEADER {
+	DWORD Magic;
+	DWORD Version;
+	DWORD VendorCount;
+	DWORD DeviceCount;
+	DWORD SubsystemCount;
+	DWORD ClassCount;
+	DWORD StringsSize;
+	DWORD Reserved;
+} PCIIDSHEADER, *PPCIIDSHEADER;
+
+typedef struct _tag_PCIIDSVENDOR {
+	WORD VendorId;
+	WORD Reserved;
+	DWORD Name;
+	DWORD FirstDevice;
+	DWORD DeviceCount;
+} PCIIDSVENDOR, *PPCIIDSVENDOR;
+
+typedef struct _tag_PCIIDSDEVICE {
+	WORD DeviceId;
+	WORD Reserved;
+	DWORD Name;
+	DWORD FirstSubsystem;
+	DWORD SubsystemCount;
+} PCIIDSDEVICE, *PPCIIDSDEVICE;
+
+typedef struct _tag_PCIIDSSUBSYSTEM {
+	WORD SubsystemVendorId;
+	WORD SubsystemId;
+	DWORD Name;
+} PCIIDSSUBSYSTEM, *PPCIIDSSUBSYSTEM;
+
+typedef struct _tag_PCIIDSCLASS {
+	DWORD Key;						// Depth (0 class, 1 subclass, 2 programming interface) << 24 | Class << 16 | Subclass << 8 | ProgIf.
+	DWORD Name;
+} PCIIDSCLASS, *PPCIIDSCLASS;
+
+/*
+ * The index is the header, then the vendor, device, subsystem and class tables, each sorted by its key, then the
+ * NUL-terminated names the tables point into. A vendor owns a contiguous range of the device table and a device a
+ * range of the subsystem table, so a lookup is one or two binary searches over the mapped file: nothing is parsed
+ * or allocated when it is opened.
+ */
+class PCIIdsIndex {
+public:
+	PCIIdsIndex() = default;
+	PCIIdsIndex(const PCIIdsIndex&) = delete;
+	PCIIdsIndex& operator=(const PCIIdsIndex&) = delete;
+	~PCIIdsIndex() { Close(); }
+
+	// Converts the text repository, as published at https://pci-ids.ucw.cz, into the index read by Open.
+	static std::optional<Error> Build(const std::filesystem::path& SourcePath, const std::filesystem::path& IndexPath);
+
+	std::optional<Error> Open(const std::filesystem::path& IndexPath);
+	void Close();
+	BOOL IsOpen() const { return pView != nullptr; }
+
+	// Empty when unknown. The names point into the mapped file and stay valid until Close.
+	std::string_view VendorName(WORD VendorId) const;
+	std::string_view DeviceName(WORD VendorId, WORD DeviceId) const;
+	std::string_view SubsystemName(WORD VendorId, WORD DeviceId, WORD SubsystemVendorId, WORD SubsystemId) const;
+	// The most specific of the programming interface, subclass and class names.
+	std::string_view ClassName(BYTE Class, BYTE Subclass, BYTE ProgIf) const;
+
+private:
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = NULL;
+	const BYTE* pView = nullptr;
+	// Tables within the view, validated by Open.
+	const PCIIDSHEADER* pHeader = nullptr;
+	const PCIIDSVENDOR* pVendors = nullptr;
+	const PCIIDSDEVICE* pDevices = nullptr;
+	const PCIIDSSUBSYSTEM* pSubsystems = nullptr;
+	const PCIIDSCLASS* pClasses = nullptr;
+	const char* pStrings = nullptr;
+
+	std::string_view _Name(DWORD Offset) const;
+	const PCIIDSDEVICE* _FindDevice(WORD VendorId, WORD DeviceId) const;
+};
@@ -0,0 +1,138 @@
+#include "SysInfoProbe.hpp"
+#include <initguid.h>		// Must precede devpkey.h and pciprop.h so that their property keys are defined in this unit
+#include <devpkey.h>		// For DEVPKEY_Device_Numa_Node
+#include <pciprop.h>		// For the PCI Express link properties
+#pragma comment(lib, "SetupAPI.lib")	// Required for device enumeration
+#pragma comment(lib, "cfgmgr32.lib")	// Required for device IDs
+
+// The `Digits` hexadecimal digits that follow `Tag` in a hardware ID such as "PCI\VEN_8086&DEV_15F3&SUBSYS_00008086&REV_03".
+static bool ParseIdField(std::wstring_view Id, std::wstring_view Tag, size_t Digits, DWORD& Value) {
+	size_t Position = Id.find(Tag);
+	if (Position == std::wstring_view::npos || Position + Tag.size() + Digits > Id.size()) return false;
+	Value = 0;
+	for (wchar_t c : Id.substr(Position + Tag.size(), Digits)) {
+		if (!iswxdigit(c)) return false;
+		Value = Value << 4 | (c <= L'9' ? c - L'0' : (c | 0x20) - L'a' + 10);
+	}
+	return true;
+}
+
+// A 32-bit device property, or zero if the device does not have it.
+static DWORD GetDeviceDword(HDEVINFO hDevInfo, SP_DEVINFO_DATA& DeviceData, const DEVPROPKEY& Key) {
+	DEVPROPTYPE Type = 0;
+	DWORD Value = 0;
+	if (!SetupDiGetDevicePropertyW(hDevInfo, &DeviceData, &Key, &Type, reinterpret_cast<PBYTE>(&Value), sizeof(Value), NULL, 0)) return 0;
+	return Type == DEVPROP_TYPE_UINT32 || Type == DEVPROP_TYPE_INT32 ? Value : 0;
+}
+
+std::optional<Error> SysInfoProbe::_OpenPCINames() {
+	const char* FuncName = "SysInfoProbe::_OpenPCINames";
+	// Tried once per probe; later calls return the same outcome.
+	if (bPCINamesOpened) return PCINamesError;
+	bPCINamesOpened = TRUE;
+	WCHAR ModulePath[MAX_PATH] = { 0 };
+	DWORD Length = GetModuleFileNameW(NULL, ModulePath, MAX_PATH);
+	if (Length == 0 || Length == MAX_PATH) {
+		PCINamesError = Error::New(FuncName, 1, L"Failed to get the executable path.", GetLastError());
+		return PCINamesError;
+	}
+	// A missing index is not an error: names then come from the drivers, as they did before the index existed.
+	auto r = PCINames.Open(std::filesystem::path(ModulePath).replace_filename(PCIIdsIndexFileName));
+	if (r && r.value().LastErrorCode != ERROR_FILE_NOT_FOUND) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		PCINamesError = r;
+	}
+	return PCINamesError;
+}
+
+std::optional<Error> SysInfoProbe::GetPCIDevices() {
+	const char* FuncName = "SysInfoProbe::GetPCIDevices";
+	INSTRUMENT_COLLECTOR(FuncName);
+	auto NamesError = _OpenPCINames();
+
+	auto r = _EnumeratePCIDevices(NULL, PCIDevices);
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 1);
+		return r;
+	}
+
+	// The devices are complete without their names, so a broken index is only reported once they are collected.
+	if (NamesError) {
+		NamesError.value().AddNewFunctionToStack(FuncName, 2);
+		return NamesError;
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_EnumeratePCIDevices(const GUID* pSetupClass, std::vector<PCIDEVICEINFO>& Devices) {
+	const char* FuncName = "SysInfoProbe::_EnumeratePCIDevices";
+	HDEVINFO hDevInfo = SetupDiGetClassDevsW(pSetupClass, L"PCI", NULL, pSetupClass ? DIGCF_PRESENT : DIGCF_ALLCLASSES | DIGCF_PRESENT);
+	if (hDevInfo == INVALID_HANDLE_VALUE) {
+		return Error::New(FuncName, 1, L"Failed to enumerate PCI devices.", GetLastError());
+	}
+
+	DEFER{
+		SetupDiDestroyDeviceInfoList(hDevInfo);
+	};
+
+	Devices.clear();
+	SP_DEVINFO_DATA DeviceData = { sizeof(DeviceData) };
+	for (DWORD DeviceIndex = 0; SetupDiEnumDeviceInfo(hDevInfo, DeviceIndex, &DeviceData); DeviceIndex++) {
+		// Both are REG_MULTI_SZ; the first hardware ID is the most specific one.
+		WCHAR HardwareIds[1024] = { 0 }, CompatibleIds[1024] = { 0 };
+		if (!SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_HARDWAREID, NULL, reinterpret_cast<PBYTE>(HardwareIds), sizeof(HardwareIds) - 2 * sizeof(WCHAR), NULL)) continue;
+		SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_COMPATIBLEIDS, NULL, reinterpret_cast<PBYTE>(CompatibleIds), sizeof(CompatibleIds) - 2 * sizeof(WCHAR), NULL);
+
+		PCIDEVICEINFO Device;
+		DWORD Value = 0;
+		std::wstring_view HardwareId = HardwareIds;
+		if (ParseIdField(HardwareId, L"VEN_", 4, Value)) Device.VendorId = static_cast<WORD>(Value);
+		if (ParseIdField(HardwareId, L"DEV_", 4, Value)) Device.DeviceId = static_cast<WORD>(Value);
+		// SUBSYS_ is the subsystem ID followed by the subsystem vendor ID.
+		if (ParseIdField(HardwareId, L"SUBSYS_", 8, Value)) {
+			Device.SubsystemId = static_cast<WORD>(Value >> 16);
+			Device.SubsystemVendorId = static_cast<WORD>(Value);
+		}
+		if (ParseIdField(HardwareId, L"REV_", 2, Value)) Device.Revision = static_cast<BYTE>(Value);
+		for (LPCWSTR pId = CompatibleIds; *pId; pId += wcslen(pId) + 1) {
+			if (!ParseIdField(pId, L"CC_", 6, Value)) continue;
+			Device.ClassCode = static_cast<BYTE>(Value >> 16);
+			Device.Subclass = static_cast<BYTE>(Value >> 8);
+			Device.ProgIf = static_cast<BYTE>(Value);
+			break;
+		}
+
+		// For PCI, the address is the device number in the high word and the function in the low word.
+		DWORD BusNumber = 0, Address = 0;
+		if (SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_BUSNUMBER, NULL, reinterpret_cast<PBYTE>(&BusNumber), sizeof(BusNumber), NULL)) Device.Bus = BusNumber;
+		if (SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_ADDRESS, NULL, reinterpret_cast<PBYTE>(&Address), sizeof(Address), NULL)) {
+			Device.Device = static_cast<BYTE>(Address >> 16);
+			Device.Function = static_cast<BYTE>(Address);
+		}
+
+		WCHAR Buffer[MAX_DEVICE_ID_LEN] = { 0 };
+		if (CM_Get_Device_IDW(DeviceData.DevInst, Buffer, MAX_DEVICE_ID_LEN, 0) == CR_SUCCESS) Device.InstanceId = w2s(Buffer);
+		if (SetupDiGetDeviceRegistryPropertyW(hDevInfo, &DeviceData, SPDRP_DEVICEDESC, NULL, reinterpret_cast<PBYTE>(Buffer), sizeof(Buffer) - sizeof(WCHAR), NULL)) Device.Description = w2s(Buffer);
+
+		Device.CurrentLinkGeneration = GetDeviceDword(hDevInfo, DeviceData, DEVPKEY_PciDevice_CurrentLinkSpeed);
+		Device.CurrentLinkWidth = GetDeviceDword(hDevInfo, DeviceData, DEVPKEY_PciDevice_CurrentLinkWidth);
+		Device.MaxLinkGeneration = GetDeviceDword(hDevInfo, DeviceData, DEVPKEY_PciDevice_MaxLinkSpeed);
+		Device.MaxLinkWidth = GetDeviceDword(hDevInfo, DeviceData, DEVPKEY_PciDevice_MaxLinkWidth);
+		DEVPROPTYPE Type = 0;
+		INT32 NumaNode = 0;
+		if (SetupDiGetDevicePropertyW(hDevInfo, &DeviceData, &DEVPKEY_Device_Numa_Node, &Type, reinterpret_cast<PBYTE>(&NumaNode), sizeof(NumaNode), NULL, 0)) Device.NUMANode = NumaNode;
+
+		Device.VendorName = PCINames.VendorName(Device.VendorId);
+		Device.DeviceName = PCINames.DeviceName(Device.VendorId, Device.DeviceId);
+		Device.SubsystemName = PCINames.SubsystemName(Device.VendorId, Device.DeviceId, Device.SubsystemVendorId, Device.SubsystemId);
+		Device.ClassName = PCINames.ClassName(Device.ClassCode, Device.Subclass, Device.ProgIf);
+		if (Device.DeviceName.empty()) Device.DeviceName = Device.Description;
+		Devices.push_back(std::move(Device));
+	}
+	Instrumentation::CountSystemCall(Devices.size() * 10 + 1);
+
+	std::sort(Devices.begin(), Devices.end(), [](const PCIDEVICEINFO& a, const PCIDEVICEINFO& b) {
+		return std::tie(a.Bus, a.Device, a.Function) < std::tie(b.Bus, b.Device, b.Function);
+	});
+	return std::nullopt;
+}
@@ -0,0 +1,117 @@
+#include "SysInfoProbe.hpp"
+
+static bool ProcessKeyLess(const PROCESSCOUNTERSINFO& a, const PROCESSCOUNTERSINFO& b) {
+	return a.ProcessId != b.ProcessId ? a.ProcessId < b.ProcessId : a.CreateTime < b.CreateTime;
+}
+
+std::optional<Error> SysInfoProbe::RefreshProcessCounters() {
+	const char* FuncName = "SysInfoProbe::RefreshProcessCounters";
+	INSTRUMENT_COLLECTOR(FuncName);
+	if (LastProcessScan != 0 && Clock::Monotonic() - LastProcessScan < ProcessScanReuseTicks) return std::nullopt;
+	auto r = _ScanProcesses();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 1);
+		return r;
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_ScanProcesses() {
+	const char* FuncName = "SysInfoProbe::_ScanProcesses";
+
+	// One call returns every process; the buffer only grows, with headroom for processes started in between.
+	// The returned size can be zero, so it grows from whichever of the two is larger.
+	ULONG ulReturned = 0;
+	NTSTATUS Status;
+	while ((Status = NtQuerySystemInformation(SystemProcessInformation, ProcessBuffer.data(), static_cast<ULONG>(ProcessBuffer.size()), &ulReturned)) == STATUS_INFO_LENGTH_MISMATCH) {
+		Instrumentation::CountSystemCall();
+		size_t Size = (std::max<size_t>)(ulReturned, ProcessBuffer.size());
+		ProcessBuffer.resize(Size + Size / 4 + 0x1000);
+	}
+	if (!NT_SUCCESS(Status)) {
+		return Error::New(FuncName, 1, L"Failed to query process information.", Status);
+	}
+	Instrumentation::CountSystemCall();
+	Instrumentation::CountBytesRead(ulReturned);
+
+	// Creation times are system times, but intervals are measured on the monotonic clock so that clock adjustments do not distort them.
+	FILETIME SystemTime = { 0 };
+	GetSystemTimeAsFileTime(&SystemTime);
+	UINT64 SystemNow = (static_cast<UINT64>(SystemTime.dwHighDateTime) << 32) | SystemTime.dwLowDateTime;
+	UINT64 Now = Clock::Monotonic();
+	double ElapsedSeconds = static_cast<double>(Now - LastProcessScan) / Clock::TicksPerSecond;
+	bool bHasPrevious = LastProcessScan != 0 && ElapsedSeconds > 0;
+	DWORD ProcessorCount = (std::max<DWORD>)(GetActiveProcessorCount(ALL_PROCESSOR_GROUPS), 1);
+
+	SCHEDULERPRESSUREINFO& Pressure = CPU.Pressure;
+	Pressure.ProcessCount = Pressure.ThreadCount = 0;
+	Pressure.RunningThreads = Pressure.ReadyThreads = Pressure.PagingWaitThreads = 0;
+	const ULONG_PTR CurrentThreadId = GetCurrentThreadId();
+
+	// The previous table is sorted by key, so each process finds its previous sample with a binary search.
+	std::swap(ProcessCounters, PreviousProcessCounters);
+	ProcessCounters.clear();
+	for (ULONG Offset = 0; ulReturned != 0;) {
+		const NTPROCESSINFO& Entry = *reinterpret_cast<const NTPROCESSINFO*>(ProcessBuffer.data() + Offset);
+		// The threads of the idle process are the idle loops of the processors.
+		if (Entry.UniqueProcessId != NULL) {
+			Pressure.ProcessCount++;
+			Pressure.ThreadCount += Entry.NumberOfThreads;
+			if (LastProcessScanSystemTime != 0 && static_cast<UINT64>(Entry.CreateTime.QuadPart) > LastProcessScanSystemTime) ProcessesCreated++;
+
+			const NTTHREADINFO* pThreads = reinterpret_cast<const NTTHREADINFO*>(&Entry + 1);
+			for (ULONG i = 0; i < Entry.NumberOfThreads; i++) {
+				switch (pThreads[i].ThreadState) {
+				case NtThreadRunning:
+					if (reinterpret_cast<ULONG_PTR>(pThreads[i].UniqueThreadId) != CurrentThreadId) Pressure.RunningThreads++;
+					break;
+				case NtThreadReady:
+				case NtThreadStandby:
+				case NtThreadDeferredReady:
+					Pressure.ReadyThreads++;
+					break;
+				case NtThreadWaiting:
+					if (pThreads[i].WaitReason == NtWaitPageIn || pThreads[i].WaitReason == NtWaitWrPageIn) Pressure.PagingWaitThreads++;
+					break;
+				}
+			}
+		}
+
+		PROCESSCOUNTERSINFO Counters;
+		Counters.ProcessId = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(Entry.UniqueProcessId));
+		Counters.CreateTime = Entry.CreateTime.QuadPart;
+		Counters.ParentProcessId = static_cast<DWORD>(reinterpret_cast<ULONG_PTR>(Entry.InheritedFromUniqueProcessId));
+		Counters.SessionId = Entry.SessionId;
+		Counters.CPUTime = Entry.UserTime.QuadPart + Entry.KernelTime.QuadPart;
+		Counters.WorkingSetBytes = Entry.WorkingSetSize;
+		Counters.PrivateBytes = Entry.PrivatePageCount;
+		Counters.ReadBytes = Entry.ReadTransferCount.QuadPart;
+		Counters.WriteBytes = Entry.WriteTransferCount.QuadPart;
+		Counters.ThreadCount = Entry.NumberOfThreads;
+		Counters.HandleCount = Entry.HandleCount;
+
+		auto Last = std::lower_bound(PreviousProcessCounters.begin(), PreviousProcessCounters.end(), Counters, ProcessKeyLess);
+		if (Last != PreviousProcessCounters.end() && !ProcessKeyLess(Counters, *Last)) {
+			// Names never change, so they are carried over instead of being converted again.
+			Counters.ImageName = std::move(Last->ImageName);
+			if (bHasPrevious) {
+				if (Counters.CPUTime >= Last->CPUTime) Counters.CPUPercent = (Counters.CPUTime - Last->CPUTime) / (ElapsedSeconds * 1e5 * ProcessorCount);
+				if (Counters.ReadBytes >= Last->ReadBytes) Counters.ReadBytesPerSecond = (Counters.ReadBytes - Last->ReadBytes) / ElapsedSeconds;
+				if (Counters.WriteBytes >= Last->WriteBytes) Counters.WriteBytesPerSecond = (Counters.WriteBytes - Last->WriteBytes) / ElapsedSeconds;
+			}
+		}
+		else {
+			// The idle process has no name.
+			Counters.ImageName = Entry.ImageName.Buffer ? w2s(std::wstring(Entry.ImageName.Buffer, Entry.ImageName.Length / sizeof(WCHAR))) : "System Idle Process";
+		}
+		ProcessCounters.push_back(std::move(Counters));
+
+		if (Entry.NextEntryOffset == 0) break;
+		Offset += Entry.NextEntryOffset;
+	}
+	std::sort(ProcessCounters.begin(), ProcessCounters.end(), ProcessKeyLess);
+
+	LastProcessScan = Now;
+	LastProcessScanSystemTime = SystemNow;
+	return std::nullopt;
+}
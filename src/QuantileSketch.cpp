@@ -0,0 +1,182 @@
+#include "QuantileSketch.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+static const double Gamma = (1.0 + QuantileSketch::RelativeAccuracy) / (1.0 - QuantileSketch::RelativeAccuracy);
+static const double LogGamma = std::log(Gamma);
+
+INT64 QuantileSketch::_BinIndex(double Value) {
+	return static_cast<INT64>(std::ceil(std::log(Value) / LogGamma));
+}
+
+// The point of the bin that is within RelativeAccuracy of both of its bounds.
+double QuantileSketch::_BinValue(INT64 Index) {
+	return 2.0 * std::pow(Gamma, static_cast<double>(Index)) / (Gamma + 1.0);
+}
+
+void QuantileSketch::_Extend(INT64 Low, INT64 High) {
+	if (Bins.empty()) {
+		Low = (std::max)(Low, High - static_cast<INT64>(MaxBins) + 1);
+		Offset = Low;
+		Bins.assign(static_cast<size_t>(High - Low + 1), 0);
+		return;
+	}
+	INT64 OldHigh = Offset + static_cast<INT64>(Bins.size()) - 1;
+	INT64 NewLow = (std::min)(Low, Offset), NewHigh = (std::max)(High, OldHigh);
+	NewLow = (std::max)(NewLow, NewHigh - static_cast<INT64>(MaxBins) + 1);
+	if (NewLow == Offset && NewHigh == OldHigh) return;
+
+	std::vector<UINT64> NewBins(static_cast<size_t>(NewHigh - NewLow + 1), 0);
+	for (size_t i = 0; i < Bins.size(); i++) {
+		INT64 Index = (std::max)(Offset + static_cast<INT64>(i), NewLow);
+		NewBins[static_cast<size_t>(Index - NewLow)] += Bins[i];
+	}
+	Bins = std::move(NewBins);
+	Offset = NewLow;
+}
+
+void QuantileSketch::Add(double Value, UINT64 Count) {
+	if (Count == 0 || std::isnan(Value)) return;
+	MinSeen = TotalCount ? (std::min)(MinSeen, Value) : Value;
+	MaxSeen = TotalCount ? (std::max)(MaxSeen, Value) : Value;
+	TotalCount += Count;
+	if (Value <= MinValue) {
+		ZeroCount += Count;
+		return;
+	}
+	INT64 Index = _BinIndex(Value);
+	_Extend(Index, Index);
+	// Below the range when the lowest bins were folded.
+	Index = (std::max)(Index, Offset);
+	Bins[static_cast<size_t>(Index - Offset)] += Count;
+}
+
+void QuantileSketch::Merge(const QuantileSketch& Other) {
+	if (Other.TotalCount == 0) return;
+	MinSeen = TotalCount ? (std::min)(MinSeen, Other.MinSeen) : Other.MinSeen;
+	MaxSeen = TotalCount ? (std::max)(MaxSeen, Other.MaxSeen) : Other.MaxSeen;
+	TotalCount += Other.TotalCount;
+	ZeroCount += Other.ZeroCount;
+	if (Other.Bins.empty()) return;
+
+	_Extend(Other.Offset, Other.Offset + static_cast<INT64>(Other.Bins.size()) - 1);
+	for (size_t i = 0; i < Other.Bins.size(); i++) {
+		INT64 Index = (std::max)(Other.Offset + static_cast<INT64>(i), Offset);
+		Bins[static_cast<size_t>(Index - Offset)] += Other.Bins[i];
+	}
+}
+
+void QuantileSketch::Clear() {
+	// The bins keep their memory; the next window usually covers the same range.
+	std::fill(Bins.begin(), Bins.end(), 0);
+	ZeroCount = 0;
+	TotalCount = 0;
+}
+
+double QuantileSketch::Quantile(double q) const {
+	if (TotalCount == 0) return 0.0;
+	double Rank = std::clamp(q, 0.0, 1.0) * (TotalCount - 1);
+	UINT64 Seen = ZeroCount;
+	double Value = MaxSeen;
+	if (Seen > Rank) {
+		Value = 0.0;
+	}
+	else {
+		for (size_t i = 0; i < Bins.size(); i++) {
+			Seen += Bins[i];
+			if (Seen > Rank) {
+				Value = _BinValue(Offset + static_cast<INT64>(i));
+				break;
+			}
+		}
+	}
+	// The extremes are known exactly, and the estimate of an extreme bin can fall outside them.
+	return std::clamp(Value, MinSeen, MaxSeen);
+}
+
+void QuantileSketch::ToInfo(SKETCHINFO& Info) const {
+	Info.Count = TotalCount;
+	Info.Min = Min();
+	Info.Max = Max();
+	Info.P50 = Quantile(0.50);
+	Info.P95 = Quantile(0.95);
+	Info.P99 = Quantile(0.99);
+	Info.ZeroCount = ZeroCount;
+
+	// Only the populated range, as cleared windows keep zero bins at both ends.
+	size_t First = 0, Last = Bins.size();
+	while (First < Last && Bins[First] == 0) First++;
+	while (Last > First && Bins[Last - 1] == 0) Last--;
+	Info.BinOffset = Offset + static_cast<INT64>(First);
+	Info.Bins.assign(Bins.begin() + First, Bins.begin() + Last);
+}
+
+std::optional<Error> QuantileSketch::FromInfo(const SKETCHINFO& Info, QuantileSketch& Out) {
+	const char* FuncName = "QuantileSketch::FromInfo";
+	// Bins of the smallest value above MinValue and of the largest double; checked before any arithmetic on the offset.
+	static const INT64 LowestBin = _BinIndex(MinValue);
+	static const INT64 HighestBin = _BinIndex((std::numeric_limits<double>::max)());
+	if (Info.Bins.size() > MaxBins || (!Info.Bins.empty() &&
+		(Info.BinOffset < LowestBin || Info.BinOffset > HighestBin - static_cast<INT64>(Info.Bins.size()) + 1))) {
+		return Error::New(FuncName, 1, L"Sketch bins are outside the range of a sketch.");
+	}
+
+	QuantileSketch Sketch;
+	Sketch.TotalCount = Info.Count;
+	Sketch.ZeroCount = Info.ZeroCount;
+	Sketch.MinSeen = Info.Min;
+	Sketch.MaxSeen = Info.Max;
+	if (!Info.Bins.empty()) {
+		Sketch._Extend(Info.BinOffset, Info.BinOffset + static_cast<INT64>(Info.Bins.size()) - 1);
+		for (size_t i = 0; i < Info.Bins.size(); i++) {
+			INT64 Index = (std::max)(Info.BinOffset + static_cast<INT64>(i), Sketch.Offset);
+			Sketch.Bins[static_cast<size_t>(Index - Sketch.Offset)] += Info.Bins[i];
+		}
+	}
+	Out = std::move(Sketch);
+	return std::nullopt;
+}
+
+WindowedSketch::WindowedSketch(size_t WindowCount, UINT64 WindowTicks) : Windows((std::max<size_t>)(WindowCount, 1)), WindowTicks(WindowTicks) {}
+
+void WindowedSketch::Rotate() {
+	Current = (Current + 1) % Windows.size();
+	Windows[Current].Clear();
+}
+
+void WindowedSketch::Add(double Value, UINT64 Now) {
+	if (WindowStart == 0) WindowStart = Now;
+	// After a gap longer than every window, all of them are stale.
+	for (size_t Rotations = 0; Now - WindowStart >= WindowTicks; Rotations++) {
+		if (Rotations == Windows.size()) {
+			WindowStart = Now;
+			break;
+		}
+		Rotate();
+		WindowStart += WindowTicks;
+	}
+	Windows[Current].Add(Value);
+}
+
+QuantileSketch WindowedSketch::Merged() const {
+	QuantileSketch Sketch;
+	for (const auto& Window : Windows) Sketch.Merge(Window);
+	return Sketch;
+}
+
+void SketchSeries::Add(UINT64 Element, double Value, UINT64 Now) {
+	auto Entry = std::lower_bound(Elements.begin(), Elements.end(), Element, [](const auto& Entry, UINT64 Key) { return Entry.first < Key; });
+	if (Entry == Elements.end() || Entry->first != Element) Entry = Elements.emplace(Entry, Element, WindowedSketch());
+	Entry->second.Add(Value, Now);
+}
+
+void SketchSeries::Export(std::vector<SKETCHINFO>& Out) const {
+	for (const auto& [Element, Sketch] : Elements) {
+		SKETCHINFO Info;
+		Info.Series = Name;
+		Info.Element = Element;
+		Sketch.Merged().ToInfo(Info);
+		Out.push_back(std::move(Info));
+	}
+}
@@ -0,0 +1,82 @@
+/* Info: Mergeable fixed-memory quantile sketches (DDSketch) and rotating windows of them, for percentiles of sampled series. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SKETCHINFO
+#include "Clock.hpp"			// For window durations
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Logarithmic bins: bin k holds the values in (gamma^(k-1), gamma^k] with gamma = (1 + a) / (1 - a), so any quantile
+ * is answered within a relative error a. Two sketches merge by adding their bins. Memory is bounded by MaxBins:
+ * past it the lowest bins are folded into one, which only loses accuracy on the smallest values.
+ */
+class QuantileSketch {
+public:
+	static constexpr double RelativeAccuracy = 0.01;
+	static constexpr size_t MaxBins = 1024;
+	// Values up to this count as zero; none of the sketched series is meaningful that close to it.
+	static constexpr double MinValue = 1e-6;
+
+	void Add(double Value, UINT64 Count = 1);
+	void Merge(const QuantileSketch& Other);
+	void Clear();
+
+	UINT64 Count() const { return TotalCount; }
+	double Min() const { return TotalCount ? MinSeen : 0.0; }
+	double Max() const { return TotalCount ? MaxSeen : 0.0; }
+	// Value at quantile `q` (0-1), within RelativeAccuracy of an actual value; 0 when empty.
+	double Quantile(double q) const;
+
+	// The SKETCHINFO carries the bins, so a sketch read back from snapshots of several hosts merges like a local one.
+	void ToInfo(SKETCHINFO& Info) const;
+	// Infos read from snapshots are untrusted: bins outside the range Add can produce are rejected.
+	static std::optional<Error> FromInfo(const SKETCHINFO& Info, QuantileSketch& Out);
+
+private:
+	std::vector<UINT64> Bins;	// Bins[i] is bin Offset + i.
+	INT64 Offset = 0;
+	UINT64 ZeroCount = 0;
+	UINT64 TotalCount = 0;
+	double MinSeen = 0.0;
+	double MaxSeen = 0.0;
+
+	static INT64 _BinIndex(double Value);
+	static double _BinValue(INT64 Index);
+	// Makes bins Low to High addressable, folding the lowest ones if the range would exceed MaxBins.
+	void _Extend(INT64 Low, INT64 High);
+};
+
+// Ring of sketches covering consecutive windows; values go to the newest, and each rotation drops the oldest.
+class WindowedSketch {
+public:
+	explicit WindowedSketch(size_t WindowCount = 5, UINT64 WindowTicks = 60 * Clock::TicksPerSecond);
+
+	// `Now` is Clock::Monotonic; windows that ended since the previous value are rotated out first.
+	void Add(double Value, UINT64 Now);
+	void Rotate();
+	// Every window merged together.
+	QuantileSketch Merged() const;
+
+private:
+	std::vector<QuantileSketch> Windows;
+	size_t Current = 0;
+	UINT64 WindowTicks;
+	UINT64 WindowStart = 0;
+};
+
+// Windowed sketches of one sampled series, one per element (processor, disk or interface), sorted by element.
+class SketchSeries {
+public:
+	explicit SketchSeries(std::string Name) : Name(std::move(Name)) {}
+
+	void Add(UINT64 Element, double Value, UINT64 Now);
+	// Appends the distribution of every element over all its windows.
+	void Export(std::vector<SKETCHINFO>& Out) const;
+
+private:
+	std::string Name;
+	std::vector<std::pair<UINT64, WindowedSketch>> Elements;
+};
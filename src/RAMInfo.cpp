@@ -1,98 +1,167 @@
 #include "SysInfoProbe.hpp"
+#pragma comment(lib, "Pdh.lib")			// Required for the NUMA node counters
 
 std::optional<Error> SysInfoProbe::GetRamInfo() {
 	const char* FuncName = "SysInfoProbe::GetRamInfo";
-	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
-	const std::vector<LPCWSTR> Attributes = {
-		L"Capacity",
-		L"Manufacturer",
-		L"PartNumber",
-		L"SerialNumber",
-		L"ConfiguredClockSpeed",
-		L"FormFactor",
-		L"MemoryType",
-		L"Speed"
-	};
-	bstr_t WQLQuery = WMIMgr.BuildWQLQueryString(L"Win32_PhysicalMemory", Attributes);
-	auto r = WMIMgr.ExecuteWQLQuery(WQLQuery);
+	INSTRUMENT_COLLECTOR(FuncName);
+	auto r = _LoadSMBIOS();
 	if (r) {
-		r.value().AddNewFunctionToStack(FuncName, 2);
+		r.value().AddNewFunctionToStack(FuncName, 1);
 		return r;
-	} 
-
-	auto [pLocator, pServices, pEnumerator] = WMIMgr.GetData();
-	IWbemClassObject* pClassObject = NULL;
-	ULONG uReturn = 0;
-	VARIANT vtProp = { 0 };
-
-	/* TODO: potential memory leak; please revisit this. */
-	/* possibility of improper variant handling. */
-	DEFER { 
-		VariantClear(&vtProp);
-		if (pClassObject) pClassObject->Release();
-	};
-
-	while (pEnumerator) {
-		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
-		if (FAILED(hr)) {
-			return Error::New(FuncName, 3, L"Failed to fetch next WMI object.", hr);
-		}
-		if (uReturn == 0) break;
-		VariantInit(&vtProp);
+	}
 
-		hr = pClassObject->Get(L"Capacity", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 4, L"Failed to get Capacity property or property is empty.", hr);
-		}
+	RAMModules = SMBIOS.MemoryDevices;
 
-		unsigned long long llRamBytes = std::stoll(vtProp.bstrVal);
-		double RamSizeInMegabytes = llRamBytes / pow(1024, 2);  // BYTES -> KB -> MB = BYTES / 1024 * 1024 
-		RAM.SizeInMegabytes = static_cast<int>(RamSizeInMegabytes);
-		RAM.SizeInGigabytes = RAM.SizeInMegabytes / 1024;
+	// RAM summarizes the machine: the total size over every module, described by the first one.
+	RAM = RAMINFO();
+	if (!RAMModules.empty()) {
+		RAM = RAMModules.front();
+		RAM.DeviceLocator.clear();
+		RAM.BankLocator.clear();
+		RAM.SizeInMegabytes = 0;
+	}
+	for (const auto& Module : RAMModules) {
+		RAM.SizeInMegabytes += Module.SizeInMegabytes;
+	}
+	RAM.SizeInGigabytes = RAM.SizeInMegabytes / 1024.0;
 
-		hr = pClassObject->Get(L"Manufacturer", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 5, L"Failed to get Manufacturer property or property is empty.", hr);
-		}
-		RAM.Manufacturer = trim(w2s(vtProp.bstrVal));
+	return std::nullopt;
+}
 
-		hr = pClassObject->Get(L"PartNumber", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 6, L"Failed to get PartNumber property or property is empty.", hr);
-		}
-		RAM.Model = trim(w2s(vtProp.bstrVal));
-		RAM.Name = trim(std::string(RAM.Manufacturer + " " + RAM.Model));
+std::optional<Error> SysInfoProbe::RefreshFreeRAM() {
+	const char* FuncName = "SysInfoProbe::RefreshFreeRAM";
+	INSTRUMENT_COLLECTOR(FuncName);
+	MEMORYSTATUSEX Status = { 0 };
+	Status.dwLength = sizeof(Status);
+	if (!GlobalMemoryStatusEx(&Status)) {
+		return Error::New(FuncName, 1, L"Failed to get memory status.", GetLastError());
+	}
+	Instrumentation::CountSystemCall();
 
-		hr = pClassObject->Get(L"SerialNumber", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
-			return Error::New(FuncName, 7, L"Failed to get SerialNumber property or property is empty.", hr);
-		}
-		RAM.SerialNumber = w2s(vtProp.bstrVal);
+	Memory.MemoryLoadPercent = Status.dwMemoryLoad;
+	Memory.TotalPhysicalBytes = Status.ullTotalPhys;
+	Memory.AvailablePhysicalBytes = Status.ullAvailPhys;
+	Memory.TotalCommitBytes = Status.ullTotalPageFile;
+	Memory.AvailableCommitBytes = Status.ullAvailPageFile;
+	MemoryAvailableHistory.Add(0, Clock::WallTime(), static_cast<INT64>(Status.ullAvailPhys));
+	return std::nullopt;
+}
 
-		hr = pClassObject->Get(L"ConfiguredClockSpeed", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_I4) {
-			return Error::New(FuncName, 8, L"Failed to get ConfiguredClockSpeed property or property is empty.", hr);
-		}
-		RAM.FrequencyInMHz = vtProp.intVal;
+/*
+ * The size of each node is only published as a performance counter, whose instances are named after the node number.
+ * The counter is missing when performance counters are disabled or corrupted; the sizes then stay at zero.
+ */
+void SysInfoProbe::_ReadNUMANodeSizes() {
+	PDH_HQUERY hQuery = NULL;
+	if (PdhOpenQueryW(NULL, 0, &hQuery) != ERROR_SUCCESS) return;
+	DEFER{ PdhCloseQuery(hQuery); };
+	PDH_HCOUNTER hTotalCounter = NULL;
+	if (PdhAddEnglishCounterW(hQuery, L"\\NUMA Node Memory(*)\\Total MBytes", 0, &hTotalCounter) != ERROR_SUCCESS ||
+		PdhCollectQueryData(hQuery) != ERROR_SUCCESS) return;
 
-		hr = pClassObject->Get(L"FormFactor", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_I4) {
-			return Error::New(FuncName, 9, L"Failed to get FormFactor property or property is empty.", hr);
-		}
-		RAM.FormFactor = RAMFormFactors[vtProp.intVal];
+	DWORD dwBufferSize = 0, dwItemCount = 0;
+	std::vector<BYTE> Buffer;
+	PDH_STATUS Status = PdhGetFormattedCounterArrayW(hTotalCounter, PDH_FMT_LARGE, &dwBufferSize, &dwItemCount, NULL);
+	if (Status == PDH_MORE_DATA) {
+		Buffer.resize(dwBufferSize);
+		Status = PdhGetFormattedCounterArrayW(hTotalCounter, PDH_FMT_LARGE, &dwBufferSize, &dwItemCount,
+			reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(Buffer.data()));
+	}
+	if (Status != ERROR_SUCCESS) return;
+	Instrumentation::CountSystemCall(4);
+	Instrumentation::CountBytesRead(dwBufferSize);
 
-		hr = pClassObject->Get(L"MemoryType", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_I4) {
-			return Error::New(FuncName, 10, L"Failed to get MemoryType property or property is empty.", hr);
+	PPDH_FMT_COUNTERVALUE_ITEM_W pItems = reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(Buffer.data());
+	for (DWORD i = 0; i < dwItemCount; i++) {
+		if (pItems[i].FmtValue.CStatus != PDH_CSTATUS_VALID_DATA || !iswdigit(pItems[i].szName[0])) continue;
+		USHORT Node = static_cast<USHORT>(wcstoul(pItems[i].szName, NULL, 10));
+		for (auto& Info : NUMANodes) {
+			if (Info.NodeNumber == Node) Info.TotalBytes = static_cast<UINT64>(pItems[i].FmtValue.largeValue) * 1024 * 1024;
 		}
-		RAM.MemoryType = RAMMemoryTypes[vtProp.intVal];
+	}
+}
+
+std::optional<Error> SysInfoProbe::GetNUMAInfo() {
+	const char* FuncName = "SysInfoProbe::GetNUMAInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
+	ULONG HighestNode = 0;
+	if (!GetNumaHighestNodeNumber(&HighestNode)) {
+		return Error::New(FuncName, 1, L"Failed to get the highest NUMA node number.", GetLastError());
+	}
+
+	NUMANodes.clear();
+	NUMACounters.clear();
+	for (ULONG Node = 0; Node <= HighestNode; Node++) {
+		// Node numbers can have gaps, which fail here.
+		GROUP_AFFINITY Affinity = { 0 };
+		if (!GetNumaNodeProcessorMaskEx(static_cast<USHORT>(Node), &Affinity)) continue;
+
+		NUMANODEINFO Info;
+		Info.NodeNumber = static_cast<USHORT>(Node);
+		Info.ProcessorGroup = Affinity.Group;
+		Info.ProcessorMask = Affinity.Mask;
+		for (KAFFINITY Mask = Affinity.Mask; Mask; Mask &= Mask - 1) Info.ProcessorCount++;
+		NUMANodes.push_back(Info);
+	}
+	Instrumentation::CountSystemCall(HighestNode + 2);
 
-		hr = pClassObject->Get(L"Speed", 0, &vtProp, 0, 0);
-		if (FAILED(hr) || vtProp.vt != VT_I4) {
-			return Error::New(FuncName, 11, L"Failed to get Speed property or property is empty.", hr);
+	_ReadNUMANodeSizes();
+
+	LargePages = LARGEPAGEINFO();
+	LargePages.LargePageMinimumBytes = GetLargePageMinimum();
+	int Registers[4] = { 0 };
+	__cpuid(Registers, 0x80000000);
+	if (static_cast<unsigned>(Registers[0]) >= 0x80000001) {
+		__cpuid(Registers, 0x80000001);
+		LargePages.bHugePagesSupported = (Registers[3] >> 26) & 1;
+	}
+
+	// Holding the privilege is enough: it is disabled by default and the allocating code enables it.
+	HANDLE hToken = NULL;
+	LUID LockMemoryLuid = { 0 };
+	if (OpenProcessToken(GetCurrentProcess(), TOKEN_QUERY, &hToken)) {
+		DEFER{ CloseHandle(hToken); };
+		DWORD dwSize = 0;
+		GetTokenInformation(hToken, TokenPrivileges, NULL, 0, &dwSize);
+		std::vector<BYTE> Privileges(dwSize);
+		if (dwSize && LookupPrivilegeValueW(NULL, SE_LOCK_MEMORY_NAME, &LockMemoryLuid) &&
+			GetTokenInformation(hToken, TokenPrivileges, Privileges.data(), dwSize, &dwSize)) {
+			PTOKEN_PRIVILEGES pPrivileges = reinterpret_cast<PTOKEN_PRIVILEGES>(Privileges.data());
+			for (DWORD i = 0; i < pPrivileges->PrivilegeCount; i++) {
+				const LUID& Luid = pPrivileges->Privileges[i].Luid;
+				if (Luid.LowPart == LockMemoryLuid.LowPart && Luid.HighPart == LockMemoryLuid.HighPart) LargePages.bLockMemoryPrivilege = TRUE;
+			}
 		}
-		RAM.LatencyInNanoseconds = vtProp.intVal;
+		Instrumentation::CountSystemCall(3);
+	}
+
+	auto r = RefreshNUMACounters();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 6);
+		return r;
 	}
+	return std::nullopt;
+}
 
+std::optional<Error> SysInfoProbe::RefreshNUMACounters() {
+	const char* FuncName = "SysInfoProbe::RefreshNUMACounters";
+	INSTRUMENT_COLLECTOR(FuncName);
+	bool bHasPrevious = NUMACounters.size() == NUMANodes.size();
+	NUMACounters.resize(NUMANodes.size());
+
+	for (size_t i = 0; i < NUMANodes.size(); i++) {
+		ULONGLONG AvailableBytes = 0;
+		if (!GetNumaAvailableMemoryNodeEx(NUMANodes[i].NodeNumber, &AvailableBytes)) {
+			return Error::New(FuncName, 1, L"Failed to get available memory of NUMA node.", GetLastError());
+		}
+		Instrumentation::CountSystemCall();
+
+		NUMANODECOUNTERSINFO& Counters = NUMACounters[i];
+		Counters.AvailableBytesChange = bHasPrevious ? static_cast<INT64>(AvailableBytes) - static_cast<INT64>(Counters.AvailableBytes) : 0;
+		Counters.NodeNumber = NUMANodes[i].NodeNumber;
+		Counters.AvailableBytes = AvailableBytes;
+		if (NUMANodes[i].TotalBytes && AvailableBytes <= NUMANodes[i].TotalBytes)
+			Counters.UsedPercent = 100.0 * (NUMANodes[i].TotalBytes - AvailableBytes) / NUMANodes[i].TotalBytes;
+	}
 	return std::nullopt;
 }
\ No newline at end of file
@@ -0,0 +1,297 @@
+#include "SMBIOS.hpp"
+#include "Utils.hpp"
+#include <cstring>
+#include <cstddef>
+#include <string_view>
+
+// A structure being walked: its formatted area and where its string set starts.
+typedef struct _tag_SMBIOSSTRUCTURE {
+	const BYTE* pFormatted;
+	BYTE Length;
+	const char* pStrings;
+} SMBIOSSTRUCTURE;
+
+// Fields past the formatted length belong to a newer SMBIOS version than the firmware implements; they read as zero.
+static BYTE ReadByte(const SMBIOSSTRUCTURE& Structure, size_t Offset) {
+	return Offset + 1 <= Structure.Length ? Structure.pFormatted[Offset] : 0;
+}
+
+static WORD ReadWord(const SMBIOSSTRUCTURE& Structure, size_t Offset) {
+	WORD Value = 0;
+	if (Offset + sizeof(Value) <= Structure.Length) memcpy(&Value, Structure.pFormatted + Offset, sizeof(Value));
+	return Value;
+}
+
+static DWORD ReadDword(const SMBIOSSTRUCTURE& Structure, size_t Offset) {
+	DWORD Value = 0;
+	if (Offset + sizeof(Value) <= Structure.Length) memcpy(&Value, Structure.pFormatted + Offset, sizeof(Value));
+	return Value;
+}
+
+static UINT64 ReadQword(const SMBIOSSTRUCTURE& Structure, size_t Offset) {
+	UINT64 Value = 0;
+	if (Offset + sizeof(Value) <= Structure.Length) memcpy(&Value, Structure.pFormatted + Offset, sizeof(Value));
+	return Value;
+}
+
+// Strings are referenced by 1-based index into the null-terminated set following the formatted area; 0 means "none".
+static std::string ReadString(const SMBIOSSTRUCTURE& Structure, size_t Offset) {
+	BYTE Index = ReadByte(Structure, Offset);
+	if (Index == 0) return std::string();
+
+	const char* pString = Structure.pStrings;
+	for (BYTE i = 1; i < Index && *pString; i++) {
+		pString += strlen(pString) + 1;
+	}
+	return trim(pString);
+}
+
+// Indexed by the SMBIOS type 17 "Form Factor" code.
+static constexpr std::string_view RAMFormFactors[] = {
+	"",
+	"Other",
+	"Unknown",
+	"SIMM",
+	"SIP",
+	"Chip",
+	"DIP",
+	"ZIP",
+	"Proprietary Card",
+	"DIMM",
+	"TSOP",
+	"Row of chips",
+	"RIMM",
+	"SODIMM",
+	"SRIMM",
+	"FB-DIMM",
+	"Die",
+	"CAMM"
+};
+
+// Indexed by the SMBIOS type 17 "Memory Type" code.
+static constexpr std::string_view RAMMemoryTypes[] = {
+	"",
+	"Other",
+	"Unknown",
+	"DRAM",
+	"EDRAM",
+	"VRAM",
+	"SRAM",
+	"RAM",
+	"ROM",
+	"Flash",
+	"EEPROM",
+	"FEPROM",
+	"EPROM",
+	"CDRAM",
+	"3DRAM",
+	"SDRAM",
+	"SGRAM",
+	"RDRAM",
+	"DDR",
+	"DDR2",
+	"DDR2 FB-DIMM",
+	"",
+	"",
+	"",
+	"DDR3",
+	"FBD2",
+	"DDR4",
+	"LPDDR",
+	"LPDDR2",
+	"LPDDR3",
+	"LPDDR4",
+	"Logical non-volatile device",
+	"HBM",
+	"HBM2",
+	"DDR5",
+	"LPDDR5",
+	"HBM3"
+};
+
+static std::string LookupName(const std::string_view* pTable, size_t TableSize, size_t Code) {
+	return Code < TableSize ? std::string(pTable[Code]) : std::string();
+}
+
+static void ParseBIOS(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	Out.BIOS.Manufacturer = ReadString(Structure, 0x04);
+	Out.BIOS.Version = ReadString(Structure, 0x05);
+	Out.BIOS.ReleaseDate = ReadString(Structure, 0x08);
+
+	// 0xFF marks a firmware that does not report its release numbers.
+	BYTE MajorRelease = ReadByte(Structure, 0x14);
+	BYTE MinorRelease = ReadByte(Structure, 0x15);
+	if (Structure.Length > 0x15 && MajorRelease != 0xFF) {
+		Out.BIOS.BuildNumber = std::to_string(MajorRelease) + "." + std::to_string(MinorRelease);
+	}
+}
+
+static void ParseSystem(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	Out.BIOS.SerialNumber = ReadString(Structure, 0x07);
+}
+
+static void ParseBaseboard(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	// Multi-board systems list several type 2 structures; the first one is the main board.
+	if (!Out.Mainboard.Manufacturer.empty() || !Out.Mainboard.Name.empty()) return;
+
+	Out.Mainboard.Manufacturer = ReadString(Structure, 0x04);
+	Out.Mainboard.Name = ReadString(Structure, 0x05);
+	Out.Mainboard.Version = ReadString(Structure, 0x06);
+	Out.Mainboard.SerialNumber = ReadString(Structure, 0x07);
+}
+
+static void ParseProcessor(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	CPUSOCKETINFO Socket;
+	Socket.SocketDesignation = ReadString(Structure, 0x04);
+	Socket.Manufacturer = ReadString(Structure, 0x07);
+	Socket.Version = ReadString(Structure, 0x10);
+	Socket.MaxSpeedMHz = ReadWord(Structure, 0x14);
+	Socket.CurrentSpeedMHz = ReadWord(Structure, 0x16);
+	Socket.bPopulated = (ReadByte(Structure, 0x18) & (1 << 6)) != 0;
+
+	// Counts above 254 are reported as 0xFF with the real value in the SMBIOS 3.0 "2" fields.
+	BYTE CoreCount = ReadByte(Structure, 0x23);
+	BYTE ThreadCount = ReadByte(Structure, 0x25);
+	Socket.CoreCount = CoreCount == 0xFF ? ReadWord(Structure, 0x2A) : CoreCount;
+	Socket.ThreadCount = ThreadCount == 0xFF ? ReadWord(Structure, 0x2E) : ThreadCount;
+
+	Out.Sockets.push_back(Socket);
+}
+
+// Cache sizes are 15 (or 31) bits with a top bit selecting 1K or 64K granularity.
+static UINT64 DecodeCacheSize(UINT64 RawSize, int GranularityBit) {
+	UINT64 Size = RawSize & ((1ULL << GranularityBit) - 1);
+	return (RawSize & (1ULL << GranularityBit)) ? Size * 64 : Size;
+}
+
+static void ParseCache(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	CACHEINFO Cache;
+	Cache.SocketDesignation = ReadString(Structure, 0x04);
+	Cache.Level = (ReadWord(Structure, 0x05) & 0x07) + 1;
+
+	WORD InstalledSize = ReadWord(Structure, 0x09);
+	if (InstalledSize == 0xFFFF && Structure.Length >= 0x1B) {
+		Cache.SizeInKilobytes = DecodeCacheSize(ReadDword(Structure, 0x17), 31);
+	}
+	else {
+		Cache.SizeInKilobytes = DecodeCacheSize(InstalledSize, 15);
+	}
+
+	Out.Caches.push_back(Cache);
+}
+
+static void ParseMemoryDevice(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	// A size of zero is an empty slot; 0xFFFF is a populated slot of unknown size.
+	WORD Size = ReadWord(Structure, 0x0C);
+	if (Size == 0) return;
+
+	RAMINFO Module;
+	if (Size == 0x7FFF) {
+		Module.SizeInMegabytes = static_cast<int>(ReadDword(Structure, 0x1C) & 0x7FFFFFFF);
+	}
+	else if (Size != 0xFFFF) {
+		// Bit 15 set means the size is in kilobytes instead of megabytes.
+		Module.SizeInMegabytes = (Size & 0x8000) ? (Size & 0x7FFF) / 1024 : Size;
+	}
+	Module.SizeInGigabytes = Module.SizeInMegabytes / 1024.0;
+
+	Module.FormFactor = LookupName(RAMFormFactors, std::size(RAMFormFactors), ReadByte(Structure, 0x0E));
+	Module.DeviceLocator = ReadString(Structure, 0x10);
+	Module.BankLocator = ReadString(Structure, 0x11);
+	Module.MemoryType = LookupName(RAMMemoryTypes, std::size(RAMMemoryTypes), ReadByte(Structure, 0x12));
+
+	// Speeds of 0xFFFF moved to the SMBIOS 3.3 extended fields.
+	WORD Speed = ReadWord(Structure, 0x15);
+	Module.LatencyInNanoseconds = Speed == 0xFFFF ? static_cast<int>(ReadDword(Structure, 0x54) & 0x7FFFFFFF) : Speed;
+	WORD ConfiguredSpeed = ReadWord(Structure, 0x20);
+	Module.FrequencyInMHz = ConfiguredSpeed == 0xFFFF ? static_cast<int>(ReadDword(Structure, 0x58) & 0x7FFFFFFF) : ConfiguredSpeed;
+
+	Module.Manufacturer = ReadString(Structure, 0x17);
+	Module.SerialNumber = ReadString(Structure, 0x18);
+	Module.Model = ReadString(Structure, 0x1A);
+	Module.Name = trim(Module.Manufacturer + " " + Module.Model);
+
+	Out.MemoryDevices.push_back(Module);
+}
+
+static void ParseMemoryArrayMappedAddress(const SMBIOSSTRUCTURE& Structure, SMBIOSINFO& Out) {
+	MEMORYRANGEINFO Range;
+	DWORD StartingAddress = ReadDword(Structure, 0x04);
+	if (StartingAddress == 0xFFFFFFFF) {
+		Range.StartingAddress = ReadQword(Structure, 0x0F);
+		Range.EndingAddress = ReadQword(Structure, 0x17);
+	}
+	else {
+		// The 32-bit fields are in kilobytes; the extended ones are in bytes.
+		Range.StartingAddress = static_cast<UINT64>(StartingAddress) * 1024;
+		Range.EndingAddress = static_cast<UINT64>(ReadDword(Structure, 0x08)) * 1024 + 1023;
+	}
+	Range.PartitionWidth = ReadByte(Structure, 0x0E);
+
+	Out.MemoryRanges.push_back(Range);
+}
+
+std::optional<Error> ParseSMBIOSTable(const BYTE* pTable, size_t TableSize, BYTE MajorVersion, BYTE MinorVersion, SMBIOSINFO& Out) {
+	const char* FuncName = "ParseSMBIOSTable";
+	if (!pTable) return Error::New(FuncName, 1, L"Invalid SMBIOS table.");
+
+	Out = SMBIOSINFO();
+	Out.MajorVersion = MajorVersion;
+	Out.MinorVersion = MinorVersion;
+
+	size_t Offset = 0;
+	while (Offset + 4 <= TableSize) {
+		SMBIOSSTRUCTURE Structure;
+		BYTE Type = pTable[Offset];
+		Structure.pFormatted = pTable + Offset;
+		Structure.Length = pTable[Offset + 1];
+		if (Structure.Length < 4 || Offset + Structure.Length > TableSize) {
+			return Error::New(FuncName, 2, L"SMBIOS structure overruns the table.");
+		}
+
+		// The string set ends with two consecutive null bytes, even when the structure has no strings.
+		size_t StringsEnd = Offset + Structure.Length;
+		while (StringsEnd + 1 < TableSize && (pTable[StringsEnd] != 0 || pTable[StringsEnd + 1] != 0)) StringsEnd++;
+		if (StringsEnd + 1 >= TableSize) {
+			return Error::New(FuncName, 3, L"SMBIOS string set is not terminated.");
+		}
+		Structure.pStrings = reinterpret_cast<const char*>(pTable + Offset + Structure.Length);
+
+		switch (Type) {
+		case 0: ParseBIOS(Structure, Out); break;
+		case 1: ParseSystem(Structure, Out); break;
+		case 2: ParseBaseboard(Structure, Out); break;
+		case 4: ParseProcessor(Structure, Out); break;
+		case 7: ParseCache(Structure, Out); break;
+		case 17: ParseMemoryDevice(Structure, Out); break;
+		case 19: ParseMemoryArrayMappedAddress(Structure, Out); break;
+		}
+
+		// Type 127 is the end-of-table marker.
+		if (Type == 127) break;
+		Offset = StringsEnd + 2;
+	}
+
+	return std::nullopt;
+}
+
+std::optional<Error> ParseRawSMBIOSData(const BYTE* pData, size_t DataSize, SMBIOSINFO& Out) {
+	const char* FuncName = "ParseRawSMBIOSData";
+	const size_t HeaderSize = offsetof(RAWSMBIOSDATA, SMBIOSTableData);
+	if (!pData || DataSize < HeaderSize) {
+		return Error::New(FuncName, 1, L"SMBIOS data is smaller than its header.");
+	}
+
+	const RAWSMBIOSDATA* pRaw = reinterpret_cast<const RAWSMBIOSDATA*>(pData);
+	if (pRaw->Length > DataSize - HeaderSize) {
+		return Error::New(FuncName, 2, L"SMBIOS table length exceeds the data size.");
+	}
+
+	auto r = ParseSMBIOSTable(pRaw->SMBIOSTableData, pRaw->Length, pRaw->SMBIOSMajorVersion, pRaw->SMBIOSMinorVersion, Out);
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 3);
+		return r;
+	}
+
+	return std::nullopt;
+}
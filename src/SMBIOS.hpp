@@ -0,0 +1,24 @@
+/* Info: Single-pass parser for the SMBIOS/DMI structure table. It only works on bytes, so captured tables can be fed to it directly. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SMBIOSINFO and the types it holds
+#include <optional>
+
+// Layout returned by GetSystemFirmwareTable('RSMB', ...); not declared by the Windows SDK headers.
+typedef struct _tag_RAWSMBIOSDATA {
+	BYTE Used20CallingMethod;
+	BYTE SMBIOSMajorVersion;
+	BYTE SMBIOSMinorVersion;
+	BYTE DmiRevision;
+	DWORD Length;
+	BYTE SMBIOSTableData[1];
+} RAWSMBIOSDATA, *PRAWSMBIOSDATA;
+
+/*
+ * Walks a bare structure table (the format of /sys/firmware/dmi/tables/DMI) once and fills `Out`
+ * from structure types 0, 1, 2, 4, 7, 17 and 19. The version is needed because later versions extend the structures.
+ */
+std::optional<Error> ParseSMBIOSTable(const BYTE* pTable, size_t TableSize, BYTE MajorVersion, BYTE MinorVersion, SMBIOSINFO& Out);
+
+// Same as ParseSMBIOSTable, for a blob prefixed with the RAWSMBIOSDATA header.
+std::optional<Error> ParseRawSMBIOSData(const BYTE* pData, size_t DataSize, SMBIOSINFO& Out);
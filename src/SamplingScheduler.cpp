@@ -0,0 +1,335 @@
+#include "SamplingScheduler.hpp"
+#include "SysInfoProbe.hpp"
+#include <cmath>
+#include <random>
+#include <utility>
+
+using namespace std::chrono;
+
+void SamplingScheduler::AddSampler(const std::string& Name, milliseconds Interval, milliseconds MaxInterval, SamplerFunction Sample, SAMPLER_PRIORITY Priority) {
+	_SAMPLER Sampler;
+	Interval = std::max(Interval, milliseconds(1));
+	Sampler.Status.Name = Name;
+	Sampler.Status.Priority = Priority;
+	Sampler.Status.BaseInterval = Interval;
+	// Kept a multiple of the base interval so that backed-off samples stay on the grid.
+	Sampler.Status.MaxInterval = std::max<milliseconds::rep>(MaxInterval / Interval, 1) * Interval;
+	Sampler.Status.CurrentInterval = Interval;
+	Sampler.Sample = std::move(Sample);
+	Sampler.CollectorId = Instrumentation::RegisterCollector("Sampler:" + Name);
+	Samplers.push_back(std::move(Sampler));
+}
+
+void SamplingScheduler::SetGovernor(OverheadGovernor* pNewGovernor, seconds Window) {
+	pGovernor = pNewGovernor;
+	GovernorWindow = std::max(Window, seconds(1));
+}
+
+GOVERNORINFO SamplingScheduler::GetGovernorStatus() const {
+	std::lock_guard Lock(StatusLock);
+	return pGovernor ? pGovernor->GetStatus() : GOVERNORINFO();
+}
+
+std::optional<Error> SamplingScheduler::_Prepare() {
+	const char* FuncName = "SamplingScheduler::_Prepare";
+	if (!hStopEvent) {
+		hStopEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+		if (!hStopEvent) return Error::New(FuncName, 1, L"Failed to create the stop event.", GetLastError());
+	}
+	ResetEvent(hStopEvent);
+
+	if (!hTimer) {
+		hTimer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
+		if (!hTimer) return Error::New(FuncName, 2, L"Failed to create the waitable timer.", GetLastError());
+	}
+
+	// Sample timestamps switch to the TSC here, before the first sample, rather than in the middle of a run.
+	Clock::Calibrate();
+	return std::nullopt;
+}
+
+std::optional<Error> SamplingScheduler::Run() {
+	const char* FuncName = "SamplingScheduler::Run";
+	auto r = _Prepare();
+	if (!r) r = _Loop();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 1);
+		return r;
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SamplingScheduler::Start() {
+	const char* FuncName = "SamplingScheduler::Start";
+	if (Worker.joinable()) return Error::New(FuncName, 1, L"Scheduler is already running.");
+	auto r = _Prepare();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		return r;
+	}
+	WorkerError.reset();
+	Worker = std::thread([this, FuncName]() {
+		WorkerError = _Loop();
+		if (WorkerError) WorkerError.value().AddNewFunctionToStack(FuncName, 3);
+	});
+	return std::nullopt;
+}
+
+std::optional<Error> SamplingScheduler::Stop() {
+	if (hStopEvent) SetEvent(hStopEvent);
+	if (Worker.joinable()) Worker.join();
+	if (hTimer) CloseHandle(hTimer);
+	if (hStopEvent) CloseHandle(hStopEvent);
+	hTimer = NULL;
+	hStopEvent = NULL;
+	return std::exchange(WorkerError, std::nullopt);
+}
+
+std::vector<SAMPLERSTATUS> SamplingScheduler::GetStatus() const {
+	std::lock_guard Lock(StatusLock);
+	std::vector<SAMPLERSTATUS> Status;
+	for (const auto& Sampler : Samplers) Status.push_back(Sampler.Status);
+	return Status;
+}
+
+bool SamplingScheduler::_RunSampler(_SAMPLER& Sampler, steady_clock::time_point Epoch) {
+	UINT64 Signature = 0;
+	UINT64 SampledAt = Clock::Timestamp();
+	std::optional<Error> r;
+	{
+		CollectorScope Scope(Sampler.CollectorId);
+		r = Sampler.Sample(Signature);
+	}
+
+	std::lock_guard Lock(StatusLock);
+	SAMPLERSTATUS& Status = Sampler.Status;
+	bool bUnchanged = !r && Status.RunCount > 0 && !Status.LastError && Signature == Sampler.LastSignature;
+	Status.RunCount++;
+	Status.LastSampledAt = SampledAt;
+	Status.LastError = r;
+	if (!r) Sampler.LastSignature = Signature;
+
+	if (bUnchanged) {
+		Status.UnchangedCount++;
+		Status.CurrentInterval = std::min(Status.CurrentInterval * 2, Status.MaxInterval);
+	}
+	else {
+		Status.UnchangedCount = 0;
+		Status.CurrentInterval = Status.BaseInterval;
+	}
+
+	_ScheduleNext(Sampler, Epoch);
+	return !bUnchanged;
+}
+
+milliseconds SamplingScheduler::_EffectiveInterval(const _SAMPLER& Sampler) const {
+	return Sampler.Status.CurrentInterval * (pGovernor ? pGovernor->StretchFactor() : 1);
+}
+
+void SamplingScheduler::_ScheduleNext(_SAMPLER& Sampler, steady_clock::time_point Epoch) {
+	if (Sampler.Status.bShed) {
+		Sampler.NextDue = steady_clock::time_point::max();
+		return;
+	}
+
+	// Next grid point strictly after both now and the slot just served; a sampler run early in a coalesced wakeup must not run twice for one slot.
+	milliseconds Interval = _EffectiveInterval(Sampler);
+	auto From = Sampler.NextDue == steady_clock::time_point::max() ? steady_clock::now() : std::max(steady_clock::now(), Sampler.NextDue);
+	auto Slots = (From - Epoch) / Interval + 1;
+	Sampler.NextDue = Epoch + Slots * Interval;
+}
+
+// Kernel plus user time of the calling thread, in 100ns units.
+static UINT64 CurrentThreadCPUTime() {
+	FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+	if (!GetThreadTimes(GetCurrentThread(), &CreationTime, &ExitTime, &KernelTime, &UserTime)) return 0;
+	return (static_cast<UINT64>(KernelTime.dwHighDateTime) << 32 | KernelTime.dwLowDateTime) +
+		(static_cast<UINT64>(UserTime.dwHighDateTime) << 32 | UserTime.dwLowDateTime);
+}
+
+/*
+ * Only the sampling thread's CPU time is charged: the probe's work runs there. Time spent on its behalf by the
+ * WMI provider host (WmiPrvSE.exe) belongs to another process and is not visible here.
+ */
+void SamplingScheduler::_EvaluateGovernor(steady_clock::time_point Epoch, steady_clock::time_point& WindowStart, UINT64& WindowCPUTime) {
+	auto Now = steady_clock::now();
+	if (!pGovernor || Now - WindowStart < GovernorWindow) return;
+
+	UINT64 CPUTime = CurrentThreadCPUTime();
+	UINT64 WallTime = static_cast<UINT64>(duration_cast<nanoseconds>(Now - WindowStart).count() / 100);
+
+	std::lock_guard Lock(StatusLock);
+	BOOL bChanged = pGovernor->Update(CPUTime - WindowCPUTime, WallTime);
+	WindowStart = Now;
+	WindowCPUTime = CPUTime;
+	if (!bChanged) return;
+
+	for (auto& Sampler : Samplers) {
+		BOOL bWasShed = Sampler.Status.bShed;
+		Sampler.Status.bShed = pGovernor->IsShed(Sampler.Status.Priority);
+		// Restored samplers start from now; the others move to the grid of their new stretched interval.
+		if (bWasShed && !Sampler.Status.bShed) Sampler.NextDue = steady_clock::time_point::max();
+		_ScheduleNext(Sampler, Epoch);
+	}
+}
+
+std::optional<Error> SamplingScheduler::_Loop() {
+	const char* FuncName = "SamplingScheduler::_Loop";
+	if (Samplers.empty()) return std::nullopt;
+
+	std::random_device Seed;
+	std::uniform_int_distribution<long long> Jitter(0, std::max<long long>(MaxJitter.count(), 0));
+	auto Epoch = steady_clock::now() + milliseconds(Jitter(Seed));
+	for (auto& Sampler : Samplers) Sampler.NextDue = Epoch;
+
+	auto WindowStart = steady_clock::now();
+	UINT64 WindowCPUTime = CurrentThreadCPUTime();
+
+	HANDLE Handles[] = { hStopEvent, hTimer };
+	for (;;) {
+		// The end of the governor window is a wakeup of its own, so that shed samplers get restored even when nothing else is due.
+		auto NextWakeup = pGovernor ? WindowStart + GovernorWindow : steady_clock::time_point::max();
+		for (const auto& Sampler : Samplers) NextWakeup = std::min(NextWakeup, Sampler.NextDue);
+
+		auto Delay = NextWakeup - steady_clock::now();
+		if (Delay > steady_clock::duration::zero()) {
+			// Negative due times are relative, in 100ns units.
+			LARGE_INTEGER DueTime;
+			DueTime.QuadPart = -std::max<LONGLONG>(duration_cast<nanoseconds>(Delay).count() / 100, 1);
+			if (!SetWaitableTimerEx(hTimer, &DueTime, 0, NULL, NULL, NULL, static_cast<ULONG>(CoalescingWindow.count()))) {
+				return Error::New(FuncName, 1, L"Failed to arm the waitable timer.", GetLastError());
+			}
+
+			DWORD dwWait = WaitForMultipleObjects(2, Handles, FALSE, INFINITE);
+			if (dwWait == WAIT_OBJECT_0) break;
+			if (dwWait != WAIT_OBJECT_0 + 1) {
+				return Error::New(FuncName, 2, L"Failed to wait for the waitable timer.", GetLastError());
+			}
+			Wakeups.fetch_add(1, std::memory_order_relaxed);
+		}
+		else if (WaitForSingleObject(hStopEvent, 0) == WAIT_OBJECT_0) break;
+
+		auto Horizon = steady_clock::now() + CoalescingWindow;
+		bool bChanged = false;
+		for (auto& Sampler : Samplers) {
+			if (Sampler.NextDue <= Horizon && _RunSampler(Sampler, Epoch)) bChanged = true;
+		}
+		if (bChanged && AfterSamples) AfterSamples();
+		_EvaluateGovernor(Epoch, WindowStart, WindowCPUTime);
+	}
+	return std::nullopt;
+}
+
+// Order-dependent mixing of quantized values into a sampler signature.
+static UINT64 MixSignature(UINT64 Signature, UINT64 Value) {
+	Signature = (Signature ^ Value) * 0x9E3779B97F4A7C15;
+	return Signature ^ (Signature >> 32);
+}
+
+void AddProbeSamplers(SamplingScheduler& Scheduler, SysInfoProbe& Probe) {
+	if constexpr (BuildCollects(COLLECTOR_CPU)) Scheduler.AddSampler("CPU", seconds(1), seconds(8), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshCPUUtilizations();
+		Signature = MixSignature(0, std::llround(Probe.CPU.Utilization.CurrentUtilization));
+		for (double Utilization : Probe.CPU.Utilization.ThreadsUtilization) Signature = MixSignature(Signature, std::llround(Utilization));
+		return r;
+	}, PRIORITY_CRITICAL);
+
+	// Whole threads, and whole percents of the 10 second waiting share.
+	if constexpr (BuildCollects(COLLECTOR_CPU)) Scheduler.AddSampler("Pressure", seconds(2), seconds(16), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshSchedulerPressure();
+		const auto& Pressure = Probe.CPU.Pressure;
+		Signature = MixSignature(MixSignature(Pressure.ReadyThreads, Pressure.PagingWaitThreads), std::llround(Pressure.WaitingPercent10));
+		return r;
+	}, PRIORITY_NORMAL);
+
+	// Changes below 16 MB are not worth sampling faster for.
+	if constexpr (BuildCollects(COLLECTOR_RAM)) Scheduler.AddSampler("Memory", seconds(2), seconds(32), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshFreeRAM();
+		Signature = MixSignature(Probe.Memory.AvailablePhysicalBytes >> 24, Probe.Memory.AvailableCommitBytes >> 24);
+		return r;
+	}, PRIORITY_CRITICAL);
+
+	// Same 16 MB resolution, per node; a no-op on machines where GetNUMAInfo found no nodes.
+	if constexpr (BuildCollects(COLLECTOR_NUMA)) Scheduler.AddSampler("NUMA", seconds(5), seconds(60), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshNUMACounters();
+		Signature = 0;
+		for (const auto& Counters : Probe.NUMACounters) Signature = MixSignature(Signature, Counters.AvailableBytes >> 24);
+		return r;
+	}, PRIORITY_LOW);
+
+	if constexpr (BuildCollects(COLLECTOR_NETWORK)) Scheduler.AddSampler("Network", seconds(1), seconds(16), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshNetworkCounters();
+		Signature = 0;
+		for (const auto& Counters : Probe.NetworkCounters) Signature = MixSignature(Signature, Counters.ReceivedPackets + Counters.SentPackets);
+		return r;
+	}, PRIORITY_NORMAL);
+
+	// Connection counts by state, and whether anything was retransmitted, reset or dropped since the previous sample.
+	if constexpr (BuildCollects(COLLECTOR_TCP)) Scheduler.AddSampler("TCP", seconds(2), seconds(30), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshTCPStatistics();
+		const auto& Stats = Probe.TCPStats;
+		Signature = MixSignature(MixSignature(Stats.EstablishedConnections, Stats.TimeWaitConnections), Stats.CloseWaitConnections);
+		Signature = MixSignature(Signature, Stats.SegmentsRetransmitted + Stats.EstablishedResets + Stats.ResetsSent + Stats.UDPReceiveErrors);
+		return r;
+	}, PRIORITY_NORMAL);
+
+	if constexpr (BuildCollects(COLLECTOR_STORAGE)) Scheduler.AddSampler("Disk", seconds(1), seconds(16), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshDiskCounters();
+		Signature = 0;
+		for (const auto& Counters : Probe.DiskCounters) Signature = MixSignature(Signature, static_cast<UINT64>(Counters.ReadCount) + Counters.WriteCount);
+		return r;
+	}, PRIORITY_NORMAL);
+
+	// Free space at 16 MB resolution; volumes fill up slowly, but a full one is worth knowing about within seconds.
+	if constexpr (BuildCollects(COLLECTOR_VOLUMES)) Scheduler.AddSampler("Volumes", seconds(5), seconds(60), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshVolumeSpace();
+		Signature = 0;
+		for (const auto& Volume : Probe.Volumes) Signature = MixSignature(Signature, Volume.FreeBytes >> 24);
+		return r;
+	}, PRIORITY_NORMAL);
+
+	// A tenth of a second of CPU time over every process; starting or ending a process always counts as a change.
+	if constexpr (BuildCollects(COLLECTOR_PROCESSES)) Scheduler.AddSampler("Processes", seconds(2), seconds(30), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshProcessCounters();
+		UINT64 CPUTime = 0;
+		Signature = 0;
+		for (const auto& Counters : Probe.ProcessCounters) {
+			Signature = MixSignature(Signature, Counters.ProcessId);
+			CPUTime += Counters.CPUTime;
+		}
+		Signature = MixSignature(Signature, CPUTime / 1000000);
+		return r;
+	}, PRIORITY_LOW);
+
+	// A tenth of a percent of interrupt and DPC time per processor; the counts themselves move with every timer tick.
+	if constexpr (BuildCollects(COLLECTOR_INTERRUPTS)) Scheduler.AddSampler("Interrupts", seconds(2), seconds(30), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshInterruptCounters();
+		Signature = 0;
+		for (const auto& Counters : Probe.InterruptCounters)
+			Signature = MixSignature(Signature, std::llround((Counters.InterruptPercent + Counters.DpcPercent) * 10));
+		return r;
+	}, PRIORITY_LOW);
+
+	// Half-degree and tenth-of-a-watt resolution.
+	if constexpr (BuildCollects(COLLECTOR_SENSORS)) Scheduler.AddSampler("Sensors", seconds(5), seconds(60), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshSensors();
+		Signature = 0;
+		for (const auto& Zone : Probe.Sensors.ThermalZones) Signature = MixSignature(Signature, std::llround(Zone.TemperatureCelsius * 2));
+		for (const auto& Domain : Probe.Sensors.PowerDomains) Signature = MixSignature(Signature, std::llround(Domain.PowerWatts * 10));
+		return r;
+	}, PRIORITY_LOW);
+
+	// 16 MB of dedicated or shared video memory per adapter; a no-op when GetGpuInfo could not open the counters.
+	if constexpr (BuildCollects(COLLECTOR_GPU)) Scheduler.AddSampler("GPU", seconds(5), seconds(60), [&Probe](UINT64& Signature) {
+		auto r = Probe.RefreshGPUMemory();
+		Signature = 0;
+		for (const auto& Counters : Probe.GPUMemoryCounters) {
+			Signature = MixSignature(Signature, Counters.DedicatedUsageBytes >> 24);
+			Signature = MixSignature(Signature, Counters.SharedUsageBytes >> 24);
+		}
+		return r;
+	}, PRIORITY_LOW);
+
+	// One snapshot for everything a wakeup refreshed, rather than one per sampler.
+	Scheduler.SetAfterSamples([&Probe]() { Probe.PublishSnapshot(); });
+}
@@ -0,0 +1,106 @@
+/* Info: Runs every periodic sampler on one thread, waking once for all the samplers that are due together. */
+#pragma once
+#include "Errors.hpp"		// For error handling
+#include "Instrumentation.hpp"	// For per-sampler latency and cost counters
+#include "OverheadGovernor.hpp"	// For the CPU budget
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+class SysInfoProbe;
+
+/*
+ * Takes one sample and stores a signature of the sampled values (any hash of them, quantized as coarsely as
+ * changes matter). A signature equal to the previous one makes the scheduler back off that sampler.
+ */
+using SamplerFunction = std::function<std::optional<Error>(UINT64& Signature)>;
+
+typedef struct _tag_SAMPLERSTATUS {
+	std::string Name;
+	SAMPLER_PRIORITY Priority = PRIORITY_NORMAL;
+	BOOL bShed = FALSE;				// Suspended by the governor.
+	std::chrono::milliseconds BaseInterval{ 0 };
+	std::chrono::milliseconds MaxInterval{ 0 };
+	// BaseInterval doubled once per unchanged sample, up to MaxInterval; back to BaseInterval on the first change.
+	std::chrono::milliseconds CurrentInterval{ 0 };
+	UINT64 RunCount = 0;
+	UINT64 UnchangedCount = 0;		// Consecutive samples with the same signature.
+	std::optional<Error> LastError;	// Cleared by the next successful sample.
+	UINT64 LastSampledAt = 0;		// Clock::Timestamp at the start of the last sample.
+} SAMPLERSTATUS, *PSAMPLERSTATUS;
+
+/*
+ * Sample times are aligned on a grid of BaseInterval multiples shared by all samplers, so that samplers with
+ * intervals of 1 s, 5 s and 10 s wake the thread once every 10 s instead of three times.
+ */
+class SamplingScheduler {
+public:
+	// The whole grid is shifted by a random offset up to this, so that many hosts started together do not sample in lockstep.
+	std::chrono::milliseconds MaxJitter{ 250 };
+	// Samplers due within this window after a wakeup run in that wakeup; the timer may also fire this late so
+	// that the OS can coalesce it with other timers.
+	std::chrono::milliseconds CoalescingWindow{ 50 };
+
+	~SamplingScheduler() { Stop(); }
+
+	// Samplers must be added before Run or Start. MaxInterval equal to Interval disables the backoff.
+	void AddSampler(const std::string& Name, std::chrono::milliseconds Interval, std::chrono::milliseconds MaxInterval, SamplerFunction Sample,
+		SAMPLER_PRIORITY Priority = PRIORITY_NORMAL);
+
+	/*
+	 * Puts the scheduler under a CPU budget, evaluated once per window against the CPU time of the sampling
+	 * thread. Must be set before Run or Start; the governor must outlive the scheduler.
+	 */
+	void SetGovernor(OverheadGovernor* pGovernor, std::chrono::seconds Window = std::chrono::seconds(10));
+	GOVERNORINFO GetGovernorStatus() const;
+
+	// Runs on the sampling thread after every wakeup in which a sampler failed or its signature changed. Must be set before Run or Start.
+	void SetAfterSamples(std::function<void()> Callback) { AfterSamples = std::move(Callback); }
+
+	// Samples on the calling thread until Stop is called from another thread.
+	std::optional<Error> Run();
+	// Samples on a thread owned by the scheduler.
+	std::optional<Error> Start();
+	// Returns the error that ended the thread started by Start, if sampling stopped on its own.
+	std::optional<Error> Stop();
+
+	std::vector<SAMPLERSTATUS> GetStatus() const;
+	UINT64 WakeupCount() const { return Wakeups.load(std::memory_order_relaxed); }
+
+private:
+	struct _SAMPLER {
+		SAMPLERSTATUS Status;
+		SamplerFunction Sample;
+		int CollectorId = -1;	// Instrumentation identifier, "Sampler:<Name>".
+		UINT64 LastSignature = 0;
+		std::chrono::steady_clock::time_point NextDue;
+	};
+	std::vector<_SAMPLER> Samplers;
+	mutable std::mutex StatusLock;	// Guards every _SAMPLER::Status while sampling runs.
+	std::atomic<UINT64> Wakeups{ 0 };
+	HANDLE hStopEvent = NULL;
+	HANDLE hTimer = NULL;
+	std::thread Worker;
+	std::optional<Error> WorkerError;	// Set by the worker thread before it exits; read after joining it.
+	OverheadGovernor* pGovernor = nullptr;
+	std::chrono::seconds GovernorWindow{ 10 };
+	std::function<void()> AfterSamples;
+
+	// Interval after backoff and the governor's stretch; only called with StatusLock held.
+	std::chrono::milliseconds _EffectiveInterval(const _SAMPLER& Sampler) const;
+	void _ScheduleNext(_SAMPLER& Sampler, std::chrono::steady_clock::time_point Epoch);
+	void _EvaluateGovernor(std::chrono::steady_clock::time_point Epoch, std::chrono::steady_clock::time_point& WindowStart, UINT64& WindowCPUTime);
+
+	std::optional<Error> _Prepare();
+	std::optional<Error> _Loop();
+	// True when the sample failed or its signature changed.
+	bool _RunSampler(_SAMPLER& Sampler, std::chrono::steady_clock::time_point Epoch);
+};
+
+// Registers the probe's refresh functions: CPU and memory (critical), network and disk counters (normal) and sensors (low).
+// Only the samplers of the build's categories (SYSINFO_COLLECTORS) are registered. The probe publishes a snapshot after
+// every wakeup that changed something, so other threads read Probe.Publisher() rather than the probe.
+void AddProbeSamplers(SamplingScheduler& Scheduler, SysInfoProbe& Probe);
@@ -0,0 +1,330 @@
+#include "SysInfoProbe.hpp"
+#include <initguid.h>		// Must precede emi.h so that GUID_DEVICE_ENERGY_METER is defined in this unit
+#include <emi.h>			// For the Energy Metering Interface (RAPL)
+#pragma comment(lib, "Pdh.lib")			// Required for the thermal zone counters
+#pragma comment(lib, "SetupAPI.lib")	// Required for energy meter enumeration
+
+// Thermal zone fields filled by _SampleThermalCounter.
+enum THERMAL_FIELD {
+	THERMAL_TEMPERATURE,
+	THERMAL_PASSIVE_LIMIT,
+	THERMAL_THROTTLE_REASONS
+};
+
+std::optional<Error> SysInfoProbe::_OpenThermalZones() {
+	const char* FuncName = "SysInfoProbe::_OpenThermalZones";
+	PDH_STATUS Status = PdhOpenQueryW(NULL, 0, &hSensorQuery);
+	if (Status != ERROR_SUCCESS) {
+		hSensorQuery = NULL;
+		return Error::New(FuncName, 1, L"Failed to open PDH query.", Status);
+	}
+
+	// Machines without ACPI thermal zones (most virtual machines) do not register the counter set; that is not an error.
+	if (PdhAddEnglishCounterW(hSensorQuery, L"\\Thermal Zone Information(*)\\High Precision Temperature", 0, &hTemperatureCounter) != ERROR_SUCCESS) {
+		hTemperatureCounter = NULL;
+		return std::nullopt;
+	}
+	if (PdhAddEnglishCounterW(hSensorQuery, L"\\Thermal Zone Information(*)\\% Passive Limit", 0, &hPassiveLimitCounter) != ERROR_SUCCESS)
+		hPassiveLimitCounter = NULL;
+	if (PdhAddEnglishCounterW(hSensorQuery, L"\\Thermal Zone Information(*)\\Throttle Reasons", 0, &hThrottleReasonsCounter) != ERROR_SUCCESS)
+		hThrottleReasonsCounter = NULL;
+
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_OpenEnergyMeters() {
+	const char* FuncName = "SysInfoProbe::_OpenEnergyMeters";
+	HDEVINFO hDevInfo = SetupDiGetClassDevsW(&GUID_DEVICE_ENERGY_METER, NULL, NULL, DIGCF_PRESENT | DIGCF_DEVICEINTERFACE);
+	if (hDevInfo == INVALID_HANDLE_VALUE) {
+		return Error::New(FuncName, 1, L"Failed to enumerate energy meter interfaces.", GetLastError());
+	}
+
+	DEFER{
+		SetupDiDestroyDeviceInfoList(hDevInfo);
+	};
+
+	SP_DEVICE_INTERFACE_DATA InterfaceData = { sizeof(InterfaceData) };
+	for (DWORD InterfaceIndex = 0; SetupDiEnumDeviceInterfaces(hDevInfo, NULL, &GUID_DEVICE_ENERGY_METER, InterfaceIndex, &InterfaceData); InterfaceIndex++) {
+		DWORD dwRequiredSize = 0;
+		SetupDiGetDeviceInterfaceDetailW(hDevInfo, &InterfaceData, NULL, 0, &dwRequiredSize, NULL);
+		if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) continue;
+
+		std::vector<BYTE> DetailBuffer(dwRequiredSize);
+		PSP_DEVICE_INTERFACE_DETAIL_DATA_W pDetail = reinterpret_cast<PSP_DEVICE_INTERFACE_DETAIL_DATA_W>(DetailBuffer.data());
+		pDetail->cbSize = sizeof(SP_DEVICE_INTERFACE_DETAIL_DATA_W);
+		if (!SetupDiGetDeviceInterfaceDetailW(hDevInfo, &InterfaceData, pDetail, dwRequiredSize, NULL, NULL)) continue;
+
+		// Opening an energy meter usually requires administrator rights; meters we cannot open are skipped.
+		HANDLE hDevice = CreateFileW(pDetail->DevicePath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hDevice == INVALID_HANDLE_VALUE) continue;
+
+		BOOL bKeepHandle = FALSE;
+		DEFER{
+			if (!bKeepHandle) CloseHandle(hDevice);
+		};
+
+		DWORD dwBytesReturned = 0;
+		EMI_VERSION Version = { 0 };
+		if (!DeviceIoControl(hDevice, IOCTL_EMI_GET_VERSION, NULL, 0, &Version, sizeof(Version), &dwBytesReturned, NULL)) continue;
+
+		EMI_METADATA_SIZE MetadataSize = { 0 };
+		if (!DeviceIoControl(hDevice, IOCTL_EMI_GET_METADATA_SIZE, NULL, 0, &MetadataSize, sizeof(MetadataSize), &dwBytesReturned, NULL)) continue;
+
+		std::vector<BYTE> Metadata(MetadataSize.MetadataSize);
+		if (!DeviceIoControl(hDevice, IOCTL_EMI_GET_METADATA, NULL, 0, Metadata.data(), static_cast<DWORD>(Metadata.size()), &dwBytesReturned, NULL)) continue;
+
+		_ENERGYMETER Meter;
+		Meter.hDevice = hDevice;
+		Meter.EmiVersion = Version.EmiVersion;
+		Meter.FirstDomain = Sensors.PowerDomains.size();
+
+		if (Version.EmiVersion == EMI_VERSION_V1) {
+			// Version 1 meters expose a single channel named after the metered hardware.
+			EMI_METADATA_V1* pMetadata = reinterpret_cast<EMI_METADATA_V1*>(Metadata.data());
+			POWERDOMAININFO Domain;
+			Domain.Name = w2s(std::wstring(pMetadata->MeteredHardwareName, pMetadata->MeteredHardwareNameSize / sizeof(WCHAR)));
+			Sensors.PowerDomains.push_back(Domain);
+			Meter.ChannelCount = 1;
+		}
+		else if (Version.EmiVersion == EMI_VERSION_V2) {
+			EMI_METADATA_V2* pMetadata = reinterpret_cast<EMI_METADATA_V2*>(Metadata.data());
+			EMI_CHANNEL_V2* pChannel = pMetadata->Channels;
+			for (USHORT ChannelIndex = 0; ChannelIndex < pMetadata->ChannelCount; ChannelIndex++) {
+				POWERDOMAININFO Domain;
+				Domain.Name = w2s(std::wstring(pChannel->ChannelName, pChannel->ChannelNameSize / sizeof(WCHAR)));
+				Sensors.PowerDomains.push_back(Domain);
+				pChannel = EMI_CHANNEL_V2_NEXT_CHANNEL(pChannel);
+			}
+			Meter.ChannelCount = pMetadata->ChannelCount;
+		}
+		else continue;
+
+		// Every buffer a sample needs is sized here, so sampling itself never allocates.
+		Meter.MeasurementBuffer.resize(Meter.ChannelCount * sizeof(EMI_CHANNEL_MEASUREMENT_DATA));
+		Meter.LastEnergy.resize(Meter.ChannelCount, 0);
+		Meter.LastTime.resize(Meter.ChannelCount, 0);
+		EnergyMeters.push_back(std::move(Meter));
+		bKeepHandle = TRUE;
+	}
+
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_GetFans() {
+	const char* FuncName = "SysInfoProbe::_GetFans";
+	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
+	const std::vector<LPCWSTR> Attributes = {
+		L"Name",
+		L"DesiredSpeed",
+		L"ActiveCooling"
+	};
+
+	bstr_t WQLQuery = WMIMgr.BuildWQLQueryString(L"Win32_Fan", Attributes);
+	auto r = WMIMgr.ExecuteWQLQuery(WQLQuery);
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		return r;
+	}
+
+	auto [pLocator, pServices, pEnumerator] = WMIMgr.GetData();
+	IWbemClassObject* pClassObject = NULL;
+	ULONG uReturn = 0;
+	VARIANT vtProp = { 0 };
+
+	DEFER{
+		VariantClear(&vtProp);
+		if (pClassObject) pClassObject->Release();
+	};
+
+	Sensors.Fans.clear();
+	while (pEnumerator) {
+		HRESULT hr = pEnumerator->Next(WBEM_INFINITE, 1, &pClassObject, &uReturn);
+		if (FAILED(hr)) {
+			return Error::New(FuncName, 3, L"Failed to fetch next WMI object.", hr);
+		}
+		if (uReturn == 0) break;
+		VariantInit(&vtProp);
+		FANINFO CurrentFan;
+
+		hr = pClassObject->Get(L"Name", 0, &vtProp, 0, 0);
+		if (FAILED(hr) || vtProp.vt != VT_BSTR || vtProp.bstrVal == NULL) {
+			return Error::New(FuncName, 4, L"Failed to get fan Name property or property is empty.", hr);
+		}
+		CurrentFan.Name = trim(w2s(vtProp.bstrVal));
+
+		// DesiredSpeed (uint64, returned as a string) and ActiveCooling are optional; firmwares often leave them NULL.
+		hr = pClassObject->Get(L"DesiredSpeed", 0, &vtProp, 0, 0);
+		if (SUCCEEDED(hr) && vtProp.vt == VT_BSTR && vtProp.bstrVal != NULL) {
+			// Some firmwares return text that is not a number; the speed then stays unknown.
+			parse_unsigned(vtProp.bstrVal, CurrentFan.DesiredSpeedRPM);
+		}
+
+		hr = pClassObject->Get(L"ActiveCooling", 0, &vtProp, 0, 0);
+		if (SUCCEEDED(hr) && vtProp.vt == VT_BOOL) {
+			CurrentFan.bActiveCooling = vtProp.boolVal == VARIANT_TRUE;
+		}
+
+		Sensors.Fans.push_back(CurrentFan);
+	}
+
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_SampleThermalCounter(PDH_HCOUNTER hCounter, int Field) {
+	const char* FuncName = "SysInfoProbe::_SampleThermalCounter";
+	if (!hCounter) return std::nullopt;
+
+	DWORD dwBufferSize = static_cast<DWORD>(SensorCounterBuffer.size());
+	DWORD dwItemCount = 0;
+	PDH_STATUS Status = PdhGetFormattedCounterArrayW(hCounter, PDH_FMT_DOUBLE | PDH_FMT_NOCAP100, &dwBufferSize, &dwItemCount,
+		reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(SensorCounterBuffer.data()));
+	if (Status == PDH_MORE_DATA) {
+		// The buffer only ever grows, so once the instance set is stable no sample allocates.
+		SensorCounterBuffer.resize(dwBufferSize);
+		Status = PdhGetFormattedCounterArrayW(hCounter, PDH_FMT_DOUBLE | PDH_FMT_NOCAP100, &dwBufferSize, &dwItemCount,
+			reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(SensorCounterBuffer.data()));
+	}
+	if (Status != ERROR_SUCCESS) {
+		return Error::New(FuncName, 1, L"Failed to read thermal zone counter array.", Status);
+	}
+
+	PPDH_FMT_COUNTERVALUE_ITEM_W pItems = reinterpret_cast<PPDH_FMT_COUNTERVALUE_ITEM_W>(SensorCounterBuffer.data());
+	for (DWORD i = 0; i < dwItemCount; i++) {
+		if (pItems[i].FmtValue.CStatus != PDH_CSTATUS_VALID_DATA && pItems[i].FmtValue.CStatus != PDH_CSTATUS_NEW_DATA) continue;
+
+		// PDH returns instances in a stable order, so the positional guess almost always hits.
+		size_t ZoneIndex = i;
+		if (ZoneIndex >= ThermalZoneInstances.size() || ThermalZoneInstances[ZoneIndex] != pItems[i].szName) {
+			auto Found = std::find(ThermalZoneInstances.begin(), ThermalZoneInstances.end(), pItems[i].szName);
+			ZoneIndex = Found - ThermalZoneInstances.begin();
+			if (Found == ThermalZoneInstances.end()) {
+				ThermalZoneInstances.push_back(pItems[i].szName);
+				THERMALZONEINFO Zone;
+				Zone.Name = w2s(pItems[i].szName);
+				Sensors.ThermalZones.push_back(Zone);
+			}
+		}
+
+		THERMALZONEINFO& Zone = Sensors.ThermalZones[ZoneIndex];
+		double Value = pItems[i].FmtValue.doubleValue;
+		switch (Field) {
+		case THERMAL_TEMPERATURE: Zone.TemperatureCelsius = Value / 10.0 - 273.15; break;
+		case THERMAL_PASSIVE_LIMIT: Zone.PassiveLimitPercent = Value; break;
+		case THERMAL_THROTTLE_REASONS: Zone.ThrottleReasons = static_cast<DWORD>(Value); break;
+		}
+	}
+
+	return std::nullopt;
+}
+
+void SysInfoProbe::_SampleEnergyMeters() {
+	for (auto& Meter : EnergyMeters) {
+		DWORD dwBytesReturned = 0;
+		if (!DeviceIoControl(Meter.hDevice, IOCTL_EMI_GET_MEASUREMENT, NULL, 0, Meter.MeasurementBuffer.data(),
+			static_cast<DWORD>(Meter.MeasurementBuffer.size()), &dwBytesReturned, NULL)) continue;
+		Instrumentation::CountSystemCall();
+		Instrumentation::CountBytesRead(dwBytesReturned);
+
+		// A version 1 measurement has the same layout as a single version 2 channel.
+		const EMI_CHANNEL_MEASUREMENT_DATA* pData = reinterpret_cast<const EMI_CHANNEL_MEASUREMENT_DATA*>(Meter.MeasurementBuffer.data());
+		for (size_t i = 0; i < Meter.ChannelCount; i++) {
+			BOOL bFirstSample = Meter.LastTime[i] == 0;
+
+			// Unsigned subtraction keeps both deltas correct when an accumulated counter wraps around.
+			ULONGLONG EnergyDelta = pData[i].AbsoluteEnergy - Meter.LastEnergy[i];
+			ULONGLONG TimeDelta = pData[i].AbsoluteTime - Meter.LastTime[i];
+			Meter.LastEnergy[i] = pData[i].AbsoluteEnergy;
+			Meter.LastTime[i] = pData[i].AbsoluteTime;
+			if (bFirstSample || TimeDelta == 0) continue;
+
+			// Energy is reported in picowatt-hours (1 pWh = 3.6e-9 J) and time in 100ns units.
+			double Joules = EnergyDelta * 3.6e-9;
+			POWERDOMAININFO& Domain = Sensors.PowerDomains[Meter.FirstDomain + i];
+			Domain.EnergyJoules += Joules;
+			Domain.PowerWatts = Joules / (TimeDelta * 1e-7);
+		}
+	}
+}
+
+void SysInfoProbe::_CloseSensors() {
+	if (hSensorQuery) {
+		// Closing the query also removes every counter added to it.
+		PdhCloseQuery(hSensorQuery);
+		hSensorQuery = NULL;
+	}
+	hTemperatureCounter = NULL;
+	hPassiveLimitCounter = NULL;
+	hThrottleReasonsCounter = NULL;
+	ThermalZoneInstances.clear();
+	bSensorsOpened = FALSE;
+
+	for (auto& Meter : EnergyMeters) {
+		if (Meter.hDevice != INVALID_HANDLE_VALUE) CloseHandle(Meter.hDevice);
+	}
+	EnergyMeters.clear();
+}
+
+std::optional<Error> SysInfoProbe::RefreshSensors() {
+	const char* FuncName = "SysInfoProbe::RefreshSensors";
+	INSTRUMENT_COLLECTOR(FuncName);
+
+	if (hSensorQuery && hTemperatureCounter) {
+		// A single collection call samples every thermal zone counter at once.
+		PDH_STATUS Status = PdhCollectQueryData(hSensorQuery);
+		if (Status != ERROR_SUCCESS) {
+			return Error::New(FuncName, 1, L"Failed to collect thermal zone counters.", Status);
+		}
+		Instrumentation::CountSystemCall();
+
+		auto r = _SampleThermalCounter(hTemperatureCounter, THERMAL_TEMPERATURE);
+		if (!r) r = _SampleThermalCounter(hPassiveLimitCounter, THERMAL_PASSIVE_LIMIT);
+		if (!r) r = _SampleThermalCounter(hThrottleReasonsCounter, THERMAL_THROTTLE_REASONS);
+		if (r) {
+			r.value().AddNewFunctionToStack(FuncName, 2);
+			return r;
+		}
+	}
+
+	_SampleEnergyMeters();
+	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::GetSensorInfo() {
+	const char* FuncName = "SysInfoProbe::GetSensorInfo";
+	INSTRUMENT_COLLECTOR(FuncName);
+	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
+
+	// Discovery: every sensor source is opened here and kept open for RefreshSensors. Once they are open, a repeated
+	// retrieval (as in daemon mode) keeps the values of the last RefreshSensors instead of resetting power and energy.
+	if (bSensorsOpened) return std::nullopt;
+	_CloseSensors();
+	Sensors = SENSORINFO();
+
+	auto r = _OpenThermalZones();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 2);
+		return r;
+	}
+
+	r = _OpenEnergyMeters();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 3);
+		return r;
+	}
+
+	r = _GetFans();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 4);
+		return r;
+	}
+
+	// The first pass fills the thermal zones and sets the energy baselines; power needs a second sample.
+	r = RefreshSensors();
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 5);
+		return r;
+	}
+
+	bSensorsOpened = TRUE;
+	return std::nullopt;
+}
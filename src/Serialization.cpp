@@ -0,0 +1,281 @@
+#include "Serialization.hpp"
+#include "SnapshotFields.hpp"
+#include <cstring>
+
+// "SIPS" in little-endian; followed by the format version and the payload length.
+constexpr DWORD SnapshotMagic = 0x53504953;
+constexpr BYTE SnapshotFormatVersion = 1;
+
+void ByteWriter::WriteFixed32(DWORD Value) {
+	for (int i = 0; i < 4; i++) Buffer.push_back(static_cast<BYTE>(Value >> (i * 8)));
+}
+
+void ByteWriter::WriteVarint(UINT64 Value) {
+	while (Value >= 0x80) {
+		Buffer.push_back(static_cast<BYTE>(Value) | 0x80);
+		Value >>= 7;
+	}
+	Buffer.push_back(static_cast<BYTE>(Value));
+}
+
+void ByteWriter::WriteSignedVarint(INT64 Value) {
+	WriteVarint((static_cast<UINT64>(Value) << 1) ^ static_cast<UINT64>(Value >> 63));
+}
+
+void ByteWriter::WriteDouble(double Value) {
+	UINT64 Bits = 0;
+	memcpy(&Bits, &Value, sizeof(Bits));
+	for (int i = 0; i < 8; i++) Buffer.push_back(static_cast<BYTE>(Bits >> (i * 8)));
+}
+
+void ByteWriter::WriteString(const std::string& Value) {
+	WriteVarint(Value.size());
+	WriteBytes(Value.data(), Value.size());
+}
+
+void ByteWriter::WriteBytes(const void* pData, size_t Size) {
+	const BYTE* pBytes = static_cast<const BYTE*>(pData);
+	Buffer.insert(Buffer.end(), pBytes, pBytes + Size);
+}
+
+size_t ByteWriter::BeginLength() {
+	size_t LengthOffset = Buffer.size();
+	WriteFixed32(0);
+	return LengthOffset;
+}
+
+void ByteWriter::EndLength(size_t LengthOffset) {
+	DWORD Length = static_cast<DWORD>(Buffer.size() - LengthOffset - 4);
+	for (int i = 0; i < 4; i++) Buffer[LengthOffset + i] = static_cast<BYTE>(Length >> (i * 8));
+}
+
+BYTE ByteReader::ReadByte() {
+	const BYTE* p = Skip(1);
+	return p ? *p : 0;
+}
+
+DWORD ByteReader::ReadFixed32() {
+	const BYTE* p = Skip(4);
+	if (!p) return 0;
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<DWORD>(p[3]) << 24);
+}
+
+UINT64 ByteReader::ReadVarint() {
+	UINT64 Value = 0;
+	for (int Shift = 0; Shift < 64; Shift += 7) {
+		const BYTE* p = Skip(1);
+		if (!p) return 0;
+		Value |= static_cast<UINT64>(*p & 0x7F) << Shift;
+		if (!(*p & 0x80)) return Value;
+	}
+	bFailed = TRUE;
+	return 0;
+}
+
+INT64 ByteReader::ReadSignedVarint() {
+	UINT64 Value = ReadVarint();
+	return static_cast<INT64>(Value >> 1) ^ -static_cast<INT64>(Value & 1);
+}
+
+double ByteReader::ReadDouble() {
+	const BYTE* p = Skip(8);
+	if (!p) return 0.0;
+	UINT64 Bits = 0;
+	for (int i = 0; i < 8; i++) Bits |= static_cast<UINT64>(p[i]) << (i * 8);
+	double Value = 0.0;
+	memcpy(&Value, &Bits, sizeof(Value));
+	return Value;
+}
+
+std::string ByteReader::ReadString() {
+	UINT64 Length = ReadVarint();
+	const BYTE* p = Skip(static_cast<size_t>(Length));
+	return p ? std::string(reinterpret_cast<const char*>(p), static_cast<size_t>(Length)) : std::string();
+}
+
+const BYTE* ByteReader::Skip(size_t Count) {
+	if (bFailed || Count > Size - Offset) {
+		bFailed = TRUE;
+		return nullptr;
+	}
+	const BYTE* p = pData + Offset;
+	Offset += Count;
+	return p;
+}
+
+// Writes the value of each visited field; vectors are a count followed by their elements.
+struct FieldWriter {
+	ByteWriter& Writer;
+
+	template<class F> void operator()(const char* Name, const F& Field) {
+		if constexpr (std::is_same_v<F, std::string>) Writer.WriteString(Field);
+		else if constexpr (std::is_same_v<F, std::vector<BYTE>>) {
+			// Opaque blobs such as compressed series; a varint per byte would grow them by half.
+			Writer.WriteVarint(Field.size());
+			Writer.WriteBytes(Field.data(), Field.size());
+		}
+		else if constexpr (std::is_floating_point_v<F>) Writer.WriteDouble(Field);
+		else if constexpr (std::is_enum_v<F>) Writer.WriteSignedVarint(static_cast<INT64>(Field));
+		else if constexpr (std::is_signed_v<F>) Writer.WriteSignedVarint(Field);
+		else if constexpr (std::is_unsigned_v<F>) Writer.WriteVarint(Field);
+		else {
+			Writer.WriteVarint(Field.size());
+			for (const auto& Element : Field) (*this)(Name, Element);
+		}
+	}
+};
+
+// Sections and list elements are length-prefixed so that readers can skip what they do not know.
+struct SectionWriter {
+	ByteWriter& Writer;
+
+	template<class S> void Section(BYTE Id, const char*, const S& Value) {
+		Writer.WriteByte(Id);
+		size_t LengthOffset = Writer.BeginLength();
+		FieldWriter Fields{ Writer };
+		VisitFields(Value, Fields);
+		Writer.EndLength(LengthOffset);
+	}
+
+	template<class S> void List(BYTE Id, const char*, const std::vector<S>& Values) {
+		Writer.WriteByte(Id);
+		size_t LengthOffset = Writer.BeginLength();
+		Writer.WriteVarint(Values.size());
+		FieldWriter Fields{ Writer };
+		for (const auto& Value : Values) {
+			size_t ElementOffset = Writer.BeginLength();
+			VisitFields(Value, Fields);
+			Writer.EndLength(ElementOffset);
+		}
+		Writer.EndLength(LengthOffset);
+	}
+};
+
+// Fields missing at the end of a section were written by an older version and keep their defaults.
+struct FieldReader {
+	ByteReader& Reader;
+
+	template<class F> void operator()(const char* Name, F& Field) {
+		if (Reader.Remaining() == 0) return;
+
+		if constexpr (std::is_same_v<F, std::string>) Field = Reader.ReadString();
+		else if constexpr (std::is_same_v<F, std::vector<BYTE>>) {
+			UINT64 Length = Reader.ReadVarint();
+			const BYTE* p = Reader.Skip(static_cast<size_t>(Length));
+			if (p) Field.assign(p, p + Length);
+		}
+		else if constexpr (std::is_floating_point_v<F>) Field = static_cast<F>(Reader.ReadDouble());
+		else if constexpr (std::is_enum_v<F>) Field = static_cast<F>(Reader.ReadSignedVarint());
+		else if constexpr (std::is_signed_v<F>) Field = static_cast<F>(Reader.ReadSignedVarint());
+		else if constexpr (std::is_unsigned_v<F>) Field = static_cast<F>(Reader.ReadVarint());
+		else {
+			// Every element takes at least one byte, which bounds the count of a corrupted blob.
+			UINT64 Count = Reader.ReadVarint();
+			if (Count > Reader.Remaining()) {
+				Reader.bFailed = TRUE;
+				return;
+			}
+			Field.clear();
+			Field.resize(static_cast<size_t>(Count));
+			for (auto& Element : Field) {
+				if (Reader.Remaining() == 0) {
+					Reader.bFailed = TRUE;
+					return;
+				}
+				(*this)(Name, Element);
+			}
+		}
+	}
+};
+
+struct SectionReader {
+	// Payload of every section present in the blob, indexed by section identifier.
+	const BYTE* pSections[256] = { nullptr };
+	size_t SectionSizes[256] = { 0 };
+	BOOL bFailed = FALSE;
+
+	template<class S> void Section(BYTE Id, const char*, S& Value) {
+		if (!pSections[Id]) return;
+		ByteReader Reader(pSections[Id], SectionSizes[Id]);
+		FieldReader Fields{ Reader };
+		VisitFields(Value, Fields);
+		if (Reader.bFailed) bFailed = TRUE;
+	}
+
+	template<class S> void List(BYTE Id, const char*, std::vector<S>& Values) {
+		if (!pSections[Id]) return;
+		ByteReader Reader(pSections[Id], SectionSizes[Id]);
+		UINT64 Count = Reader.ReadVarint();
+		if (Count > Reader.Remaining() / 4) {
+			bFailed = TRUE;
+			return;
+		}
+
+		Values.clear();
+		Values.resize(static_cast<size_t>(Count));
+		for (auto& Value : Values) {
+			DWORD ElementSize = Reader.ReadFixed32();
+			const BYTE* pElement = Reader.Skip(ElementSize);
+			if (!pElement) break;
+			ByteReader ElementReader(pElement, ElementSize);
+			FieldReader Fields{ ElementReader };
+			VisitFields(Value, Fields);
+			if (ElementReader.bFailed) bFailed = TRUE;
+		}
+		if (Reader.bFailed) bFailed = TRUE;
+	}
+};
+
+void SerializeSnapshot(const SYSINFOSNAPSHOT& Snapshot, ByteWriter& Writer) {
+	Writer.WriteFixed32(SnapshotMagic);
+	Writer.WriteByte(SnapshotFormatVersion);
+	size_t LengthOffset = Writer.BeginLength();
+	SectionWriter Sections{ Writer };
+	VisitSections(Snapshot, Sections);
+	Writer.EndLength(LengthOffset);
+}
+
+std::vector<BYTE> SerializeSnapshot(const SYSINFOSNAPSHOT& Snapshot) {
+	ByteWriter Writer;
+	SerializeSnapshot(Snapshot, Writer);
+	return std::move(Writer.Buffer);
+}
+
+std::optional<Error> DeserializeSnapshot(const BYTE* pData, size_t DataSize, SYSINFOSNAPSHOT& Out, size_t* pConsumed) {
+	const char* FuncName = "DeserializeSnapshot";
+	ByteReader Reader(pData, DataSize);
+	if (Reader.ReadFixed32() != SnapshotMagic) {
+		return Error::New(FuncName, 1, L"Data is not a serialized snapshot.");
+	}
+	if (Reader.ReadByte() != SnapshotFormatVersion) {
+		return Error::New(FuncName, 2, L"Unsupported snapshot format version.");
+	}
+
+	DWORD PayloadSize = Reader.ReadFixed32();
+	const BYTE* pPayload = Reader.Skip(PayloadSize);
+	if (!pPayload) {
+		return Error::New(FuncName, 3, L"Snapshot is truncated.");
+	}
+
+	SectionReader Sections;
+	ByteReader PayloadReader(pPayload, PayloadSize);
+	while (PayloadReader.Remaining() > 0) {
+		BYTE Id = PayloadReader.ReadByte();
+		DWORD SectionSize = PayloadReader.ReadFixed32();
+		const BYTE* pSection = PayloadReader.Skip(SectionSize);
+		if (!pSection) {
+			return Error::New(FuncName, 4, L"Snapshot section overruns the payload.");
+		}
+		Sections.pSections[Id] = pSection;
+		Sections.SectionSizes[Id] = SectionSize;
+	}
+
+	Out = SYSINFOSNAPSHOT();
+	VisitSections(Out, Sections);
+	if (Sections.bFailed) {
+		return Error::New(FuncName, 5, L"Snapshot section is malformed.");
+	}
+
+	if (pConsumed) *pConsumed = Reader.Position();
+	return std::nullopt;
+}
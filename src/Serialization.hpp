@@ -0,0 +1,58 @@
+/* Info: Compact binary encoding of SYSINFOSNAPSHOT, used to store, ship and share probe results. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SYSINFOSNAPSHOT
+#include <optional>
+
+// Appends little-endian fixed-width values, LEB128 varints and length-prefixed strings to a growing buffer.
+class ByteWriter {
+public:
+	std::vector<BYTE> Buffer;
+
+	void WriteByte(BYTE Value) { Buffer.push_back(Value); }
+	void WriteFixed32(DWORD Value);
+	void WriteVarint(UINT64 Value);
+	// Zigzag-encoded so that small negative numbers stay small.
+	void WriteSignedVarint(INT64 Value);
+	void WriteDouble(double Value);
+	void WriteString(const std::string& Value);
+	void WriteBytes(const void* pData, size_t Size);
+
+	// Reserves a 32-bit length and returns its offset; EndLength fills in the number of bytes written since.
+	size_t BeginLength();
+	void EndLength(size_t LengthOffset);
+};
+
+// Reads what ByteWriter wrote. Reads never go past the end: they set bFailed and return zero values instead.
+class ByteReader {
+public:
+	BOOL bFailed = FALSE;
+
+	ByteReader(const BYTE* pData, size_t Size) : pData(pData), Size(Size), Offset(0) {}
+
+	BYTE ReadByte();
+	DWORD ReadFixed32();
+	UINT64 ReadVarint();
+	INT64 ReadSignedVarint();
+	double ReadDouble();
+	std::string ReadString();
+	// Returns a pointer to the next `Count` bytes and moves past them, or nullptr if there are not enough left.
+	const BYTE* Skip(size_t Count);
+
+	size_t Position() const { return Offset; }
+	size_t Remaining() const { return Size - Offset; }
+
+private:
+	const BYTE* pData;
+	size_t Size;
+	size_t Offset;
+};
+
+void SerializeSnapshot(const SYSINFOSNAPSHOT& Snapshot, ByteWriter& Writer);
+std::vector<BYTE> SerializeSnapshot(const SYSINFOSNAPSHOT& Snapshot);
+
+/*
+ * Decodes one serialized snapshot from the start of `pData`. Several snapshots may be stored back to back;
+ * `pConsumed` receives the size of the one that was read so the caller can continue after it.
+ */
+std::optional<Error> DeserializeSnapshot(const BYTE* pData, size_t DataSize, SYSINFOSNAPSHOT& Out, size_t* pConsumed = nullptr);
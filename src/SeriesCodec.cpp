@@ -0,0 +1,264 @@
+#include "SeriesCodec.hpp"
+#include "Serialization.hpp"
+#include <algorithm>
+#include <bit>
+
+void BitWriter::Write(UINT64 Value, int Count) {
+	if (Count < 64) Value &= (1ULL << Count) - 1;
+	const int Free = 64 - Used;
+	if (Count < Free) {
+		Accumulator |= Value << (Free - Count);
+		Used += Count;
+		return;
+	}
+	// Fills the accumulator, stores it and keeps the bits that did not fit.
+	const int Rest = Count - Free;
+	Accumulator |= Rest ? Value >> Rest : Value;
+	for (int i = 7; i >= 0; i--) Buffer.push_back(static_cast<BYTE>(Accumulator >> (i * 8)));
+	Accumulator = Rest ? Value << (64 - Rest) : 0;
+	Used = Rest;
+}
+
+void BitWriter::CopyTo(std::vector<BYTE>& Out) const {
+	Out.insert(Out.end(), Buffer.begin(), Buffer.end());
+	for (int i = 0; i < (Used + 7) / 8; i++) Out.push_back(static_cast<BYTE>(Accumulator >> (56 - i * 8)));
+}
+
+void BitWriter::Clear() {
+	Buffer.clear();
+	Accumulator = 0;
+	Used = 0;
+}
+
+UINT64 BitReader::Read(int Count) {
+	if (bFailed || Count > static_cast<INT64>(Size * 8 - Position)) {
+		bFailed = TRUE;
+		return 0;
+	}
+	// The fast path below needs the bits within one unaligned 8-byte load.
+	if (Count > 56) {
+		UINT64 High = Read(Count - 32);
+		return (High << 32) | Read(32);
+	}
+	const size_t Byte = Position >> 3;
+	const int Offset = static_cast<int>(Position & 7);
+	Position += Count;
+
+	UINT64 Word = 0;
+	if (Byte + 8 <= Size) {
+		for (int i = 0; i < 8; i++) Word = (Word << 8) | pData[Byte + i];
+	}
+	else {
+		for (size_t i = 0; i < 8; i++) Word = (Word << 8) | (Byte + i < Size ? pData[Byte + i] : 0);
+	}
+	return (Word << Offset) >> (64 - Count);
+}
+
+/*
+ * Prefix codes for the change of a delta, sized for timestamps in milliseconds sampled with scheduling jitter:
+ * 0 = unchanged, 10 = 7 bits, 110 = 9 bits, 1110 = 12 bits, 11110 = 32 bits, 11111 = 64 bits.
+ */
+static void WriteDeltaOfDelta(BitWriter& Bits, INT64 Value) {
+	if (Value == 0) Bits.Write(0, 1);
+	else if (Value >= -63 && Value <= 64) Bits.Write((0b10ULL << 7) | static_cast<UINT64>(Value + 63), 9);
+	else if (Value >= -255 && Value <= 256) Bits.Write((0b110ULL << 9) | static_cast<UINT64>(Value + 255), 12);
+	else if (Value >= -2047 && Value <= 2048) Bits.Write((0b1110ULL << 12) | static_cast<UINT64>(Value + 2047), 16);
+	else if (Value >= INT32_MIN && Value <= INT32_MAX) {
+		Bits.Write(0b11110, 5);
+		Bits.Write(static_cast<UINT32>(Value), 32);
+	}
+	else {
+		Bits.Write(0b11111, 5);
+		Bits.Write(static_cast<UINT64>(Value), 64);
+	}
+}
+
+static INT64 ReadDeltaOfDelta(BitReader& Bits) {
+	if (Bits.Read(1) == 0) return 0;
+	if (Bits.Read(1) == 0) return static_cast<INT64>(Bits.Read(7)) - 63;
+	if (Bits.Read(1) == 0) return static_cast<INT64>(Bits.Read(9)) - 255;
+	if (Bits.Read(1) == 0) return static_cast<INT64>(Bits.Read(12)) - 2047;
+	if (Bits.Read(1) == 0) return static_cast<INT32>(static_cast<UINT32>(Bits.Read(32)));
+	return static_cast<INT64>(Bits.Read(64));
+}
+
+void SeriesBlockEncoder::Append(INT64 Timestamp, double Value) {
+	_AppendBits(Timestamp, Kind == SERIES_DOUBLE ? std::bit_cast<UINT64>(Value) : static_cast<UINT64>(static_cast<INT64>(Value)));
+}
+
+void SeriesBlockEncoder::Append(INT64 Timestamp, INT64 Value) {
+	_AppendBits(Timestamp, Kind == SERIES_DOUBLE ? std::bit_cast<UINT64>(static_cast<double>(Value)) : static_cast<UINT64>(Value));
+}
+
+void SeriesBlockEncoder::_AppendBits(INT64 Timestamp, UINT64 Value) {
+	if (PointCount++ == 0) {
+		Bits.Write(static_cast<UINT64>(Timestamp), 64);
+		Bits.Write(Value, 64);
+		FirstTime = PreviousTime = Timestamp;
+		PreviousValue = Value;
+		return;
+	}
+	// Differences wrap like the decoder's sums do, so that any input round-trips.
+	INT64 TimeDelta = static_cast<INT64>(static_cast<UINT64>(Timestamp) - static_cast<UINT64>(PreviousTime));
+	WriteDeltaOfDelta(Bits, static_cast<INT64>(static_cast<UINT64>(TimeDelta) - static_cast<UINT64>(PreviousTimeDelta)));
+	PreviousTime = Timestamp;
+	PreviousTimeDelta = TimeDelta;
+
+	if (Kind == SERIES_INTEGER) {
+		INT64 ValueDelta = static_cast<INT64>(Value - PreviousValue);
+		WriteDeltaOfDelta(Bits, static_cast<INT64>(static_cast<UINT64>(ValueDelta) - static_cast<UINT64>(PreviousValueDelta)));
+		PreviousValue = Value;
+		PreviousValueDelta = ValueDelta;
+		return;
+	}
+
+	const UINT64 Xor = Value ^ PreviousValue;
+	PreviousValue = Value;
+	if (Xor == 0) {
+		Bits.Write(0, 1);
+		return;
+	}
+	// The leading count is stored in 5 bits.
+	const int Leading = (std::min)(std::countl_zero(Xor), 31);
+	const int Trailing = std::countr_zero(Xor);
+	if (PreviousLeading >= 0 && Leading >= PreviousLeading && Trailing >= PreviousTrailing) {
+		Bits.Write(0b10, 2);
+		Bits.Write(Xor >> PreviousTrailing, 64 - PreviousLeading - PreviousTrailing);
+		return;
+	}
+	const int Meaningful = 64 - Leading - Trailing;
+	Bits.Write((0b11ULL << 11) | (static_cast<UINT64>(Leading) << 6) | static_cast<UINT64>(Meaningful - 1), 13);
+	Bits.Write(Xor >> Trailing, Meaningful);
+	PreviousLeading = Leading;
+	PreviousTrailing = Trailing;
+}
+
+std::vector<BYTE> SeriesBlockEncoder::Encode() const {
+	ByteWriter Header;
+	Header.WriteByte(Kind);
+	Header.WriteVarint(PointCount);
+	std::vector<BYTE> Block = std::move(Header.Buffer);
+	Block.reserve(Block.size() + Bits.SizeBytes());
+	Bits.CopyTo(Block);
+	return Block;
+}
+
+void SeriesBlockEncoder::Clear() {
+	Bits.Clear();
+	PointCount = 0;
+	FirstTime = PreviousTime = PreviousTimeDelta = 0;
+	PreviousValue = 0;
+	PreviousValueDelta = 0;
+	PreviousLeading = -1;
+	PreviousTrailing = 0;
+}
+
+std::optional<Error> DecodeSeriesBlock(const BYTE* pData, size_t Size, std::vector<INT64>& Timestamps, std::vector<double>& Values) {
+	const char* FuncName = "DecodeSeriesBlock";
+	ByteReader Header(pData, Size);
+	BYTE Kind = Header.ReadByte();
+	UINT64 Count = Header.ReadVarint();
+	if (Header.bFailed || Kind > SERIES_INTEGER) return Error::New(FuncName, 1, L"Invalid block header.");
+	if (Count == 0) return std::nullopt;
+	// The first point takes 128 bits and every other one at least two, which bounds the count of a corrupted block.
+	const UINT64 AvailableBits = static_cast<UINT64>(Header.Remaining()) * 8;
+	if (AvailableBits < 128 || Count - 1 > (AvailableBits - 128) / 2) return Error::New(FuncName, 2, L"The point count exceeds the block size.");
+
+	BitReader Bits(pData + Header.Position(), Header.Remaining());
+	const size_t First = Timestamps.size();
+	Timestamps.resize(First + static_cast<size_t>(Count));
+	Values.resize(First + static_cast<size_t>(Count));
+	INT64* pTimestamps = Timestamps.data() + First;
+	double* pValues = Values.data() + First;
+
+	UINT64 Time = Bits.Read(64), Value = Bits.Read(64);
+	UINT64 TimeDelta = 0, ValueDelta = 0;
+	int Leading = 0, Trailing = 0;
+	pTimestamps[0] = static_cast<INT64>(Time);
+	pValues[0] = Kind == SERIES_DOUBLE ? std::bit_cast<double>(Value) : static_cast<double>(static_cast<INT64>(Value));
+	for (size_t i = 1; i < Count; i++) {
+		TimeDelta += static_cast<UINT64>(ReadDeltaOfDelta(Bits));
+		Time += TimeDelta;
+		pTimestamps[i] = static_cast<INT64>(Time);
+
+		if (Kind == SERIES_INTEGER) {
+			ValueDelta += static_cast<UINT64>(ReadDeltaOfDelta(Bits));
+			Value += ValueDelta;
+			pValues[i] = static_cast<double>(static_cast<INT64>(Value));
+			continue;
+		}
+		if (Bits.Read(1)) {
+			if (Bits.Read(1)) {
+				UINT64 Window = Bits.Read(11);
+				Leading = static_cast<int>(Window >> 6);
+				Trailing = 64 - Leading - static_cast<int>((Window & 0x3F) + 1);
+				// A window past 64 bits only comes from corruption.
+				if (Trailing < 0) break;
+			}
+			Value ^= Bits.Read(64 - Leading - Trailing) << Trailing;
+		}
+		pValues[i] = std::bit_cast<double>(Value);
+		if (Bits.bFailed) break;
+	}
+	if (Bits.bFailed || Trailing < 0) {
+		Timestamps.resize(First);
+		Values.resize(First);
+		return Error::New(FuncName, 3, L"The block is truncated or corrupted.");
+	}
+	return std::nullopt;
+}
+
+SeriesHistory::_ELEMENT& SeriesHistory::_Find(UINT64 Element) {
+	auto Entry = std::lower_bound(Elements.begin(), Elements.end(), Element, [](const _ELEMENT& Entry, UINT64 Key) { return Entry.Element < Key; });
+	if (Entry == Elements.end() || Entry->Element != Element) {
+		Entry = Elements.insert(Entry, _ELEMENT());
+		Entry->Element = Element;
+		Entry->Open = SeriesBlockEncoder(Kind);
+	}
+	return *Entry;
+}
+
+void SeriesHistory::Add(UINT64 Element, INT64 Timestamp, double Value) {
+	_ELEMENT& Entry = _Find(Element);
+	Entry.Open.Append(Timestamp, Value);
+	if (Entry.Open.Count() >= BlockPoints) _Close(Entry);
+}
+
+void SeriesHistory::Add(UINT64 Element, INT64 Timestamp, INT64 Value) {
+	_ELEMENT& Entry = _Find(Element);
+	Entry.Open.Append(Timestamp, Value);
+	if (Entry.Open.Count() >= BlockPoints) _Close(Entry);
+}
+
+SERIESBLOCKINFO SeriesHistory::_Encode(const _ELEMENT& Entry) const {
+	SERIESBLOCKINFO Block;
+	Block.Series = Name;
+	Block.Element = Entry.Element;
+	Block.FirstTimestamp = Entry.Open.FirstTimestamp();
+	Block.LastTimestamp = Entry.Open.LastTimestamp();
+	Block.PointCount = Entry.Open.Count();
+	Block.Data = Entry.Open.Encode();
+	return Block;
+}
+
+void SeriesHistory::_Close(_ELEMENT& Entry) {
+	if (Entry.Closed.size() >= MaxBlocks) Entry.Closed.erase(Entry.Closed.begin());
+	Entry.Closed.push_back(_Encode(Entry));
+	Entry.Open.Clear();
+}
+
+void SeriesHistory::Export(std::vector<SERIESBLOCKINFO>& Out) const {
+	for (const _ELEMENT& Entry : Elements) {
+		Out.insert(Out.end(), Entry.Closed.begin(), Entry.Closed.end());
+		if (Entry.Open.Count()) Out.push_back(_Encode(Entry));
+	}
+}
+
+size_t SeriesHistory::SizeBytes() const {
+	size_t Size = 0;
+	for (const _ELEMENT& Entry : Elements) {
+		Size += Entry.Open.SizeBytes();
+		for (const auto& Block : Entry.Closed) Size += Block.Data.size();
+	}
+	return Size;
+}
@@ -0,0 +1,118 @@
+/* Info: Gorilla-style compressed blocks for sampled time series (delta-of-delta timestamps, XOR floats or delta-of-delta integers) and a rolling history built on them. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SERIESBLOCKINFO
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum SERIES_VALUE_KIND : BYTE {
+	SERIES_DOUBLE = 0,		// XOR with the previous value; best for gauges that repeat or move in few bits.
+	SERIES_INTEGER			// Delta of deltas; best for counters that grow at a steady rate.
+};
+
+// Most significant bit first, so that prefix codes read in the order they were written.
+class BitWriter {
+public:
+	std::vector<BYTE> Buffer;
+
+	// Writes the low `Count` bits of `Value`, 1 to 64.
+	void Write(UINT64 Value, int Count);
+	// Bytes written so far, counting a partly filled last byte.
+	size_t SizeBytes() const { return Buffer.size() + (Used + 7) / 8; }
+	// Appends the pending bits to `Out`, padded with zeros to a whole byte.
+	void CopyTo(std::vector<BYTE>& Out) const;
+	void Clear();
+
+private:
+	UINT64 Accumulator = 0;		// Pending bits, aligned to the top.
+	int Used = 0;
+};
+
+class BitReader {
+public:
+	BOOL bFailed = FALSE;
+
+	BitReader(const BYTE* pData, size_t Size) : pData(pData), Size(Size) {}
+
+	// Reads `Count` bits, 1 to 64; past the end it sets bFailed and returns zero.
+	UINT64 Read(int Count);
+
+private:
+	const BYTE* pData;
+	size_t Size;
+	size_t Position = 0;		// In bits.
+};
+
+/*
+ * Block layout: the value kind, a varint point count, then the bit stream. The first point is stored raw; each
+ * following timestamp stores the change of its delta in a prefix code (a single 0 bit for a steady interval) and
+ * each value either its XOR with the previous one, reusing the previous leading/trailing zero window when it fits,
+ * or the change of its delta like timestamps.
+ */
+class SeriesBlockEncoder {
+public:
+	explicit SeriesBlockEncoder(SERIES_VALUE_KIND Kind = SERIES_DOUBLE) : Kind(Kind) {}
+
+	// Timestamps are expected in increasing order; they are stored exactly either way.
+	void Append(INT64 Timestamp, double Value);
+	void Append(INT64 Timestamp, INT64 Value);
+
+	DWORD Count() const { return PointCount; }
+	INT64 FirstTimestamp() const { return FirstTime; }
+	INT64 LastTimestamp() const { return PreviousTime; }
+	size_t SizeBytes() const { return Bits.SizeBytes() + 6; }
+	// The block so far; the encoder keeps appending to it.
+	std::vector<BYTE> Encode() const;
+	void Clear();
+
+private:
+	SERIES_VALUE_KIND Kind;
+	BitWriter Bits;
+	DWORD PointCount = 0;
+	INT64 FirstTime = 0;
+	INT64 PreviousTime = 0;
+	INT64 PreviousTimeDelta = 0;
+	UINT64 PreviousValue = 0;	// Bit pattern for SERIES_DOUBLE, two's complement for SERIES_INTEGER.
+	INT64 PreviousValueDelta = 0;
+	int PreviousLeading = -1;	// Zero window of the last XOR written with its own window; -1 before the first.
+	int PreviousTrailing = 0;
+
+	void _AppendBits(INT64 Timestamp, UINT64 Value);
+};
+
+// Decodes a whole block. Integer blocks come back as doubles, which is exact up to 2^53.
+std::optional<Error> DecodeSeriesBlock(const BYTE* pData, size_t Size, std::vector<INT64>& Timestamps, std::vector<double>& Values);
+
+/*
+ * Compressed history of one series, one block stream per element (processor, interface). A block is closed every
+ * BlockPoints points and the oldest closed block of an element is dropped past MaxBlocks.
+ */
+class SeriesHistory {
+public:
+	SeriesHistory(std::string Name, SERIES_VALUE_KIND Kind = SERIES_DOUBLE, DWORD BlockPoints = 60, size_t MaxBlocks = 15)
+		: Name(std::move(Name)), Kind(Kind), BlockPoints(BlockPoints), MaxBlocks(MaxBlocks) {}
+
+	void Add(UINT64 Element, INT64 Timestamp, double Value);
+	void Add(UINT64 Element, INT64 Timestamp, INT64 Value);
+	// Appends every closed block and the open one of each element, oldest first.
+	void Export(std::vector<SERIESBLOCKINFO>& Out) const;
+	size_t SizeBytes() const;
+
+private:
+	struct _ELEMENT {
+		UINT64 Element = 0;
+		SeriesBlockEncoder Open;
+		std::vector<SERIESBLOCKINFO> Closed;
+	};
+	std::string Name;
+	SERIES_VALUE_KIND Kind;
+	DWORD BlockPoints;
+	size_t MaxBlocks;
+	std::vector<_ELEMENT> Elements;		// Sorted by element.
+
+	_ELEMENT& _Find(UINT64 Element);
+	SERIESBLOCKINFO _Encode(const _ELEMENT& Entry) const;
+	void _Close(_ELEMENT& Entry);
+};
@@ -0,0 +1,189 @@
+#include "SharedSnapshot.hpp"
+#include <algorithm>
+#include <cstring>
+
+// "SIPM" in little-endian.
+constexpr DWORD SharedMagic = 0x4D504953;
+constexpr DWORD SharedLayoutVersion = 2;
+
+// A reader that keeps seeing an update in progress this many times gives up, e.g. when the writer died mid-update.
+constexpr int MaxReadAttempts = 1 << 16;
+
+static BYTE* PayloadOf(SHAREDSNAPSHOTHEADER* pHeader) { return reinterpret_cast<BYTE*>(pHeader + 1); }
+static const BYTE* PayloadOf(const SHAREDSNAPSHOTHEADER* pHeader) { return reinterpret_cast<const BYTE*>(pHeader + 1); }
+
+// Writer side of the sequence lock: the counter is odd for the duration of `Update`.
+template<class F> static void SequencedWrite(std::atomic<UINT64>& Sequence, F Update) {
+	UINT64 Value = Sequence.load(std::memory_order_relaxed);
+	Sequence.store(Value + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Update();
+	Sequence.store(Value + 2, std::memory_order_release);
+}
+
+// Reader side: retries `Copy` until it ran entirely between two updates. Returns FALSE if that never happened.
+template<class F> static BOOL SequencedRead(const std::atomic<UINT64>& Sequence, F Copy) {
+	for (int Attempt = 0; Attempt < MaxReadAttempts; Attempt++) {
+		UINT64 Before = Sequence.load(std::memory_order_acquire);
+		if (Before & 1) {
+			YieldProcessor();
+			continue;
+		}
+		Copy();
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (Sequence.load(std::memory_order_relaxed) == Before) return TRUE;
+	}
+	return FALSE;
+}
+
+// Keeps the newest `KeepBlocks` blocks of every history element; Export lists the blocks of an element together, oldest first.
+static void TrimHistory(std::vector<SERIESBLOCKINFO>& History, size_t KeepBlocks) {
+	size_t Kept = 0;
+	for (size_t Begin = 0; Begin < History.size();) {
+		size_t End = Begin + 1;
+		while (End < History.size() && History[End].Series == History[Begin].Series && History[End].Element == History[Begin].Element) End++;
+		for (size_t i = End - (std::min)(End - Begin, KeepBlocks); i < End; i++, Kept++) {
+			if (Kept != i) History[Kept] = std::move(History[i]);
+		}
+		Begin = End;
+	}
+	History.resize(Kept);
+}
+
+std::optional<Error> SharedSnapshotPublisher::Create(LPCWSTR Name, DWORD PayloadCapacity) {
+	const char* FuncName = "SharedSnapshotPublisher::Create";
+	Close();
+
+	DWORD SectionSize = sizeof(SHAREDSNAPSHOTHEADER) + PayloadCapacity;
+	hMapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, SectionSize, Name);
+	if (!hMapping) {
+		return Error::New(FuncName, 1, L"Failed to create the shared memory section.", GetLastError());
+	}
+	if (GetLastError() == ERROR_ALREADY_EXISTS) {
+		Close();
+		return Error::New(FuncName, 2, L"Another process is already publishing under this name.", ERROR_ALREADY_EXISTS);
+	}
+
+	pHeader = static_cast<PSHAREDSNAPSHOTHEADER>(MapViewOfFile(hMapping, FILE_MAP_WRITE, 0, 0, SectionSize));
+	if (!pHeader) {
+		DWORD LastError = GetLastError();
+		Close();
+		return Error::New(FuncName, 3, L"Failed to map the shared memory section.", LastError);
+	}
+
+	// New sections are zero-filled, so both sequences start even with nothing published yet.
+	pHeader->PayloadCapacity = PayloadCapacity;
+	pHeader->WriterProcessId = GetCurrentProcessId();
+	pHeader->LayoutVersion = SharedLayoutVersion;
+	std::atomic_thread_fence(std::memory_order_release);
+	pHeader->Magic = SharedMagic;
+	return std::nullopt;
+}
+
+std::optional<Error> SharedSnapshotPublisher::PublishSnapshot(const SYSINFOSNAPSHOT& Snapshot) {
+	const char* FuncName = "SharedSnapshotPublisher::PublishSnapshot";
+	if (!pHeader) return Error::New(FuncName, 1, L"Shared memory section is not created.");
+
+	// Encoding happens before the update starts so that readers only ever wait for a memcpy.
+	Writer.Buffer.clear();
+	SerializeSnapshot(Snapshot, Writer);
+	// The history grows with the processor count and its age, up to several times the section. When the snapshot
+	// does not fit, only the newest block of each element is published, then no history, so the rest still is.
+	if (Writer.Buffer.size() > pHeader->PayloadCapacity && !Snapshot.History.empty()) {
+		SYSINFOSNAPSHOT Trimmed = Snapshot;
+		for (size_t KeepBlocks : { 1, 0 }) {
+			TrimHistory(Trimmed.History, KeepBlocks);
+			Writer.Buffer.clear();
+			SerializeSnapshot(Trimmed, Writer);
+			if (Writer.Buffer.size() <= pHeader->PayloadCapacity) break;
+		}
+	}
+	if (Writer.Buffer.size() > pHeader->PayloadCapacity) {
+		return Error::New(FuncName, 2, L"Snapshot does not fit in the shared memory section.");
+	}
+
+	SequencedWrite(pHeader->SnapshotSequence, [&]() {
+		memcpy(PayloadOf(pHeader), Writer.Buffer.data(), Writer.Buffer.size());
+		pHeader->SnapshotSize = static_cast<DWORD>(Writer.Buffer.size());
+	});
+	return std::nullopt;
+}
+
+void SharedSnapshotPublisher::PublishCounters(const LIVECOUNTERS& Counters) {
+	if (!pHeader) return;
+	SequencedWrite(pHeader->CountersSequence, [&]() { pHeader->Counters = Counters; });
+}
+
+void SharedSnapshotPublisher::Close() {
+	if (pHeader) UnmapViewOfFile(pHeader);
+	if (hMapping) CloseHandle(hMapping);
+	pHeader = nullptr;
+	hMapping = NULL;
+}
+
+std::optional<Error> SharedSnapshotReader::Open(LPCWSTR Name) {
+	const char* FuncName = "SharedSnapshotReader::Open";
+	Close();
+
+	hMapping = OpenFileMappingW(FILE_MAP_READ, FALSE, Name);
+	if (!hMapping) {
+		return Error::New(FuncName, 1, L"No snapshot is being published under this name.", GetLastError());
+	}
+
+	// The view covers the whole section, whose size is only known from the header.
+	pHeader = static_cast<const SHAREDSNAPSHOTHEADER*>(MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (!pHeader) {
+		DWORD LastError = GetLastError();
+		Close();
+		return Error::New(FuncName, 2, L"Failed to map the shared memory section.", LastError);
+	}
+
+	if (pHeader->Magic != SharedMagic || pHeader->LayoutVersion != SharedLayoutVersion) {
+		Close();
+		return Error::New(FuncName, 3, L"Shared memory section has an unknown layout.");
+	}
+
+	SnapshotCopy.resize(pHeader->PayloadCapacity);
+	return std::nullopt;
+}
+
+void SharedSnapshotReader::Close() {
+	if (pHeader) UnmapViewOfFile(pHeader);
+	if (hMapping) CloseHandle(hMapping);
+	pHeader = nullptr;
+	hMapping = NULL;
+}
+
+UINT64 SharedSnapshotReader::SnapshotSequence() const {
+	return pHeader ? pHeader->SnapshotSequence.load(std::memory_order_acquire) : 0;
+}
+
+std::optional<Error> SharedSnapshotReader::ReadSnapshot(SYSINFOSNAPSHOT& Out) {
+	const char* FuncName = "SharedSnapshotReader::ReadSnapshot";
+	if (!pHeader) return Error::New(FuncName, 1, L"Shared memory section is not open.");
+
+	DWORD Size = 0;
+	BOOL bConsistent = SequencedRead(pHeader->SnapshotSequence, [&]() {
+		Size = std::min(pHeader->SnapshotSize, static_cast<DWORD>(SnapshotCopy.size()));
+		memcpy(SnapshotCopy.data(), PayloadOf(pHeader), Size);
+	});
+	if (!bConsistent) return Error::New(FuncName, 2, L"Snapshot is being rewritten for too long.");
+	if (Size == 0) return Error::New(FuncName, 3, L"No snapshot has been published yet.");
+
+	auto r = DeserializeSnapshot(SnapshotCopy.data(), Size, Out);
+	if (r) {
+		r.value().AddNewFunctionToStack(FuncName, 4);
+		return r;
+	}
+	return std::nullopt;
+}
+
+std::optional<Error> SharedSnapshotReader::ReadCounters(LIVECOUNTERS& Out) const {
+	const char* FuncName = "SharedSnapshotReader::ReadCounters";
+	if (!pHeader) return Error::New(FuncName, 1, L"Shared memory section is not open.");
+
+	if (!SequencedRead(pHeader->CountersSequence, [&]() { memcpy(&Out, &pHeader->Counters, sizeof(Out)); })) {
+		return Error::New(FuncName, 2, L"Counters are being rewritten for too long.");
+	}
+	return std::nullopt;
+}
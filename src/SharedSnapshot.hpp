@@ -0,0 +1,84 @@
+/* Info: Publishes the latest snapshot and live counters in a named shared memory section that local processes read without locks. */
+#pragma once
+#include "Errors.hpp"			// For error handling
+#include "SysInfoTypes.hpp"		// For SYSINFOSNAPSHOT
+#include "Serialization.hpp"	// For the snapshot encoding used in the shared section
+#include <atomic>
+#include <optional>
+
+// Session-local by default; a "Global\\" name shares across sessions but needs SeCreateGlobalPrivilege to create.
+constexpr LPCWSTR SharedSnapshotDefaultName = L"Local\\SysInfoProbeSnapshot";
+constexpr DWORD SharedSnapshotDefaultCapacity = 1024 * 1024;
+constexpr DWORD SharedLiveMaxThreads = 256;
+constexpr DWORD SharedLiveMaxSensors = 16;
+
+// Fixed-size figures refreshed every few seconds, much more often than the full snapshot.
+typedef struct _tag_LIVECOUNTERS {
+	INT64 SampledAt = 0;				// Unix time in milliseconds.
+	UINT64 UptimeMilliseconds = 0;
+	double CPUUtilization = 0.0;
+	INT64 CPUClockSpeed = 0;			// Percent of the nominal frequency.
+	UINT64 TotalPhysicalMemory = 0;		// Bytes.
+	UINT64 AvailablePhysicalMemory = 0;	// Bytes.
+	DWORD ThreadCount = 0;
+	double ThreadsUtilization[SharedLiveMaxThreads] = { 0 };
+	DWORD ThermalZoneCount = 0;
+	double TemperaturesCelsius[SharedLiveMaxSensors] = { 0 };
+	DWORD PowerDomainCount = 0;
+	double PowerWatts[SharedLiveMaxSensors] = { 0 };
+	DWORD GovernorLevel = 0;			// Non-zero while the publisher degrades its sampling to stay within its CPU budget.
+} LIVECOUNTERS, *PLIVECOUNTERS;
+
+/*
+ * Layout of the shared section; the serialized snapshot follows the header.
+ * Both parts are guarded by their own sequence counter, which is odd while the writer is updating that part.
+ * A reader copies a part and keeps the copy only if the counter was even and unchanged across the copy.
+ */
+typedef struct _tag_SHAREDSNAPSHOTHEADER {
+	DWORD Magic;
+	DWORD LayoutVersion;
+	DWORD PayloadCapacity;
+	DWORD WriterProcessId;
+	alignas(64) std::atomic<UINT64> CountersSequence;
+	LIVECOUNTERS Counters;
+	alignas(64) std::atomic<UINT64> SnapshotSequence;
+	DWORD SnapshotSize;
+} SHAREDSNAPSHOTHEADER, *PSHAREDSNAPSHOTHEADER;
+
+static_assert(std::atomic<UINT64>::is_always_lock_free, "Sequence counters must be lock-free to live in shared memory.");
+
+// Owned by the daemon; only one publisher may exist per name.
+class SharedSnapshotPublisher {
+public:
+	~SharedSnapshotPublisher() { Close(); }
+
+	std::optional<Error> Create(LPCWSTR Name = SharedSnapshotDefaultName, DWORD PayloadCapacity = SharedSnapshotDefaultCapacity);
+	// Cuts the history down to the newest block of each element, or leaves it out, when the whole snapshot does not fit.
+	std::optional<Error> PublishSnapshot(const SYSINFOSNAPSHOT& Snapshot);
+	void PublishCounters(const LIVECOUNTERS& Counters);
+	void Close();
+
+private:
+	HANDLE hMapping = NULL;
+	PSHAREDSNAPSHOTHEADER pHeader = nullptr;
+	ByteWriter Writer;		// Reused so that publishing does not allocate once the buffer has grown.
+};
+
+// Maps the section read-only. After Open, reads touch only the mapped memory: no system calls and no locks.
+class SharedSnapshotReader {
+public:
+	~SharedSnapshotReader() { Close(); }
+
+	std::optional<Error> Open(LPCWSTR Name = SharedSnapshotDefaultName);
+	void Close();
+
+	// Changes every time a new snapshot is published; cheap enough to poll before calling ReadSnapshot.
+	UINT64 SnapshotSequence() const;
+	std::optional<Error> ReadSnapshot(SYSINFOSNAPSHOT& Out);
+	std::optional<Error> ReadCounters(LIVECOUNTERS& Out) const;
+
+private:
+	HANDLE hMapping = NULL;
+	const SHAREDSNAPSHOTHEADER* pHeader = nullptr;
+	std::vector<BYTE> SnapshotCopy;
+};
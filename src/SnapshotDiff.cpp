@@ -0,0 +1,243 @@
+#include "SnapshotDiff.hpp"
+#include <cstring>
+#include <format>
+#include <unordered_map>
+
+// Sections left out of digests and diffs with DIFF_IGNORE_VOLATILE.
+static bool IsVolatileSection(BYTE Id) {
+	return Id == SECTION_CPUUTILIZATION || Id == SECTION_UPTIME || Id == SECTION_THERMALZONES || Id == SECTION_FANS || Id == SECTION_POWERDOMAINS ||
+		Id == SECTION_MEMORYUSAGE || Id == SECTION_NETWORKCOUNTERS || Id == SECTION_DISKCOUNTERS || Id == SECTION_COLLECTORSTATS || Id == SECTION_GOVERNOR ||
+		Id == SECTION_JOBUSAGE || Id == SECTION_NUMACOUNTERS ||
+		Id == SECTION_INTERRUPTCOUNTERS || Id == SECTION_CPUPRESSURE ||
+		Id == SECTION_TCPSTATS || Id == SECTION_VOLUMES || Id == SECTION_SKETCHES || Id == SECTION_HISTORY ||
+		Id == SECTION_GPUMEMORYCOUNTERS || Id == SECTION_PROCESSCOUNTERS;
+}
+
+// Multiply-xorshift mixing over 64-bit words; strings are consumed eight bytes at a time.
+class FieldHasher {
+public:
+	UINT64 State = 0x243F6A8885A308D3;
+	const char* SkipField = nullptr;
+
+	void Mix(UINT64 Value) {
+		State = (State ^ Value) * 0x9E3779B97F4A7C15;
+		State ^= State >> 32;
+	}
+
+	void MixBytes(const char* pData, size_t Size) {
+		Mix(Size);
+		size_t i = 0;
+		for (; i + 8 <= Size; i += 8) {
+			UINT64 Word;
+			memcpy(&Word, pData + i, 8);
+			Mix(Word);
+		}
+		if (i < Size) {
+			UINT64 Word = 0;
+			memcpy(&Word, pData + i, Size - i);
+			Mix(Word);
+		}
+	}
+
+	UINT64 Finish() const {
+		UINT64 Hash = State;
+		Hash ^= Hash >> 33;
+		Hash *= 0xFF51AFD7ED558CCD;
+		Hash ^= Hash >> 33;
+		return Hash;
+	}
+
+	template<class F> void operator()(const char* Name, const F& Field) {
+		if (SkipField && strcmp(Name, SkipField) == 0) return;
+
+		if constexpr (std::is_same_v<F, std::string>) MixBytes(Field.data(), Field.size());
+		else if constexpr (std::is_floating_point_v<F>) {
+			// +0.0 and -0.0 compare equal, so they must hash equal too.
+			double Value = Field == 0 ? 0.0 : static_cast<double>(Field);
+			UINT64 Bits;
+			memcpy(&Bits, &Value, sizeof(Bits));
+			Mix(Bits);
+		}
+		else if constexpr (std::is_enum_v<F> || std::is_integral_v<F>) Mix(static_cast<UINT64>(Field));
+		else {
+			Mix(Field.size());
+			for (const auto& Element : Field) (*this)(Name, Element);
+		}
+	}
+};
+
+template<class S> static UINT64 HashFields(const S& Value, const char* SkipField = nullptr) {
+	FieldHasher Hasher;
+	Hasher.SkipField = SkipField;
+	VisitFields(Value, Hasher);
+	return Hasher.Finish();
+}
+
+// The field that changes on every collection of an otherwise stable section, if any.
+static const char* VolatileField(BYTE Id, DWORD Flags) {
+	return (Flags & DIFF_IGNORE_VOLATILE) && Id == SECTION_HOST ? "CollectedAt" : nullptr;
+}
+
+struct SectionDigester {
+	SNAPSHOTDIGEST& Digest;
+
+	template<class S> void Section(BYTE Id, const char*, const S& Value) {
+		if ((Digest.Flags & DIFF_IGNORE_VOLATILE) && IsVolatileSection(Id)) return;
+		Digest.SectionHashes[Id] = HashFields(Value, VolatileField(Id, Digest.Flags));
+	}
+
+	// Elements are summed so that enumeration order does not change the hash.
+	template<class S> void List(BYTE Id, const char*, const std::vector<S>& Values) {
+		if ((Digest.Flags & DIFF_IGNORE_VOLATILE) && IsVolatileSection(Id)) return;
+		UINT64 Hash = Values.size();
+		for (const auto& Value : Values) Hash += HashFields(Value);
+		Digest.SectionHashes[Id] = Hash;
+	}
+};
+
+SNAPSHOTDIGEST ComputeSnapshotDigest(const SYSINFOSNAPSHOT& Snapshot, DWORD Flags) {
+	SNAPSHOTDIGEST Digest;
+	Digest.Flags = Flags;
+	SectionDigester Digester{ Digest };
+	VisitSections(Snapshot, Digester);
+	return Digest;
+}
+
+// Identity of list elements across two snapshots.
+static const std::string& ElementKey(const CPUSOCKETINFO& Value) { return Value.SocketDesignation; }
+static const std::string& ElementKey(const CACHEINFO& Value) { return Value.SocketDesignation; }
+static const std::string& ElementKey(const RAMINFO& Value) { return Value.DeviceLocator; }
+static const std::string& ElementKey(const STORAGEDEVICEINFO& Value) { return Value.SerialNumber.empty() ? Value.Model : Value.SerialNumber; }
+static const std::string& ElementKey(const NETWORKINTERFACEINFO& Value) { return Value.MACAddress.empty() ? Value.Name : Value.MACAddress; }
+static const std::string& ElementKey(const CDROMINFO& Value) { return Value.Name; }
+static const std::string& ElementKey(const DISPLAYINFO& Value) { return Value.SerialNumber.empty() ? Value.MonitorName : Value.SerialNumber; }
+static const std::string& ElementKey(const THERMALZONEINFO& Value) { return Value.Name; }
+static const std::string& ElementKey(const FANINFO& Value) { return Value.Name; }
+static const std::string& ElementKey(const POWERDOMAININFO& Value) { return Value.Name; }
+static const std::string& ElementKey(const COLLECTORSTATS& Value) { return Value.Name; }
+static std::string ElementKey(const NETWORKCOUNTERSINFO& Value) { return std::to_string(Value.InterfaceIndex); }
+static std::string ElementKey(const DISKCOUNTERSINFO& Value) { return std::to_string(Value.DeviceNumber); }
+static std::string ElementKey(const NUMANODEINFO& Value) { return std::to_string(Value.NodeNumber); }
+static std::string ElementKey(const NUMANODECOUNTERSINFO& Value) { return std::to_string(Value.NodeNumber); }
+static std::string ElementKey(const INTERRUPTCOUNTERSINFO& Value) { return std::to_string(Value.Processor); }
+static std::string ElementKey(const INTERRUPTASSIGNMENTINFO& Value) { return std::format("{}/{}", Value.InstanceId, Value.Vector); }
+static std::string ElementKey(const PCIDEVICEINFO& Value) { return Value.InstanceId; }
+// LUIDs change across reboots; the PCI instance does not, and non-PCI adapters fall back to their name.
+static const std::string& ElementKey(const GPUINFO& Value) { return Value.PCIInstanceId.empty() ? Value.Name : Value.PCIInstanceId; }
+static std::string ElementKey(const GPUMEMORYCOUNTERSINFO& Value) { return std::format("{:016X}", Value.AdapterLuid); }
+// Process ids are reused, so a new process with an old id is another element.
+static std::string ElementKey(const PROCESSCOUNTERSINFO& Value) { return std::format("{}/{}", Value.ProcessId, Value.CreateTime); }
+static const std::string& ElementKey(const VOLUMESPACEINFO& Value) { return Value.RootPath; }
+static std::string ElementKey(const SKETCHINFO& Value) { return std::format("{}/{}", Value.Series, Value.Element); }
+static std::string ElementKey(const SERIESBLOCKINFO& Value) { return std::format("{}/{}/{}", Value.Series, Value.Element, Value.FirstTimestamp); }
+
+// Keys made unique by numbering repeats ("Samsung SSD", "Samsung SSD#2"), so identical devices still pair up in order.
+template<class S> static std::vector<std::string> ElementKeys(const std::vector<S>& Values) {
+	std::vector<std::string> Keys;
+	Keys.reserve(Values.size());
+	std::unordered_map<std::string, size_t> Seen;
+	for (const auto& Value : Values) {
+		std::string Key = ElementKey(Value);
+		size_t Occurrence = ++Seen[Key];
+		Keys.push_back(Occurrence == 1 ? Key : std::format("{}#{}", Key, Occurrence));
+	}
+	return Keys;
+}
+
+// Renders each visited field as text, in visiting order.
+struct FieldFormatter {
+	std::vector<std::pair<const char*, std::string>> Fields;
+
+	template<class F> static std::string Format(const F& Field) {
+		if constexpr (std::is_same_v<F, std::string>) return Field;
+		else if constexpr (std::is_floating_point_v<F>) return std::format("{}", Field);
+		else if constexpr (std::is_enum_v<F>) return std::to_string(static_cast<INT64>(Field));
+		else if constexpr (std::is_integral_v<F>) return std::to_string(Field);
+		else {
+			std::string Text;
+			for (const auto& Element : Field) {
+				if (!Text.empty()) Text += ", ";
+				Text += Format(Element);
+			}
+			return Text;
+		}
+	}
+
+	template<class F> void operator()(const char* Name, const F& Field) {
+		Fields.emplace_back(Name, Format(Field));
+	}
+};
+
+struct SectionLocator {
+	const void* pSections[SnapshotSectionLimit] = { nullptr };
+
+	template<class S> void Section(BYTE Id, const char*, const S& Value) { pSections[Id] = &Value; }
+	template<class S> void List(BYTE Id, const char*, const std::vector<S>& Values) { pSections[Id] = &Values; }
+};
+
+struct SectionDiffer {
+	// Sections of the old snapshot; a given identifier always refers to the same type in both snapshots.
+	const SectionLocator& Old;
+	const SNAPSHOTDIGEST& OldDigest;
+	const SNAPSHOTDIGEST& NewDigest;
+	std::vector<SNAPSHOTCHANGE>& Changes;
+
+	bool Skip(BYTE Id) const {
+		return ((NewDigest.Flags & DIFF_IGNORE_VOLATILE) && IsVolatileSection(Id)) || OldDigest.SectionHashes[Id] == NewDigest.SectionHashes[Id];
+	}
+
+	template<class S> void DiffFields(BYTE Id, const char* Name, const std::string& Key, const S& OldValue, const S& NewValue) {
+		FieldFormatter OldFields, NewFields;
+		VisitFields(OldValue, OldFields);
+		VisitFields(NewValue, NewFields);
+		const char* SkipField = VolatileField(Id, NewDigest.Flags);
+		for (size_t i = 0; i < NewFields.Fields.size(); i++) {
+			const auto& [Field, NewText] = NewFields.Fields[i];
+			const std::string& OldText = OldFields.Fields[i].second;
+			if (OldText == NewText || (SkipField && strcmp(Field, SkipField) == 0)) continue;
+			Changes.push_back({ CHANGE_MODIFIED, static_cast<SNAPSHOT_SECTION>(Id), Name, Key, Field, OldText, NewText });
+		}
+	}
+
+	template<class S> void Section(BYTE Id, const char* Name, const S& Value) {
+		if (Skip(Id)) return;
+		DiffFields(Id, Name, std::string(), *static_cast<const S*>(Old.pSections[Id]), Value);
+	}
+
+	template<class S> void List(BYTE Id, const char* Name, const std::vector<S>& Values) {
+		if (Skip(Id)) return;
+		const auto& OldValues = *static_cast<const std::vector<S>*>(Old.pSections[Id]);
+		std::vector<std::string> OldKeys = ElementKeys(OldValues);
+		std::vector<std::string> NewKeys = ElementKeys(Values);
+
+		std::unordered_map<std::string_view, size_t> OldIndex;
+		for (size_t i = 0; i < OldKeys.size(); i++) OldIndex.emplace(OldKeys[i], i);
+
+		std::vector<bool> Matched(OldValues.size(), false);
+		for (size_t i = 0; i < Values.size(); i++) {
+			auto Found = OldIndex.find(NewKeys[i]);
+			if (Found == OldIndex.end()) {
+				Changes.push_back({ CHANGE_ADDED, static_cast<SNAPSHOT_SECTION>(Id), Name, NewKeys[i] });
+				continue;
+			}
+			Matched[Found->second] = true;
+			if (HashFields(OldValues[Found->second]) != HashFields(Values[i])) DiffFields(Id, Name, NewKeys[i], OldValues[Found->second], Values[i]);
+		}
+
+		for (size_t i = 0; i < OldValues.size(); i++) {
+			if (!Matched[i]) Changes.push_back({ CHANGE_REMOVED, static_cast<SNAPSHOT_SECTION>(Id), Name, OldKeys[i] });
+		}
+	}
+};
+
+void DiffSnapshots(const SYSINFOSNAPSHOT& Old, const SYSINFOSNAPSHOT& New, std::vector<SNAPSHOTCHANGE>& Changes,
+	DWORD Flags, const SNAPSHOTDIGEST* pOldDigest, const SNAPSHOTDIGEST* pNewDigest) {
+	// A digest computed with other flags hashed other sections (volatile ones as zero), so it is recomputed rather than trusted.
+	SNAPSHOTDIGEST OldDigest = pOldDigest && pOldDigest->Flags == Flags ? *pOldDigest : ComputeSnapshotDigest(Old, Flags);
+	SNAPSHOTDIGEST NewDigest = pNewDigest && pNewDigest->Flags == Flags ? *pNewDigest : ComputeSnapshotDigest(New, Flags);
+
+	SectionLocator OldSections;
+	VisitSections(Old, OldSections);
+	SectionDiffer Differ{ OldSections, OldDigest, NewDigest, Changes };
+	VisitSections(New, Differ);
+}
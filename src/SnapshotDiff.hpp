@@ -0,0 +1,48 @@
+/* Info: Section-level hashing and field-level differences between two snapshots, used to detect hardware and configuration drift. */
+#pragma once
+#include "SysInfoTypes.hpp"		// For SYSINFOSNAPSHOT
+#include "SnapshotFields.hpp"	// For SNAPSHOT_SECTION
+
+// Section identifiers must stay below this to have a slot in SNAPSHOTDIGEST.
+constexpr BYTE SnapshotSectionLimit = 64;
+static_assert(SECTION_END <= SnapshotSectionLimit, "Every section needs a slot in SNAPSHOTDIGEST.");
+
+enum SNAPSHOT_DIFF_FLAGS : DWORD {
+	// Skip sections that change on every collection (utilization, uptime, sensors) and the collection time.
+	DIFF_IGNORE_VOLATILE = 0x1
+};
+
+// One hash per section; two snapshots whose hashes for a section match are treated as identical there.
+typedef struct _tag_SNAPSHOTDIGEST {
+	UINT64 SectionHashes[SnapshotSectionLimit] = { 0 };
+	DWORD Flags = 0;	// The SNAPSHOT_DIFF_FLAGS the digest was computed with.
+} SNAPSHOTDIGEST, *PSNAPSHOTDIGEST;
+
+enum SNAPSHOT_CHANGE_KIND : BYTE {
+	CHANGE_MODIFIED = 1,
+	CHANGE_ADDED,		// A list element (disk, NIC, module...) only present in the new snapshot.
+	CHANGE_REMOVED		// A list element only present in the old snapshot.
+};
+
+typedef struct _tag_SNAPSHOTCHANGE {
+	SNAPSHOT_CHANGE_KIND Kind = CHANGE_MODIFIED;
+	SNAPSHOT_SECTION Section = SECTION_HOST;
+	std::string SectionName;
+	// Identity of the list element, e.g. the disk serial number or the MAC address; empty for single sections.
+	std::string Key;
+	// Empty for added and removed elements.
+	std::string Field;
+	std::string OldValue;
+	std::string NewValue;
+} SNAPSHOTCHANGE, *PSNAPSHOTCHANGE;
+
+SNAPSHOTDIGEST ComputeSnapshotDigest(const SYSINFOSNAPSHOT& Snapshot, DWORD Flags = DIFF_IGNORE_VOLATILE);
+
+/*
+ * Appends the differences between `Old` and `New` to `Changes`. Sections whose hashes match are skipped without
+ * looking at their fields. Digests computed earlier can be passed in so that diffing one snapshot against many
+ * others hashes it only once; a digest computed with other flags than `Flags` is recomputed. List elements are matched by key: storage devices by serial
+ * number, network interfaces by MAC address, memory modules by slot, and everything else by name.
+ */
+void DiffSnapshots(const SYSINFOSNAPSHOT& Old, const SYSINFOSNAPSHOT& New, std::vector<SNAPSHOTCHANGE>& Changes,
+	DWORD Flags = DIFF_IGNORE_VOLATILE, const SNAPSHOTDIGEST* pOldDigest = nullptr, const SNAPSHOTDIGEST* pNewDigest = nullptr);
@@ -0,0 +1,535 @@
+/* Info: Field and section lists of every snapshot type. Serialization, hashing and diffing all walk these, so a field added here is picked up by all of them. */
+#pragma once
+#include "SysInfoTypes.hpp"
+#include <type_traits>
+
+// Matches both `X` and `const X`, so one visitor list serves readers and writers.
+template<class T, class U> concept FieldsOf = std::is_same_v<std::remove_const_t<T>, U>;
+
+/*
+ * Section identifiers of a snapshot. They are part of the serialized format: never renumber them,
+ * and append new fields at the end of a VisitFields list so older readers can skip them.
+ */
+enum SNAPSHOT_SECTION : BYTE {
+	SECTION_HOST = 1,
+	SECTION_CPU,
+	SECTION_CPUSOCKETS,
+	SECTION_CPUCACHES,
+	SECTION_CPUUTILIZATION,
+	SECTION_RAM,
+	SECTION_RAMMODULES,
+	SECTION_GPU,				// Retired: the single WMI adapter, superseded by SECTION_GPUS. Readers skip it.
+	SECTION_MAINBOARD,
+	SECTION_BIOS,
+	SECTION_OS,
+	SECTION_UPTIME,
+	SECTION_SOUND,
+	SECTION_STORAGEDEVICES,
+	SECTION_NETWORKINTERFACES,
+	SECTION_CDROMS,
+	SECTION_DISPLAYS,
+	SECTION_THERMALZONES,
+	SECTION_FANS,
+	SECTION_POWERDOMAINS,
+	SECTION_MEMORYUSAGE,
+	SECTION_NETWORKCOUNTERS,
+	SECTION_DISKCOUNTERS,
+	SECTION_COLLECTORSTATS,
+	SECTION_GOVERNOR,
+	SECTION_JOBLIMITS,
+	SECTION_JOBUSAGE,
+	SECTION_NUMANODES,
+	SECTION_NUMACOUNTERS,
+	SECTION_LARGEPAGES,
+	SECTION_INTERRUPTCOUNTERS,
+	SECTION_INTERRUPTASSIGNMENTS,
+	SECTION_CPUPRESSURE,
+	SECTION_TCPSTATS,
+	SECTION_VOLUMES,
+	SECTION_SKETCHES,
+	SECTION_HISTORY,
+	SECTION_PCIDEVICES,
+	SECTION_GPUS,
+	SECTION_GPUMEMORYCOUNTERS,
+	SECTION_PROCESSCOUNTERS,
+	SECTION_END					// One past the last section; new sections go before it.
+};
+
+template<FieldsOf<HOSTINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("HostName", Value.HostName);
+	Visitor("CollectedAt", Value.CollectedAt);
+	Visitor("ComputerType", Value.ComputerType);
+}
+
+// Inventory only; the live utilization figures have their own section.
+template<FieldsOf<CPUINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Instructions", Value.Instructions);
+	Visitor("Name", Value.Name);
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("CoreCount", Value.CoreCount);
+	Visitor("ThreadCount", Value.ThreadCount);
+	Visitor("MaxClockSpeed", Value.MaxClockSpeed);
+	Visitor("Cache.L1", Value.Cache.L1);
+	Visitor("Cache.L2", Value.Cache.L2);
+	Visitor("Cache.L3", Value.Cache.L3);
+}
+
+template<FieldsOf<CPUUTILIZATION> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("CurrentClockSpeed", Value.CurrentClockSpeed);
+	Visitor("CurrentUtilization", Value.CurrentUtilization);
+	Visitor("ThreadUtilization", Value.ThreadUtilization);
+	Visitor("ThreadsUtilization", Value.ThreadsUtilization);
+	Visitor("CurrentClockSpeeds", Value.CurrentClockSpeeds);
+}
+
+template<FieldsOf<SCHEDULERPRESSUREINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("ProcessCount", Value.ProcessCount);
+	Visitor("ThreadCount", Value.ThreadCount);
+	Visitor("RunningThreads", Value.RunningThreads);
+	Visitor("ReadyThreads", Value.ReadyThreads);
+	Visitor("PagingWaitThreads", Value.PagingWaitThreads);
+	Visitor("ContextSwitchesPerSecond", Value.ContextSwitchesPerSecond);
+	Visitor("ProcessesCreatedPerSecond", Value.ProcessesCreatedPerSecond);
+	Visitor("LoadAverage1", Value.LoadAverage1);
+	Visitor("LoadAverage5", Value.LoadAverage5);
+	Visitor("LoadAverage15", Value.LoadAverage15);
+	Visitor("WaitingPercent10", Value.WaitingPercent10);
+	Visitor("WaitingPercent60", Value.WaitingPercent60);
+}
+
+template<FieldsOf<CPUSOCKETINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("SocketDesignation", Value.SocketDesignation);
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("Version", Value.Version);
+	Visitor("MaxSpeedMHz", Value.MaxSpeedMHz);
+	Visitor("CurrentSpeedMHz", Value.CurrentSpeedMHz);
+	Visitor("CoreCount", Value.CoreCount);
+	Visitor("ThreadCount", Value.ThreadCount);
+	Visitor("bPopulated", Value.bPopulated);
+}
+
+template<FieldsOf<CACHEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("SocketDesignation", Value.SocketDesignation);
+	Visitor("Level", Value.Level);
+	Visitor("SizeInKilobytes", Value.SizeInKilobytes);
+}
+
+template<FieldsOf<RAMINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("Model", Value.Model);
+	Visitor("MemoryType", Value.MemoryType);
+	Visitor("FormFactor", Value.FormFactor);
+	Visitor("SerialNumber", Value.SerialNumber);
+	Visitor("DeviceLocator", Value.DeviceLocator);
+	Visitor("BankLocator", Value.BankLocator);
+	Visitor("SizeInGigabytes", Value.SizeInGigabytes);
+	Visitor("SizeInMegabytes", Value.SizeInMegabytes);
+	Visitor("LatencyInNanoseconds", Value.LatencyInNanoseconds);
+	Visitor("FrequencyInMHz", Value.FrequencyInMHz);
+}
+
+template<FieldsOf<GPUINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("DriverVersion", Value.DriverVersion);
+	Visitor("VRAMSizeInGigabytes", Value.VRAMSizeInGigabytes);
+	Visitor("VRAMSizeInMegabytes", Value.VRAMSizeInMegabytes);
+	Visitor("RefreshRate", Value.RefreshRate);
+	Visitor("AdapterLuid", Value.AdapterLuid);
+	Visitor("VendorId", Value.VendorId);
+	Visitor("DeviceId", Value.DeviceId);
+	Visitor("SubsystemVendorId", Value.SubsystemVendorId);
+	Visitor("SubsystemId", Value.SubsystemId);
+	Visitor("Revision", Value.Revision);
+	Visitor("DedicatedVideoMemoryBytes", Value.DedicatedVideoMemoryBytes);
+	Visitor("DedicatedSystemMemoryBytes", Value.DedicatedSystemMemoryBytes);
+	Visitor("SharedSystemMemoryBytes", Value.SharedSystemMemoryBytes);
+	Visitor("PCIInstanceId", Value.PCIInstanceId);
+	Visitor("CurrentLinkGeneration", Value.CurrentLinkGeneration);
+	Visitor("CurrentLinkWidth", Value.CurrentLinkWidth);
+	Visitor("MaxLinkGeneration", Value.MaxLinkGeneration);
+	Visitor("MaxLinkWidth", Value.MaxLinkWidth);
+	Visitor("NUMANode", Value.NUMANode);
+}
+
+template<FieldsOf<GPUMEMORYCOUNTERSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("AdapterLuid", Value.AdapterLuid);
+	Visitor("DedicatedUsageBytes", Value.DedicatedUsageBytes);
+	Visitor("SharedUsageBytes", Value.SharedUsageBytes);
+	Visitor("DedicatedUsedPercent", Value.DedicatedUsedPercent);
+}
+
+template<FieldsOf<MAINBOARDINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("Name", Value.Name);
+	Visitor("Version", Value.Version);
+	Visitor("SerialNumber", Value.SerialNumber);
+}
+
+template<FieldsOf<BIOSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("Version", Value.Version);
+	Visitor("BuildNumber", Value.BuildNumber);
+	Visitor("SerialNumber", Value.SerialNumber);
+	Visitor("ReleaseDate", Value.ReleaseDate);
+}
+
+template<FieldsOf<OSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("TechnicalName", Value.TechnicalName);
+	Visitor("Name", Value.Name);
+	Visitor("Version", Value.Version);
+	Visitor("BuildNumber", Value.BuildNumber);
+	Visitor("Architecture", Value.Architecture);
+	Visitor("InstallDate", Value.InstallDate);
+}
+
+template<FieldsOf<UPTIMEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Days", Value.Days);
+	Visitor("Hours", Value.Hours);
+	Visitor("Minutes", Value.Minutes);
+	Visitor("Seconds", Value.Seconds);
+	Visitor("SuspendedSeconds", Value.SuspendedSeconds);
+	Visitor("BootedAt", Value.BootedAt);
+}
+
+template<FieldsOf<SOUNDINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+}
+
+template<FieldsOf<CDROMINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+}
+
+template<FieldsOf<DISPLAYINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("MonitorName", Value.MonitorName);
+	Visitor("MonitorManufacturer", Value.MonitorManufacturer);
+	Visitor("ScreenSizeInch", Value.ScreenSizeInch);
+	Visitor("ScreenWidth", Value.ScreenWidth);
+	Visitor("ScreenHeight", Value.ScreenHeight);
+	Visitor("MaxWidthRes", Value.MaxWidthRes);
+	Visitor("MaxHeightRes", Value.MaxHeightRes);
+	Visitor("RefreshRate", Value.RefreshRate);
+	Visitor("ManufacturerId", Value.ManufacturerId);
+	Visitor("ProductCode", Value.ProductCode);
+	Visitor("SerialNumber", Value.SerialNumber);
+	Visitor("ManufactureYear", Value.ManufactureYear);
+	Visitor("ImageWidthMm", Value.ImageWidthMm);
+	Visitor("ImageHeightMm", Value.ImageHeightMm);
+	Visitor("NativeWidth", Value.NativeWidth);
+	Visitor("NativeHeight", Value.NativeHeight);
+	Visitor("NativeRefreshRate", Value.NativeRefreshRate);
+	Visitor("MaxModeWidth", Value.MaxModeWidth);
+	Visitor("MaxModeHeight", Value.MaxModeHeight);
+	Visitor("MaxModeRefreshRate", Value.MaxModeRefreshRate);
+}
+
+template<FieldsOf<NETWORKINTERFACEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("Description", Value.Description);
+	Visitor("InterfaceIndex", Value.InterfaceIndex);
+	Visitor("InterfaceType", Value.InterfaceType);
+	Visitor("MACAddress", Value.MACAddress);
+	Visitor("DNSSuffix", Value.DNSSuffix);
+	Visitor("IPAddresses", Value.IPAddresses);
+	Visitor("DNSAddresses", Value.DNSAddresses);
+	Visitor("SubnetMasks", Value.SubnetMasks);
+}
+
+template<FieldsOf<STORAGEDEVICEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Model", Value.Model);
+	Visitor("Manufacturer", Value.Manufacturer);
+	Visitor("SerialNumber", Value.SerialNumber);
+	Visitor("SizeInMebibytes", Value.SizeInMebibytes);
+	Visitor("SizeInGibibytes", Value.SizeInGibibytes);
+}
+
+template<FieldsOf<THERMALZONEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("TemperatureCelsius", Value.TemperatureCelsius);
+	Visitor("PassiveLimitPercent", Value.PassiveLimitPercent);
+	Visitor("ThrottleReasons", Value.ThrottleReasons);
+}
+
+template<FieldsOf<FANINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("DesiredSpeedRPM", Value.DesiredSpeedRPM);
+	Visitor("bActiveCooling", Value.bActiveCooling);
+}
+
+template<FieldsOf<POWERDOMAININFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("EnergyJoules", Value.EnergyJoules);
+	Visitor("PowerWatts", Value.PowerWatts);
+}
+
+template<FieldsOf<MEMORYUSAGEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("MemoryLoadPercent", Value.MemoryLoadPercent);
+	Visitor("TotalPhysicalBytes", Value.TotalPhysicalBytes);
+	Visitor("AvailablePhysicalBytes", Value.AvailablePhysicalBytes);
+	Visitor("TotalCommitBytes", Value.TotalCommitBytes);
+	Visitor("AvailableCommitBytes", Value.AvailableCommitBytes);
+}
+
+template<FieldsOf<NETWORKCOUNTERSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("InterfaceIndex", Value.InterfaceIndex);
+	Visitor("ReceivedBytes", Value.ReceivedBytes);
+	Visitor("SentBytes", Value.SentBytes);
+	Visitor("ReceivedPackets", Value.ReceivedPackets);
+	Visitor("SentPackets", Value.SentPackets);
+	Visitor("ReceiveErrors", Value.ReceiveErrors);
+	Visitor("SendErrors", Value.SendErrors);
+	Visitor("ReceiveDiscards", Value.ReceiveDiscards);
+	Visitor("SendDiscards", Value.SendDiscards);
+	Visitor("ReceiveBytesPerSecond", Value.ReceiveBytesPerSecond);
+	Visitor("SendBytesPerSecond", Value.SendBytesPerSecond);
+}
+
+template<FieldsOf<DISKCOUNTERSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("DeviceNumber", Value.DeviceNumber);
+	Visitor("BytesRead", Value.BytesRead);
+	Visitor("BytesWritten", Value.BytesWritten);
+	Visitor("ReadCount", Value.ReadCount);
+	Visitor("WriteCount", Value.WriteCount);
+	Visitor("QueueDepth", Value.QueueDepth);
+	Visitor("ReadBytesPerSecond", Value.ReadBytesPerSecond);
+	Visitor("WriteBytesPerSecond", Value.WriteBytesPerSecond);
+	Visitor("BusyPercent", Value.BusyPercent);
+	Visitor("ServiceTimeMilliseconds", Value.ServiceTimeMilliseconds);
+}
+
+template<FieldsOf<TCPSTATSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("SegmentsReceived", Value.SegmentsReceived);
+	Visitor("SegmentsSent", Value.SegmentsSent);
+	Visitor("SegmentsRetransmitted", Value.SegmentsRetransmitted);
+	Visitor("ActiveOpens", Value.ActiveOpens);
+	Visitor("PassiveOpens", Value.PassiveOpens);
+	Visitor("FailedAttempts", Value.FailedAttempts);
+	Visitor("EstablishedResets", Value.EstablishedResets);
+	Visitor("ResetsSent", Value.ResetsSent);
+	Visitor("ReceiveErrors", Value.ReceiveErrors);
+	Visitor("EstablishedConnections", Value.EstablishedConnections);
+	Visitor("ListeningSockets", Value.ListeningSockets);
+	Visitor("TimeWaitConnections", Value.TimeWaitConnections);
+	Visitor("CloseWaitConnections", Value.CloseWaitConnections);
+	Visitor("TotalConnections", Value.TotalConnections);
+	Visitor("UDPDatagramsReceived", Value.UDPDatagramsReceived);
+	Visitor("UDPDatagramsSent", Value.UDPDatagramsSent);
+	Visitor("UDPNoPorts", Value.UDPNoPorts);
+	Visitor("UDPReceiveErrors", Value.UDPReceiveErrors);
+	Visitor("UDPEndpoints", Value.UDPEndpoints);
+	Visitor("RetransmitPercent", Value.RetransmitPercent);
+	Visitor("RetransmitsPerSecond", Value.RetransmitsPerSecond);
+	Visitor("FailedAttemptsPerSecond", Value.FailedAttemptsPerSecond);
+	Visitor("ResetsPerSecond", Value.ResetsPerSecond);
+	Visitor("UDPReceiveErrorsPerSecond", Value.UDPReceiveErrorsPerSecond);
+}
+
+template<FieldsOf<COLLECTORSTATS> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Name", Value.Name);
+	Visitor("Calls", Value.Calls);
+	Visitor("TotalNanoseconds", Value.TotalNanoseconds);
+	Visitor("MaxNanoseconds", Value.MaxNanoseconds);
+	Visitor("P50Nanoseconds", Value.P50Nanoseconds);
+	Visitor("P90Nanoseconds", Value.P90Nanoseconds);
+	Visitor("P99Nanoseconds", Value.P99Nanoseconds);
+	Visitor("WMIQueries", Value.WMIQueries);
+	Visitor("SystemCalls", Value.SystemCalls);
+	Visitor("BytesRead", Value.BytesRead);
+	Visitor("Allocations", Value.Allocations);
+	Visitor("AllocatedBytes", Value.AllocatedBytes);
+}
+
+template<FieldsOf<GOVERNORINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("BudgetPercent", Value.BudgetPercent);
+	Visitor("UsagePercent", Value.UsagePercent);
+	Visitor("Level", Value.Level);
+	Visitor("StretchFactor", Value.StretchFactor);
+	Visitor("bLowPriorityShed", Value.bLowPriorityShed);
+	Visitor("bNormalPriorityShed", Value.bNormalPriorityShed);
+	Visitor("DegradedSince", Value.DegradedSince);
+}
+
+// Limits only; the usage figures have their own section.
+template<FieldsOf<JOBLIMITSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("bInJob", Value.bInJob);
+	Visitor("ProcessorCount", Value.ProcessorCount);
+	Visitor("AffinityProcessorCount", Value.AffinityProcessorCount);
+	Visitor("CPURateLimitPercent", Value.CPURateLimitPercent);
+	Visitor("CPUWeight", Value.CPUWeight);
+	Visitor("JobMemoryLimitBytes", Value.JobMemoryLimitBytes);
+	Visitor("ProcessMemoryLimitBytes", Value.ProcessMemoryLimitBytes);
+	Visitor("EffectiveParallelism", Value.EffectiveParallelism);
+}
+
+template<FieldsOf<JOBUSAGEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("TotalCPUTime", Value.TotalCPUTime);
+	Visitor("ActiveProcesses", Value.ActiveProcesses);
+	Visitor("PeakJobMemoryBytes", Value.PeakJobMemoryBytes);
+	Visitor("PeakProcessMemoryBytes", Value.PeakProcessMemoryBytes);
+	Visitor("CPUCapUsagePercent", Value.CPUCapUsagePercent);
+}
+
+template<FieldsOf<NUMANODEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("NodeNumber", Value.NodeNumber);
+	Visitor("ProcessorGroup", Value.ProcessorGroup);
+	Visitor("ProcessorMask", Value.ProcessorMask);
+	Visitor("ProcessorCount", Value.ProcessorCount);
+	Visitor("TotalBytes", Value.TotalBytes);
+}
+
+template<FieldsOf<NUMANODECOUNTERSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("NodeNumber", Value.NodeNumber);
+	Visitor("AvailableBytes", Value.AvailableBytes);
+	Visitor("UsedPercent", Value.UsedPercent);
+	Visitor("AvailableBytesChange", Value.AvailableBytesChange);
+}
+
+template<FieldsOf<LARGEPAGEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("LargePageMinimumBytes", Value.LargePageMinimumBytes);
+	Visitor("bHugePagesSupported", Value.bHugePagesSupported);
+	Visitor("bLockMemoryPrivilege", Value.bLockMemoryPrivilege);
+}
+
+template<FieldsOf<INTERRUPTCOUNTERSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Processor", Value.Processor);
+	Visitor("Group", Value.Group);
+	Visitor("Number", Value.Number);
+	Visitor("InterruptCount", Value.InterruptCount);
+	Visitor("DpcCount", Value.DpcCount);
+	Visitor("ContextSwitches", Value.ContextSwitches);
+	Visitor("InterruptsPerSecond", Value.InterruptsPerSecond);
+	Visitor("DpcsPerSecond", Value.DpcsPerSecond);
+	Visitor("ContextSwitchesPerSecond", Value.ContextSwitchesPerSecond);
+	Visitor("InterruptPercent", Value.InterruptPercent);
+	Visitor("DpcPercent", Value.DpcPercent);
+}
+
+template<FieldsOf<INTERRUPTASSIGNMENTINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("DeviceName", Value.DeviceName);
+	Visitor("InstanceId", Value.InstanceId);
+	Visitor("Vector", Value.Vector);
+	Visitor("bMessageSignaled", Value.bMessageSignaled);
+	Visitor("Affinity", Value.Affinity);
+	Visitor("AffinityProcessorCount", Value.AffinityProcessorCount);
+}
+
+template<FieldsOf<PCIDEVICEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("InstanceId", Value.InstanceId);
+	Visitor("Bus", Value.Bus);
+	Visitor("Device", Value.Device);
+	Visitor("Function", Value.Function);
+	Visitor("VendorId", Value.VendorId);
+	Visitor("DeviceId", Value.DeviceId);
+	Visitor("SubsystemVendorId", Value.SubsystemVendorId);
+	Visitor("SubsystemId", Value.SubsystemId);
+	Visitor("Revision", Value.Revision);
+	Visitor("ClassCode", Value.ClassCode);
+	Visitor("Subclass", Value.Subclass);
+	Visitor("ProgIf", Value.ProgIf);
+	Visitor("VendorName", Value.VendorName);
+	Visitor("DeviceName", Value.DeviceName);
+	Visitor("SubsystemName", Value.SubsystemName);
+	Visitor("ClassName", Value.ClassName);
+	Visitor("Description", Value.Description);
+	Visitor("CurrentLinkGeneration", Value.CurrentLinkGeneration);
+	Visitor("CurrentLinkWidth", Value.CurrentLinkWidth);
+	Visitor("MaxLinkGeneration", Value.MaxLinkGeneration);
+	Visitor("MaxLinkWidth", Value.MaxLinkWidth);
+	Visitor("NUMANode", Value.NUMANode);
+}
+
+template<FieldsOf<PROCESSCOUNTERSINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("ProcessId", Value.ProcessId);
+	Visitor("CreateTime", Value.CreateTime);
+	Visitor("ParentProcessId", Value.ParentProcessId);
+	Visitor("SessionId", Value.SessionId);
+	Visitor("ImageName", Value.ImageName);
+	Visitor("CPUTime", Value.CPUTime);
+	Visitor("WorkingSetBytes", Value.WorkingSetBytes);
+	Visitor("PrivateBytes", Value.PrivateBytes);
+	Visitor("ReadBytes", Value.ReadBytes);
+	Visitor("WriteBytes", Value.WriteBytes);
+	Visitor("ThreadCount", Value.ThreadCount);
+	Visitor("HandleCount", Value.HandleCount);
+	Visitor("CPUPercent", Value.CPUPercent);
+	Visitor("ReadBytesPerSecond", Value.ReadBytesPerSecond);
+	Visitor("WriteBytesPerSecond", Value.WriteBytesPerSecond);
+}
+
+template<FieldsOf<VOLUMESPACEINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("RootPath", Value.RootPath);
+	Visitor("TotalBytes", Value.TotalBytes);
+	Visitor("FreeBytes", Value.FreeBytes);
+	Visitor("FreePercent", Value.FreePercent);
+}
+
+template<FieldsOf<SKETCHINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Series", Value.Series);
+	Visitor("Element", Value.Element);
+	Visitor("Count", Value.Count);
+	Visitor("Min", Value.Min);
+	Visitor("Max", Value.Max);
+	Visitor("P50", Value.P50);
+	Visitor("P95", Value.P95);
+	Visitor("P99", Value.P99);
+	Visitor("ZeroCount", Value.ZeroCount);
+	Visitor("BinOffset", Value.BinOffset);
+	Visitor("Bins", Value.Bins);
+}
+
+template<FieldsOf<SERIESBLOCKINFO> T, class V> void VisitFields(T& Value, V& Visitor) {
+	Visitor("Series", Value.Series);
+	Visitor("Element", Value.Element);
+	Visitor("FirstTimestamp", Value.FirstTimestamp);
+	Visitor("LastTimestamp", Value.LastTimestamp);
+	Visitor("PointCount", Value.PointCount);
+	Visitor("Data", Value.Data);
+}
+
+/*
+ * Walks every section of a snapshot. `Visitor.Section` receives single structures and
+ * `Visitor.List` receives vectors of them; both get the section identifier and its name.
+ */
+template<FieldsOf<SYSINFOSNAPSHOT> T, class V> void VisitSections(T& Snapshot, V& Visitor) {
+	Visitor.Section(SECTION_HOST, "Host", Snapshot.Host);
+	Visitor.Section(SECTION_CPU, "CPU", Snapshot.CPU);
+	Visitor.List(SECTION_CPUSOCKETS, "CPUSockets", Snapshot.CPUSockets);
+	Visitor.List(SECTION_CPUCACHES, "CPUCaches", Snapshot.CPUCaches);
+	Visitor.Section(SECTION_CPUUTILIZATION, "CPU.Utilization", Snapshot.CPU.Utilization);
+	Visitor.Section(SECTION_RAM, "RAM", Snapshot.RAM);
+	Visitor.List(SECTION_RAMMODULES, "RAMModules", Snapshot.RAMModules);
+	Visitor.Section(SECTION_MAINBOARD, "Mainboard", Snapshot.Mainboard);
+	Visitor.Section(SECTION_BIOS, "BIOS", Snapshot.BIOS);
+	Visitor.Section(SECTION_OS, "OS", Snapshot.OS);
+	Visitor.Section(SECTION_UPTIME, "Uptime", Snapshot.Uptime);
+	Visitor.Section(SECTION_SOUND, "Sound", Snapshot.Sound);
+	Visitor.List(SECTION_STORAGEDEVICES, "StorageDevices", Snapshot.StorageDevices);
+	Visitor.List(SECTION_NETWORKINTERFACES, "NetworkInterfaces", Snapshot.NetworkInterfaces);
+	Visitor.List(SECTION_CDROMS, "CDROMs", Snapshot.CDROMs);
+	Visitor.List(SECTION_DISPLAYS, "Displays", Snapshot.Displays);
+	Visitor.List(SECTION_THERMALZONES, "ThermalZones", Snapshot.Sensors.ThermalZones);
+	Visitor.List(SECTION_FANS, "Fans", Snapshot.Sensors.Fans);
+	Visitor.List(SECTION_POWERDOMAINS, "PowerDomains", Snapshot.Sensors.PowerDomains);
+	Visitor.Section(SECTION_MEMORYUSAGE, "Memory", Snapshot.Memory);
+	Visitor.List(SECTION_NETWORKCOUNTERS, "NetworkCounters", Snapshot.NetworkCounters);
+	Visitor.List(SECTION_DISKCOUNTERS, "DiskCounters", Snapshot.DiskCounters);
+	Visitor.List(SECTION_COLLECTORSTATS, "Collectors", Snapshot.Collectors);
+	Visitor.Section(SECTION_GOVERNOR, "Governor", Snapshot.Governor);
+	Visitor.Section(SECTION_JOBLIMITS, "JobLimits", Snapshot.JobLimits);
+	Visitor.Section(SECTION_JOBUSAGE, "JobLimits.Usage", Snapshot.JobLimits.Usage);
+	Visitor.List(SECTION_NUMANODES, "NUMANodes", Snapshot.NUMANodes);
+	Visitor.List(SECTION_NUMACOUNTERS, "NUMACounters", Snapshot.NUMACounters);
+	Visitor.Section(SECTION_LARGEPAGES, "LargePages", Snapshot.LargePages);
+	Visitor.List(SECTION_INTERRUPTCOUNTERS, "InterruptCounters", Snapshot.InterruptCounters);
+	Visitor.List(SECTION_INTERRUPTASSIGNMENTS, "InterruptAssignments", Snapshot.InterruptAssignments);
+	Visitor.Section(SECTION_CPUPRESSURE, "CPU.Pressure", Snapshot.CPU.Pressure);
+	Visitor.Section(SECTION_TCPSTATS, "TCPStats", Snapshot.TCPStats);
+	Visitor.List(SECTION_VOLUMES, "Volumes", Snapshot.Volumes);
+	Visitor.List(SECTION_SKETCHES, "Sketches", Snapshot.Sketches);
+	Visitor.List(SECTION_HISTORY, "History", Snapshot.History);
+	Visitor.List(SECTION_PCIDEVICES, "PCIDevices", Snapshot.PCIDevices);
+	Visitor.List(SECTION_GPUS, "GPUs", Snapshot.GPUs);
+	Visitor.List(SECTION_GPUMEMORYCOUNTERS, "GPUMemoryCounters", Snapshot.GPUMemoryCounters);
+	Visitor.List(SECTION_PROCESSCOUNTERS, "ProcessCounters", Snapshot.ProcessCounters);
+}
@@ -2,6 +2,7 @@
 
 std::optional<Error> SysInfoProbe::GetStorageDevices() {
 	const char* FuncName = "SysInfoProbe::GetStorageDevices";
+	INSTRUMENT_COLLECTOR(FuncName);
 	if (!bInitialized) return Error::New(FuncName, 1, L"API not initialized.");
 	const std::vector<LPCWSTR> Attributes = {
 		L"Model",
@@ -64,4 +65,119 @@ std::optional<Error> SysInfoProbe::GetStorageDevices() {
 		StorageDevices.push_back(CurrentDeviceInfo);
 	}
 	return std::nullopt;
+}
+
+std::optional<Error> SysInfoProbe::_OpenDisks() {
+	const char* FuncName = "SysInfoProbe::_OpenDisks";
+	_CloseDisks();
+
+	// Drive numbers can have gaps (removed devices), so every possible number is tried.
+	for (DWORD DeviceNumber = 0; DeviceNumber < 64; DeviceNumber++) {
+		std::wstring Path = L"\\\\.\\PhysicalDrive" + std::to_wstring(DeviceNumber);
+		// No access rights are needed for IOCTL_DISK_PERFORMANCE, which also works without elevation.
+		HANDLE hDevice = CreateFileW(Path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, 0, NULL);
+		if (hDevice == INVALID_HANDLE_VALUE) continue;
+
+		_DISKHANDLE Disk;
+		Disk.hDevice = hDevice;
+		Disk.DeviceNumber = DeviceNumber;
+		Disks.push_back(Disk);
+	}
+
+	if (Disks.empty()) {
+		return Error::New(FuncName, 1, L"No physical drive could be opened.", GetLastError());
+	}
+	return std::nullopt;
+}
+
+void SysInfoProbe::_CloseDisks() {
+	for (auto& Disk : Disks) {
+		if (Disk.hDevice != INVALID_HANDLE_VALUE) CloseHandle(Disk.hDevice);
+	}
+	Disks.clear();
+	DiskCounters.clear();
+}
+
+std::optional<Error> SysInfoProbe::RefreshDiskCounters() {
+	const char* FuncName = "SysInfoProbe::RefreshDiskCounters";
+	INSTRUMENT_COLLECTOR(FuncName);
+	if (Disks.empty()) {
+		auto r = _OpenDisks();
+		if (r) {
+			r.value().AddNewFunctionToStack(FuncName, 1);
+			return r;
+		}
+	}
+
+	DiskCounters.resize(Disks.size());
+	UINT64 Now = Clock::Monotonic();
+	for (size_t i = 0; i < Disks.size(); i++) {
+		_DISKHANDLE& Disk = Disks[i];
+		DISK_PERFORMANCE Performance = { 0 };
+		DWORD dwBytesReturned = 0;
+		if (!DeviceIoControl(Disk.hDevice, IOCTL_DISK_PERFORMANCE, NULL, 0, &Performance, sizeof(Performance), &dwBytesReturned, NULL)) {
+			return Error::New(FuncName, 2, L"Failed to query disk performance.", GetLastError());
+		}
+		Instrumentation::CountSystemCall();
+		Instrumentation::CountBytesRead(dwBytesReturned);
+
+		DISKCOUNTERSINFO& Counters = DiskCounters[i];
+		Counters = DISKCOUNTERSINFO();
+		Counters.DeviceNumber = Disk.DeviceNumber;
+		Counters.BytesRead = Performance.BytesRead.QuadPart;
+		Counters.BytesWritten = Performance.BytesWritten.QuadPart;
+		Counters.ReadCount = Performance.ReadCount;
+		Counters.WriteCount = Performance.WriteCount;
+		Counters.QueueDepth = Performance.QueueDepth;
+
+		// QueryTime and IdleTime are in 100ns units.
+		LONGLONG Elapsed = Performance.QueryTime.QuadPart - Disk.Last.QueryTime.QuadPart;
+		if (Disk.bHasLast && Elapsed > 0) {
+			double ElapsedSeconds = Elapsed / 1e7;
+			Counters.ReadBytesPerSecond = (Performance.BytesRead.QuadPart - Disk.Last.BytesRead.QuadPart) / ElapsedSeconds;
+			Counters.WriteBytesPerSecond = (Performance.BytesWritten.QuadPart - Disk.Last.BytesWritten.QuadPart) / ElapsedSeconds;
+			LONGLONG Idle = Performance.IdleTime.QuadPart - Disk.Last.IdleTime.QuadPart;
+			Counters.BusyPercent = std::clamp(100.0 * (1.0 - static_cast<double>(Idle) / Elapsed), 0.0, 100.0);
+
+			// ReadTime and WriteTime add up the time of every completed request, so overlapping requests all count.
+			DWORD Completed = (Performance.ReadCount - Disk.Last.ReadCount) + (Performance.WriteCount - Disk.Last.WriteCount);
+			LONGLONG ServiceTime = (Performance.ReadTime.QuadPart - Disk.Last.ReadTime.QuadPart) + (Performance.WriteTime.QuadPart - Disk.Last.WriteTime.QuadPart);
+			if (Completed > 0 && ServiceTime >= 0) {
+				Counters.ServiceTimeMilliseconds = ServiceTime / 1e4 / Completed;
+				DiskServiceTimeSketches.Add(Disk.DeviceNumber, Counters.ServiceTimeMilliseconds, Now);
+			}
+		}
+		Disk.Last = Performance;
+		Disk.bHasLast = TRUE;
+	}
+	return std::nullopt;
+}
+std::optional<Error> SysInfoProbe::RefreshVolumeSpace() {
+	const char* FuncName = "SysInfoProbe::RefreshVolumeSpace";
+	INSTRUMENT_COLLECTOR(FuncName);
+	// Roots as "C:\", "D:\", ... separated by NULs and ended by an empty one.
+	WCHAR Roots[512] = { 0 };
+	DWORD dwLength = GetLogicalDriveStringsW(ARRAYSIZE(Roots) - 1, Roots);
+	if (dwLength == 0 || dwLength >= ARRAYSIZE(Roots)) {
+		return Error::New(FuncName, 1, L"Failed to list logical drives.", GetLastError());
+	}
+	Instrumentation::CountSystemCall();
+
+	Volumes.clear();
+	for (LPCWSTR pRoot = Roots; *pRoot; pRoot += wcslen(pRoot) + 1) {
+		// Removable, optical and network drives can be absent or slow to answer; only fixed volumes are tracked.
+		if (GetDriveTypeW(pRoot) != DRIVE_FIXED) continue;
+		ULARGE_INTEGER Total = { 0 }, Free = { 0 };
+		BOOL bQueried = GetDiskFreeSpaceExW(pRoot, NULL, &Total, &Free);
+		Instrumentation::CountSystemCall(2);
+		if (!bQueried || Total.QuadPart == 0) continue;
+
+		VOLUMESPACEINFO Volume;
+		Volume.RootPath = w2s(pRoot);
+		Volume.TotalBytes = Total.QuadPart;
+		Volume.FreeBytes = Free.QuadPart;
+		Volume.FreePercent = 100.0 * Free.QuadPart / Total.QuadPart;
+		Volumes.push_back(Volume);
+	}
+	return std::nullopt;
 }
\ No newline at end of file
@@ -1,30 +1,58 @@
 #include "SysInfoProbe.hpp"
 
 std::optional<std::vector<Error>> SysInfoProbe::RetrieveAllData(bool StopOnError) {
-	std::vector<Error> errors;
-	std::vector<std::optional<Error>(SysInfoProbe::*)()> InfoFunctions{
-		 &SysInfoProbe::GetCpuInfo,
-		 &SysInfoProbe::GetRamInfo,
-		 &SysInfoProbe::GetGpuInfo,
-		 &SysInfoProbe::GetMotherboardInfo,
-		 &SysInfoProbe::GetBIOSInfo,
-		 &SysInfoProbe::GetComputerType,
-		 &SysInfoProbe::GetStorageDevices,
-		 &SysInfoProbe::GetDisplayInfo,
-		 &SysInfoProbe::GetNetworkInterfacesInfo,
-		 &SysInfoProbe::GetCDROMInfo,
-		 &SysInfoProbe::GetOperatingSystemInfo,
-		 &SysInfoProbe::GetSoundInfo
-	};
+	auto Errors = Retrieve<SYSINFO_COLLECTORS>(StopOnError);
+	PublishSnapshot();
+	return Errors;
+}
 
-	for (auto& function : InfoFunctions) {
-		if (auto r = (this->*function)()) {
-			errors.push_back(r.value());
+SYSINFOSNAPSHOT SysInfoProbe::TakeSnapshot() const {
+	SYSINFOSNAPSHOT Snapshot;
 
-			if (StopOnError) return errors;
-		}
-	}
+	char HostName[256] = { 0 };
+	DWORD HostNameSize = sizeof(HostName);
+	if (GetComputerNameExA(ComputerNameDnsFullyQualified, HostName, &HostNameSize)) Snapshot.Host.HostName = HostName;
+	Snapshot.Host.CollectedAt = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	Snapshot.Host.ComputerType = ComputerType;
 
-	GetUptimeInfo();
-	return errors.empty() ? std::nullopt : std::make_optional(errors);
+	Snapshot.CPU = CPU;
+	Snapshot.CPUSockets = CPUSockets;
+	Snapshot.CPUCaches = CPUCaches;
+	Snapshot.Mainboard = Mainboard;
+	Snapshot.RAM = RAM;
+	Snapshot.RAMModules = RAMModules;
+	Snapshot.OS = OS;
+	Snapshot.BIOS = BIOS;
+	Snapshot.Uptime = Uptime;
+	Snapshot.Sound = Sound;
+	Snapshot.Sensors = Sensors;
+	Snapshot.StorageDevices = StorageDevices;
+	Snapshot.NetworkInterfaces = NetworkInterfaces;
+	Snapshot.CDROMs = CDROMs;
+	Snapshot.Displays = Displays;
+	Snapshot.Memory = Memory;
+	Snapshot.NetworkCounters = NetworkCounters;
+	Snapshot.DiskCounters = DiskCounters;
+	Snapshot.TCPStats = TCPStats;
+	Snapshot.Collectors = Instrumentation::GetCollectorStats();
+	Snapshot.JobLimits = JobLimits;
+	Snapshot.NUMANodes = NUMANodes;
+	Snapshot.NUMACounters = NUMACounters;
+	Snapshot.LargePages = LargePages;
+	Snapshot.InterruptCounters = InterruptCounters;
+	Snapshot.InterruptAssignments = InterruptAssignments;
+	Snapshot.Volumes = Volumes;
+	Snapshot.PCIDevices = PCIDevices;
+	Snapshot.GPUs = GPUs;
+	Snapshot.GPUMemoryCounters = GPUMemoryCounters;
+	Snapshot.ProcessCounters = ProcessCounters;
+	CoreUtilizationSketches.Export(Snapshot.Sketches);
+	DiskServiceTimeSketches.Export(Snapshot.Sketches);
+	ReceiveRateSketches.Export(Snapshot.Sketches);
+	SendRateSketches.Export(Snapshot.Sketches);
+	CoreUtilizationHistory.Export(Snapshot.History);
+	MemoryAvailableHistory.Export(Snapshot.History);
+	ReceivedBytesHistory.Export(Snapshot.History);
+	SentBytesHistory.Export(Snapshot.History);
+	return Snapshot;
 }
@@ -7,49 +7,120 @@
 #include "WMIMgr.hpp"		// For WMI API
 #include "Utils.hpp"		// For small utility functions
 #include "SysInfoTypes.hpp"	// User-defined types for system information
+#include "SMBIOS.hpp"		// For the SMBIOS structure table parser
+#include "Instrumentation.hpp"	// For per-collector latency and cost counters
+#include "NtApi.hpp"			// For the process list of NtQuerySystemInformation
+#include "Clock.hpp"			// For the intervals of rate calculations
+#include "QuantileSketch.hpp"	// For percentiles of the sampled series
+#include "SeriesCodec.hpp"		// For the compressed history of the sampled series
+#include "PCIIds.hpp"			// For the names of PCI devices
+#include "EDID.hpp"				// For the monitor EDID parser
+#include "TextFormat.hpp"		// For MAC addresses, masks and dates
+#include "LocalSnapshot.hpp"	// For publishing snapshots to other threads
 #include <intrin.h>			// For CPUID instruction
-#include <PowerBase.h>		// For GetPwrCapabilities function
-#include <sstream>			// For std::ostringstream used in network information
+#include <Pdh.h>			// For performance counters used by the sensor collector
+#include <SetupAPI.h>		// For device interface enumeration (energy meters)
+#include <winioctl.h>		// For IOCTL_DISK_PERFORMANCE
+#include <cfgmgr32.h>		// For the IRQ resources of devices
 #include <chrono>			// For setw and setfill
-#pragma comment(lib, "PowrProf.lib")	// Required to use PowerBase.h
-#pragma comment(lib, "ws2_32.lib")		// Required for network information
-#pragma comment(lib, "IPHlpApi.lib")	// Required for network information
+#include <cmath>			// For the decay of load averages
 
+/*
+ * The public members belong to the thread that runs the collectors and refresh functions, which rewrites them in
+ * place. Other threads must not read them; they read the snapshots published through Publisher() instead.
+ */
 class SysInfoProbe {
 public:
 	CPUINFO CPU;
 	MAINBOARDINFO Mainboard;
 	RAMINFO RAM;
-	GPUINFO GPU;
 	OSINFO OS;
 	BIOSINFO BIOS;
 	UPTIMEINFO Uptime;
 	SOUNDINFO Sound;
+	SENSORINFO Sensors;
+	MEMORYUSAGEINFO Memory;
+	TCPSTATSINFO TCPStats;
+	JOBLIMITSINFO JobLimits;
+	LARGEPAGEINFO LargePages;
 
+	std::vector<RAMINFO> RAMModules;
+	std::vector<CPUSOCKETINFO> CPUSockets;
+	std::vector<CACHEINFO> CPUCaches;
 	std::vector<STORAGEDEVICEINFO> StorageDevices;
 	std::vector<NETWORKINTERFACEINFO> NetworkInterfaces;
 	std::vector<CDROMINFO> CDROMs;
 	std::vector<DISPLAYINFO> Displays;
+	std::vector<NETWORKCOUNTERSINFO> NetworkCounters;
+	std::vector<DISKCOUNTERSINFO> DiskCounters;
+	std::vector<PROCESSCOUNTERSINFO> ProcessCounters;
+	std::vector<NUMANODEINFO> NUMANodes;
+	std::vector<NUMANODECOUNTERSINFO> NUMACounters;
+	std::vector<INTERRUPTCOUNTERSINFO> InterruptCounters;
+	std::vector<VOLUMESPACEINFO> Volumes;
+	std::vector<INTERRUPTASSIGNMENTINFO> InterruptAssignments;
+	std::vector<PCIDEVICEINFO> PCIDevices;
+	std::vector<GPUINFO> GPUs;
+	std::vector<GPUMEMORYCOUNTERSINFO> GPUMemoryCounters;		// Parallel to GPUs.
 	COMPUTER_TYPE ComputerType = NONE;
 
 	std::optional<Error> GetCpuInfo();
 	std::optional<Error> GetRamInfo();
+	// Nodes, their memory and large page support; also takes the first NUMACounters sample.
+	std::optional<Error> GetNUMAInfo();
+	// Every hardware adapter, with the link state of its PCI function; also takes the first GPUMemoryCounters sample.
 	std::optional<Error> GetGpuInfo();
 	std::optional<Error> GetMotherboardInfo();
 	std::optional<Error> GetBIOSInfo();
 	std::optional<Error> GetComputerType();
 
 	std::optional<Error> GetStorageDevices();
+	// One entry per active monitor, matched to its EDID through the monitor's device interface; does not need WMI.
 	std::optional<Error> GetDisplayInfo();
 	std::optional<Error> GetNetworkInterfacesInfo();
 	std::optional<Error> GetCDROMInfo();
 	std::optional<Error> GetOperatingSystemInfo();
 	std::optional<Error> GetSoundInfo();
+	std::optional<Error> GetSensorInfo();
+	// Does not need WMI, so it can run at process startup before InitializeWMIAPI.
+	std::optional<Error> GetJobLimits();
+	// Interrupt assignments of every device; also takes the first InterruptCounters sample.
+	std::optional<Error> GetInterruptInfo();
+	// Every present PCI function, sorted by location.
+	std::optional<Error> GetPCIDevices();
 	void GetUptimeInfo();
+	/*
+	 * Runs the collectors of `Categories` in the order of ProbeCollectors. The selection is made at compile time, so
+	 * the other collectors are never referenced and the linker leaves them, and the libraries they import, out.
+	 */
+	template<UINT32 Categories> std::optional<std::vector<Error>> Retrieve(bool StopOnError = false);
+	// Every category of the build (SYSINFO_COLLECTORS); publishes a snapshot once they ran.
 	std::optional<std::vector<Error>> RetrieveAllData(bool StopOnError = false);
+	// Copies everything retrieved so far into a self-contained snapshot, stamped with the host name and the current time.
+	SYSINFOSNAPSHOT TakeSnapshot() const;
+	// Takes a snapshot and swaps it in for the readers of Publisher(). Called on the refreshing thread, after a batch of refreshes.
+	void PublishSnapshot() { Snapshots.Publish(TakeSnapshot()); }
+	// Readers opened on it must be closed before the probe is destroyed.
+	LocalSnapshotPublisher& Publisher() { return Snapshots; }
 
 	std::optional<Error> RefreshCPUUtilizations();
-	std::optional<Error> RefreshFreeRAM() { return std::nullopt; };
+	std::optional<Error> RefreshSchedulerPressure();
+	std::optional<Error> RefreshFreeRAM();
+	std::optional<Error> RefreshNUMACounters();
+	std::optional<Error> RefreshSensors();
+	std::optional<Error> RefreshNetworkCounters();
+	std::optional<Error> RefreshTCPStatistics();
+	std::optional<Error> RefreshDiskCounters();
+	std::optional<Error> RefreshVolumeSpace();
+	std::optional<Error> RefreshProcessCounters();
+	std::optional<Error> RefreshInterruptCounters();
+	std::optional<Error> RefreshGPUMemory();
+
+	~SysInfoProbe() {
+		if constexpr (BuildCollects(COLLECTOR_SENSORS)) _CloseSensors();
+		if constexpr (BuildCollects(COLLECTOR_STORAGE)) _CloseDisks();
+		if constexpr (BuildCollects(COLLECTOR_GPU)) _CloseGPUMemoryCounters();
+	}
 
 	std::optional<Error> InitializeWMIAPI() {
 		auto r = WMIMgr.InitializeAPI();
@@ -60,15 +131,193 @@ public:
 private:
 	BOOL bInitialized = FALSE;
 	WMIManager WMIMgr;
+	LocalSnapshotPublisher Snapshots;
+
+	// Runs ProbeCollectors[Index] and every later collector of `Categories`; false when StopOnError cut it short.
+	template<UINT32 Categories, size_t Index> bool _RunCollectors(std::vector<Error>& Errors, bool StopOnError);
 
 	/* Private Information Retrieval Functions */
 	/* - CPU */
 	void _GetCPUInstructions();
 	std::optional<Error> _GetCPUCache();
 
+	/* - Memory */
+	// Best effort: leaves NUMANODEINFO::TotalBytes at zero when the counter set is unavailable.
+	void _ReadNUMANodeSizes();
+
 	/* - Mainboard */
 	std::string _FormatWMIDateTime(const std::string& WMIDateTime);
 
-	/* - Monitor/Display */
-	std::optional<Error> _GetRealMonitorSize();
+	/* - SMBIOS (BIOS, mainboard, CPU sockets/caches and memory modules) */
+	// The table is read and parsed once; every collector that needs it copies from here.
+	SMBIOSINFO SMBIOS;
+	BOOL bSMBIOSLoaded = FALSE;
+	std::optional<Error> _LoadSMBIOS();
+
+	/* - Network counters */
+	ULONGLONG LastNetworkRefresh = 0;	// Clock::Monotonic at the previous RefreshNetworkCounters.
+	ULONGLONG LastTCPRefresh = 0;		// Clock::Monotonic at the previous RefreshTCPStatistics.
+	std::vector<BYTE> TCPTableBuffer;	// Output of GetTcpTable/GetTcp6Table, kept between refreshes.
+
+	/* - Disk counters */
+	// Physical drives opened on the first RefreshDiskCounters and kept open for the following ones.
+	struct _DISKHANDLE {
+		HANDLE hDevice = INVALID_HANDLE_VALUE;
+		DWORD DeviceNumber = 0;
+		DISK_PERFORMANCE Last = { 0 };
+		BOOL bHasLast = FALSE;
+	};
+	std::vector<_DISKHANDLE> Disks;
+	std::optional<Error> _OpenDisks();
+	void _CloseDisks();
+
+	/* - Process scan */
+	// One pass over the process list fills ProcessCounters and the thread counts of CPU.Pressure. RefreshProcessCounters and
+	// RefreshSchedulerPressure reuse a scan younger than ProcessScanReuseTicks, so samplers that come due together share it.
+	static constexpr UINT64 ProcessScanReuseTicks = Clock::TicksPerSecond / 4;
+	// Both kept between scans so that a pass over every process does not reallocate.
+	std::vector<BYTE> ProcessBuffer;						// Output of NtQuerySystemInformation.
+	std::vector<PROCESSCOUNTERSINFO> PreviousProcessCounters;
+	ULONGLONG LastProcessScan = 0;		// Clock::Monotonic at the previous _ScanProcesses.
+	UINT64 LastProcessScanSystemTime = 0;	// FILETIME of the previous _ScanProcesses, to compare with creation times.
+	DWORD ProcessesCreated = 0;			// Since the previous RefreshSchedulerPressure, which resets it.
+	std::optional<Error> _ScanProcesses();
+
+	/* - Scheduler pressure */
+	std::vector<BYTE> SchedulerBuffer;	// Output of NtQuerySystemInformationEx; kept so that refreshes do not allocate.
+	UINT32 LastContextSwitches = 0;	// Sum of the 32-bit per-processor counters, which wraps along with them.
+	UINT64 LastSchedulerRefresh = 0;	// Clock::Monotonic at the previous RefreshSchedulerPressure.
+
+	/* - Interrupt counters */
+	// Column c of processor p is at [c * ProcessorCount + p], so each refresh subtracts whole arrays.
+	std::vector<UINT32> InterruptCounts, PreviousInterruptCounts;	// Interrupts, DPCs and context switches.
+	std::vector<UINT64> InterruptTimes, PreviousInterruptTimes;		// Interrupt, DPC and total time, in 100ns units.
+	std::vector<BYTE> InterruptBuffer;								// Output of NtQuerySystemInformationEx.
+	ULONGLONG LastInterruptRefresh = 0;	// Clock::Monotonic at the previous RefreshInterruptCounters.
+
+	/* - Job limits */
+	UINT64 LastJobCPUTime = 0;			// JOBUSAGEINFO::TotalCPUTime at the previous GetJobLimits.
+	ULONGLONG LastJobRefresh = 0;		// Clock::Monotonic at the previous GetJobLimits.
+
+	/* - Sketches */
+	// Fed by the refresh functions of each series; TakeSnapshot exports them.
+	SketchSeries CoreUtilizationSketches{ "CPU.Core" };
+	SketchSeries DiskServiceTimeSketches{ "Disk.ServiceTime" };
+	SketchSeries ReceiveRateSketches{ "Network.Receive" };
+	SketchSeries SendRateSketches{ "Network.Send" };
+
+	/* - History */
+	// Fed next to the sketches; at one sample per second each element keeps its last 15 minutes.
+	SeriesHistory CoreUtilizationHistory{ "CPU.Core" };
+	SeriesHistory MemoryAvailableHistory{ "Memory.Available", SERIES_INTEGER };
+	SeriesHistory ReceivedBytesHistory{ "Network.ReceivedBytes", SERIES_INTEGER };
+	SeriesHistory SentBytesHistory{ "Network.SentBytes", SERIES_INTEGER };
+
+	/* - Sensors */
+	// Handles opened once by GetSensorInfo and kept open so that RefreshSensors is a single batched pass.
+	struct _ENERGYMETER {
+		HANDLE hDevice = INVALID_HANDLE_VALUE;
+		USHORT EmiVersion = 0;
+		size_t FirstDomain = 0;		// Index of the first channel of this meter in Sensors.PowerDomains.
+		size_t ChannelCount = 0;
+		std::vector<BYTE> MeasurementBuffer;
+		std::vector<ULONGLONG> LastEnergy;	// Picowatt-hours.
+		std::vector<ULONGLONG> LastTime;	// 100ns units.
+	};
+	PDH_HQUERY hSensorQuery = NULL;
+	PDH_HCOUNTER hTemperatureCounter = NULL;
+	PDH_HCOUNTER hPassiveLimitCounter = NULL;
+	PDH_HCOUNTER hThrottleReasonsCounter = NULL;
+	std::vector<BYTE> SensorCounterBuffer;
+	std::vector<std::wstring> ThermalZoneInstances;	// PDH instance names, parallel to Sensors.ThermalZones.
+	std::vector<_ENERGYMETER> EnergyMeters;
+	BOOL bSensorsOpened = FALSE;		// Set once discovery succeeded; _CloseSensors clears it.
+
+	std::optional<Error> _OpenThermalZones();
+	std::optional<Error> _OpenEnergyMeters();
+	// One WMI query; run by discovery only, since the speeds firmware reports through it are set points that rarely change.
+	std::optional<Error> _GetFans();
+	std::optional<Error> _SampleThermalCounter(PDH_HCOUNTER hCounter, int Field);
+	void _SampleEnergyMeters();
+	void _CloseSensors();
+
+	/* - PCI */
+	PCIIdsIndex PCINames;
+	BOOL bPCINamesOpened = FALSE;		// Opening is attempted once; without an index the names stay empty.
+	std::optional<Error> PCINamesError;	// Outcome of that attempt; a missing index is not an error.
+
+	std::optional<Error> _OpenPCINames();
+	// Present PCI functions of one setup class, or of every class when it is NULL, sorted by location.
+	std::optional<Error> _EnumeratePCIDevices(const GUID* pSetupClass, std::vector<PCIDEVICEINFO>& Devices);
+
+	/* - GPU */
+	PDH_HQUERY hGPUMemoryQuery = NULL;
+	PDH_HCOUNTER hDedicatedUsageCounter = NULL;
+	PDH_HCOUNTER hSharedUsageCounter = NULL;
+	std::vector<BYTE> GPUCounterBuffer;
+
+	std::optional<Error> _OpenGPUMemoryCounters();
+	std::optional<Error> _SampleGPUMemoryCounter(PDH_HCOUNTER hCounter, BOOL bDedicated);
+	void _CloseGPUMemoryCounters();
+};
+
+// A collector RetrieveAllData can run and the category that selects it.
+typedef struct _tag_PROBECOLLECTOR {
+	COLLECTOR_CATEGORY Category;
+	std::optional<Error>(SysInfoProbe::*Function)();
+} PROBECOLLECTOR;
+
+// Every collector, in the order they run.
+inline constexpr PROBECOLLECTOR ProbeCollectors[] = {
+	{ COLLECTOR_CPU, &SysInfoProbe::GetCpuInfo },
+	{ COLLECTOR_RAM, &SysInfoProbe::GetRamInfo },
+	{ COLLECTOR_NUMA, &SysInfoProbe::GetNUMAInfo },
+	{ COLLECTOR_PCI, &SysInfoProbe::GetPCIDevices },
+	{ COLLECTOR_GPU, &SysInfoProbe::GetGpuInfo },
+	{ COLLECTOR_MAINBOARD, &SysInfoProbe::GetMotherboardInfo },
+	{ COLLECTOR_BIOS, &SysInfoProbe::GetBIOSInfo },
+	{ COLLECTOR_COMPUTERTYPE, &SysInfoProbe::GetComputerType },
+	{ COLLECTOR_STORAGE, &SysInfoProbe::GetStorageDevices },
+	{ COLLECTOR_VOLUMES, &SysInfoProbe::RefreshVolumeSpace },
+	{ COLLECTOR_DISPLAY, &SysInfoProbe::GetDisplayInfo },
+	{ COLLECTOR_NETWORK, &SysInfoProbe::GetNetworkInterfacesInfo },
+	{ COLLECTOR_TCP, &SysInfoProbe::RefreshTCPStatistics },
+	{ COLLECTOR_CDROM, &SysInfoProbe::GetCDROMInfo },
+	{ COLLECTOR_OS, &SysInfoProbe::GetOperatingSystemInfo },
+	{ COLLECTOR_SOUND, &SysInfoProbe::GetSoundInfo },
+	{ COLLECTOR_SENSORS, &SysInfoProbe::GetSensorInfo },
+	{ COLLECTOR_JOBLIMITS, &SysInfoProbe::GetJobLimits },
+	{ COLLECTOR_INTERRUPTS, &SysInfoProbe::GetInterruptInfo }
 };
+
+template<UINT32 Categories, size_t Index> bool SysInfoProbe::_RunCollectors(std::vector<Error>& Errors, bool StopOnError) {
+	if constexpr (Index == std::size(ProbeCollectors)) return true;
+	else {
+		if constexpr ((ProbeCollectors[Index].Category & Categories) != 0) {
+			constexpr auto Function = ProbeCollectors[Index].Function;
+			if (auto r = (this->*Function)()) {
+				Errors.push_back(r.value());
+
+				if (StopOnError) return false;
+			}
+		}
+		return _RunCollectors<Categories, Index + 1>(Errors, StopOnError);
+	}
+}
+
+template<UINT32 Categories> std::optional<std::vector<Error>> SysInfoProbe::Retrieve(bool StopOnError) {
+	// The destructor only releases the handles of the build's categories.
+	static_assert((Categories & ~static_cast<UINT32>(SYSINFO_COLLECTORS)) == 0, "Categories must be part of SYSINFO_COLLECTORS.");
+	std::vector<Error> errors;
+
+	// These collectors append, so a repeated retrieval (as in daemon mode) has to start from empty lists.
+	StorageDevices.clear();
+	NetworkInterfaces.clear();
+	CDROMs.clear();
+	Displays.clear();
+
+	if (!_RunCollectors<Categories, 0>(errors, StopOnError)) return errors;
+
+	if constexpr ((Categories & COLLECTOR_UPTIME) != 0) GetUptimeInfo();
+	return errors.empty() ? std::nullopt : std::make_optional(errors);
+}
@@ -2,142 +2,108 @@
 #pragma once
 #include <Windows.h>
 #include <map>
+#include <vector>
 #include <string>
 
-static std::string RAMFormFactors[24] {
-	"Unknown form factor",
-	"",
-	"SIP",
-	"DIP",
-	"ZIP",
-	"SOJ",
-	"Proprietary",
-	"SIMM",
-	"DIMM",
-	"TSOP",
-	"PGA",
-	"RIMM",
-	"SODIMM",
-	"SRIMM",
-	"SMD",
-	"SSMP",
-	"QFP",
-	"TQFP",
-	"SOIC",
-	"LCC",
-	"PLCC",
-	"BGA",
-	"FPBGA",
-	"LGA"
-};
-
-static std::string RAMMemoryTypes[] = {
-	"Unknown",
-	"Other",
-	"DRAM",
-	"Synchronous DRAM",
-	"Cache DRAM",
-	"EDO",
-	"EDRAM",
-	"VRAM",
-	"SRAM",
-	"RAM",
-	"ROM",
-	"Flash",
-	"EEPROM",
-	"FEPROM",
-	"EPROM",
-	"CDRAM",
-	"3DRAM",
-	"SDRAM",
-	"SGRAM",
-	"RDRAM",
-	"DDR",
-	"DDR2",
-	"DDR2 FB-DIMM",
-	"",
-	"DDR3",
-	"FBD2",
-	"DDR4",
-	"LPDDR",
-	"LPDDR2",
-	"LPDDR3",
-	"LPDDR4",
-	"Logical non-volatile device",
-	"HBM",
-	"HBM2"
-	// TODO: Add a way to check for DDR5
-};
-
-// Win32_PhysicalMemory
+// SMBIOS type 17 (Memory Device); one entry per installed module.
 typedef struct _tag_RAMINFO {
 	// Manufacturer + Model
 	std::string Name;
 
-	// Aka Vendor; obtained using "Manufacturer" property.
+	// Aka Vendor; obtained using "Manufacturer" string.
 	std::string Manufacturer;
 
-	// TODO: We expect actual name of the RAM but WMI does not provide such a property...
-    // The "Name"-property of WMI returns "PhysicalMemory". Obtained by "PartNumber" property;
+	// Obtained using "Part Number" string.
 	std::string Model;
 
-	// Obtained using "MemoryType" property;
+	// Obtained using "Memory Type" code.
 	std::string MemoryType;
 
-	// Obtained using "FormFactor" property;
+	// Obtained using "Form Factor" code.
 	std::string FormFactor;
 
-	// Obtained using "SerialNumber" property;
+	// Obtained using "Serial Number" string.
 	std::string SerialNumber;
 
-	// SizeInMegabytes is obtained by iterating each slot and accumulating "Capacity" property;
-	// SizeInGigabytes is obtained by dividing SizeInMegabytes by 1024 
+	// Obtained using "Device Locator" string, e.g. "DIMM_A1".
+	std::string DeviceLocator;
+
+	// Obtained using "Bank Locator" string, e.g. "P0 CHANNEL A".
+	std::string BankLocator;
+
+	// Obtained using "Size" (or "Extended Size") field.
+	// For the machine-wide SysInfoProbe::RAM this is the sum over all modules.
 	double SizeInGigabytes = 0.0;
 	int SizeInMegabytes = 0;
 
-	// Retrieval latency obtained using "Speed" property; Unsure about its use but seems useful.
-	// It seems to be same as the Frequency as RAM.
+	// Obtained using "Speed" field (MT/s); kept under its historical name.
 	int LatencyInNanoseconds = 0;
 
-	// Obtained using "ConfiguredClockSpeed" property.
+	// Obtained using "Configured Memory Speed" field.
 	int FrequencyInMHz = 0;
 } RAMINFO, * PRAMINFO;
 
-// Win32_VideoController
+// DXGI (IDXGIFactory1::EnumAdapters1); one entry per hardware adapter, software rasterizers excluded.
 typedef struct _tag_GPUINFO {
-	// Obtained using "Name" property;
+	// Obtained using DXGI_ADAPTER_DESC1::Description.
 	std::string Name;
 
-	// Aka Vendor; obtained using "AdapterCompatibility" property.
+	// Aka Vendor; the PCI ID index name for VendorId.
 	std::string Manufacturer;
 
-	// Obtained using "DriverVersion" property.
+	// User-mode driver version, from IDXGIAdapter::CheckInterfaceSupport.
 	std::string DriverVersion;
 
-	// Obtained by dividing the VRAMSizeInGigabytes values by 1024.
+	// Obtained by dividing DedicatedVideoMemoryBytes by 1024^3.
 	double VRAMSizeInGigabytes = 0.0;
 
-	// Obtained using "AdapterRAM" property.
+	// Obtained by dividing DedicatedVideoMemoryBytes by 1024^2.
 	int VRAMSizeInMegabytes = 0;
 	
-	// Obtained using "CurrentRefreshRate" property.
+	// Highest current refresh rate of the displays attached to the adapter, from EnumDisplaySettings.
 	int RefreshRate = 0;
 	// TODO: Add a way of obtaining Frequency, CoreCount and many other properties without using
 	// External libraries like OpenCL, CUDA or others.
+
+	// Identifies the adapter to DXGI, D3DKMT and the "GPU Adapter Memory" counters until the next reboot.
+	UINT64 AdapterLuid = 0;
+	WORD VendorId = 0;
+	WORD DeviceId = 0;
+	WORD SubsystemVendorId = 0;
+	WORD SubsystemId = 0;
+	BYTE Revision = 0;
+	UINT64 DedicatedVideoMemoryBytes = 0;
+	UINT64 DedicatedSystemMemoryBytes = 0;	// Carved out of system RAM at boot; integrated GPUs.
+	UINT64 SharedSystemMemoryBytes = 0;		// Most system RAM the adapter may page in.
+	// Copied from the matching PCIDevices entry; empty or zero for adapters that are not PCI functions.
+	std::string PCIInstanceId;
+	DWORD CurrentLinkGeneration = 0;
+	DWORD CurrentLinkWidth = 0;
+	DWORD MaxLinkGeneration = 0;
+	DWORD MaxLinkWidth = 0;
+	INT32 NUMANode = -1;
 } GPUINFO, * PGPUINFO;
 
-// Win32_BaseBoard
+// Obtained using the "GPU Adapter Memory" performance counters; system-wide usage, one entry per GPUs entry.
+typedef struct _tag_GPUMEMORYCOUNTERSINFO {
+	UINT64 AdapterLuid = 0;
+	UINT64 DedicatedUsageBytes = 0;
+	UINT64 SharedUsageBytes = 0;
+	double DedicatedUsedPercent = 0.0;
+} GPUMEMORYCOUNTERSINFO, *PGPUMEMORYCOUNTERSINFO;
+
+// SMBIOS type 2 (Baseboard Information)
 typedef struct _tag_MAINBOARDINFO {
-	// Obtained using "Manufacturer property. "
+	// Obtained using "Manufacturer" string.
 	std::string Manufacturer;
 
-	// Obtained using "Product" property.
+	// Obtained using "Product" string.
 	std::string Name;
 
-	// Obtained using "Version" property.
+	// Obtained using "Version" string.
 	std::string Version;
 
-	// Obtained using "SerialNumber" property.
+	// Obtained using "Serial Number" string.
 	std::string SerialNumber;
 } MAINBOARDINFO, * PMAINBOARDINFO;
 
@@ -166,7 +132,7 @@ typedef struct _tag_OSINFO {
 typedef struct _tag_CPUUTILIZATION {
 	// Obtained using "PercentProcessorPerformance" property.
 	int64_t CurrentClockSpeed = 0;
-	// Obtained using "PercentProcessorUtility" property with filter Name=0,_Total
+	// Obtained using "PercentProcessorUtility" property with filter Name=_Total
 	double CurrentUtilization =  0.0;
 	// Both below are obtained using "PercentProcessorUtility" property.
 	double ThreadUtilization = 0.0;
@@ -175,6 +141,27 @@ typedef struct _tag_CPUUTILIZATION {
 	std::vector<int64_t> CurrentClockSpeeds;
 } CPUUTILIZATION, *PCPUUTILIZATION;
 
+/*
+ * Whether work is waiting for the processors. Thread states come from NtQuerySystemInformation(SystemProcessInformation)
+ * and context switches from SystemInterruptInformation; rates and averages are computed over the previous refreshes.
+ */
+typedef struct _tag_SCHEDULERPRESSUREINFO {
+	DWORD ProcessCount = 0;
+	DWORD ThreadCount = 0;
+	DWORD RunningThreads = 0;		// Excluding the idle threads and the collecting thread.
+	DWORD ReadyThreads = 0;			// Run queue length: threads that could run but have no processor.
+	DWORD PagingWaitThreads = 0;	// Blocked on paging I/O, the closest to Linux D-state tasks.
+	double ContextSwitchesPerSecond = 0.0;
+	double ProcessesCreatedPerSecond = 0.0;	// Processes still alive at the refresh that were created since the previous one.
+	// Linux-style load averages: exponentially weighted running plus ready threads over 1, 5 and 15 minutes.
+	double LoadAverage1 = 0.0;
+	double LoadAverage5 = 0.0;
+	double LoadAverage15 = 0.0;
+	// Weighted share of refreshes that found threads waiting for a processor, over 10 and 60 seconds (like PSI "some").
+	double WaitingPercent10 = 0.0;
+	double WaitingPercent60 = 0.0;
+} SCHEDULERPRESSUREINFO, *PSCHEDULERPRESSUREINFO;
+
 // Win32_CacheMemory
 typedef struct _tag_CPUCACHE {
 	// All are obtained using "MaxCacheSize" property.
@@ -184,6 +171,34 @@ typedef struct _tag_CPUCACHE {
 	int L3 = 0;
 } CPUCACHE, *PCPUCACHE;
 
+// SMBIOS type 4 (Processor Information); one entry per socket.
+typedef struct _tag_CPUSOCKETINFO {
+	// Obtained using "Socket Designation" string.
+	std::string SocketDesignation;
+	// Obtained using "Processor Manufacturer" string.
+	std::string Manufacturer;
+	// Obtained using "Processor Version" string.
+	std::string Version;
+	// Obtained using "Max Speed" and "Current Speed" fields.
+	int MaxSpeedMHz = 0;
+	int CurrentSpeedMHz = 0;
+	// Obtained using "Core Count"/"Thread Count" fields, or their "2" variants above 255.
+	int CoreCount = 0;
+	int ThreadCount = 0;
+	// Obtained using bit 6 of "Status" field.
+	BOOL bPopulated = FALSE;
+} CPUSOCKETINFO, *PCPUSOCKETINFO;
+
+// SMBIOS type 7 (Cache Information)
+typedef struct _tag_CACHEINFO {
+	// Obtained using "Socket Designation" string, e.g. "L2 Cache".
+	std::string SocketDesignation;
+	// Obtained using bits 0-2 of "Cache Configuration" field.
+	int Level = 0;
+	// Obtained using "Installed Size" (or "Installed Cache Size 2") field.
+	UINT64 SizeInKilobytes = 0;
+} CACHEINFO, *PCACHEINFO;
+
 // Win32_Processor
 typedef struct _tag_CPUINFO {
 	// Obtained manually using CPUID instruction.
@@ -201,43 +216,108 @@ typedef struct _tag_CPUINFO {
 	unsigned int MaxClockSpeed = 0;
 
 	CPUUTILIZATION Utilization;
+	SCHEDULERPRESSUREINFO Pressure;
 	CPUCACHE Cache;
 } CPUINFO, * PCPUINFO;
 
-// Win32_BIOS
+// SMBIOS type 0 (BIOS Information)
 typedef struct _tag_BIOSINFO {
-	// Obtained using "Manufacturer" property.
+	// Obtained using "Vendor" string.
 	std::string Manufacturer;
-	// Obtained using "Version" property.
+	// Obtained using "BIOS Version" string.
 	std::string Version;
-	// Obtained using "BuildNumber" property; unused as of now
+	// Obtained using "System BIOS Major/Minor Release" fields, e.g. "5.27".
 	std::string BuildNumber;
-	// Obtained using "SerialNumber" property.
+	// Obtained using "BIOS Release Date" string.
+	std::string ReleaseDate;
+	// Obtained using type 1 (System Information) "Serial Number" string, as Win32_BIOS did.
 	std::string SerialNumber;
 } BIOSINFO, *PBIOSINFO;
 
-// Win32_DesktopMonitor
+// SMBIOS type 19 (Memory Array Mapped Address)
+typedef struct _tag_MEMORYRANGEINFO {
+	// Obtained using "Starting/Ending Address" fields or their extended variants, in bytes.
+	UINT64 StartingAddress = 0;
+	UINT64 EndingAddress = 0;
+	// Obtained using "Partition Width" field; number of modules forming the range.
+	int PartitionWidth = 0;
+} MEMORYRANGEINFO, *PMEMORYRANGEINFO;
+
+// Everything SysInfoProbe reads from one pass over the SMBIOS structure table.
+typedef struct _tag_SMBIOSINFO {
+	BYTE MajorVersion = 0;
+	BYTE MinorVersion = 0;
+	BIOSINFO BIOS;
+	MAINBOARDINFO Mainboard;
+	std::vector<CPUSOCKETINFO> Sockets;
+	std::vector<CACHEINFO> Caches;
+	std::vector<RAMINFO> MemoryDevices;
+	std::vector<MEMORYRANGEINFO> MemoryRanges;
+} SMBIOSINFO, *PSMBIOSINFO;
+
+// Everything ParseEDID reads from an EDID base block and its CTA-861 and DisplayID extension blocks.
+typedef struct _tag_EDIDINFO {
+	BYTE Version = 0;
+	BYTE Revision = 0;
+	BYTE ExtensionCount = 0;
+	std::string ManufacturerId;		// Three-letter PNP ID, e.g. "DEL".
+	WORD ProductCode = 0;
+	// The serial number descriptor, or the numeric serial number when the monitor has no such descriptor.
+	std::string SerialNumber;
+	std::string MonitorName;		// The display product name descriptor.
+	int ManufactureYear = 0;
+	int ManufactureWeek = 0;		// Zero when unspecified.
+	// From the preferred detailed timing in millimetres, or the base block's centimetres when it has none.
+	int ImageWidthMm = 0;
+	int ImageHeightMm = 0;
+	// The preferred timing: the first detailed timing of the base block.
+	int NativeWidth = 0;
+	int NativeHeight = 0;
+	double NativeRefreshRate = 0.0;
+	// The largest mode in any timing list: established, standard, detailed, CTA-861 video formats and DisplayID timings.
+	int MaxWidth = 0;
+	int MaxHeight = 0;
+	double MaxRefreshRate = 0.0;
+} EDIDINFO, *PEDIDINFO;
+
+// One entry per active monitor of every active adapter, from EnumDisplayDevices and the monitor's EDID.
 typedef struct _tag_DISPLAYINFO {
-	// Obtained using "Name" property.
+	// The EDID product name, or the monitor driver's description when it has none.
 	std::string MonitorName;
-	// Obtained using "MonitorManufacturer" property.
+	// Vendor name of the EDID manufacturer ID, or the ID itself when the vendor is not known.
 	std::string MonitorManufacturer;
-	// Manually calculated using MaxHorizontalImageSize and MaxVerticalImageSize in `WmiMonitorBasicDisplayParams`.
+	// Diagonal of the EDID image size.
 	double ScreenSizeInch = 0.0;
-	// All the below use Win32 API.
+	// The current mode and the largest one the adapter offers, from EnumDisplaySettings.
 	int ScreenWidth = 0;
 	int ScreenHeight = 0;
 	int MaxWidthRes = 0;
 	int MaxHeightRes = 0;
 	int RefreshRate = 0;
+	// All the below are decoded from the EDID.
+	std::string ManufacturerId;
+	WORD ProductCode = 0;
+	std::string SerialNumber;
+	int ManufactureYear = 0;
+	int ImageWidthMm = 0;
+	int ImageHeightMm = 0;
+	int NativeWidth = 0;
+	int NativeHeight = 0;
+	double NativeRefreshRate = 0.0;
+	// The largest mode the monitor advertises, which the adapter may not be able to drive.
+	int MaxModeWidth = 0;
+	int MaxModeHeight = 0;
+	double MaxModeRefreshRate = 0.0;
 } DISPLAYINFO, *PDISPLAYINFO;
 
-// Obtained using GetTickCount64.
+// Obtained using QueryInterruptTimePrecise and QueryUnbiasedInterruptTimePrecise.
 typedef struct _tag_UPTIMEINFO {
 	UINT64 Days = 0;
 	UINT64 Hours = 0;
 	UINT64 Minutes = 0; 
 	UINT64 Seconds = 0;
+	UINT64 SuspendedSeconds = 0;	// Part of the uptime spent in sleep or hibernation.
+	INT64 BootedAt = 0;				// Unix time.
 } UPTIMEINFO, *PUPTIMEINFO;
 
 // Win32_SoundDevice
@@ -281,8 +361,416 @@ typedef struct _tag_STORAGEDEVICEINFO {
 	int SizeInGibibytes = 0;
 } STORAGEDEVICEINFO, *PSTORAGEDEVICEINFO;
 
+// Obtained from the probe's own instrumentation (Instrumentation::GetCollectorStats); times are in nanoseconds.
+typedef struct _tag_COLLECTORSTATS {
+	std::string Name;
+	UINT64 Calls = 0;
+	UINT64 TotalNanoseconds = 0;
+	UINT64 MaxNanoseconds = 0;
+	UINT64 P50Nanoseconds = 0;
+	UINT64 P90Nanoseconds = 0;
+	UINT64 P99Nanoseconds = 0;
+	UINT64 WMIQueries = 0;
+	UINT64 SystemCalls = 0;
+	UINT64 BytesRead = 0;
+	UINT64 Allocations = 0;
+	UINT64 AllocatedBytes = 0;
+} COLLECTORSTATS, *PCOLLECTORSTATS;
+
+// Obtained using QueryInformationJobObject on the job of the current process; changes on every refresh.
+typedef struct _tag_JOBUSAGEINFO {
+	UINT64 TotalCPUTime = 0;			// User plus kernel time of every process ever in the job, in 100ns units.
+	DWORD ActiveProcesses = 0;
+	UINT64 PeakJobMemoryBytes = 0;
+	UINT64 PeakProcessMemoryBytes = 0;
+	// Share of the CPU rate cap used since the previous refresh; near 100 means the job is being throttled.
+	double CPUCapUsagePercent = 0.0;
+} JOBUSAGEINFO, *PJOBUSAGEINFO;
+
+/*
+ * Limits that the job object of the current process (e.g. a Windows container) puts on it.
+ * Obtained using IsProcessInJob, GetProcessAffinityMask and QueryInformationJobObject.
+ */
+typedef struct _tag_JOBLIMITSINFO {
+	BOOL bInJob = FALSE;
+	DWORD ProcessorCount = 0;			// Logical processors of the machine, over every processor group.
+	DWORD AffinityProcessorCount = 0;	// Logical processors the process is allowed to run on.
+	double CPURateLimitPercent = 0.0;	// Hard cap in percent of the whole machine; 0 when not capped.
+	DWORD CPUWeight = 0;				// Relative weight (1-9) when weight-based scheduling is used, otherwise 0.
+	UINT64 JobMemoryLimitBytes = 0;		// 0 when not limited.
+	UINT64 ProcessMemoryLimitBytes = 0;	// 0 when not limited.
+	// Threads that can actually run at once: the affinity count, reduced by the CPU rate cap. Use it to size thread pools.
+	DWORD EffectiveParallelism = 0;
+	JOBUSAGEINFO Usage;
+} JOBLIMITSINFO, *PJOBLIMITSINFO;
+
+// Groups of collectors, for selecting at compile time what a build or an embedding application collects.
+enum COLLECTOR_CATEGORY : UINT32 {
+	COLLECTOR_CPU = 1 << 0,				// GetCpuInfo and the CPU and pressure samplers.
+	COLLECTOR_RAM = 1 << 1,				// GetRamInfo and the memory sampler.
+	COLLECTOR_NUMA = 1 << 2,
+	COLLECTOR_PCI = 1 << 3,
+	COLLECTOR_GPU = 1 << 4,
+	COLLECTOR_MAINBOARD = 1 << 5,
+	COLLECTOR_BIOS = 1 << 6,
+	COLLECTOR_COMPUTERTYPE = 1 << 7,
+	COLLECTOR_STORAGE = 1 << 8,			// GetStorageDevices and the disk sampler.
+	COLLECTOR_VOLUMES = 1 << 9,
+	COLLECTOR_DISPLAY = 1 << 10,
+	COLLECTOR_NETWORK = 1 << 11,
+	COLLECTOR_TCP = 1 << 12,
+	COLLECTOR_CDROM = 1 << 13,
+	COLLECTOR_OS = 1 << 14,
+	COLLECTOR_SOUND = 1 << 15,
+	COLLECTOR_SENSORS = 1 << 16,
+	COLLECTOR_JOBLIMITS = 1 << 17,
+	COLLECTOR_INTERRUPTS = 1 << 18,
+	COLLECTOR_UPTIME = 1 << 19,
+	COLLECTOR_PROCESSES = 1 << 20,		// Sampler only; nothing is collected up front.
+	COLLECTOR_ALL = (1 << 21) - 1
+};
+
+// Categories this build can collect; a minimal agent narrows it, e.g. /DSYSINFO_COLLECTORS=(COLLECTOR_CPU|COLLECTOR_RAM).
+#ifndef SYSINFO_COLLECTORS
+#define SYSINFO_COLLECTORS COLLECTOR_ALL
+#endif
+
+constexpr bool BuildCollects(UINT32 Categories) {
+	return (SYSINFO_COLLECTORS & Categories) != 0;
+}
+
+// Samplers of lower priority are shed first when the probe exceeds its CPU budget.
+enum SAMPLER_PRIORITY : BYTE {
+	PRIORITY_CRITICAL = 0,	// Never shed, only stretched.
+	PRIORITY_NORMAL,
+	PRIORITY_LOW
+};
+
+// Obtained from OverheadGovernor::GetStatus.
+typedef struct _tag_GOVERNORINFO {
+	double BudgetPercent = 0.0;		// Allowed probe CPU time, in percent of one core.
+	double UsagePercent = 0.0;		// Measured over the last evaluation window.
+	DWORD Level = 0;				// 0 when the data is complete; higher levels degrade it further.
+	DWORD StretchFactor = 1;		// Every sampling interval is multiplied by this.
+	BOOL bLowPriorityShed = FALSE;
+	BOOL bNormalPriorityShed = FALSE;
+	INT64 DegradedSince = 0;		// Unix time in seconds when the level last left 0, or 0 while at level 0.
+} GOVERNORINFO, *PGOVERNORINFO;
+
+// Obtained using GlobalMemoryStatusEx.
+typedef struct _tag_MEMORYUSAGEINFO {
+	DWORD MemoryLoadPercent = 0;
+	UINT64 TotalPhysicalBytes = 0;
+	UINT64 AvailablePhysicalBytes = 0;
+	// Commit charge limit and the amount of it still available, in bytes.
+	UINT64 TotalCommitBytes = 0;
+	UINT64 AvailableCommitBytes = 0;
+} MEMORYUSAGEINFO, *PMEMORYUSAGEINFO;
+
+// One entry per NUMA node. Obtained using GetNumaNodeProcessorMaskEx and the "NUMA Node Memory" performance counters.
+typedef struct _tag_NUMANODEINFO {
+	USHORT NodeNumber = 0;
+	WORD ProcessorGroup = 0;
+	UINT64 ProcessorMask = 0;		// Within ProcessorGroup.
+	DWORD ProcessorCount = 0;
+	UINT64 TotalBytes = 0;			// Obtained using "Total MBytes" counter; zero when performance counters are unavailable.
+} NUMANODEINFO, *PNUMANODEINFO;
+
+// Obtained using GetNumaAvailableMemoryNodeEx; one entry per node in NUMANodes.
+typedef struct _tag_NUMANODECOUNTERSINFO {
+	USHORT NodeNumber = 0;
+	UINT64 AvailableBytes = 0;
+	double UsedPercent = 0.0;		// Of NUMANODEINFO::TotalBytes; compare nodes to spot imbalanced allocation.
+	// Computed from the previous refresh; negative while the node is being allocated from.
+	INT64 AvailableBytesChange = 0;
+} NUMANODECOUNTERSINFO, *PNUMANODECOUNTERSINFO;
+
+// Large page support of the machine and of the current process.
+typedef struct _tag_LARGEPAGEINFO {
+	UINT64 LargePageMinimumBytes = 0;	// Obtained using GetLargePageMinimum; 0 when large pages are not supported.
+	BOOL bHugePagesSupported = FALSE;	// 1 GB pages, obtained using CPUID leaf 0x80000001 (EDX bit 26).
+	// Obtained using GetTokenInformation; large pages can only be allocated by accounts holding SeLockMemoryPrivilege.
+	BOOL bLockMemoryPrivilege = FALSE;
+} LARGEPAGEINFO, *PLARGEPAGEINFO;
+
+// Obtained using GetIfTable2; one entry per interface in NetworkInterfaces.
+typedef struct _tag_NETWORKCOUNTERSINFO {
+	ULONG InterfaceIndex = 0;
+	UINT64 ReceivedBytes = 0;
+	UINT64 SentBytes = 0;
+	UINT64 ReceivedPackets = 0;
+	UINT64 SentPackets = 0;
+	UINT64 ReceiveErrors = 0;
+	UINT64 SendErrors = 0;
+	UINT64 ReceiveDiscards = 0;
+	UINT64 SendDiscards = 0;
+	// Computed from the previous refresh; zero on the first one.
+	double ReceiveBytesPerSecond = 0.0;
+	double SendBytesPerSecond = 0.0;
+} NETWORKCOUNTERSINFO, *PNETWORKCOUNTERSINFO;
+
+/*
+ * IPv4 and IPv6 added together. Counters are obtained using GetTcpStatisticsEx2 and GetUdpStatisticsEx2,
+ * connection states using GetTcpTable and GetTcp6Table.
+ */
+typedef struct _tag_TCPSTATSINFO {
+	UINT64 SegmentsReceived = 0;
+	UINT64 SegmentsSent = 0;
+	UINT64 SegmentsRetransmitted = 0;
+	UINT64 ActiveOpens = 0;
+	UINT64 PassiveOpens = 0;
+	UINT64 FailedAttempts = 0;		// Connections that went back to CLOSED or LISTEN before being established.
+	UINT64 EstablishedResets = 0;
+	UINT64 ResetsSent = 0;
+	UINT64 ReceiveErrors = 0;
+	DWORD EstablishedConnections = 0;
+	DWORD ListeningSockets = 0;
+	DWORD TimeWaitConnections = 0;
+	DWORD CloseWaitConnections = 0;	// Closed by the peer but not yet by the application; a steady rise is a socket leak.
+	DWORD TotalConnections = 0;
+	UINT64 UDPDatagramsReceived = 0;
+	UINT64 UDPDatagramsSent = 0;
+	UINT64 UDPNoPorts = 0;			// Datagrams for a port nobody listens on.
+	UINT64 UDPReceiveErrors = 0;	// Mostly full receive buffers.
+	DWORD UDPEndpoints = 0;
+	// Computed from the previous refresh; zero on the first one.
+	double RetransmitPercent = 0.0;	// Retransmitted segments over segments sent.
+	double RetransmitsPerSecond = 0.0;
+	double FailedAttemptsPerSecond = 0.0;
+	double ResetsPerSecond = 0.0;
+	double UDPReceiveErrorsPerSecond = 0.0;
+} TCPSTATSINFO, *PTCPSTATSINFO;
+
+// Obtained using IOCTL_DISK_PERFORMANCE on each physical drive.
+typedef struct _tag_DISKCOUNTERSINFO {
+	DWORD DeviceNumber = 0;		// N in \\.\PhysicalDriveN.
+	UINT64 BytesRead = 0;
+	UINT64 BytesWritten = 0;
+	DWORD ReadCount = 0;
+	DWORD WriteCount = 0;
+	DWORD QueueDepth = 0;
+	// Computed from the previous refresh; zero on the first one.
+	double ReadBytesPerSecond = 0.0;
+	double WriteBytesPerSecond = 0.0;
+	double BusyPercent = 0.0;
+	double ServiceTimeMilliseconds = 0.0;	// Average time per read or write completed since the previous refresh.
+} DISKCOUNTERSINFO, *PDISKCOUNTERSINFO;
+
+// Obtained using GetLogicalDriveStringsW and GetDiskFreeSpaceExW; fixed volumes with a drive letter only.
+typedef struct _tag_VOLUMESPACEINFO {
+	std::string RootPath;			// e.g. "C:\".
+	UINT64 TotalBytes = 0;
+	UINT64 FreeBytes = 0;			// Free for any user, regardless of quotas.
+	double FreePercent = 0.0;
+} VOLUMESPACEINFO, *PVOLUMESPACEINFO;
+
+/*
+ * Distribution of one element of a sampled series over the last few minutes, from the probe's QuantileSketch of it.
+ * The bins are the sketch itself, so QuantileSketch::FromInfo can merge them across periods or hosts.
+ */
+typedef struct _tag_SKETCHINFO {
+	std::string Series;				// "CPU.Core", "Disk.ServiceTime", "Network.Receive" or "Network.Send".
+	UINT64 Element = 0;				// Processor index, disk device number or interface index.
+	UINT64 Count = 0;
+	double Min = 0.0;
+	double Max = 0.0;
+	double P50 = 0.0;
+	double P95 = 0.0;
+	double P99 = 0.0;
+	UINT64 ZeroCount = 0;
+	INT64 BinOffset = 0;			// Sketch index of Bins[0].
+	std::vector<UINT64> Bins;
+} SKETCHINFO, *PSKETCHINFO;
+
+/*
+ * One compressed block of a sampled series, from the probe's SeriesHistory of it; DecodeSeriesBlock turns Data back
+ * into timestamps (Unix time in milliseconds) and values.
+ */
+typedef struct _tag_SERIESBLOCKINFO {
+	std::string Series;				// "CPU.Core", "Memory.Available", "Network.ReceivedBytes" or "Network.SentBytes".
+	UINT64 Element = 0;				// Processor index or interface index; zero for whole-machine series.
+	INT64 FirstTimestamp = 0;
+	INT64 LastTimestamp = 0;
+	DWORD PointCount = 0;
+	std::vector<BYTE> Data;
+} SERIESBLOCKINFO, *PSERIESBLOCKINFO;
+
+/*
+ * Interrupt and DPC (deferred procedure call, the Windows counterpart of softirqs) activity of one logical processor.
+ * Obtained using NtQuerySystemInformationEx(SystemProcessorPerformanceInformation and SystemInterruptInformation) for each processor group.
+ */
+typedef struct _tag_INTERRUPTCOUNTERSINFO {
+	DWORD Processor = 0;			// Index over every processor group.
+	WORD Group = 0;
+	BYTE Number = 0;				// Within Group.
+	// Raw counters; they are 32 bits wide and wrap.
+	DWORD InterruptCount = 0;
+	DWORD DpcCount = 0;
+	DWORD ContextSwitches = 0;
+	// Computed from the previous refresh; zero on the first one.
+	double InterruptsPerSecond = 0.0;
+	double DpcsPerSecond = 0.0;
+	double ContextSwitchesPerSecond = 0.0;
+	double InterruptPercent = 0.0;	// Time of this processor spent in interrupt service routines.
+	double DpcPercent = 0.0;		// Time of this processor spent running DPCs.
+} INTERRUPTCOUNTERSINFO, *PINTERRUPTCOUNTERSINFO;
+
+// One interrupt assigned to a device. Obtained using the IRQ resources of the allocated configuration of each device (cfgmgr32).
+typedef struct _tag_INTERRUPTASSIGNMENTINFO {
+	std::string DeviceName;
+	std::string InstanceId;
+	// Line-based IRQ number; message-signaled interrupts (MSI/MSI-X) report negative numbers.
+	INT64 Vector = 0;
+	BOOL bMessageSignaled = FALSE;
+	UINT64 Affinity = 0;			// Processors the interrupt may be delivered to.
+	DWORD AffinityProcessorCount = 0;
+} INTERRUPTASSIGNMENTINFO, *PINTERRUPTASSIGNMENTINFO;
+
+/*
+ * Obtained using SetupDiGetClassDevsW("PCI"): identifiers from the hardware and compatible IDs, location from the bus number
+ * and address, link and NUMA node from the device properties. Names come from the PCI ID index (PCIIdsIndex) when one is
+ * installed next to the executable; otherwise only DeviceName is set, to the driver's description.
+ */
+typedef struct _tag_PCIDEVICEINFO {
+	std::string InstanceId;
+	DWORD Bus = 0;
+	BYTE Device = 0;
+	BYTE Function = 0;
+	WORD VendorId = 0;
+	WORD DeviceId = 0;
+	WORD SubsystemVendorId = 0;
+	WORD SubsystemId = 0;
+	BYTE Revision = 0;
+	BYTE ClassCode = 0;				// e.g. 0x02 for network controllers.
+	BYTE Subclass = 0;
+	BYTE ProgIf = 0;				// Programming interface.
+	std::string VendorName;
+	std::string DeviceName;
+	std::string SubsystemName;
+	std::string ClassName;			// The most specific of the programming interface, subclass and class names.
+	std::string Description;		// From the driver's INF file.
+	// PCI Express generation (1 = 2.5 GT/s, 2 = 5 GT/s, 3 = 8 GT/s, ...) and lane count; zero for conventional PCI.
+	DWORD CurrentLinkGeneration = 0;
+	DWORD CurrentLinkWidth = 0;
+	DWORD MaxLinkGeneration = 0;
+	DWORD MaxLinkWidth = 0;
+	INT32 NUMANode = -1;			// -1 when the firmware does not report one.
+} PCIDEVICEINFO, *PPCIDEVICEINFO;
+
+// Obtained using NtQuerySystemInformation(SystemProcessInformation); one entry per running process, sorted by ProcessId.
+// Windows accounts by process, not by container: a container is a job object (a server silo for Windows containers),
+// and which job a process belongs to cannot be read without a handle to that job. Every counter here but the working
+// set adds up, so the totals of a container are the sums over the processes its runtime lists, and per-process rows
+// stand in for per-container ones.
+typedef struct _tag_PROCESSCOUNTERSINFO {
+	// A process is identified by both, since process ids are reused as soon as a process exits.
+	DWORD ProcessId = 0;
+	UINT64 CreateTime = 0;			// FILETIME, in 100ns units since 1601.
+	DWORD ParentProcessId = 0;
+	DWORD SessionId = 0;
+	std::string ImageName;
+	UINT64 CPUTime = 0;				// User plus kernel time, in 100ns units.
+	UINT64 WorkingSetBytes = 0;
+	UINT64 PrivateBytes = 0;
+	UINT64 ReadBytes = 0;
+	UINT64 WriteBytes = 0;
+	DWORD ThreadCount = 0;
+	DWORD HandleCount = 0;
+	// Computed from the previous refresh; zero on the first one and for processes started since.
+	double CPUPercent = 0.0;		// Share of every logical processor of the machine.
+	double ReadBytesPerSecond = 0.0;
+	double WriteBytesPerSecond = 0.0;
+} PROCESSCOUNTERSINFO, *PPROCESSCOUNTERSINFO;
+
+// "Thermal Zone Information" performance counters, sampled through PDH.
+typedef struct _tag_THERMALZONEINFO {
+	// Counter instance name, e.g. "\_TZ.TZ00".
+	std::string Name;
+	// Obtained using "High Precision Temperature" counter (tenths of kelvin) and converted to celsius.
+	double TemperatureCelsius = 0.0;
+	// Obtained using "% Passive Limit" counter; anything below 100 means the zone is throttling the processors.
+	double PassiveLimitPercent = 100.0;
+	// Obtained using "Throttle Reasons" counter; non-zero while the zone is throttling.
+	DWORD ThrottleReasons = 0;
+} THERMALZONEINFO, *PTHERMALZONEINFO;
+
+// Win32_Fan
+typedef struct _tag_FANINFO {
+	// Obtained using "Name" property.
+	std::string Name;
+	// Obtained using "DesiredSpeed" property: the speed the fan is set to, not a measured one. Most firmwares do not expose a tachometer reading.
+	UINT64 DesiredSpeedRPM = 0;
+	// Obtained using "ActiveCooling" property.
+	BOOL bActiveCooling = FALSE;
+} FANINFO, *PFANINFO;
+
+// Energy Metering Interface (EMI) channels; on Intel and AMD these are backed by the RAPL counters.
+typedef struct _tag_POWERDOMAININFO {
+	// Channel name reported by the energy meter, e.g. "RAPL_Package0_PKG".
+	std::string Name;
+	// Energy accumulated since the domain was discovered, in joules.
+	double EnergyJoules = 0.0;
+	// Average power between the last two samples, in watts.
+	double PowerWatts = 0.0;
+} POWERDOMAININFO, *PPOWERDOMAININFO;
+
+// Discovered once by GetSensorInfo; RefreshSensors resamples the thermal zones and power domains in a single pass.
+typedef struct _tag_SENSORINFO {
+	std::vector<THERMALZONEINFO> ThermalZones;
+	std::vector<FANINFO> Fans;
+	std::vector<POWERDOMAININFO> PowerDomains;
+} SENSORINFO, *PSENSORINFO;
+
 enum COMPUTER_TYPE {
 	NONE,
 	DESKTOP,
 	LAPTOP
 };
+
+// Identifies the machine a snapshot was taken on.
+typedef struct _tag_HOSTINFO {
+	// Obtained using GetComputerNameEx(ComputerNameDnsFullyQualified).
+	std::string HostName;
+	// Seconds since the Unix epoch at which the snapshot was taken.
+	INT64 CollectedAt = 0;
+	COMPUTER_TYPE ComputerType = NONE;
+} HOSTINFO, *PHOSTINFO;
+
+// Plain copy of everything a SysInfoProbe collected; this is what gets serialized and shipped.
+typedef struct _tag_SYSINFOSNAPSHOT {
+	HOSTINFO Host;
+	CPUINFO CPU;
+	std::vector<CPUSOCKETINFO> CPUSockets;
+	std::vector<CACHEINFO> CPUCaches;
+	MAINBOARDINFO Mainboard;
+	RAMINFO RAM;
+	std::vector<RAMINFO> RAMModules;
+	std::vector<GPUINFO> GPUs;
+	OSINFO OS;
+	BIOSINFO BIOS;
+	UPTIMEINFO Uptime;
+	SOUNDINFO Sound;
+	SENSORINFO Sensors;
+	std::vector<STORAGEDEVICEINFO> StorageDevices;
+	std::vector<NETWORKINTERFACEINFO> NetworkInterfaces;
+	std::vector<CDROMINFO> CDROMs;
+	std::vector<DISPLAYINFO> Displays;
+	MEMORYUSAGEINFO Memory;
+	std::vector<NETWORKCOUNTERSINFO> NetworkCounters;
+	std::vector<DISKCOUNTERSINFO> DiskCounters;
+	TCPSTATSINFO TCPStats;
+	std::vector<COLLECTORSTATS> Collectors;
+	GOVERNORINFO Governor;		// Only filled by processes that run a governor, such as the daemon.
+	JOBLIMITSINFO JobLimits;
+	std::vector<NUMANODEINFO> NUMANodes;
+	std::vector<NUMANODECOUNTERSINFO> NUMACounters;
+	LARGEPAGEINFO LargePages;
+	std::vector<INTERRUPTCOUNTERSINFO> InterruptCounters;
+	std::vector<INTERRUPTASSIGNMENTINFO> InterruptAssignments;
+	std::vector<VOLUMESPACEINFO> Volumes;
+	std::vector<SKETCHINFO> Sketches;
+	std::vector<SERIESBLOCKINFO> History;
+	std::vector<PCIDEVICEINFO> PCIDevices;
+	std::vector<GPUMEMORYCOUNTERSINFO> GPUMemoryCounters;
+	std::vector<PROCESSCOUNTERSINFO> ProcessCounters;
+} SYSINFOSNAPSHOT, *PSYSINFOSNAPSHOT;
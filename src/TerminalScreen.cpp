@@ -0,0 +1,135 @@
+#include "TerminalScreen.hpp"
+#include <algorithm>
+
+// Rewriting a few unchanged cells is cheaper than the cursor movement that skips them.
+constexpr int MaxBridgedCells = 4;
+
+std::optional<Error> TerminalScreen::Open() {
+	const char* FuncName = "TerminalScreen::Open";
+	hOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+	if (hOutput == INVALID_HANDLE_VALUE || hOutput == NULL) {
+		return Error::New(FuncName, 1, L"No standard output.", GetLastError());
+	}
+	if (!GetConsoleMode(hOutput, &OriginalMode)) {
+		hOutput = NULL;
+		return Error::New(FuncName, 2, L"Standard output is not a console.", GetLastError());
+	}
+	// Without DISABLE_NEWLINE_AUTO_RETURN, writing the last column moves the cursor to the next line.
+	if (!SetConsoleMode(hOutput, OriginalMode | ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN)) {
+		hOutput = NULL;
+		return Error::New(FuncName, 3, L"Failed to enable virtual terminal processing.", GetLastError());
+	}
+
+	// Alternate screen, hidden cursor and no autowrap, so that the bottom-right cell does not scroll the screen.
+	const char Setup[] = "\033[?1049h\033[?25l\033[?7l";
+	DWORD dwWritten = 0;
+	WriteFile(hOutput, Setup, sizeof(Setup) - 1, &dwWritten, NULL);
+	bFullRedraw = TRUE;
+	return std::nullopt;
+}
+
+void TerminalScreen::Close() {
+	if (!hOutput) return;
+	const char Restore[] = "\033[0m\033[?7h\033[?25h\033[?1049l";
+	DWORD dwWritten = 0;
+	WriteFile(hOutput, Restore, sizeof(Restore) - 1, &dwWritten, NULL);
+	SetConsoleMode(hOutput, OriginalMode);
+	hOutput = NULL;
+}
+
+void TerminalScreen::BeginFrame() {
+	CONSOLE_SCREEN_BUFFER_INFO Info = { 0 };
+	int NewColumns = 80, NewRows = 25;
+	if (hOutput && GetConsoleScreenBufferInfo(hOutput, &Info)) {
+		NewColumns = Info.srWindow.Right - Info.srWindow.Left + 1;
+		NewRows = Info.srWindow.Bottom - Info.srWindow.Top + 1;
+	}
+	if (NewColumns != Columns || NewRows != Rows) {
+		// The terminal reflows its content on a resize, so nothing it shows can be trusted any more.
+		Columns = NewColumns;
+		Rows = NewRows;
+		bFullRedraw = TRUE;
+	}
+	Back.assign(static_cast<size_t>(Columns) * Rows, _CELL());
+}
+
+int TerminalScreen::Put(int x, int y, std::string_view Text, BYTE Style) {
+	if (y < 0 || y >= Rows) return x + static_cast<int>(Text.size());
+	for (char Character : Text) {
+		if (x >= 0 && x < Columns) {
+			_CELL& Cell = Back[static_cast<size_t>(y) * Columns + x];
+			Cell.Character = Character >= 0x20 && Character < 0x7F ? Character : '?';
+			Cell.Style = Style;
+		}
+		x++;
+	}
+	return x;
+}
+
+void TerminalScreen::Fill(int x, int y, int Count, char Character, BYTE Style) {
+	if (y < 0 || y >= Rows) return;
+	int First = (std::max)(x, 0), Last = (std::min)(x + Count, Columns);
+	for (int i = First; i < Last; i++) Back[static_cast<size_t>(y) * Columns + i] = { Character, Style };
+}
+
+void TerminalScreen::_AppendStyle(BYTE Style) {
+	Output += "\033[0";
+	if (Style & STYLE_BOLD) Output += ";1";
+	if (Style & STYLE_INVERSE) Output += ";7";
+	if (Style & STYLE_COLOR_MASK) {
+		Output += ";3";
+		Output += static_cast<char>('0' + (Style & STYLE_COLOR_MASK));
+	}
+	Output += 'm';
+	TerminalStyle = Style;
+}
+
+std::optional<Error> TerminalScreen::Present() {
+	const char* FuncName = "TerminalScreen::Present";
+	Output.clear();
+	if (bFullRedraw) {
+		// Blank cells then match the default cells of Front, so only the drawn ones are written.
+		Output += "\033[0m\033[2J";
+		Front.assign(Back.size(), _CELL());
+		TerminalStyle = STYLE_DEFAULT;
+		bFullRedraw = FALSE;
+	}
+
+	for (int y = 0; y < Rows; y++) {
+		const size_t Row = static_cast<size_t>(y) * Columns;
+		int CursorX = -1;		// Column the cursor is at after the last write on this row, if any.
+		for (int x = 0; x < Columns; x++) {
+			if (Back[Row + x] == Front[Row + x]) continue;
+
+			bool bBridge = CursorX >= 0 && x - CursorX <= MaxBridgedCells &&
+				std::all_of(Back.begin() + Row + CursorX, Back.begin() + Row + x, [this](const _CELL& Cell) { return Cell.Style == TerminalStyle; });
+			if (bBridge) {
+				for (int i = CursorX; i < x; i++) Output += Back[Row + i].Character;
+			}
+			else if (x != CursorX) {
+				Output += "\033[";
+				Output += std::to_string(y + 1);
+				Output += ';';
+				Output += std::to_string(x + 1);
+				Output += 'H';
+			}
+			if (Back[Row + x].Style != TerminalStyle) _AppendStyle(Back[Row + x].Style);
+			Output += Back[Row + x].Character;
+			Front[Row + x] = Back[Row + x];
+			CursorX = x + 1;
+		}
+	}
+	if (Output.empty()) return std::nullopt;
+
+	for (size_t Offset = 0; Offset < Output.size();) {
+		DWORD dwWritten = 0;
+		if (!WriteFile(hOutput, Output.data() + Offset, static_cast<DWORD>(Output.size() - Offset), &dwWritten, NULL)) {
+			// Whatever the terminal got is unknown now.
+			bFullRedraw = TRUE;
+			return Error::New(FuncName, 1, L"Failed to write to the console.", GetLastError());
+		}
+		Offset += dwWritten;
+	}
+	TotalBytesWritten += Output.size();
+	return std::nullopt;
+}
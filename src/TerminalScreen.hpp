@@ -0,0 +1,67 @@
+/* Info: Off-screen cell buffer for full-screen terminal views; each frame writes only the cells that changed since the previous one. */
+#pragma once
+#include "Errors.hpp"		// For error handling
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Low three bits select one of the basic ANSI foreground colors; the others are flags.
+enum TERMINAL_STYLE : BYTE {
+	STYLE_DEFAULT = 0,
+	STYLE_RED,
+	STYLE_GREEN,
+	STYLE_YELLOW,
+	STYLE_BLUE,
+	STYLE_MAGENTA,
+	STYLE_CYAN,
+	STYLE_WHITE,
+	STYLE_COLOR_MASK = 0x07,
+	STYLE_BOLD = 0x08,
+	STYLE_INVERSE = 0x10
+};
+
+/*
+ * Draws into the back buffer between BeginFrame and Present. Present compares it with what the terminal already
+ * shows and emits cursor moves, style changes and characters for the changed cells only, in a single write.
+ * Cells hold one byte, so text is expected to be ASCII; other bytes are drawn as '?'.
+ */
+class TerminalScreen {
+public:
+	~TerminalScreen() { Close(); }
+
+	// Switches the console to virtual terminal processing and the alternate screen, with the cursor hidden.
+	std::optional<Error> Open();
+	// Restores the console mode and the normal screen.
+	void Close();
+
+	// Picks up a resize of the window and clears the back buffer.
+	void BeginFrame();
+	std::optional<Error> Present();
+
+	int Width() const { return Columns; }
+	int Height() const { return Rows; }
+	// Clipped to the screen; returns the column after the text.
+	int Put(int x, int y, std::string_view Text, BYTE Style = STYLE_DEFAULT);
+	void Fill(int x, int y, int Count, char Character, BYTE Style = STYLE_DEFAULT);
+	UINT64 BytesWritten() const { return TotalBytesWritten; }
+
+private:
+	struct _CELL {
+		char Character = ' ';
+		BYTE Style = STYLE_DEFAULT;
+		bool operator==(const _CELL&) const = default;
+	};
+	HANDLE hOutput = NULL;
+	DWORD OriginalMode = 0;
+	int Columns = 0;
+	int Rows = 0;
+	std::vector<_CELL> Front;	// What the terminal shows.
+	std::vector<_CELL> Back;	// The frame being drawn.
+	BOOL bFullRedraw = TRUE;
+	BYTE TerminalStyle = STYLE_DEFAULT;
+	std::string Output;			// Reused so that a frame does not allocate once it has grown.
+	UINT64 TotalBytesWritten = 0;
+
+	void _AppendStyle(BYTE Style);
+};
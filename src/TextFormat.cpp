@@ -0,0 +1,206 @@
+#include "TextFormat.hpp"
+#include <charconv>
+#include <cstring>
+#include <array>
+
+// "00" to "99", so a division by 100 produces two digits at once.
+static constexpr std::array<char, 200> DecimalPairs = [] {
+	std::array<char, 200> Table{};
+	for (int i = 0; i < 100; i++) {
+		Table[i * 2] = static_cast<char>('0' + i / 10);
+		Table[i * 2 + 1] = static_cast<char>('0' + i % 10);
+	}
+	return Table;
+}();
+
+// "00" to "ff" and "00" to "FF", one byte per lookup.
+static constexpr std::array<char, 512> HexPairs[2] = {
+	[] {
+		std::array<char, 512> Table{};
+		for (int i = 0; i < 256; i++) {
+			Table[i * 2] = "0123456789abcdef"[i >> 4];
+			Table[i * 2 + 1] = "0123456789abcdef"[i & 0xF];
+		}
+		return Table;
+	}(),
+	[] {
+		std::array<char, 512> Table{};
+		for (int i = 0; i < 256; i++) {
+			Table[i * 2] = "0123456789ABCDEF"[i >> 4];
+			Table[i * 2 + 1] = "0123456789ABCDEF"[i & 0xF];
+		}
+		return Table;
+	}()
+};
+
+// Writes the digits of Value right-aligned to pEnd; returns where they start.
+static char* WriteDecimal(char* pEnd, UINT64 Value) {
+	while (Value >= 100) {
+		pEnd -= 2;
+		memcpy(pEnd, &DecimalPairs[(Value % 100) * 2], 2);
+		Value /= 100;
+	}
+	if (Value >= 10) {
+		pEnd -= 2;
+		memcpy(pEnd, &DecimalPairs[Value * 2], 2);
+	}
+	else *--pEnd = static_cast<char>('0' + Value);
+	return pEnd;
+}
+
+// Two decimal digits of a fixed-width date or time field; -1 when either is not a digit.
+static int ReadTwoDigits(const char* p) {
+	if (p[0] < '0' || p[0] > '9' || p[1] < '0' || p[1] > '9') return -1;
+	return (p[0] - '0') * 10 + (p[1] - '0');
+}
+
+bool TextWriter::_Reserve(size_t Count) {
+	if (Count <= Capacity - Length) return true;
+	bTruncated = true;
+	return false;
+}
+
+TextWriter& TextWriter::Text(std::string_view Value) {
+	size_t Count = Value.size();
+	if (!_Reserve(Count)) Count = Capacity - Length;
+	memcpy(pData + Length, Value.data(), Count);
+	Length += Count;
+	return *this;
+}
+
+TextWriter& TextWriter::Char(char Value, size_t Count) {
+	if (!_Reserve(Count)) Count = Capacity - Length;
+	memset(pData + Length, Value, Count);
+	Length += Count;
+	return *this;
+}
+
+TextWriter& TextWriter::Unsigned(UINT64 Value, int MinDigits) {
+	char Digits[20];
+	char* pEnd = Digits + sizeof(Digits);
+	char* pStart = WriteDecimal(pEnd, Value);
+	if (pEnd - pStart < MinDigits) Char('0', MinDigits - (pEnd - pStart));
+	return Text(std::string_view(pStart, pEnd - pStart));
+}
+
+TextWriter& TextWriter::Signed(INT64 Value) {
+	if (Value >= 0) return Unsigned(static_cast<UINT64>(Value));
+	Char('-');
+	// Negating in unsigned arithmetic also covers INT64_MIN.
+	return Unsigned(0 - static_cast<UINT64>(Value));
+}
+
+TextWriter& TextWriter::Hex(UINT64 Value, int MinDigits, bool bUppercase) {
+	const auto& Pairs = HexPairs[bUppercase ? 1 : 0];
+	char Digits[16];
+	char* pEnd = Digits + sizeof(Digits);
+	char* pStart = pEnd;
+	do {
+		pStart -= 2;
+		memcpy(pStart, &Pairs[(Value & 0xFF) * 2], 2);
+		Value >>= 8;
+	} while (Value);
+	// Pairs can leave one leading zero too many.
+	if (*pStart == '0' && pEnd - pStart > 1 && pEnd - pStart > MinDigits) pStart++;
+	if (pEnd - pStart < MinDigits) Char('0', MinDigits - (pEnd - pStart));
+	return Text(std::string_view(pStart, pEnd - pStart));
+}
+
+TextWriter& TextWriter::Fixed(double Value, int Precision) {
+	char Digits[64];
+	std::to_chars_result Result = std::to_chars(Digits, Digits + sizeof(Digits), Value, std::chars_format::fixed, Precision);
+	// Only magnitudes beyond about 1e60 overflow the buffer; scientific notation is still better than nothing.
+	if (Result.ec != std::errc()) Result = std::to_chars(Digits, Digits + sizeof(Digits), Value, std::chars_format::scientific, Precision);
+	return Text(std::string_view(Digits, Result.ptr - Digits));
+}
+
+TextWriter& TextWriter::Bytes(double Value) {
+	static const std::string_view Units[] = { " B", " KB", " MB", " GB", " TB" };
+	int Unit = 0;
+	for (; Value >= 1024 && Unit < 4; Unit++) Value /= 1024;
+	if (Unit == 0) Fixed(Value, 0);
+	else Fixed(Value, 1);
+	return Text(Units[Unit]);
+}
+
+TextWriter& TextWriter::MACAddress(const BYTE* pAddress, size_t AddressLength, char Separator) {
+	for (size_t i = 0; i < AddressLength; i++) {
+		if (i != 0) Char(Separator);
+		Text(std::string_view(&HexPairs[0][pAddress[i] * 2], 2));
+	}
+	return *this;
+}
+
+TextWriter& TextWriter::IPv4Mask(unsigned int PrefixLength) {
+	DWORD Mask = PrefixLength == 0 ? 0 : PrefixLength >= 32 ? 0xFFFFFFFF : 0xFFFFFFFF << (32 - PrefixLength);
+	for (int Shift = 24; Shift >= 0; Shift -= 8) {
+		Unsigned((Mask >> Shift) & 0xFF);
+		if (Shift) Char('.');
+	}
+	return *this;
+}
+
+bool TextWriter::WMIDateTime(std::string_view Value) {
+	if (Value.size() < 14) return false;
+	int Century = ReadTwoDigits(Value.data()), YearOfCentury = ReadTwoDigits(Value.data() + 2);
+	int Month = ReadTwoDigits(Value.data() + 4), Day = ReadTwoDigits(Value.data() + 6);
+	int Hour = ReadTwoDigits(Value.data() + 8), Minutes = ReadTwoDigits(Value.data() + 10), Seconds = ReadTwoDigits(Value.data() + 12);
+	if (Century < 0 || YearOfCentury < 0 || Month < 0 || Day < 0 || Hour < 0 || Minutes < 0 || Seconds < 0) return false;
+
+	// The offset follows the fraction: a sign and three digits of minutes.
+	int OffsetMinutes = 0;
+	bool bPlus = false;
+	size_t Sign = Value.find_first_of("+-", 14);
+	if (Sign != std::string_view::npos) {
+		bPlus = Value[Sign] == '+';
+		for (size_t i = Sign + 1; i < Value.size() && Value[i] >= '0' && Value[i] <= '9'; i++) OffsetMinutes = OffsetMinutes * 10 + (Value[i] - '0');
+	}
+
+	const char* AmPm = Hour >= 12 ? "PM" : "AM";
+	if (Hour > 12) Hour -= 12;
+	else if (Hour == 0) Hour = 12;
+
+	Unsigned(Century * 100 + YearOfCentury, 4).Char('-').Unsigned(Month, 2).Char('-').Unsigned(Day, 2).Char(' ');
+	Unsigned(Hour, 2).Char(':').Unsigned(Minutes, 2).Char(':').Unsigned(Seconds, 2).Char(' ').Text(AmPm);
+	Text(" UTC ").Char(bPlus ? '+' : '-').Unsigned(OffsetMinutes / 60, 2).Char(':').Unsigned(OffsetMinutes % 60, 2);
+	return true;
+}
+
+TextWriter& TextWriter::PadFrom(size_t Start, size_t Width) {
+	size_t Written = Length - Start;
+	if (Written < Width) Char(' ', Width - Written);
+	return *this;
+}
+
+TextWriter& TextWriter::AlignRight(size_t Start, size_t Width) {
+	size_t Written = Length - Start;
+	if (Written >= Width) return *this;
+	size_t Padding = Width - Written;
+	if (!_Reserve(Padding)) Padding = Capacity - Length;
+	memmove(pData + Start + Padding, pData + Start, Written);
+	memset(pData + Start, ' ', Padding);
+	Length += Padding;
+	return *this;
+}
+
+TextWriter& ReportWriter::Row() {
+	if (Remaining() < MaxRowSize) Flush();
+	return *this;
+}
+
+TextWriter& ReportWriter::Field(std::string_view Label, size_t LabelWidth) {
+	Row();
+	size_t Start = Mark();
+	return Text(Label).PadFrom(Start, LabelWidth);
+}
+
+void ReportWriter::Flush() {
+	std::string_view Pending = View();
+	HANDLE hOutput = GetStdHandle(STD_OUTPUT_HANDLE);
+	while (!Pending.empty()) {
+		DWORD dwWritten = 0;
+		if (!WriteFile(hOutput, Pending.data(), static_cast<DWORD>(Pending.size()), &dwWritten, NULL) || dwWritten == 0) break;
+		Pending.remove_prefix(dwWritten);
+	}
+	Clear();
+}
@@ -0,0 +1,90 @@
+/* Info: Allocation-free text formatting into fixed-size buffers: numbers, sizes, MAC and IPv4 addresses, WMI dates and padded report columns. */
+#pragma once
+#include <Windows.h>
+#include <string>
+#include <string_view>
+
+/*
+ * Appends to a buffer the caller owns, usually an array on the stack. Integers go through two-digit lookup tables and
+ * floating point through std::to_chars, so nothing here allocates or consults the locale. Text that does not fit is
+ * cut off and IsTruncated reports it; the buffer is never grown.
+ */
+class TextWriter {
+public:
+	TextWriter(char* pBuffer, size_t Capacity) : pData(pBuffer), Capacity(Capacity) {}
+
+	TextWriter& Text(std::string_view Value);
+	TextWriter& Char(char Value, size_t Count = 1);
+	TextWriter& EndLine() { return Char('\n'); }
+	// Zero-padded to at least MinDigits.
+	TextWriter& Unsigned(UINT64 Value, int MinDigits = 1);
+	TextWriter& Signed(INT64 Value);
+	TextWriter& Hex(UINT64 Value, int MinDigits = 1, bool bUppercase = false);
+	TextWriter& Fixed(double Value, int Precision);
+	// Binary multiples with one decimal: "512 B", "1.5 KB", "3.2 GB".
+	TextWriter& Bytes(double Value);
+	// Bytes separated by `Separator`, each as two lowercase hex digits.
+	TextWriter& MACAddress(const BYTE* pAddress, size_t Length, char Separator = '-');
+	// The dotted-quad netmask of an IPv4 prefix length; 24 gives "255.255.255.0".
+	TextWriter& IPv4Mask(unsigned int PrefixLength);
+	/*
+	 * A CIM_DATETIME ("yyyymmddHHMMSS.mmmmmmsUUU") as "yyyy-mm-dd hh:mm:ss AM UTC +hh:mm". The offset is in minutes
+	 * after the sign. Returns false, having written nothing, when the value is shorter than the date and time fields.
+	 */
+	bool WMIDateTime(std::string_view Value);
+
+	// Columns: remember where a value starts, write it, then pad it on the right (left-aligned) or the left (right-aligned).
+	size_t Mark() const { return Length; }
+	TextWriter& PadFrom(size_t Start, size_t Width);
+	TextWriter& AlignRight(size_t Start, size_t Width);
+
+	std::string_view View() const { return std::string_view(pData, Length); }
+	std::string String() const { return std::string(pData, Length); }
+	size_t Size() const { return Length; }
+	size_t Remaining() const { return Capacity - Length; }
+	bool IsTruncated() const { return bTruncated; }
+	void Clear() { Length = 0; bTruncated = false; }
+
+private:
+	char* pData;
+	size_t Capacity;
+	size_t Length = 0;
+	bool bTruncated = false;
+
+	// Room for Count more characters, or false (and truncated) when there is none.
+	bool _Reserve(size_t Count);
+};
+
+// A TextWriter with its own buffer, for values rendered on the stack.
+template<size_t N> class FixedText : public TextWriter {
+public:
+	FixedText() : TextWriter(Buffer, N) {}
+	FixedText(const FixedText&) = delete;
+	FixedText& operator=(const FixedText&) = delete;
+
+private:
+	char Buffer[N];
+};
+
+/*
+ * Builds a text report in a fixed 64 KB buffer and writes it to standard output in a few large writes. Every Row and
+ * Field first makes sure a whole row fits, flushing if it does not, so rows up to MaxRowSize are never cut.
+ */
+class ReportWriter : public TextWriter {
+public:
+	static constexpr size_t BufferSize = 64 * 1024;
+	static constexpr size_t MaxRowSize = 4096;
+
+	ReportWriter() : TextWriter(Buffer, BufferSize) {}
+	~ReportWriter() { Flush(); }
+	ReportWriter(const ReportWriter&) = delete;
+	ReportWriter& operator=(const ReportWriter&) = delete;
+
+	TextWriter& Row();
+	// A row starting with `Label` padded to `LabelWidth`.
+	TextWriter& Field(std::string_view Label, size_t LabelWidth);
+	void Flush();
+
+private:
+	char Buffer[BufferSize];
+};
@@ -1,28 +1,15 @@
 #include "SysInfoProbe.hpp"
 
 void SysInfoProbe::GetUptimeInfo() {
-	UINT64 Milliseconds = GetTickCount64();
-	UINT64 Seconds = 0;
-	UINT64 Minutes = 0;
-	UINT64 Hours = 0;
-	UINT64 Days = 0;
+	INSTRUMENT_COLLECTOR("SysInfoProbe::GetUptimeInfo");
+	// Uptime includes the time spent suspended, as the boot time does; the difference to the monotonic clock is that time.
+	UINT64 SinceBoot = Clock::SinceBoot();
+	UINT64 Seconds = SinceBoot / Clock::TicksPerSecond;
 
-	Seconds = Milliseconds / 1000;
-	Minutes = Seconds / 60;
-	Hours = Seconds / 3600;
-	if (Minutes > 1)
-		Seconds -= Minutes * 60;
-	
-	if (Hours > 0) {
-		Minutes -= Hours * 60;
-		if (Hours > 24) {
-			Days = Hours / 24;
-			Hours -= Days * 24;
-		}
-	}
-
-	Uptime.Days = Days;
-	Uptime.Hours = Hours;
-	Uptime.Minutes = Minutes;
-	Uptime.Seconds = Seconds;
+	Uptime.Days = Seconds / 86400;
+	Uptime.Hours = Seconds / 3600 % 24;
+	Uptime.Minutes = Seconds / 60 % 60;
+	Uptime.Seconds = Seconds % 60;
+	Uptime.SuspendedSeconds = (SinceBoot - (std::min)(Clock::Monotonic(), SinceBoot)) / Clock::TicksPerSecond;
+	Uptime.BootedAt = Clock::BootWallTime() / 1000;
 }
\ No newline at end of file
@@ -1,4 +1,7 @@
 #include "Utils.hpp"
+#include <cerrno>
+#include <cwchar>
+#include <cwctype>
 
 std::string w2s(std::wstring ws) {
 	int size = WideCharToMultiByte(CP_UTF8, 0, ws.c_str(), -1, NULL, 0, NULL, NULL);
@@ -22,4 +25,14 @@ std::string trim_leading(const std::string& str) {
 std::string trim_trailing(const std::string& str) {
 	auto right_trimmed = std::find_if_not(str.rbegin(), str.rend(), [](unsigned char ch) { return std::isspace(ch); }).base();
 	return std::string(str.begin(), right_trimmed);
+}
+
+bool parse_unsigned(const wchar_t* text, UINT64& value) {
+	if (!text || !iswdigit(*text)) return false;
+	wchar_t* end = nullptr;
+	errno = 0;
+	UINT64 parsed = wcstoull(text, &end, 10);
+	if (errno != 0 || *end != L'\0') return false;
+	value = parsed;
+	return true;
 }
\ No newline at end of file
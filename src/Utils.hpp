@@ -6,4 +6,6 @@
 std::string w2s(std::wstring ws);
 std::string trim(const std::string& str);
 std::string trim_leading(const std::string& str);
-std::string trim_trailing(const std::string& str);
\ No newline at end of file
+std::string trim_trailing(const std::string& str);
+// Whole decimal strings only: false for NULL, empty or signed text, trailing characters and overflow.
+bool parse_unsigned(const wchar_t* text, UINT64& value);
\ No newline at end of file
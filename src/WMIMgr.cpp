@@ -51,6 +51,7 @@ std::optional<Error> WMIManager::ExecuteWQLQuery(BSTR WQLQuery) {
         pEnumerator->Release();
         pEnumerator = nullptr;
     }
+    Instrumentation::CountWMIQuery();
     HRESULT hRes = pServices->ExecQuery(bstr_t(L"WQL"), WQLQuery, WBEM_FLAG_FORWARD_ONLY | WBEM_FLAG_RETURN_IMMEDIATELY, NULL, &pEnumerator);
     if (FAILED(hRes)) {
         return Error::New("WMIManager::ExecuteWQLQuery", -3, L"WQL Query Failed", hRes);
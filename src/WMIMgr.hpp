@@ -1,5 +1,6 @@
 #pragma once
 #include "Errors.hpp"       // Better error handling
+#include "Instrumentation.hpp"  // For counting WMI queries
 #include <Windows.h>        // Windows API
 #include <iostream>         // Basic C++ I/O
 #include <optional>         // For std::optional